@@ -25,12 +25,27 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include "JlCompress.h"
 
+#include <QtCore/QFutureInterface>
+#include <QtCore/QPair>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
 // #define Q_DEBUG
 #ifdef Q_DEBUG
 #include <QDebug>
 #endif
 
-bool JlCompress::copyData(QIODevice &inFile, QIODevice &outFile)
+/// \cond internal
+/// Receives progress notifications from the copying functions.
+class JlCompressProgressSink {
+public:
+    virtual ~JlCompressProgressSink() {}
+    /// Called after each chunk, returns false to stop copying.
+    virtual bool transferred(qint64 bytes) = 0;
+};
+
+static bool copyDataImpl(QIODevice &inFile, QIODevice &outFile,
+                         JlCompressProgressSink *sink)
 {
     while (!inFile.atEnd()) {
         char buf[4096];
@@ -39,11 +54,39 @@ bool JlCompress::copyData(QIODevice &inFile, QIODevice &outFile)
             return false;
         if (outFile.write(buf, readLen) != readLen)
             return false;
+        if (sink != nullptr && !sink->transferred(readLen))
+            return false;
     }
     return true;
 }
 
+static bool compressFileImpl(QuaZip* zip, QString fileName, QString fileDest,
+                             int method, int level,
+                             JlCompressProgressSink *sink);
+static bool extractFileImpl(QuaZip* zip, QString fileName, QString fileDest,
+                            JlCompressProgressSink *sink);
+/// \endcond
+
+bool JlCompress::copyData(QIODevice &inFile, QIODevice &outFile)
+{
+    return copyDataImpl(inFile, outFile, nullptr);
+}
+
 bool JlCompress::compressFile(QuaZip* zip, QString fileName, QString fileDest) 
+{
+    return compressFileImpl(zip, fileName, fileDest, Z_DEFLATED,
+                            Z_DEFAULT_COMPRESSION, nullptr);
+}
+
+bool JlCompress::compressFile(QuaZip* zip, QString fileName, QString fileDest,
+                              int method, int level)
+{
+    return compressFileImpl(zip, fileName, fileDest, method, level, nullptr);
+}
+
+static bool compressFileImpl(QuaZip* zip, QString fileName, QString fileDest,
+                             int method, int level,
+                             JlCompressProgressSink *sink)
 {
     // zip: oggetto dove aggiungere il file
     // fileName: nome del file reale
@@ -57,7 +100,8 @@ bool JlCompress::compressFile(QuaZip* zip, QString fileName, QString fileDest)
 
     // Apro il file risulato
     QuaZipFile outFile(zip);
-    if(!outFile.open(QIODevice::WriteOnly, QuaZipNewInfo(fileDest, fileName))) return false;
+    if(!outFile.open(QIODevice::WriteOnly, QuaZipNewInfo(fileDest, fileName),
+                     nullptr, 0, method, level)) return false;
 
     QFileInfo input(fileName);
     if (quazip_is_symlink(input)) {
@@ -72,7 +116,7 @@ bool JlCompress::compressFile(QuaZip* zip, QString fileName, QString fileDest)
         inFile.setFileName(fileName);
         if (!inFile.open(QIODevice::ReadOnly))
             return false;
-        if (!copyData(inFile, outFile) || outFile.getZipError()!=UNZ_OK)
+        if (!copyDataImpl(inFile, outFile, sink) || outFile.getZipError()!=UNZ_OK)
             return false;
         inFile.close();
     }
@@ -85,6 +129,13 @@ bool JlCompress::compressFile(QuaZip* zip, QString fileName, QString fileDest)
 }
 
 bool JlCompress::compressSubDir(QuaZip* zip, QString dir, QString origDir, bool recursive, QDir::Filters filters) 
+{
+    return compressSubDir(zip, dir, origDir, recursive, filters,
+                          Z_DEFLATED, Z_DEFAULT_COMPRESSION);
+}
+
+bool JlCompress::compressSubDir(QuaZip* zip, QString dir, QString origDir, bool recursive,
+                                QDir::Filters filters, int method, int level)
 {
     // zip: object where to add the file
     // dir: current real directory
@@ -133,7 +184,8 @@ bool JlCompress::compressSubDir(QuaZip* zip, QString dir, QString origDir, bool
                 continue;
 
             // Compressing the sub folder
-            if (!compressSubDir(zip, file.absoluteFilePath(), origDir, recursive, filters)) 
+            if (!compressSubDir(zip, file.absoluteFilePath(), origDir, recursive, filters,
+                                method, level))
                 return false;
         }
     }
@@ -154,7 +206,7 @@ bool JlCompress::compressSubDir(QuaZip* zip, QString dir, QString origDir, bool
         #endif
 
         // I compress the file
-        if (!compressFile(zip, file.absoluteFilePath(), filename)) {
+        if (!compressFile(zip, file.absoluteFilePath(), filename, method, level)) {
             #ifdef Q_DEBUG
                 qDebug() << "*** JlCompress::compressSubDir() - Fatal error: can't compress item -> " << file.absoluteFilePath();
             #endif
@@ -171,6 +223,12 @@ bool JlCompress::compressSubDir(QuaZip* zip, QString dir, QString origDir, bool
 }
 
 bool JlCompress::extractFile(QuaZip* zip, QString fileName, QString fileDest) 
+{
+    return extractFileImpl(zip, fileName, fileDest, nullptr);
+}
+
+static bool extractFileImpl(QuaZip* zip, QString fileName, QString fileDest,
+                            JlCompressProgressSink *sink)
 {
     // zip: oggetto dove aggiungere il file
     // filename: nome del file reale
@@ -223,9 +281,9 @@ bool JlCompress::extractFile(QuaZip* zip, QString fileName, QString fileDest)
     if(!outFile.open(QIODevice::WriteOnly)) return false;
 
     // Copio i dati
-    if (!copyData(inFile, outFile) || inFile.getZipError()!=UNZ_OK) {
+    if (!copyDataImpl(inFile, outFile, sink) || inFile.getZipError()!=UNZ_OK) {
         outFile.close();
-        removeFile(QStringList(fileDest));
+        JlCompress::removeFile(QStringList(fileDest));
         return false;
     }
     outFile.close();
@@ -233,7 +291,7 @@ bool JlCompress::extractFile(QuaZip* zip, QString fileName, QString fileDest)
     // Chiudo i file
     inFile.close();
     if (inFile.getZipError()!=UNZ_OK) {
-        removeFile(QStringList(fileDest));
+        JlCompress::removeFile(QStringList(fileDest));
         return false;
     }
 
@@ -255,6 +313,12 @@ bool JlCompress::removeFile(QStringList listFile)
 }
 
 bool JlCompress::compressFile(QString fileCompressed, QString file) 
+{
+    return compressFile(fileCompressed, file, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
+}
+
+bool JlCompress::compressFile(QString fileCompressed, QString file,
+                              int method, int level)
 {
     // Creo lo zip
     QuaZip zip(fileCompressed);
@@ -265,7 +329,7 @@ bool JlCompress::compressFile(QString fileCompressed, QString file)
     }
 
     // Aggiungo il file
-    if (!compressFile(&zip,file,QFileInfo(file).fileName())) {
+    if (!compressFile(&zip,file,QFileInfo(file).fileName(),method,level)) {
         QFile::remove(fileCompressed);
         return false;
     }
@@ -281,6 +345,12 @@ bool JlCompress::compressFile(QString fileCompressed, QString file)
 }
 
 bool JlCompress::compressFiles(QString fileCompressed, QStringList files) 
+{
+    return compressFiles(fileCompressed, files, Z_DEFLATED, Z_DEFAULT_COMPRESSION);
+}
+
+bool JlCompress::compressFiles(QString fileCompressed, QStringList files,
+                               int method, int level)
 {
     // Creo lo zip
     QuaZip zip(fileCompressed);
@@ -295,7 +365,7 @@ bool JlCompress::compressFiles(QString fileCompressed, QStringList files)
     for (int index = 0; index < files.size(); ++index ) {
         const QString & file( files.at( index ) );
         info.setFile(file);
-        if (!info.exists() || !compressFile(&zip,file,info.fileName())) {
+        if (!info.exists() || !compressFile(&zip,file,info.fileName(),method,level)) {
             QFile::remove(fileCompressed);
             return false;
         }
@@ -318,6 +388,14 @@ bool JlCompress::compressDir(QString fileCompressed, QString dir, bool recursive
 
 bool JlCompress::compressDir(QString fileCompressed, QString dir,
                              bool recursive, QDir::Filters filters)
+{
+    return compressDir(fileCompressed, dir, recursive, filters,
+                       Z_DEFLATED, Z_DEFAULT_COMPRESSION);
+}
+
+bool JlCompress::compressDir(QString fileCompressed, QString dir,
+                             bool recursive, QDir::Filters filters,
+                             int method, int level)
 {
     // Creo lo zip
     QuaZip zip(fileCompressed);
@@ -328,7 +406,7 @@ bool JlCompress::compressDir(QString fileCompressed, QString dir,
     }
 
     // Aggiungo i file e le sotto cartelle
-    if (!compressSubDir(&zip,dir,dir,recursive, filters)) {
+    if (!compressSubDir(&zip,dir,dir,recursive, filters, method, level)) {
         QFile::remove(fileCompressed);
         return false;
     }
@@ -523,3 +601,319 @@ QStringList JlCompress::extractFiles(QIODevice *ioDevice, QStringList files, QSt
     QuaZip zip(ioDevice);
     return extractFiles(zip, files, dir);
 } 
+
+/// \cond internal
+/// The common part of the asynchronous JlCompress operations.
+template<typename T>
+class JlCompressAsyncTask: public QRunnable, public JlCompressProgressSink {
+public:
+    JlCompressAsyncTask():
+        bytesDone(0),
+        bytesReported(0),
+        entriesDone(0),
+        entriesTotal(0),
+        scale(0),
+        progressMaximum(0)
+    {
+        setAutoDelete(true);
+        futureInterface.reportStarted();
+    }
+    QFuture<T> start()
+    {
+        QFuture<T> future = futureInterface.future();
+        QThreadPool::globalInstance()->start(this);
+        return future;
+    }
+    virtual void run()
+    {
+        T result = isCanceled() ? T() : work();
+        if (!isCanceled())
+            futureInterface.reportResult(result);
+        futureInterface.reportFinished();
+    }
+    virtual bool transferred(qint64 bytes)
+    {
+        bytesDone += bytes;
+        // don't flood the watchers with progress updates
+        if (bytesDone - bytesReported >= 256 * 1024)
+            reportProgress();
+        return !isCanceled();
+    }
+protected:
+    virtual T work() = 0;
+    bool isCanceled() const
+    {
+        return futureInterface.isCanceled();
+    }
+    void setTotals(qint64 bytesTotal, int entries)
+    {
+        // Each entry counts as one more unit, so that the value changes
+        // after empty entries too: QFuture ignores the progress text
+        // unless the value changes.
+        qint64 total = bytesTotal + entries;
+        entriesTotal = entries;
+        scale = 0;
+        while ((total >> scale) > 0x7FFFFFFF)
+            ++scale;
+        progressMaximum = static_cast<int>(total >> scale);
+        futureInterface.setProgressRange(0, progressMaximum);
+        reportProgress();
+    }
+    void entryFinished()
+    {
+        ++entriesDone;
+        reportProgress();
+    }
+private:
+    void reportProgress()
+    {
+        bytesReported = bytesDone;
+        int value = static_cast<int>(qMin<qint64>(
+                    (bytesDone + entriesDone) >> scale, progressMaximum));
+        futureInterface.setProgressValueAndText(value,
+                QString::fromLatin1("%1/%2").arg(entriesDone)
+                    .arg(entriesTotal));
+    }
+    QFutureInterface<T> futureInterface;
+    qint64 bytesDone;
+    qint64 bytesReported;
+    int entriesDone;
+    int entriesTotal;
+    int scale;
+    int progressMaximum;
+};
+
+/// Collects the files compressSubDir() would pack, in the same order.
+static bool collectSubDir(const QString &dir, const QDir &origDirectory,
+                          bool recursive, QDir::Filters filters,
+                          const QString &zipPath,
+                          QList<QPair<QString, QString> > &items)
+{
+    QDir directory(dir);
+    if (!directory.exists())
+        return false;
+    if (recursive) {
+        QFileInfoList dirs = directory.entryInfoList(QDir::AllDirs | QDir::NoDotAndDotDot | filters);
+        for (int index = 0; index < dirs.size(); ++index) {
+            const QFileInfo &file(dirs.at(index));
+            if (!file.isDir())
+                continue;
+            if (!collectSubDir(file.absoluteFilePath(), origDirectory,
+                               recursive, filters, zipPath, items))
+                return false;
+        }
+    }
+    QFileInfoList files = directory.entryInfoList(QDir::Files | filters);
+    for (int index = 0; index < files.size(); ++index) {
+        const QFileInfo &file(files.at(index));
+        if (!file.isFile() || file.absoluteFilePath() == zipPath)
+            continue;
+        QString filename = origDirectory.dirName() + QLatin1String("/")
+            + origDirectory.relativeFilePath(file.absoluteFilePath());
+        items.append(qMakePair(file.absoluteFilePath(), filename));
+    }
+    return true;
+}
+
+/// compressFilesAsync() and compressDirAsync()
+class JlCompressTask: public JlCompressAsyncTask<bool> {
+public:
+    JlCompressTask(const QString &fileCompressed, const QStringList &files,
+                   int method, int level):
+        fileCompressed(fileCompressed), files(files), isDir(false),
+        recursive(false), method(method), level(level) {}
+    JlCompressTask(const QString &fileCompressed, const QString &dir,
+                   bool recursive, QDir::Filters filters, int method,
+                   int level):
+        fileCompressed(fileCompressed), dir(dir), isDir(true),
+        recursive(recursive), filters(filters), method(method),
+        level(level) {}
+protected:
+    virtual bool work()
+    {
+        QList<QPair<QString, QString> > items;
+        if (isDir) {
+            if (!collectSubDir(dir, QDir(dir), recursive, filters,
+                        QFileInfo(fileCompressed).absoluteFilePath(), items))
+                return false;
+        } else {
+            for (int index = 0; index < files.size(); ++index) {
+                QFileInfo info(files.at(index));
+                if (!info.exists())
+                    return false;
+                items.append(qMakePair(files.at(index), info.fileName()));
+            }
+        }
+        qint64 total = 0;
+        for (int index = 0; index < items.size(); ++index) {
+            QFileInfo info(items.at(index).first);
+            if (!quazip_is_symlink(info))
+                total += info.size();
+        }
+        setTotals(total, items.size());
+        QuaZip zip(fileCompressed);
+        QDir().mkpath(QFileInfo(fileCompressed).absolutePath());
+        if (!zip.open(QuaZip::mdCreate)) {
+            QFile::remove(fileCompressed);
+            return false;
+        }
+        for (int index = 0; index < items.size() && !isCanceled(); ++index) {
+            if (!compressFileImpl(&zip, items.at(index).first,
+                                  items.at(index).second, method, level,
+                                  this)) {
+                zip.close();
+                QFile::remove(fileCompressed);
+                return false;
+            }
+            entryFinished();
+        }
+        zip.close();
+        if (isCanceled() || zip.getZipError() != 0) {
+            QFile::remove(fileCompressed);
+            return false;
+        }
+        return true;
+    }
+private:
+    QString fileCompressed;
+    QStringList files;
+    QString dir;
+    bool isDir;
+    bool recursive;
+    QDir::Filters filters;
+    int method;
+    int level;
+};
+
+/// extractFilesAsync() and extractDirAsync()
+class JlExtractTask: public JlCompressAsyncTask<QStringList> {
+public:
+    JlExtractTask(const QString &fileCompressed, const QStringList &files,
+                  const QString &dir):
+        fileCompressed(fileCompressed), files(files), dir(dir),
+        allFiles(false) {}
+    JlExtractTask(const QString &fileCompressed, const QString &dir):
+        fileCompressed(fileCompressed), dir(dir), allFiles(true) {}
+protected:
+    virtual QStringList work()
+    {
+        QuaZip zip(fileCompressed);
+        if (!zip.open(QuaZip::mdUnzip))
+            return QStringList();
+        // what to extract and where, same rules as extractDir()/extractFiles()
+        QList<QuaZipFileInfo64> infos = zip.getFileInfoList64();
+        QList<int> indexes;
+        QStringList destinations;
+        qint64 total = 0;
+        if (allFiles) {
+            QDir directory(QDir::cleanPath(dir));
+            QString absCleanDir = directory.absolutePath();
+            if (!absCleanDir.endsWith('/')) // It only ends with / if it's the FS root.
+                absCleanDir += '/';
+            for (int index = 0; index < infos.size(); ++index) {
+                QString absFilePath = directory.absoluteFilePath(infos.at(index).name);
+                if (!QDir::cleanPath(absFilePath).startsWith(absCleanDir))
+                    continue;
+                indexes.append(index);
+                destinations.append(absFilePath);
+                total += infos.at(index).uncompressedSize;
+            }
+        } else {
+            for (int i = 0; i < files.size(); ++i) {
+                int found = -1;
+                for (int index = 0; index < infos.size(); ++index) {
+                    if (infos.at(index).name == files.at(i)) {
+                        found = index;
+                        break;
+                    }
+                }
+                if (found == -1)
+                    return QStringList();
+                indexes.append(found);
+                destinations.append(QDir(dir).absoluteFilePath(files.at(i)));
+                total += infos.at(found).uncompressedSize;
+            }
+        }
+        setTotals(total, indexes.size());
+        QStringList extracted;
+        int current = 0;
+        bool more = zip.goToFirstFile();
+        for (int i = 0; i < indexes.size() && !isCanceled(); ++i) {
+            // walk forward when possible instead of searching by name
+            if (indexes.at(i) < current) {
+                current = 0;
+                more = zip.goToFirstFile();
+            }
+            while (more && current < indexes.at(i)) {
+                more = zip.goToNextFile();
+                ++current;
+            }
+            if (!more || !extractFileImpl(&zip, QLatin1String(""),
+                                          destinations.at(i), this)) {
+                JlCompress::removeFile(extracted);
+                return QStringList();
+            }
+            extracted.append(destinations.at(i));
+            entryFinished();
+        }
+        zip.close();
+        if (isCanceled() || zip.getZipError() != 0) {
+            JlCompress::removeFile(extracted);
+            return QStringList();
+        }
+        return extracted;
+    }
+private:
+    QString fileCompressed;
+    QStringList files;
+    QString dir;
+    bool allFiles;
+};
+/// \endcond
+
+QFuture<bool> JlCompress::compressFilesAsync(const QString &fileCompressed,
+                                             const QStringList &files)
+{
+    return compressFilesAsync(fileCompressed, files, Z_DEFLATED,
+                              Z_DEFAULT_COMPRESSION);
+}
+
+QFuture<bool> JlCompress::compressFilesAsync(const QString &fileCompressed,
+                                             const QStringList &files,
+                                             int method, int level)
+{
+    return (new JlCompressTask(fileCompressed, files, method, level))
+        ->start();
+}
+
+QFuture<bool> JlCompress::compressDirAsync(const QString &fileCompressed,
+                                           const QString &dir,
+                                           bool recursive,
+                                           QDir::Filters filters)
+{
+    return compressDirAsync(fileCompressed, dir, recursive, filters,
+                            Z_DEFLATED, Z_DEFAULT_COMPRESSION);
+}
+
+QFuture<bool> JlCompress::compressDirAsync(const QString &fileCompressed,
+                                           const QString &dir,
+                                           bool recursive,
+                                           QDir::Filters filters,
+                                           int method, int level)
+{
+    return (new JlCompressTask(fileCompressed, dir, recursive, filters,
+                               method, level))->start();
+}
+
+QFuture<QStringList> JlCompress::extractFilesAsync(
+        const QString &fileCompressed, const QStringList &files,
+        const QString &dir)
+{
+    return (new JlExtractTask(fileCompressed, files, dir))->start();
+}
+
+QFuture<QStringList> JlCompress::extractDirAsync(const QString &fileCompressed,
+                                                 const QString &dir)
+{
+    return (new JlExtractTask(fileCompressed, dir))->start();
+}
@@ -34,6 +34,7 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
 #include <QtCore/QFile>
+#include <QtCore/QFuture>
 
 /// Utility class for typical operations.
 /**
@@ -55,6 +56,15 @@ public:
       \return true if success, false otherwise.
       */
     static bool compressFile(QuaZip* zip, QString fileName, QString fileDest);
+    /// Compress a single file with the specified method and level.
+    /**
+      \overload
+
+      \param method The compression method, as in QuaZipFile::open().
+      \param level The compression level, as in QuaZipFile::open().
+      */
+    static bool compressFile(QuaZip* zip, QString fileName, QString fileDest,
+                             int method, int level);
     /// Compress a subdirectory.
     /**
       \param parentZip Opened zip containing the parent directory.
@@ -67,6 +77,15 @@ public:
       */
     static bool compressSubDir(QuaZip* parentZip, QString dir, QString parentDir, bool recursive,
                                QDir::Filters filters);
+    /// Compress a subdirectory with the specified method and level.
+    /**
+      \overload
+
+      \param method The compression method, as in QuaZipFile::open().
+      \param level The compression level, as in QuaZipFile::open().
+      */
+    static bool compressSubDir(QuaZip* parentZip, QString dir, QString parentDir, bool recursive,
+                               QDir::Filters filters, int method, int level);
     /// Extract a single file.
     /**
       \param zip The opened zip archive to extract from.
@@ -89,6 +108,16 @@ public:
       \return true if success, false otherwise.
       */
     static bool compressFile(QString fileCompressed, QString file);
+    /// Compress a single file with the specified method and level.
+    /**
+      \overload
+
+      \param method The compression method, as in QuaZipFile::open().
+      For example, \c Z_ZSTD.
+      \param level The compression level, as in QuaZipFile::open().
+      */
+    static bool compressFile(QString fileCompressed, QString file,
+                             int method, int level);
     /// Compress a list of files.
     /**
       \param fileCompressed The name of the archive.
@@ -96,6 +125,15 @@ public:
       \return true if success, false otherwise.
       */
     static bool compressFiles(QString fileCompressed, QStringList files);
+    /// Compress a list of files with the specified method and level.
+    /**
+      \overload
+
+      \param method The compression method, as in QuaZipFile::open().
+      \param level The compression level, as in QuaZipFile::open().
+      */
+    static bool compressFiles(QString fileCompressed, QStringList files,
+                              int method, int level);
     /// Compress a whole directory.
     /**
       Does not compress hidden files. See compressDir(QString, QString, bool, QDir::Filters).
@@ -125,6 +163,16 @@ public:
      */
     static bool compressDir(QString fileCompressed, QString dir,
                             bool recursive, QDir::Filters filters);
+    /// Compress a whole directory with the specified method and level.
+    /**
+      \overload
+
+      \param method The compression method, as in QuaZipFile::open().
+      \param level The compression level, as in QuaZipFile::open().
+      */
+    static bool compressDir(QString fileCompressed, QString dir,
+                            bool recursive, QDir::Filters filters,
+                            int method, int level);
 
     /// Extract a single file.
     /**
@@ -210,6 +258,74 @@ public:
       are present separately.
       */
     static QStringList getFileList(QIODevice *ioDevice); 
+
+    /** \name Asynchronous operations
+     * These functions do the same thing as their synchronous counterparts,
+     * but in a thread from QThreadPool::globalInstance(), and return
+     * immediately.
+     *
+     * The progress is reported through the returned QFuture, so it can be
+     * watched with QFutureWatcher. The progress value is the amount of
+     * uncompressed data processed so far plus the number of entries
+     * finished, and the progress maximum is the total amount of data plus
+     * the number of entries. If the maximum doesn't fit into an \c int,
+     * both are scaled down by the same power of two, so only their ratio
+     * makes sense in that case. The progress text contains the number of
+     * entries finished and their total number, like \c "3/10".
+     *
+     * Calling QFuture::cancel() stops the operation as soon as the
+     * current chunk of data is processed, without finishing the current
+     * entry. The partial output is then removed: the archive being
+     * created, or the files extracted so far. A canceled future has no
+     * result. A future that finished without being canceled always has
+     * one, which is \c false or an empty list on failure, just like the
+     * synchronous functions return.
+     */
+    ///@{
+    /// Compress a list of files asynchronously.
+    /**
+      \sa compressFiles()
+      */
+    static QFuture<bool> compressFilesAsync(const QString &fileCompressed,
+                                            const QStringList &files);
+    /// Compress a list of files asynchronously with the specified method and level.
+    /**
+      \sa compressFiles(QString, QStringList, int, int)
+      */
+    static QFuture<bool> compressFilesAsync(const QString &fileCompressed,
+                                            const QStringList &files,
+                                            int method, int level);
+    /// Compress a whole directory asynchronously.
+    /**
+      \sa compressDir(QString, QString, bool, QDir::Filters)
+      */
+    static QFuture<bool> compressDirAsync(const QString &fileCompressed,
+                                          const QString &dir = QString(),
+                                          bool recursive = true,
+                                          QDir::Filters filters = QDir::Filters());
+    /// Compress a whole directory asynchronously with the specified method and level.
+    /**
+      \sa compressDir(QString, QString, bool, QDir::Filters, int, int)
+      */
+    static QFuture<bool> compressDirAsync(const QString &fileCompressed,
+                                          const QString &dir,
+                                          bool recursive,
+                                          QDir::Filters filters,
+                                          int method, int level);
+    /// Extract a list of files asynchronously.
+    /**
+      \sa extractFiles(QString, QStringList, QString)
+      */
+    static QFuture<QStringList> extractFilesAsync(const QString &fileCompressed,
+                                                  const QStringList &files,
+                                                  const QString &dir = QString());
+    /// Extract a whole archive asynchronously.
+    /**
+      \sa extractDir(QString, QString)
+      */
+    static QFuture<QStringList> extractDirAsync(const QString &fileCompressed,
+                                                const QString &dir = QString());
+    ///@}
 };
 
 #endif /* JLCOMPRESSFOLDER_H_ */
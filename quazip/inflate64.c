@@ -0,0 +1,574 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+  The decoding follows RFC 1951 and Mark Adler's puff.c, with a lookup
+  table for short codes. Whenever the input runs out in the middle of a
+  symbol, the bits read so far are kept and the same step is retried on
+  the next call, so the state machine never has to split a symbol.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "inflate64.h"
+
+#ifndef local
+#  define local static
+#endif
+
+#define INF64_WSIZE (65536U)
+#define INF64_WMASK (INF64_WSIZE - 1)
+#define INF64_MAXBITS 15
+#define INF64_MAXLCODES 288
+#define INF64_MAXDCODES 32
+#define INF64_FASTBITS 9
+
+typedef enum {
+    INF64_HEAD,         /* the block header */
+    INF64_STORED,       /* the length of a stored block */
+    INF64_COPY,         /* the data of a stored block */
+    INF64_TABLE,        /* the sizes of the dynamic code tables */
+    INF64_LENLENS,      /* the code lengths of the code length code */
+    INF64_CODELENS,     /* the code lengths of the literal/length and distance codes */
+    INF64_LEN,          /* a literal/length symbol */
+    INF64_LENEXT,       /* the extra bits of a length */
+    INF64_DIST,         /* a distance symbol */
+    INF64_DISTEXT,      /* the extra bits of a distance */
+    INF64_MATCH,        /* copying a match */
+    INF64_DONE,
+    INF64_BAD
+} inf64_mode;
+
+typedef struct {
+    unsigned short count[INF64_MAXBITS + 1]; /* the number of codes of each length */
+    unsigned short symbol[INF64_MAXLCODES];  /* the symbols, ordered by their codes */
+    /* (length << 9) | symbol for every code of up to INF64_FASTBITS bits,
+       indexed by the next bits of the input; 0 for longer codes */
+    unsigned short fast[1U << INF64_FASTBITS];
+} inf64_huffman;
+
+struct inflate64_state_s {
+    inf64_mode mode;
+    int last;               /* the current block is the last one */
+    uLong bitbuf;           /* the bits not used yet, at least 32 of them fit */
+    unsigned bitcnt;
+    unsigned length;        /* of the stored block or the match left to copy */
+    unsigned distance;
+    unsigned sym;           /* the length or distance symbol */
+    unsigned nlen, ndist, ncode; /* the sizes of the dynamic tables */
+    unsigned have;          /* the code lengths read so far */
+    unsigned char lens[INF64_MAXLCODES + INF64_MAXDCODES];
+    inf64_huffman lencode;
+    inf64_huffman distcode;
+    unsigned char window[INF64_WSIZE];
+    unsigned wnext;         /* where the next byte goes in the window */
+    uLong whave;            /* the valid bytes in the window, up to INF64_WSIZE */
+};
+
+/* Deflate64 differs from Deflate in the last length and distance codes */
+local const unsigned short inf64_lbase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 3};
+local const unsigned char inf64_lext[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 16};
+local const unsigned short inf64_dbase[32] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577, 32769, 49153};
+local const unsigned char inf64_dext[32] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14};
+local const unsigned char inf64_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/* Returns 0 on success, -1 if the code lengths are over-subscribed. */
+local int inf64_build(inf64_huffman* h, const unsigned char* lens, unsigned n)
+{
+    unsigned short offs[INF64_MAXBITS + 1];
+    unsigned sym, len, i, code, index, rev, fill;
+    int left;
+
+    memset(h->count, 0, sizeof(h->count));
+    memset(h->fast, 0, sizeof(h->fast));
+    for (sym = 0; sym < n; sym++)
+        h->count[lens[sym]]++;
+    h->count[0] = 0;
+
+    left = 1;
+    for (len = 1; len <= INF64_MAXBITS; len++)
+    {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0)
+            return -1;
+    }
+    /* incomplete codes are accepted, the missing codes fail to decode */
+
+    offs[1] = 0;
+    for (len = 1; len < INF64_MAXBITS; len++)
+        offs[len + 1] = (unsigned short)(offs[len] + h->count[len]);
+    for (sym = 0; sym < n; sym++)
+        if (lens[sym] != 0)
+            h->symbol[offs[lens[sym]]++] = (unsigned short)sym;
+
+    /* the codes are stored starting from their first bit, so reversed */
+    code = 0;
+    index = 0;
+    for (len = 1; len <= INF64_FASTBITS; len++)
+    {
+        for (i = 0; i < h->count[len]; i++)
+        {
+            unsigned bit;
+            rev = 0;
+            for (bit = 0; bit < len; bit++)
+                rev |= ((code >> bit) & 1) << (len - 1 - bit);
+            for (fill = rev; fill < (1U << INF64_FASTBITS); fill += 1U << len)
+                h->fast[fill] = (unsigned short)((len << 9) | h->symbol[index]);
+            code++;
+            index++;
+        }
+        code <<= 1;
+    }
+    return 0;
+}
+
+/* Reads input until there are n bits, returns 0 if it runs out first. */
+local int inf64_need(inflate64_state* s, z_streamp strm, unsigned n)
+{
+    while (s->bitcnt < n)
+    {
+        if (strm->avail_in == 0)
+            return 0;
+        s->bitbuf |= (uLong)(*strm->next_in++) << s->bitcnt;
+        strm->avail_in--;
+        strm->total_in++;
+        s->bitcnt += 8;
+    }
+    return 1;
+}
+
+local void inf64_fill(inflate64_state* s, z_streamp strm)
+{
+    while (s->bitcnt <= 24 && strm->avail_in != 0)
+    {
+        s->bitbuf |= (uLong)(*strm->next_in++) << s->bitcnt;
+        strm->avail_in--;
+        strm->total_in++;
+        s->bitcnt += 8;
+    }
+}
+
+local void inf64_drop(inflate64_state* s, unsigned n)
+{
+    s->bitbuf >>= n;
+    s->bitcnt -= n;
+}
+
+/* Returns the next symbol, -1 if more input is needed or -2 if the code is invalid. */
+local int inf64_decode(inflate64_state* s, const inf64_huffman* h)
+{
+    unsigned entry = h->fast[s->bitbuf & ((1U << INF64_FASTBITS) - 1)];
+    uLong bits;
+    int code, first, index, count;
+    unsigned len;
+
+    if (entry != 0)
+    {
+        len = entry >> 9;
+        if (len > s->bitcnt)
+            return -1;
+        inf64_drop(s, len);
+        return (int)(entry & 0x1ff);
+    }
+    bits = s->bitbuf;
+    code = first = index = 0;
+    for (len = 1; len <= INF64_MAXBITS; len++)
+    {
+        if (len > s->bitcnt)
+            return -1;
+        code |= (int)(bits & 1);
+        bits >>= 1;
+        count = h->count[len];
+        if (code - count < first)
+        {
+            inf64_drop(s, len);
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -2;
+}
+
+local void inf64_put(inflate64_state* s, z_streamp strm, unsigned char b)
+{
+    s->window[s->wnext] = b;
+    s->wnext = (s->wnext + 1) & INF64_WMASK;
+    if (s->whave < INF64_WSIZE)
+        s->whave++;
+    *strm->next_out++ = b;
+    strm->avail_out--;
+    strm->total_out++;
+}
+
+local void inf64_put_block(inflate64_state* s, z_streamp strm, const Bytef* data, unsigned len)
+{
+    unsigned done = 0;
+    memcpy(strm->next_out, data, len);
+    strm->next_out += len;
+    strm->avail_out -= len;
+    strm->total_out += len;
+    if (len > INF64_WSIZE)
+    {
+        /* only the end matters */
+        done = len - INF64_WSIZE;
+    }
+    while (done < len)
+    {
+        unsigned chunk = INF64_WSIZE - s->wnext;
+        if (chunk > len - done)
+            chunk = len - done;
+        memcpy(s->window + s->wnext, data + done, chunk);
+        s->wnext = (s->wnext + chunk) & INF64_WMASK;
+        done += chunk;
+    }
+    s->whave += len;
+    if (s->whave > INF64_WSIZE)
+        s->whave = INF64_WSIZE;
+}
+
+local void inf64_fixed(inflate64_state* s)
+{
+    unsigned sym;
+    for (sym = 0; sym < 144; sym++)
+        s->lens[sym] = 8;
+    for (; sym < 256; sym++)
+        s->lens[sym] = 9;
+    for (; sym < 280; sym++)
+        s->lens[sym] = 7;
+    for (; sym < INF64_MAXLCODES; sym++)
+        s->lens[sym] = 8;
+    inf64_build(&s->lencode, s->lens, INF64_MAXLCODES);
+    for (sym = 0; sym < INF64_MAXDCODES; sym++)
+        s->lens[sym] = 5;
+    inf64_build(&s->distcode, s->lens, INF64_MAXDCODES);
+}
+
+/* Reads one code length, returns 0 if more input is needed. */
+local int inf64_codelen(inflate64_state* s, z_streamp strm)
+{
+    uLong bitbuf;
+    unsigned bitcnt;
+    unsigned total = s->nlen + s->ndist;
+    unsigned len = 0, rep, extra, base;
+    int sym;
+
+    inf64_fill(s, strm);
+    bitbuf = s->bitbuf;
+    bitcnt = s->bitcnt;
+    sym = inf64_decode(s, &s->lencode);
+    if (sym == -1)
+        return 0;
+    if (sym < 0)
+    {
+        s->mode = INF64_BAD;
+        return 1;
+    }
+    if (sym < 16)
+    {
+        s->lens[s->have++] = (unsigned char)sym;
+        return 1;
+    }
+    if (sym == 16)
+    {
+        if (s->have == 0)
+        {
+            s->mode = INF64_BAD;
+            return 1;
+        }
+        len = s->lens[s->have - 1];
+        extra = 2;
+        base = 3;
+    }
+    else if (sym == 17)
+    {
+        extra = 3;
+        base = 3;
+    }
+    else
+    {
+        extra = 7;
+        base = 11;
+    }
+    if (!inf64_need(s, strm, extra))
+    {
+        /* the repeat count isn't there yet, start over next time */
+        s->bitbuf = bitbuf;
+        s->bitcnt = bitcnt;
+        return 0;
+    }
+    rep = base + (unsigned)(s->bitbuf & ((1U << extra) - 1));
+    inf64_drop(s, extra);
+    if (s->have + rep > total)
+    {
+        s->mode = INF64_BAD;
+        return 1;
+    }
+    while (rep-- > 0)
+        s->lens[s->have++] = (unsigned char)len;
+    return 1;
+}
+
+extern inflate64_state* inflate64New(void)
+{
+    inflate64_state* s = (inflate64_state*)malloc(sizeof(inflate64_state));
+    if (s == NULL)
+        return NULL;
+    s->mode = INF64_HEAD;
+    s->last = 0;
+    s->bitbuf = 0;
+    s->bitcnt = 0;
+    s->wnext = 0;
+    s->whave = 0;
+    return s;
+}
+
+extern void inflate64Free(inflate64_state* s)
+{
+    free(s);
+}
+
+extern int inflate64(inflate64_state* s, z_streamp strm)
+{
+    int sym;
+    unsigned copy;
+
+    for (;;)
+    {
+        switch (s->mode)
+        {
+        case INF64_HEAD:
+            if (s->last)
+            {
+                s->mode = INF64_DONE;
+                break;
+            }
+            if (!inf64_need(s, strm, 3))
+                return Z_OK;
+            s->last = (int)(s->bitbuf & 1);
+            switch ((s->bitbuf >> 1) & 3)
+            {
+            case 0:
+                inf64_drop(s, 3);
+                inf64_drop(s, s->bitcnt & 7);
+                s->mode = INF64_STORED;
+                break;
+            case 1:
+                inf64_drop(s, 3);
+                inf64_fixed(s);
+                s->mode = INF64_LEN;
+                break;
+            case 2:
+                inf64_drop(s, 3);
+                s->mode = INF64_TABLE;
+                break;
+            default:
+                s->mode = INF64_BAD;
+                break;
+            }
+            break;
+        case INF64_STORED:
+            if (!inf64_need(s, strm, 32))
+                return Z_OK;
+            s->length = (unsigned)(s->bitbuf & 0xffff);
+            if (s->length != ((unsigned)(s->bitbuf >> 16) ^ 0xffff))
+            {
+                s->mode = INF64_BAD;
+                break;
+            }
+            /* in two steps, as uLong may have no more than 32 bits */
+            inf64_drop(s, 16);
+            inf64_drop(s, 16);
+            s->mode = INF64_COPY;
+            break;
+        case INF64_COPY:
+            /* whole bytes may be left in the bit buffer */
+            while (s->length != 0 && s->bitcnt >= 8 && strm->avail_out != 0)
+            {
+                inf64_put(s, strm, (unsigned char)(s->bitbuf & 0xff));
+                inf64_drop(s, 8);
+                s->length--;
+            }
+            copy = s->length;
+            if (copy > strm->avail_in)
+                copy = strm->avail_in;
+            if (copy > strm->avail_out)
+                copy = strm->avail_out;
+            if (copy != 0)
+            {
+                inf64_put_block(s, strm, strm->next_in, copy);
+                strm->next_in += copy;
+                strm->avail_in -= copy;
+                strm->total_in += copy;
+                s->length -= copy;
+            }
+            if (s->length != 0)
+                return Z_OK;
+            s->mode = INF64_HEAD;
+            break;
+        case INF64_TABLE:
+            if (!inf64_need(s, strm, 14))
+                return Z_OK;
+            s->nlen = (unsigned)(s->bitbuf & 0x1f) + 257;
+            s->ndist = (unsigned)((s->bitbuf >> 5) & 0x1f) + 1;
+            s->ncode = (unsigned)((s->bitbuf >> 10) & 0xf) + 4;
+            inf64_drop(s, 14);
+            if (s->nlen > 286)
+            {
+                s->mode = INF64_BAD;
+                break;
+            }
+            s->have = 0;
+            s->mode = INF64_LENLENS;
+            break;
+        case INF64_LENLENS:
+            while (s->have < s->ncode)
+            {
+                if (!inf64_need(s, strm, 3))
+                    return Z_OK;
+                s->lens[inf64_order[s->have++]] = (unsigned char)(s->bitbuf & 7);
+                inf64_drop(s, 3);
+            }
+            while (s->have < 19)
+                s->lens[inf64_order[s->have++]] = 0;
+            /* the code length code is kept in lencode until the real one is built */
+            if (inf64_build(&s->lencode, s->lens, 19) != 0)
+            {
+                s->mode = INF64_BAD;
+                break;
+            }
+            s->have = 0;
+            s->mode = INF64_CODELENS;
+            break;
+        case INF64_CODELENS:
+            while (s->have < s->nlen + s->ndist && s->mode == INF64_CODELENS)
+            {
+                if (!inf64_codelen(s, strm))
+                    return Z_OK;
+            }
+            if (s->mode != INF64_CODELENS)
+                break;
+            if (s->lens[256] == 0
+                || inf64_build(&s->lencode, s->lens, s->nlen) != 0
+                || inf64_build(&s->distcode, s->lens + s->nlen, s->ndist) != 0)
+            {
+                s->mode = INF64_BAD;
+                break;
+            }
+            s->mode = INF64_LEN;
+            break;
+        case INF64_LEN:
+            while (strm->avail_out != 0)
+            {
+                inf64_fill(s, strm);
+                sym = inf64_decode(s, &s->lencode);
+                if (sym == -1)
+                    return Z_OK;
+                if (sym >= 0 && sym < 256)
+                {
+                    inf64_put(s, strm, (unsigned char)sym);
+                    continue;
+                }
+                if (sym < 0)
+                    s->mode = INF64_BAD;
+                else if (sym == 256)
+                    s->mode = INF64_HEAD;
+                else if (sym > 285)
+                    s->mode = INF64_BAD;
+                else
+                {
+                    s->sym = (unsigned)sym - 257;
+                    s->mode = INF64_LENEXT;
+                }
+                break;
+            }
+            if (s->mode == INF64_LEN)
+                return Z_OK;
+            break;
+        case INF64_LENEXT:
+            if (!inf64_need(s, strm, inf64_lext[s->sym]))
+                return Z_OK;
+            s->length = inf64_lbase[s->sym]
+                + (unsigned)(s->bitbuf & ((1UL << inf64_lext[s->sym]) - 1));
+            inf64_drop(s, inf64_lext[s->sym]);
+            s->mode = INF64_DIST;
+            break;
+        case INF64_DIST:
+            inf64_fill(s, strm);
+            sym = inf64_decode(s, &s->distcode);
+            if (sym == -1)
+                return Z_OK;
+            if (sym < 0 || sym >= INF64_MAXDCODES)
+            {
+                s->mode = INF64_BAD;
+                break;
+            }
+            s->sym = (unsigned)sym;
+            s->mode = INF64_DISTEXT;
+            break;
+        case INF64_DISTEXT:
+            if (!inf64_need(s, strm, inf64_dext[s->sym]))
+                return Z_OK;
+            s->distance = inf64_dbase[s->sym]
+                + (unsigned)(s->bitbuf & ((1UL << inf64_dext[s->sym]) - 1));
+            inf64_drop(s, inf64_dext[s->sym]);
+            if (s->distance > s->whave)
+            {
+                /* too far back */
+                s->mode = INF64_BAD;
+                break;
+            }
+            s->mode = INF64_MATCH;
+            break;
+        case INF64_MATCH:
+            while (s->length != 0 && strm->avail_out != 0)
+            {
+                inf64_put(s, strm, s->window[(s->wnext - s->distance) & INF64_WMASK]);
+                s->length--;
+            }
+            if (s->length != 0)
+                return Z_OK;
+            s->mode = INF64_LEN;
+            break;
+        case INF64_DONE:
+            return Z_STREAM_END;
+        default:
+            return Z_DATA_ERROR;
+        }
+    }
+}
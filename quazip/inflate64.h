@@ -0,0 +1,66 @@
+#ifndef QUAZIP_INFLATE64_H
+#define QUAZIP_INFLATE64_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+ * A streaming decompressor for Deflate64 (method 9 in ZIP files), also
+ * known as Enhanced Deflate. It is Deflate with a 64 KB window, length
+ * code 285 taking 16 extra bits and distance codes 30 and 31, which
+ * zlib doesn't support. Only used internally by unzip.c.
+ *
+ * The data is passed through the next_in/avail_in/total_in and
+ * next_out/avail_out/total_out fields of a z_stream, the rest of it is
+ * not used.
+ *
+ * This file must stay valid C, as it is included by unzip.c.
+ */
+
+#include "quazip_zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct inflate64_state_s inflate64_state;
+
+/* Returns a new decompressor, or NULL if out of memory. */
+extern inflate64_state* inflate64New OF((void));
+
+/*
+  Decompresses as much as possible from strm->next_in to strm->next_out.
+  Returns Z_STREAM_END once the last block has been decompressed, Z_OK if
+  more input or output space is needed, or Z_DATA_ERROR if the data is
+  corrupt.
+*/
+extern int inflate64 OF((inflate64_state* state, z_streamp strm));
+
+extern void inflate64Free OF((inflate64_state* state));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QUAZIP_INFLATE64_H */
@@ -44,7 +44,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <zlib.h>
+#include "quazip_zlib.h"
 
 #if defined(USE_FILE32API)
 #define fopen64 fopen
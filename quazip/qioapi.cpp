@@ -11,7 +11,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <zlib.h>
+#include "quazip_zlib.h"
 
 #include "ioapi.h"
 #include "quazip_global.h"
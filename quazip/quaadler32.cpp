@@ -25,7 +25,82 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include "quaadler32.h"
 
-#include <zlib.h>
+#include <QtCore/QList>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include "quazip_adler32.h"
+#include "quazip_zlib.h"
+
+/// \cond internal
+/// The checksum of one part of a large buffer, run by a pool thread.
+class QuaAdler32Job: public QRunnable {
+public:
+    QuaAdler32Job(const Bytef *data, qint64 size, QSemaphore *done);
+    virtual void run();
+    const Bytef *data;
+    qint64 size;
+    // valid once done is acquired
+    uLong adler;
+private:
+    QSemaphore *done;
+};
+/// \endcond
+
+QuaAdler32Job::QuaAdler32Job(const Bytef *data, qint64 size,
+                             QSemaphore *done):
+    data(data), size(size), adler(1), done(done)
+{
+    setAutoDelete(false);
+}
+
+void QuaAdler32Job::run()
+{
+    adler = quazip_adler32(1, data, static_cast<size_t>(size));
+    done->release();
+}
+
+// A pool of its own, as the global one may be busy with the very jobs
+// waiting for the checksums.
+Q_GLOBAL_STATIC(QThreadPool, quaAdler32Pool)
+
+static qint64 quaAdler32ParallelThreshold = 4 * 1024 * 1024;
+
+static quint32 quaAdler32(quint32 adler, const char *data, qint64 size)
+{
+    const Bytef *bytes = reinterpret_cast<const Bytef*>(data);
+    int parts = QThread::idealThreadCount();
+    if (quaAdler32ParallelThreshold <= 0
+            || size < quaAdler32ParallelThreshold || parts < 2) {
+        return static_cast<quint32>(quazip_adler32(adler, bytes,
+                                                   static_cast<size_t>(size)));
+    }
+    // the first parts go to the pool, the last one is done right here
+    qint64 partSize = size / parts;
+    QSemaphore done;
+    QList<QuaAdler32Job*> jobs;
+    for (int i = 0; i < parts - 1; ++i) {
+        QuaAdler32Job *job = new QuaAdler32Job(bytes + i * partSize,
+                                               partSize, &done);
+        jobs.append(job);
+        quaAdler32Pool()->start(job);
+    }
+    qint64 lastOffset = partSize * (parts - 1);
+    uLong last = quazip_adler32(1, bytes + lastOffset,
+                                static_cast<size_t>(size - lastOffset));
+    done.acquire(parts - 1);
+    uLong result = adler;
+    for (int i = 0; i < jobs.size(); ++i) {
+        result = adler32_combine(result, jobs.at(i)->adler,
+                                 static_cast<z_off_t>(partSize));
+    }
+    result = adler32_combine(result, last,
+                             static_cast<z_off_t>(size - lastOffset));
+    qDeleteAll(jobs);
+    return static_cast<quint32>(result);
+}
 
 QuaAdler32::QuaAdler32()
 {
@@ -34,20 +109,40 @@ QuaAdler32::QuaAdler32()
 
 quint32 QuaAdler32::calculate(const QByteArray &data)
 {
-	return adler32( adler32(0L, Z_NULL, 0), (const Bytef*)data.data(), data.size() );
+	return quaAdler32(1, data.constData(), data.size());
+}
+
+quint32 QuaAdler32::calculate(const char *data, qint64 size)
+{
+	return quaAdler32(1, data, size);
 }
 
 void QuaAdler32::reset()
 {
-	checksum = adler32(0L, Z_NULL, 0);
+	checksum = 1;
 }
 
 void QuaAdler32::update(const QByteArray &buf)
 {
-	checksum = adler32( checksum, (const Bytef*)buf.data(), buf.size() );
+	checksum = quaAdler32(checksum, buf.constData(), buf.size());
+}
+
+void QuaAdler32::update(const char *data, qint64 size)
+{
+	checksum = quaAdler32(checksum, data, size);
 }
 
 quint32 QuaAdler32::value()
 {
 	return checksum;
 }
+
+void QuaAdler32::setParallelThreshold(qint64 bytes)
+{
+	quaAdler32ParallelThreshold = bytes;
+}
+
+qint64 QuaAdler32::parallelThreshold()
+{
+	return quaAdler32ParallelThreshold;
+}
@@ -34,6 +34,12 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 /** \class QuaAdler32 quaadler32.h <quazip/quaadler32.h>
  * This class wrappers the adler32 function with the QuaChecksum32 interface.
  * See QuaChecksum32 for more info.
+ *
+ * The checksum is calculated with AVX2, SSSE3 or NEON instructions when
+ * the CPU has them, giving the same values as zlib's adler32(). Buffers
+ * of parallelThreshold() bytes or more are split between several
+ * threads, and the checksums of the parts are combined with
+ * adler32_combine().
  */
 class QUAZIP_EXPORT QuaAdler32 : public QuaChecksum32
 {
@@ -42,11 +48,21 @@ public:
 	QuaAdler32();
 
 	quint32 calculate(const QByteArray &data);
+	quint32 calculate(const char *data, qint64 size);
 
 	void reset();
 	void update(const QByteArray &buf);
+	void update(const char *data, qint64 size);
 	quint32 value();
 
+	/// Sets the smallest buffer checksummed by several threads.
+	/** The default is 4 MB. Zero or a negative value disables the
+	 * threads. Affects all instances, so set it before they are used.
+	 */
+	static void setParallelThreshold(qint64 bytes);
+	/// Returns the smallest buffer checksummed by several threads.
+	static qint64 parallelThreshold();
+
 private:
 	quint32 checksum;
 };
@@ -1,5 +1,27 @@
 #include "quachecksum32.h"
 
+#include <climits>
+
 QuaChecksum32::~QuaChecksum32()
 {
 }
+
+quint32 QuaChecksum32::calculate(const char *data, qint64 size)
+{
+    if (size > INT_MAX) {
+        qWarning("QuaChecksum32::calculate(): can't wrap %lld bytes"
+                 " into a QByteArray", static_cast<long long>(size));
+        return 0;
+    }
+    return calculate(QByteArray::fromRawData(data, static_cast<int>(size)));
+}
+
+void QuaChecksum32::update(const char *data, qint64 size)
+{
+    while (size > 0) {
+        int chunk = static_cast<int>(qMin(size, static_cast<qint64>(INT_MAX)));
+        update(QByteArray::fromRawData(data, chunk));
+        data += chunk;
+        size -= chunk;
+    }
+}
@@ -70,6 +70,25 @@ public:
 	 */
 	virtual void update(const QByteArray &buf) = 0;
 
+	///Calculates the checksum for \a size bytes at \a data.
+	/** Same as calculate(const QByteArray&), for data that isn't in a
+	 * QByteArray, such as a raw or memory-mapped buffer.
+	 *
+	 * This version wraps the data into QByteArray::fromRawData(),
+	 * without copying it, and passes it to the virtual function, so it
+	 * works with any implementation, but only for up to INT_MAX bytes.
+	 * QuaCrc32 and QuaAdler32 have versions of their own working on the
+	 * pointer directly, used when called through them.
+	 */
+	quint32 calculate(const char *data, qint64 size);
+
+	///Updates the calculated checksum with \a size bytes at \a data.
+	/** Same as update(const QByteArray&), for data that isn't in a
+	 * QByteArray. Like calculate(const char*, qint64), it doesn't copy
+	 * the data, and there is no limit on the size.
+	 */
+	void update(const char *data, qint64 size);
+
 	///Value of the checksum calculated for the stream passed throw update().
 	/** \return checksum
 	 */
@@ -0,0 +1,158 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "quachecksumiodevice.h"
+
+#include "quachecksum32.h"
+
+/// \cond internal
+class QuaChecksumIODevicePrivate {
+    friend class QuaChecksumIODevice;
+private:
+    QuaChecksumIODevicePrivate(QIODevice *io, QuaChecksum32 *checksum);
+    QIODevice *io;
+    QuaChecksum32 *checksum;
+    qint64 total;
+};
+
+QuaChecksumIODevicePrivate::QuaChecksumIODevicePrivate(QIODevice *io,
+        QuaChecksum32 *checksum):
+    io(io),
+    checksum(checksum),
+    total(0)
+{
+}
+/// \endcond
+
+QuaChecksumIODevice::QuaChecksumIODevice(QIODevice *io,
+        QuaChecksum32 *checksum, QObject *parent):
+    QIODevice(parent),
+    d(new QuaChecksumIODevicePrivate(io, checksum))
+{
+    connect(io, SIGNAL(readyRead()), SIGNAL(readyRead()));
+    connect(io, SIGNAL(bytesWritten(qint64)), SIGNAL(bytesWritten(qint64)));
+}
+
+QuaChecksumIODevice::~QuaChecksumIODevice()
+{
+    if (isOpen())
+        close();
+    delete d;
+}
+
+QIODevice *QuaChecksumIODevice::getIoDevice() const
+{
+    return d->io;
+}
+
+QuaChecksum32 *QuaChecksumIODevice::getChecksum() const
+{
+    return d->checksum;
+}
+
+qint64 QuaChecksumIODevice::totalBytes() const
+{
+    return d->total;
+}
+
+bool QuaChecksumIODevice::open(QIODevice::OpenMode mode)
+{
+    if ((mode & QIODevice::ReadWrite) == QIODevice::ReadWrite) {
+        setErrorString(tr("QIODevice::ReadWrite is not supported for"
+                    " QuaChecksumIODevice"));
+        return false;
+    }
+    if ((mode & QIODevice::ReadWrite) == 0) {
+        setErrorString(tr("Neither QIODevice::ReadOnly nor"
+                    " QIODevice::WriteOnly given to QuaChecksumIODevice"));
+        return false;
+    }
+    if ((d->io->openMode() & mode & QIODevice::ReadWrite) == 0) {
+        setErrorString(tr("The underlying device is not open in the"
+                    " requested mode"));
+        return false;
+    }
+    d->checksum->reset();
+    d->total = 0;
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void QuaChecksumIODevice::close()
+{
+    QIODevice::close();
+}
+
+qint64 QuaChecksumIODevice::readData(char *data, qint64 maxSize)
+{
+    qint64 read = d->io->read(data, maxSize);
+    if (read < 0) {
+        setErrorString(d->io->errorString());
+        return -1;
+    }
+    d->checksum->update(data, read);
+    d->total += read;
+    return read;
+}
+
+qint64 QuaChecksumIODevice::writeData(const char *data, qint64 maxSize)
+{
+    qint64 written = d->io->write(data, maxSize);
+    if (written < 0) {
+        setErrorString(d->io->errorString());
+        return -1;
+    }
+    d->checksum->update(data, written);
+    d->total += written;
+    return written;
+}
+
+bool QuaChecksumIODevice::isSequential() const
+{
+    return true;
+}
+
+bool QuaChecksumIODevice::atEnd() const
+{
+    return (openMode() == NotOpen) || d->io->atEnd();
+}
+
+qint64 QuaChecksumIODevice::bytesAvailable() const
+{
+    return d->io->bytesAvailable() + QIODevice::bytesAvailable();
+}
+
+qint64 QuaChecksumIODevice::bytesToWrite() const
+{
+    return d->io->bytesToWrite();
+}
+
+bool QuaChecksumIODevice::waitForReadyRead(int msecs)
+{
+    return d->io->waitForReadyRead(msecs);
+}
+
+bool QuaChecksumIODevice::waitForBytesWritten(int msecs)
+{
+    return d->io->waitForBytesWritten(msecs);
+}
@@ -0,0 +1,114 @@
+#ifndef QUAZIP_QUACHECKSUMIODEVICE_H
+#define QUAZIP_QUACHECKSUMIODEVICE_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QIODevice>
+
+#include "quazip_global.h"
+
+class QuaChecksum32;
+class QuaChecksumIODevicePrivate;
+
+/// A device computing the checksum of the data passing through it.
+/** \class QuaChecksumIODevice quachecksumiodevice.h <quazip/quachecksumiodevice.h>
+ * Wraps another device and passes all reads and writes on to it, adding
+ * every byte read or written to a checksum on the way. This gives the
+ * checksum of a download or of an upload in the same pass that stores
+ * or sends it, without reading the data a second time:
+ * \code
+ * QuaCrc32 crc;
+ * QuaZipFile entry(&zip);
+ * entry.open(QIODevice::WriteOnly, QuaZipNewInfo("upload.bin"));
+ * QuaChecksumIODevice checked(&entry, &crc);
+ * checked.open(QIODevice::WriteOnly);
+ * while (socket->bytesAvailable() > 0)
+ *     checked.write(socket->read(65536));
+ * checked.close();
+ * entry.close();
+ * // crc.value() is the checksum of everything written
+ * \endcode
+ *
+ * Only the bytes actually transferred by the underlying device count: a
+ * short write adds only the bytes it accepted. The device is always open
+ * in the QIODevice::Unbuffered mode, so nothing is read ahead that the
+ * caller hasn't got yet.
+ *
+ * Neither the underlying device nor the checksum is owned by this one.
+ */
+class QUAZIP_EXPORT QuaChecksumIODevice: public QIODevice {
+  friend class QuaChecksumIODevicePrivate;
+  Q_OBJECT
+public:
+  /// Constructor.
+  /**
+    \param io The QIODevice to read/write, opened by the caller.
+    \param checksum The checksum to update, QuaCrc32 or QuaAdler32 for
+    example.
+    \param parent The parent object, as per QObject logic.
+    */
+  QuaChecksumIODevice(QIODevice *io, QuaChecksum32 *checksum,
+                      QObject *parent = nullptr);
+  /// Destructor.
+  ~QuaChecksumIODevice();
+  /// Opens the device and resets the checksum.
+  /**
+    \param mode Either QIODevice::ReadOnly or QIODevice::WriteOnly,
+    possibly with QIODevice::Append; the checksum covers a single
+    direction, so QIODevice::ReadWrite is not supported. The
+    underlying device must be already open in this mode.
+    QIODevice::Unbuffered is always added.
+    */
+  virtual bool open(QIODevice::OpenMode mode);
+  /// Closes this device, but not the underlying one.
+  virtual void close();
+  /// Returns the underlying device.
+  QIODevice *getIoDevice() const;
+  /// Returns the checksum updated by this device.
+  QuaChecksum32 *getChecksum() const;
+  /// Returns the number of bytes passed through since open().
+  qint64 totalBytes() const;
+  /// Returns true.
+  virtual bool isSequential() const;
+  /// Returns true if the underlying device is at its end.
+  virtual bool atEnd() const;
+  /// Returns the number of bytes available from the underlying device.
+  virtual qint64 bytesAvailable() const;
+  /// Returns the number of bytes waiting in the underlying device.
+  virtual qint64 bytesToWrite() const;
+  /// Waits for the underlying device.
+  virtual bool waitForReadyRead(int msecs);
+  /// Waits for the underlying device.
+  virtual bool waitForBytesWritten(int msecs);
+protected:
+  /// Implementation of QIODevice::readData().
+  virtual qint64 readData(char *data, qint64 maxSize);
+  /// Implementation of QIODevice::writeData().
+  virtual qint64 writeData(const char *data, qint64 maxSize);
+private:
+  QuaChecksumIODevicePrivate *d;
+};
+
+#endif // QUAZIP_QUACHECKSUMIODEVICE_H
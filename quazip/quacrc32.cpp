@@ -24,7 +24,7 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include "quacrc32.h"
 
-#include <zlib.h>
+#include "quazip_crc32.h"
 
 QuaCrc32::QuaCrc32()
 {
@@ -33,17 +33,27 @@ QuaCrc32::QuaCrc32()
 
 quint32 QuaCrc32::calculate(const QByteArray &data)
 {
-	return crc32( crc32(0L, Z_NULL, 0), (const Bytef*)data.data(), data.size() );
+	return quazip_crc32( 0L, (const Bytef*)data.data(), data.size() );
+}
+
+quint32 QuaCrc32::calculate(const char *data, qint64 size)
+{
+	return quazip_crc32( 0L, (const Bytef*)data, (size_t)size );
 }
 
 void QuaCrc32::reset()
 {
-	checksum = crc32(0L, Z_NULL, 0);
+	checksum = 0;
 }
 
 void QuaCrc32::update(const QByteArray &buf)
 {
-	checksum = crc32( checksum, (const Bytef*)buf.data(), buf.size() );
+	checksum = quazip_crc32( checksum, (const Bytef*)buf.data(), buf.size() );
+}
+
+void QuaCrc32::update(const char *data, qint64 size)
+{
+	checksum = quazip_crc32( checksum, (const Bytef*)data, (size_t)size );
 }
 
 quint32 QuaCrc32::value()
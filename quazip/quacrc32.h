@@ -31,6 +31,11 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 /** \class QuaCrc32 quacrc32.h <quazip/quacrc32.h>
 * This class wrappers the crc32 function with the QuaChecksum32 interface.
 * See QuaChecksum32 for more info.
+*
+* The checksum is the same as zlib's, but computed with the CPU's own
+* instructions where available: PCLMULQDQ on x86 and x86-64, the CRC32
+* instructions on ARMv8. The rest of %QuaZip uses the same code for the
+* CRC of the entries it reads and writes.
 */
 class QUAZIP_EXPORT QuaCrc32 : public QuaChecksum32 {
 
@@ -38,9 +43,11 @@ public:
 	QuaCrc32();
 
 	quint32 calculate(const QByteArray &data);
+	quint32 calculate(const char *data, qint64 size);
 
 	void reset();
 	void update(const QByteArray &buf);
+	void update(const char *data, qint64 size);
 	quint32 value();
 
 private:
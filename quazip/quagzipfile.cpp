@@ -23,21 +23,929 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
 #include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
 
 #include "quagzipfile.h"
+#include "quazip_blockdeflater.h"
+#include "quazip_crc32.h"
 
 /// \cond internal
+/// One member of a blocked GZIP file, inflated by a pool thread.
+class QuaGzipFileInflateJob: public QRunnable {
+public:
+    QuaGzipFileInflateJob(const QByteArray &member, qint64 address);
+    virtual void run();
+    QByteArray member;
+    qint64 address;
+    qint64 memberSize;
+    // the results, valid once done is acquired
+    QByteArray data;
+    bool ok;
+    QSemaphore done;
+};
+
+/// Compresses a GZIP file by several threads.
+/**
+  A single member, deflated by QuaBlockDeflater, or in the blocked
+  format, every block a complete GZIP member without a dictionary, and
+  the file ending with an empty one. The output goes to the device as
+  soon as it's compressed.
+  */
+class QuaGzipFileWriter: public QuaBlockDeflater {
+public:
+    QuaGzipFileWriter(QIODevice *device, int threads, bool blocked);
+protected:
+    virtual bool appendBlock(const QuaBlockDeflateJob &job);
+    virtual bool appendTrailer();
+    virtual bool writeOutput();
+private:
+    Q_DISABLE_COPY(QuaGzipFileWriter)
+    QIODevice *device;
+};
+
+/// Reads a blocked GZIP file, inflating the next members ahead.
+/**
+  The members are read in the calling thread, which is cheap, as each
+  header tells the size of the member, and inflated by the pool. A
+  position in the file is given by a virtual offset: the address of the
+  member in the file shifted 16 bits left, plus the position in its
+  uncompressed data, which is never more than 64 KB.
+  */
+class QuaGzipFileReader {
+public:
+    QuaGzipFileReader(QIODevice *device, int threads);
+    ~QuaGzipFileReader();
+    qint64 read(char *data, qint64 maxSize);
+    qint64 virtualOffset() const;
+    bool atEnd() const;
+    bool seek(qint64 virtualOffset);
+private:
+    Q_DISABLE_COPY(QuaGzipFileReader)
+    QIODevice *device;
+    int threads;
+    QThreadPool pool;
+    QList<QuaGzipFileInflateJob*> jobs;
+    // where to read the next member to inflate from
+    qint64 nextAddress;
+    // no more members to inflate
+    bool ended;
+    bool error;
+    // the current member
+    QByteArray block;
+    int blockPos;
+    qint64 blockAddress;
+    qint64 blockEnd;
+    void fill();
+    bool nextBlock();
+    void discard();
+};
+
+/// Reads an ordinary GZIP file, possibly keeping an index.
+/**
+  The members are inflated one after another, with inflate handling the
+  GZIP headers and trailers. For a sequential device, running out of the
+  input means that the rest hasn't arrived yet, rather than the end.
+
+  To allow random access, the index is kept with the technique of zran.c
+  from the zlib examples, unless the span is 0 or the device is
+  sequential. The data is
+  inflated block by block, and once every span bytes of the uncompressed
+  data, at a deflate block boundary, an access point is added: the
+  positions in both the compressed and the uncompressed data, the bits of
+  the block left in the previous byte and the last 32 KB of the output,
+  which is all the state inflate needs to start over from there. A seek
+  then starts from the closest access point before the target.
+
+  The access points are added whenever the data is inflated beyond the
+  last one, so the index grows as the file is read, and is complete once
+  the end is reached once. A complete index may be saved into a file and
+  loaded from it later.
+  */
+class QuaGzipFileInflater {
+public:
+    QuaGzipFileInflater(QIODevice *device, int bufferSize, qint64 span,
+                        const QString &indexFileName);
+    ~QuaGzipFileInflater();
+    inline bool isIndexed() const {return span > 0;}
+    qint64 read(char *data, qint64 maxSize);
+    bool seek(qint64 pos);
+    bool build();
+    bool atEnd() const;
+    /// The uncompressed size, or 0 if not known yet.
+    qint64 size() const;
+private:
+    Q_DISABLE_COPY(QuaGzipFileInflater)
+    enum {
+        WindowSize = 32 * 1024
+    };
+    struct AccessPoint {
+        qint64 out;
+        qint64 in;
+        int bits;
+        QByteArray window;
+    };
+    QIODevice *device;
+    qint64 span;
+    QString indexFileName;
+    qint64 start;
+    QList<AccessPoint> points;
+    bool complete;
+    qint64 total;
+    z_stream stream;
+    // whether inflating raw deflate data, after starting at a point
+    bool raw;
+    QByteArray input;
+    qint64 inputPos;
+    bool inputEnd;
+    // the last 32 KB of the output, rotated through
+    QByteArray window;
+    int windowPos;
+    int history;
+    qint64 out;
+    bool ended;
+    bool error;
+    void restart();
+    void restart(const AccessPoint &point);
+    void fillInput();
+    bool nextMember();
+    bool startMember();
+    void addPoint();
+    QByteArray fingerprint() const;
+    bool load();
+    bool save() const;
+};
+
+/// Compresses a GZIP file in the calling thread.
+/**
+  Unlike gzwrite(), works with any device: deflate writes the GZIP header
+  and trailer itself.
+  */
+class QuaGzipFileDeflater {
+public:
+    QuaGzipFileDeflater(QIODevice *device, int bufferSize);
+    ~QuaGzipFileDeflater();
+    bool write(const char *data, qint64 size);
+    bool flush();
+    bool finish();
+private:
+    Q_DISABLE_COPY(QuaGzipFileDeflater)
+    QIODevice *device;
+    z_stream stream;
+    QByteArray output;
+    bool error;
+    bool run(int flush);
+};
+
+/// The size of the header of a blocked GZIP member.
+#define QUAGZIP_BLOCK_HEADER_SIZE 18
+/// The largest blocked GZIP member.
+#define QUAGZIP_BLOCK_MAX_SIZE 0x10000
+/// The data in a member, small enough for any deflate output to fit.
+#define QUAGZIP_BLOCK_DATA_SIZE 0xFF00
+/// The default size of the buffers for the compressed data.
+#define QUAGZIP_DEFAULT_BUFFER_SIZE (64 * 1024)
+
+static quint32 quagzip_get_uint16(const char *data)
+{
+    return static_cast<quint32>(static_cast<uchar>(data[0]))
+        | (static_cast<quint32>(static_cast<uchar>(data[1])) << 8);
+}
+
+static quint32 quagzip_get_uint32(const char *data)
+{
+    return quagzip_get_uint16(data) | (quagzip_get_uint16(data + 2) << 16);
+}
+
+static void quagzip_put_uint32(QByteArray *data, quint32 value)
+{
+    for (int i = 0; i < 4; ++i)
+        data->append(static_cast<char>((value >> (i * 8)) & 0xFF));
+}
+
+/// Returns the size of a blocked member, or 0 if it is not one.
+/**
+  Only looks at the fixed part of the header, which the blocked members
+  have, as they have no name, comment or header CRC, and at the first
+  extra subfield, which must be the "BC" one.
+  */
+static qint64 quagzip_block_size(const char *header)
+{
+    const uchar *h = reinterpret_cast<const uchar*>(header);
+    if (h[0] != 0x1F || h[1] != 0x8B || h[2] != Z_DEFLATED
+            || (h[3] & 0xFE) != 0x04 // FEXTRA only, maybe FTEXT
+            || quagzip_get_uint16(header + 10) < 6
+            || h[12] != 'B' || h[13] != 'C'
+            || quagzip_get_uint16(header + 14) != 2)
+        return 0;
+    return static_cast<qint64>(quagzip_get_uint16(header + 16)) + 1;
+}
+
+QuaGzipFileInflateJob::QuaGzipFileInflateJob(const QByteArray &member,
+        qint64 address):
+    member(member), address(address), memberSize(member.size()), ok(false)
+{
+    setAutoDelete(false);
+}
+
+void QuaGzipFileInflateJob::run()
+{
+    const char *bytes = member.constData();
+    // the header is checked already, the deflate stream follows the
+    // extra field
+    int start = 12 + static_cast<int>(quagzip_get_uint16(bytes + 10));
+    int end = member.size() - 8;
+    if (start <= end) {
+        quint32 size = quagzip_get_uint32(bytes + end + 4);
+        if (size <= QUAGZIP_BLOCK_MAX_SIZE) {
+            data.resize(static_cast<int>(size));
+            z_stream stream;
+            stream.zalloc = (alloc_func) nullptr;
+            stream.zfree = (free_func) nullptr;
+            stream.opaque = nullptr;
+            stream.next_in = reinterpret_cast<Bytef*>(
+                    const_cast<char*>(bytes + start));
+            stream.avail_in = static_cast<uInt>(end - start);
+            if (inflateInit2(&stream, -MAX_WBITS) == Z_OK) {
+                stream.next_out = reinterpret_cast<Bytef*>(data.data());
+                stream.avail_out = static_cast<uInt>(data.size());
+                ok = inflate(&stream, Z_FINISH) == Z_STREAM_END
+                    && stream.total_out == size;
+                inflateEnd(&stream);
+            }
+            ok = ok && quazip_crc32(0,
+                    reinterpret_cast<const Bytef*>(data.constData()),
+                    static_cast<size_t>(data.size()))
+                == quagzip_get_uint32(bytes + end);
+        }
+    }
+    if (!ok)
+        data = QByteArray();
+    member = QByteArray();
+    done.release();
+}
+
+QuaGzipFileWriter::QuaGzipFileWriter(QIODevice *device, int threads,
+                                     bool blocked):
+    QuaBlockDeflater(QuaBlockDeflaterGzip, threads,
+                     blocked ? QUAGZIP_BLOCK_DATA_SIZE : BlockSize, blocked),
+    device(device)
+{
+    if (!blocked) {
+        // no name, no time stamp, unknown OS
+        static const char header[] = {
+            '\x1F', '\x8B', Z_DEFLATED, 0, 0, 0, 0, 0, 0, '\xFF'
+        };
+        output = QByteArray(header, sizeof(header));
+    }
+}
+
+bool QuaGzipFileWriter::appendBlock(const QuaBlockDeflateJob &job)
+{
+    if (!independent)
+        return QuaBlockDeflater::appendBlock(job);
+    if (!job.ok)
+        return false;
+    int memberSize = QUAGZIP_BLOCK_HEADER_SIZE + job.compressed.size() + 8;
+    if (memberSize > QUAGZIP_BLOCK_MAX_SIZE)
+        return false;
+    // FEXTRA with a single "BC" subfield holding the member size - 1
+    static const char header[] = {
+        '\x1F', '\x8B', Z_DEFLATED, 4, 0, 0, 0, 0, 0, '\xFF',
+        6, 0, 'B', 'C', 2, 0
+    };
+    output.append(header, sizeof(header));
+    output.append(static_cast<char>((memberSize - 1) & 0xFF));
+    output.append(static_cast<char>((memberSize - 1) >> 8));
+    output.append(job.compressed);
+    quagzip_put_uint32(&output, static_cast<quint32>(job.checksum));
+    quagzip_put_uint32(&output, static_cast<quint32>(job.size));
+    return true;
+}
+
+bool QuaGzipFileWriter::appendTrailer()
+{
+    if (!independent)
+        return QuaBlockDeflater::appendTrailer();
+    // the empty member that tells the readers the file is complete
+    QuaBlockDeflateJob job(QByteArray(), QByteArray(), true, format);
+    job.run();
+    return appendBlock(job);
+}
+
+bool QuaGzipFileWriter::writeOutput()
+{
+    if (output.isEmpty())
+        return true;
+    bool ok = device->write(output) == output.size();
+    output.clear();
+    return ok;
+}
+
+QuaGzipFileReader::QuaGzipFileReader(QIODevice *device, int threads):
+    device(device),
+    threads(threads),
+    nextAddress(device->pos()),
+    ended(false),
+    error(false),
+    blockPos(0),
+    blockAddress(nextAddress),
+    blockEnd(nextAddress)
+{
+    pool.setMaxThreadCount(threads);
+}
+
+QuaGzipFileReader::~QuaGzipFileReader()
+{
+    discard();
+}
+
+qint64 QuaGzipFileReader::read(char *data, qint64 maxSize)
+{
+    qint64 done = 0;
+    while (done < maxSize) {
+        if (blockPos == block.size()) {
+            if (!nextBlock())
+                break;
+            continue;
+        }
+        int count = static_cast<int>(qMin(static_cast<qint64>(
+                block.size() - blockPos), maxSize - done));
+        memcpy(data + done, block.constData() + blockPos,
+               static_cast<size_t>(count));
+        blockPos += count;
+        done += count;
+    }
+    return done == 0 && error ? -1 : done;
+}
+
+qint64 QuaGzipFileReader::virtualOffset() const
+{
+    if (blockPos == block.size())
+        return blockEnd << 16;
+    return (blockAddress << 16) | blockPos;
+}
+
+bool QuaGzipFileReader::atEnd() const
+{
+    // the members still queued may be empty, then reading gets here
+    return error || (ended && jobs.isEmpty() && blockPos == block.size());
+}
+
+bool QuaGzipFileReader::seek(qint64 virtualOffset)
+{
+    discard();
+    nextAddress = virtualOffset >> 16;
+    int pos = static_cast<int>(virtualOffset & 0xFFFF);
+    ended = false;
+    error = false;
+    block.clear();
+    blockPos = 0;
+    blockAddress = blockEnd = nextAddress;
+    if (!nextBlock())
+        return pos == 0 && !error;
+    if (pos > block.size())
+        return false;
+    blockPos = pos;
+    return true;
+}
+
+void QuaGzipFileReader::fill()
+{
+    while (!ended && !error && jobs.size() < threads * 2) {
+        if (device->pos() != nextAddress && !device->seek(nextAddress)) {
+            error = true;
+            break;
+        }
+        QByteArray member = device->read(QUAGZIP_BLOCK_HEADER_SIZE);
+        if (member.isEmpty()) {
+            ended = true;
+            break;
+        }
+        qint64 size = member.size() == QUAGZIP_BLOCK_HEADER_SIZE
+            ? quagzip_block_size(member.constData()) : 0;
+        if (size < QUAGZIP_BLOCK_HEADER_SIZE + 8) {
+            error = true;
+            break;
+        }
+        member += device->read(size - QUAGZIP_BLOCK_HEADER_SIZE);
+        if (member.size() != size) {
+            error = true;
+            break;
+        }
+        QuaGzipFileInflateJob *job = new QuaGzipFileInflateJob(member,
+                nextAddress);
+        nextAddress += size;
+        jobs.append(job);
+        pool.start(job);
+    }
+}
+
+bool QuaGzipFileReader::nextBlock()
+{
+    fill();
+    if (jobs.isEmpty())
+        return false;
+    QuaGzipFileInflateJob *job = jobs.takeFirst();
+    job->done.acquire();
+    bool ok = job->ok;
+    if (ok) {
+        block = job->data;
+        blockPos = 0;
+        blockAddress = job->address;
+        blockEnd = job->address + job->memberSize;
+    } else {
+        error = true;
+    }
+    delete job;
+    if (ok)
+        fill();
+    return ok;
+}
+
+void QuaGzipFileReader::discard()
+{
+    pool.waitForDone();
+    qDeleteAll(jobs);
+    jobs.clear();
+}
+
+static void quagzip_put_uint64(QByteArray *data, quint64 value)
+{
+    quagzip_put_uint32(data, static_cast<quint32>(value));
+    quagzip_put_uint32(data, static_cast<quint32>(value >> 32));
+}
+
+static quint64 quagzip_get_uint64(const char *data)
+{
+    return quagzip_get_uint32(data)
+        | (static_cast<quint64>(quagzip_get_uint32(data + 4)) << 32);
+}
+
+/// The first bytes of an index file, followed by the format version.
+#define QUAGZIP_INDEX_MAGIC "QuaGzIdx"
+#define QUAGZIP_INDEX_VERSION 2
+
+QuaGzipFileInflater::QuaGzipFileInflater(QIODevice *device, int bufferSize,
+                                         qint64 span,
+                                         const QString &indexFileName):
+    device(device),
+    span(device->isSequential() ? 0 : span),
+    indexFileName(indexFileName),
+    start(device->pos()),
+    complete(false),
+    total(0),
+    raw(false),
+    input(bufferSize, '\0'),
+    inputPos(start),
+    inputEnd(false),
+    window(WindowSize, '\0'),
+    windowPos(0),
+    history(0),
+    out(0),
+    ended(false),
+    error(false)
+{
+    stream.zalloc = (alloc_func) nullptr;
+    stream.zfree = (free_func) nullptr;
+    stream.opaque = nullptr;
+    stream.next_in = nullptr;
+    stream.avail_in = 0;
+    error = inflateInit2(&stream, MAX_WBITS + 16) != Z_OK;
+    if (isIndexed() && !indexFileName.isEmpty()
+            && QFile::exists(indexFileName) && !load())
+        qWarning("QuaGzipFile: ignoring an invalid or outdated index %s",
+                 QFile::encodeName(indexFileName).constData());
+}
+
+QuaGzipFileInflater::~QuaGzipFileInflater()
+{
+    inflateEnd(&stream);
+}
+
+qint64 QuaGzipFileInflater::read(char *data, qint64 maxSize)
+{
+    if (ended && !error && device->isSequential()) {
+        // another member may have arrived since
+        if (stream.avail_in == 0)
+            fillInput();
+        if (stream.avail_in != 0 && startMember())
+            ended = false;
+    }
+    qint64 done = 0;
+    while (done < maxSize && !ended && !error) {
+        if (stream.avail_in == 0)
+            fillInput();
+        if (windowPos == WindowSize)
+            windowPos = 0;
+        uInt avail = static_cast<uInt>(qMin(static_cast<qint64>(
+                WindowSize - windowPos), maxSize - done));
+        stream.next_out = reinterpret_cast<Bytef*>(window.data())
+            + windowPos;
+        stream.avail_out = avail;
+        // stop at the block boundaries, where access points may be added
+        int result = inflate(&stream,
+                isIndexed() && !complete ? Z_BLOCK : Z_NO_FLUSH);
+        int count = static_cast<int>(avail - stream.avail_out);
+        if (data != nullptr) {
+            memcpy(data + done, window.constData() + windowPos,
+                   static_cast<size_t>(count));
+        }
+        windowPos += count;
+        history = qMin(history + count, static_cast<int>(WindowSize));
+        out += count;
+        done += count;
+        if (result == Z_BUF_ERROR && !(stream.avail_in == 0 && inputEnd))
+            continue;
+        // nothing more for now
+        if (result == Z_BUF_ERROR && device->isSequential())
+            break;
+        if (result != Z_OK && result != Z_STREAM_END) {
+            // corrupt or truncated
+            error = true;
+            break;
+        }
+        if (isIndexed() && !complete && (stream.data_type & 0xC0) == 0x80
+                && out >= (points.isEmpty() ? 0 : points.last().out) + span)
+            addPoint();
+        if (result == Z_STREAM_END && !nextMember())
+            break;
+    }
+    return done == 0 && error ? -1 : done;
+}
+
+bool QuaGzipFileInflater::seek(qint64 pos)
+{
+    if (pos < 0 || (complete && pos > total))
+        return false;
+    // the last point at or before pos
+    int lo = -1, hi = points.size();
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (points.at(mid).out <= pos)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    qint64 closest = lo >= 0 ? points.at(lo).out : 0;
+    // keep going if that's where we are, restart otherwise
+    if (error || out > pos || out < closest) {
+        if (lo >= 0)
+            restart(points.at(lo));
+        else
+            restart();
+    }
+    while (out < pos && !ended && !error) {
+        if (read(nullptr, pos - out) <= 0)
+            break;
+    }
+    return out == pos;
+}
+
+bool QuaGzipFileInflater::build()
+{
+    if (complete)
+        return true;
+    qint64 pos = out;
+    // no need to inflate again what is indexed already
+    if (!points.isEmpty() && points.last().out > out)
+        seek(points.last().out);
+    while (!ended && !error) {
+        if (read(nullptr, WindowSize) <= 0)
+            break;
+    }
+    return seek(pos) && complete;
+}
+
+bool QuaGzipFileInflater::atEnd() const
+{
+    return complete ? out >= total : ended || error;
+}
+
+qint64 QuaGzipFileInflater::size() const
+{
+    return complete ? total : 0;
+}
+
+void QuaGzipFileInflater::restart()
+{
+    device->seek(start);
+    inputPos = start;
+    inputEnd = false;
+    stream.avail_in = 0;
+    error = inflateReset2(&stream, MAX_WBITS + 16) != Z_OK;
+    raw = false;
+    windowPos = 0;
+    history = 0;
+    out = 0;
+    ended = false;
+}
+
+void QuaGzipFileInflater::restart(const AccessPoint &point)
+{
+    qint64 pos = point.in - (point.bits != 0 ? 1 : 0);
+    error = !device->seek(pos)
+        || inflateReset2(&stream, -MAX_WBITS) != Z_OK;
+    inputPos = pos;
+    inputEnd = false;
+    stream.avail_in = 0;
+    if (!error && point.bits != 0) {
+        // the rest of the byte the previous block ends in
+        fillInput();
+        error = stream.avail_in == 0 || inflatePrime(&stream, point.bits,
+                *stream.next_in >> (8 - point.bits)) != Z_OK;
+        if (!error) {
+            ++stream.next_in;
+            --stream.avail_in;
+        }
+    }
+    if (!error && !point.window.isEmpty()) {
+        error = inflateSetDictionary(&stream,
+                reinterpret_cast<const Bytef*>(point.window.constData()),
+                static_cast<uInt>(point.window.size())) != Z_OK;
+    }
+    // the window ends with the dictionary, the rest is ignored
+    memcpy(window.data() + WindowSize - point.window.size(),
+           point.window.constData(), static_cast<size_t>(point.window.size()));
+    raw = true;
+    windowPos = 0;
+    history = point.window.size();
+    out = point.out;
+    ended = false;
+}
+
+void QuaGzipFileInflater::fillInput()
+{
+    qint64 count = device->read(input.data(), input.size());
+    if (count < 0) {
+        error = true;
+        count = 0;
+    }
+    inputPos += count;
+    inputEnd = count == 0;
+    stream.next_in = reinterpret_cast<Bytef*>(input.data());
+    stream.avail_in = static_cast<uInt>(count);
+}
+
+bool QuaGzipFileInflater::nextMember()
+{
+    if (raw) {
+        // inflate doesn't know about the trailer in the raw mode
+        for (int trailer = 8; trailer > 0; ) {
+            if (stream.avail_in == 0)
+                fillInput();
+            if (stream.avail_in == 0) {
+                error = true;
+                return false;
+            }
+            uInt count = qMin(stream.avail_in, static_cast<uInt>(trailer));
+            stream.next_in += count;
+            stream.avail_in -= count;
+            trailer -= static_cast<int>(count);
+        }
+    }
+    if (stream.avail_in == 0)
+        fillInput();
+    if (stream.avail_in != 0 && startMember())
+        return !error;
+    ended = true;
+    if (isIndexed() && !complete) {
+        complete = true;
+        total = out;
+        if (!indexFileName.isEmpty() && !save())
+            qWarning("QuaGzipFile: could not save the index to %s",
+                     QFile::encodeName(indexFileName).constData());
+    }
+    return false;
+}
+
+bool QuaGzipFileInflater::startMember()
+{
+    // like gzread(), ignore whatever isn't another member
+    if (*stream.next_in != 0x1F)
+        return false;
+    raw = false;
+    error = inflateReset2(&stream, MAX_WBITS + 16) != Z_OK;
+    return true;
+}
+
+void QuaGzipFileInflater::addPoint()
+{
+    AccessPoint point;
+    point.out = out;
+    point.in = inputPos - stream.avail_in;
+    point.bits = stream.data_type & 7;
+    // the window is rotated through, the oldest data is after windowPos
+    point.window = window.mid(windowPos) + window.left(windowPos);
+    point.window = point.window.right(history);
+    points.append(point);
+}
+
+QByteArray QuaGzipFileInflater::fingerprint() const
+{
+    // the header of the first member and the CRC and the size of the
+    // last one, which tell the file from another one of the same size
+    qint64 pos = device->pos();
+    QByteArray check;
+    if (device->seek(start))
+        check = device->read(10);
+    if (device->size() - 8 >= start && device->seek(device->size() - 8))
+        check += device->read(8);
+    device->seek(pos);
+    return check;
+}
+
+bool QuaGzipFileInflater::load()
+{
+    QFile file(indexFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray data = file.readAll();
+    file.close();
+    QByteArray expected = fingerprint();
+    const int headerSize = 8 + 4 + 8 + 4 + expected.size() + 8 + 4;
+    if (data.size() < headerSize
+            || !data.startsWith(QUAGZIP_INDEX_MAGIC)
+            || quagzip_get_uint32(data.constData() + 8)
+                != QUAGZIP_INDEX_VERSION
+            // an index of another file, or of an older version of it
+            || static_cast<qint64>(quagzip_get_uint64(data.constData() + 12))
+                != device->size()
+            || quagzip_get_uint32(data.constData() + 20)
+                != static_cast<quint32>(expected.size())
+            || data.mid(24, expected.size()) != expected)
+        return false;
+    int pos = 24 + expected.size();
+    qint64 size = static_cast<qint64>(
+            quagzip_get_uint64(data.constData() + pos));
+    quint32 count = quagzip_get_uint32(data.constData() + pos + 8);
+    QList<AccessPoint> loaded;
+    pos = headerSize;
+    for (quint32 i = 0; i < count; ++i) {
+        const int pointSize = 8 + 8 + 1 + 4;
+        if (data.size() - pos < pointSize)
+            return false;
+        AccessPoint point;
+        point.out = static_cast<qint64>(
+                quagzip_get_uint64(data.constData() + pos));
+        point.in = static_cast<qint64>(
+                quagzip_get_uint64(data.constData() + pos + 8));
+        point.bits = static_cast<uchar>(data.at(pos + 16));
+        quint32 windowSize = quagzip_get_uint32(data.constData() + pos + 17);
+        pos += pointSize;
+        if (point.bits > 7 || windowSize > WindowSize
+                || static_cast<quint32>(data.size() - pos) < windowSize
+                || point.out > size
+                || (!loaded.isEmpty() && point.out <= loaded.last().out))
+            return false;
+        point.window = data.mid(pos, static_cast<int>(windowSize));
+        pos += static_cast<int>(windowSize);
+        loaded.append(point);
+    }
+    points = loaded;
+    total = size;
+    complete = true;
+    return true;
+}
+
+bool QuaGzipFileInflater::save() const
+{
+    QByteArray data(QUAGZIP_INDEX_MAGIC);
+    quagzip_put_uint32(&data, QUAGZIP_INDEX_VERSION);
+    quagzip_put_uint64(&data, static_cast<quint64>(device->size()));
+    QByteArray check = fingerprint();
+    quagzip_put_uint32(&data, static_cast<quint32>(check.size()));
+    data.append(check);
+    quagzip_put_uint64(&data, static_cast<quint64>(total));
+    quagzip_put_uint32(&data, static_cast<quint32>(points.size()));
+    for (int i = 0; i < points.size(); ++i) {
+        const AccessPoint &point = points.at(i);
+        quagzip_put_uint64(&data, static_cast<quint64>(point.out));
+        quagzip_put_uint64(&data, static_cast<quint64>(point.in));
+        data.append(static_cast<char>(point.bits));
+        quagzip_put_uint32(&data, static_cast<quint32>(point.window.size()));
+        data.append(point.window);
+    }
+    QFile file(indexFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    bool ok = file.write(data) == data.size();
+    file.close();
+    return ok;
+}
+
+QuaGzipFileDeflater::QuaGzipFileDeflater(QIODevice *device, int bufferSize):
+    device(device),
+    output(bufferSize, '\0')
+{
+    stream.zalloc = (alloc_func) nullptr;
+    stream.zfree = (free_func) nullptr;
+    stream.opaque = nullptr;
+    error = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK;
+}
+
+QuaGzipFileDeflater::~QuaGzipFileDeflater()
+{
+    deflateEnd(&stream);
+}
+
+bool QuaGzipFileDeflater::write(const char *data, qint64 size)
+{
+    while (size > 0 && !error) {
+        // avail_in is only 32 bits
+        uInt count = static_cast<uInt>(qMin(size,
+                static_cast<qint64>(0x40000000)));
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = count;
+        if (!run(Z_NO_FLUSH))
+            return false;
+        data += count;
+        size -= count;
+    }
+    return !error;
+}
+
+bool QuaGzipFileDeflater::flush()
+{
+    return run(Z_SYNC_FLUSH);
+}
+
+bool QuaGzipFileDeflater::finish()
+{
+    return run(Z_FINISH);
+}
+
+bool QuaGzipFileDeflater::run(int flush)
+{
+    if (flush != Z_NO_FLUSH) {
+        stream.next_in = nullptr;
+        stream.avail_in = 0;
+    }
+    while (!error) {
+        stream.next_out = reinterpret_cast<Bytef*>(output.data());
+        stream.avail_out = static_cast<uInt>(output.size());
+        int result = deflate(&stream, flush);
+        int count = output.size() - static_cast<int>(stream.avail_out);
+        if ((result != Z_OK && result != Z_STREAM_END
+                    && result != Z_BUF_ERROR)
+                || (count > 0 && device->write(output.constData(), count)
+                    != count)) {
+            error = true;
+            break;
+        }
+        // the output buffer is all that stops deflate here
+        if (stream.avail_out != 0 || result == Z_STREAM_END)
+            break;
+    }
+    return !error;
+}
+
 class QuaGzipFilePrivate {
     friend class QuaGzipFile;
     QString fileName;
     gzFile gzd;
-    inline QuaGzipFilePrivate(): gzd(nullptr) {}
+    int threads;
+    bool blocked;
+    qint64 indexSpan;
+    QString indexFileName;
+    int bufferSize;
+    QIODevice *ioDevice;
+    bool ioDeviceOpened;
+    QFile *file;
+    QuaGzipFileWriter *writer;
+    QuaGzipFileReader *reader;
+    QuaGzipFileInflater *inflater;
+    QuaGzipFileDeflater *deflater;
+    inline QuaGzipFilePrivate():
+        gzd(nullptr), threads(1), blocked(false), indexSpan(0),
+        bufferSize(QUAGZIP_DEFAULT_BUFFER_SIZE), ioDevice(nullptr),
+        ioDeviceOpened(false), file(nullptr), writer(nullptr),
+        reader(nullptr), inflater(nullptr), deflater(nullptr) {}
     inline QuaGzipFilePrivate(const QString &fileName): 
-        fileName(fileName), gzd(nullptr) {}
+        fileName(fileName), gzd(nullptr), threads(1), blocked(false),
+        indexSpan(0), bufferSize(QUAGZIP_DEFAULT_BUFFER_SIZE),
+        ioDevice(nullptr), ioDeviceOpened(false), file(nullptr),
+        writer(nullptr), reader(nullptr), inflater(nullptr),
+        deflater(nullptr) {}
+    static bool checkMode(QIODevice::OpenMode mode, QString &error);
     template<typename FileId> bool open(FileId id, 
         QIODevice::OpenMode mode, QString &error);
+    bool openDevice(QIODevice::OpenMode mode, QString &error);
+    void openStream(QIODevice *device, QIODevice::OpenMode mode);
     gzFile open(int fd, const char *modeString);
     gzFile open(const QString &name, const char *modeString);
+    template<typename FileId> bool openFile(FileId id,
+        QIODevice::OpenMode mode, QString &error);
+    static bool openFile(QFile *file, int fd, QIODevice::OpenMode mode,
+                         QFile::FileHandleFlags handleFlags);
+    static bool openFile(QFile *file, const QString &name,
+                         QIODevice::OpenMode mode,
+                         QFile::FileHandleFlags handleFlags);
+    template<typename FileId> static bool isBlocked(FileId id);
+    void closeDevice();
 };
 
 gzFile QuaGzipFilePrivate::open(const QString &name, const char *modeString)
@@ -50,12 +958,116 @@ gzFile QuaGzipFilePrivate::open(int fd, const char *modeString)
     return gzdopen(fd, modeString);
 }
 
+bool QuaGzipFilePrivate::openFile(QFile *file, const QString &name,
+                                  QIODevice::OpenMode mode,
+                                  QFile::FileHandleFlags)
+{
+    file->setFileName(name);
+    if ((mode & QIODevice::WriteOnly) != 0)
+        mode |= QIODevice::Truncate;
+    return file->open(mode);
+}
+
+bool QuaGzipFilePrivate::openFile(QFile *file, int fd,
+                                  QIODevice::OpenMode mode,
+                                  QFile::FileHandleFlags handleFlags)
+{
+    return file->open(fd, mode, handleFlags);
+}
+
 template<typename FileId>
-bool QuaGzipFilePrivate::open(FileId id, QIODevice::OpenMode mode, 
-                              QString &error)
+bool QuaGzipFilePrivate::openFile(FileId id, QIODevice::OpenMode mode,
+                                  QString &error)
+{
+    file = new QFile();
+    // gzdopen() takes the ownership too
+    if (!openFile(file, id, mode, QFile::AutoCloseHandle)) {
+        error = QuaGzipFile::tr("Could not open file: %1")
+            .arg(file->errorString());
+        delete file;
+        file = nullptr;
+        return false;
+    }
+    openStream(file, mode);
+    return true;
+}
+
+bool QuaGzipFilePrivate::openDevice(QIODevice::OpenMode mode,
+                                    QString &error)
+{
+    if (!checkMode(mode, error))
+        return false;
+    if (!ioDevice->isOpen()) {
+        if (!ioDevice->open(mode)) {
+            error = QuaGzipFile::tr("Could not open the device: %1")
+                .arg(ioDevice->errorString());
+            return false;
+        }
+        ioDeviceOpened = true;
+    } else if ((ioDevice->openMode() & mode & QIODevice::ReadWrite)
+            != (mode & QIODevice::ReadWrite)) {
+        error = QuaGzipFile::tr("The device is open in an incompatible"
+                " mode");
+        return false;
+    }
+    if ((mode & QIODevice::ReadOnly) != 0) {
+        // the blocked format needs seeking
+        QByteArray header = ioDevice->isSequential() ? QByteArray()
+            : ioDevice->peek(QUAGZIP_BLOCK_HEADER_SIZE);
+        blocked = header.size() == QUAGZIP_BLOCK_HEADER_SIZE
+            && quagzip_block_size(header.constData()) != 0;
+    }
+    openStream(ioDevice, mode);
+    return true;
+}
+
+void QuaGzipFilePrivate::openStream(QIODevice *device,
+                                    QIODevice::OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) == 0) {
+        if (blocked)
+            reader = new QuaGzipFileReader(device, threads);
+        else
+            inflater = new QuaGzipFileInflater(device, bufferSize, indexSpan,
+                                               indexFileName);
+    } else if (threads > 1 || blocked) {
+        writer = new QuaGzipFileWriter(device, threads, blocked);
+    } else {
+        deflater = new QuaGzipFileDeflater(device, bufferSize);
+    }
+}
+
+template<typename FileId>
+bool QuaGzipFilePrivate::isBlocked(FileId id)
+{
+    // unbuffered, so a descriptor is left where it was for gzdopen()
+    QFile probe;
+    if (!openFile(&probe, id, QIODevice::ReadOnly | QIODevice::Unbuffered,
+                  QFile::DontCloseHandle)
+            || probe.isSequential())
+        return false;
+    qint64 start = probe.pos();
+    QByteArray header = probe.read(QUAGZIP_BLOCK_HEADER_SIZE);
+    bool blocked = header.size() == QUAGZIP_BLOCK_HEADER_SIZE
+        && quagzip_block_size(header.constData()) != 0;
+    probe.seek(start);
+    return blocked;
+}
+
+void QuaGzipFilePrivate::closeDevice()
+{
+    if (file != nullptr) {
+        file->close();
+        delete file;
+        file = nullptr;
+    } else if (ioDeviceOpened) {
+        ioDevice->close();
+        ioDeviceOpened = false;
+    }
+}
+
+bool QuaGzipFilePrivate::checkMode(QIODevice::OpenMode mode, QString &error)
 {
-    char modeString[2];
-    modeString[0] = modeString[1] = '\0';
     if ((mode & QIODevice::Append) != 0) {
         error = QuaGzipFile::tr("QIODevice::Append is not "
                 "supported for GZIP");
@@ -66,20 +1078,39 @@ bool QuaGzipFilePrivate::open(FileId id, QIODevice::OpenMode mode,
         error = QuaGzipFile::tr("Opening gzip for both reading"
             " and writing is not supported");
         return false;
-    } else if ((mode & QIODevice::ReadOnly) != 0) {
-        modeString[0] = 'r';
-    } else if ((mode & QIODevice::WriteOnly) != 0) {
-        modeString[0] = 'w';
-    } else {
+    } else if ((mode & QIODevice::ReadOnly) == 0
+            && (mode & QIODevice::WriteOnly) == 0) {
         error = QuaGzipFile::tr("You can open a gzip either for reading"
             " or for writing. Which is it?");
         return false;
     }
+    return true;
+}
+
+template<typename FileId>
+bool QuaGzipFilePrivate::open(FileId id, QIODevice::OpenMode mode, 
+                              QString &error)
+{
+    char modeString[2];
+    modeString[0] = modeString[1] = '\0';
+    if (!checkMode(mode, error))
+        return false;
+    if ((mode & QIODevice::ReadOnly) != 0) {
+        blocked = isBlocked(id);
+        if (blocked || indexSpan > 0)
+            return openFile(id, QIODevice::ReadOnly, error);
+        modeString[0] = 'r';
+    } else if ((mode & QIODevice::WriteOnly) != 0) {
+        if (threads > 1 || blocked)
+            return openFile(id, QIODevice::WriteOnly, error);
+        modeString[0] = 'w';
+    }
     gzd = open(id, modeString);
     if (gzd == nullptr) {
         error = QuaGzipFile::tr("Could not gzopen() file");
         return false;
     }
+    gzbuffer(gzd, static_cast<unsigned>(bufferSize));
     return true;
 }
 /// \endcond
@@ -112,6 +1143,7 @@ QuaGzipFile::~QuaGzipFile()
 void QuaGzipFile::setFileName(const QString& fileName)
 {
     d->fileName = fileName;
+    d->ioDevice = nullptr;
 }
 
 QString QuaGzipFile::getFileName() const
@@ -119,18 +1151,135 @@ QString QuaGzipFile::getFileName() const
     return d->fileName;
 }
 
+void QuaGzipFile::setIoDevice(QIODevice *ioDevice)
+{
+    d->ioDevice = ioDevice;
+    d->fileName = QString();
+}
+
+QIODevice *QuaGzipFile::getIoDevice() const
+{
+    return d->ioDevice;
+}
+
+void QuaGzipFile::setBufferSize(int bufferSize)
+{
+    // deflate needs a few bytes of room for a sync flush marker
+    d->bufferSize = qMax(bufferSize, 64);
+}
+
+int QuaGzipFile::getBufferSize() const
+{
+    return d->bufferSize;
+}
+
+void QuaGzipFile::setMaxThreadCount(int threads)
+{
+    d->threads = qMax(threads, 1);
+}
+
+int QuaGzipFile::getMaxThreadCount() const
+{
+    return d->threads;
+}
+
+void QuaGzipFile::setBlocked(bool blocked)
+{
+    d->blocked = blocked;
+}
+
+bool QuaGzipFile::isBlocked() const
+{
+    return d->blocked;
+}
+
+qint64 QuaGzipFile::virtualOffset() const
+{
+    if (d->reader == nullptr)
+        return -1;
+    return d->reader->virtualOffset();
+}
+
+bool QuaGzipFile::seekVirtual(qint64 offset)
+{
+    if (d->reader == nullptr) {
+        qWarning("QuaGzipFile::seekVirtual(): "
+                 "file is not open for reading in the blocked format");
+        return false;
+    }
+    return d->reader->seek(offset);
+}
+
+void QuaGzipFile::setIndexSpan(qint64 span)
+{
+    d->indexSpan = qMax(span, static_cast<qint64>(0));
+}
+
+qint64 QuaGzipFile::getIndexSpan() const
+{
+    return d->indexSpan;
+}
+
+void QuaGzipFile::setIndexFileName(const QString &indexFileName)
+{
+    d->indexFileName = indexFileName;
+}
+
+QString QuaGzipFile::getIndexFileName() const
+{
+    return d->indexFileName;
+}
+
+bool QuaGzipFile::buildIndex()
+{
+    if (d->inflater == nullptr || !d->inflater->isIndexed()) {
+        qWarning("QuaGzipFile::buildIndex(): "
+                 "file is not open for reading with an index");
+        return false;
+    }
+    return d->inflater->build();
+}
+
 bool QuaGzipFile::isSequential() const
 {
-  return true;
+  return d->inflater == nullptr || !d->inflater->isIndexed();
+}
+
+bool QuaGzipFile::seek(qint64 pos)
+{
+    if (d->inflater == nullptr || !d->inflater->isIndexed())
+        return QIODevice::seek(pos);
+    return QIODevice::seek(pos) && d->inflater->seek(pos);
+}
+
+qint64 QuaGzipFile::size() const
+{
+    if (d->inflater == nullptr || !d->inflater->isIndexed())
+        return QIODevice::size();
+    return d->inflater->size();
+}
+
+bool QuaGzipFile::atEnd() const
+{
+    if (d->reader != nullptr)
+        return d->reader->atEnd();
+    if (d->inflater == nullptr)
+        return QIODevice::atEnd();
+    return d->inflater->atEnd();
 }
 
 bool QuaGzipFile::open(QIODevice::OpenMode mode)
 {
     QString error;
-    if (!d->open(d->fileName, mode, error)) {
+    if (d->ioDevice != nullptr ? !d->openDevice(mode, error)
+            : !d->open(d->fileName, mode, error)) {
         setErrorString(error);
         return false;
     }
+    // the current member is the buffer, and seekVirtual() can't reach
+    // the one of QIODevice
+    if (d->reader != nullptr || d->inflater != nullptr)
+        mode |= QIODevice::Unbuffered;
     return QIODevice::open(mode);
 }
 
@@ -141,22 +1290,61 @@ bool QuaGzipFile::open(int fd, QIODevice::OpenMode mode)
         setErrorString(error);
         return false;
     }
+    if (d->reader != nullptr || d->inflater != nullptr)
+        mode |= QIODevice::Unbuffered;
     return QIODevice::open(mode);
 }
 
 bool QuaGzipFile::flush()
 {
+    if (d->writer != nullptr) {
+        return d->writer->flush()
+            && (d->file == nullptr || d->file->flush());
+    }
+    if (d->deflater != nullptr) {
+        return d->deflater->flush()
+            && (d->file == nullptr || d->file->flush());
+    }
+    if (d->reader != nullptr || d->inflater != nullptr)
+        return false;
     return gzflush(d->gzd, Z_SYNC_FLUSH) == Z_OK;
 }
 
 void QuaGzipFile::close()
 {
   QIODevice::close();
-  gzclose(d->gzd);
+  if (d->writer != nullptr) {
+    if (!d->writer->finish())
+      setErrorString(tr("Could not write the compressed data"));
+    delete d->writer;
+    d->writer = nullptr;
+    d->closeDevice();
+  } else if (d->deflater != nullptr) {
+    if (!d->deflater->finish())
+      setErrorString(tr("Could not write the compressed data"));
+    delete d->deflater;
+    d->deflater = nullptr;
+    d->closeDevice();
+  } else if (d->reader != nullptr) {
+    delete d->reader;
+    d->reader = nullptr;
+    d->closeDevice();
+  } else if (d->inflater != nullptr) {
+    delete d->inflater;
+    d->inflater = nullptr;
+    d->closeDevice();
+  } else {
+    gzclose(d->gzd);
+    d->gzd = nullptr;
+  }
 }
 
 qint64 QuaGzipFile::readData(char *data, qint64 maxSize)
 {
+    if (d->reader != nullptr)
+        return d->reader->read(data, maxSize);
+    if (d->inflater != nullptr)
+        return d->inflater->read(data, maxSize);
     return gzread(d->gzd, (voidp)data, (unsigned)maxSize);
 }
 
@@ -164,6 +1352,10 @@ qint64 QuaGzipFile::writeData(const char *data, qint64 maxSize)
 {
     if (maxSize == 0)
         return 0;
+    if (d->writer != nullptr)
+        return d->writer->write(data, maxSize) ? maxSize : -1;
+    if (d->deflater != nullptr)
+        return d->deflater->write(data, maxSize) ? maxSize : -1;
     int written = gzwrite(d->gzd, (voidp)data, (unsigned)maxSize);
     if (written == 0)
         return -1;
@@ -28,25 +28,35 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QtCore/QIODevice>
 #include "quazip_global.h"
 
-#include <zlib.h>
+#include "quazip_zlib.h"
 
 class QuaGzipFilePrivate;
 
 /// GZIP file
 /**
-  This class is a wrapper around GZIP file access functions in zlib. Unlike QuaZip classes, it doesn't allow reading from a GZIP file opened as QIODevice, for example, if your GZIP file is in QBuffer. It only provides QIODevice access to a GZIP file contents, but the GZIP file itself must be identified by its name on disk or by descriptor id.
+  This class is a wrapper around GZIP file access functions in zlib. It provides QIODevice access to a GZIP file contents. The GZIP file itself is identified either by its name on disk, by descriptor id or by another QIODevice, such as a QBuffer, a QTcpSocket or a QProcess, see setIoDevice().
+
+  For writing, the data may be compressed by several threads, see
+  setMaxThreadCount().
+
+  QuaGzipFile can also write and read GZIP files in the blocked format,
+  known as BGZF, see setBlocked(). Such a file is a sequence of small GZIP
+  members, so any gunzip can still read it, but it can also be
+  decompressed by several threads and allows fast random access.
+  Ordinary GZIP files can be read with random access too, by keeping an
+  index of access points, see setIndexSpan().
   */
 class QUAZIP_EXPORT QuaGzipFile: public QIODevice {
   Q_OBJECT
 public:
   /// Empty constructor.
   /**
-    Must call setFileName() before trying to open.
+    Must call setFileName() or setIoDevice() before trying to open.
     */
   QuaGzipFile();
   /// Empty constructor with a parent.
   /**
-    Must call setFileName() before trying to open.
+    Must call setFileName() or setIoDevice() before trying to open.
     \param parent The parent object, as per QObject logic.
     */
   QuaGzipFile(QObject *parent);
@@ -59,18 +69,193 @@ public:
   /// Destructor.
   virtual ~QuaGzipFile();
   /// Sets the name of the GZIP file to be opened.
+  /**
+    Clears the device set by setIoDevice().
+    */
   void setFileName(const QString& fileName);
   /// Returns the name of the GZIP file.
   QString getFileName() const;
-  /// Returns true.
+  /// Sets the device to read or write the GZIP file from/to.
+  /**
+    Then open() compresses to or decompresses from that device, using
+    zlib's deflate and inflate instead of its GZIP file functions. Several
+    GZIP members one after another are read as a single file. If the device
+    is sequential, such as a socket, reading returns whatever can be
+    decompressed from the data that has arrived so far, and stops there
+    without an error.
+
+    If the device is not open, open() opens it, and close() closes it.
+    Otherwise, it must be open in a mode that allows the requested
+    operation, and is left open by close(). QuaGzipFile doesn't take the
+    ownership of the device.
+
+    Clears the file name set by setFileName().
+    */
+  void setIoDevice(QIODevice *ioDevice);
+  /// Returns the device set by setIoDevice(), or null if none.
+  QIODevice *getIoDevice() const;
+  /// Sets the size of the buffers for the compressed data.
+  /**
+    Takes effect the next time the file is opened. Reading from or writing
+    to the file or device in larger pieces means fewer calls to it and to
+    zlib. When zlib's GZIP file functions are used, that is, for a file
+    opened by name or descriptor without an index, the blocked format or
+    several threads, this is passed to gzbuffer(). The blocked format has
+    buffers of its own.
+
+    The default is 64 KB, and sizes below 64 bytes are raised to that.
+    */
+  void setBufferSize(int bufferSize);
+  /// Returns the size of the buffers for the compressed data.
+  /**
+    \sa setBufferSize()
+    */
+  int getBufferSize() const;
+  /// Sets the number of threads used to compress the data.
+  /**
+    Takes effect the next time the file is opened for writing. With more
+    than one thread, the data is split into 128 KB blocks that are
+    deflated concurrently, each using the last 32 KB of the data before it
+    as the dictionary, in the same way pigz does it. The blocks are joined
+    with sync flushes into a single GZIP member with the combined CRC, so
+    any gunzip can read the result. The output is slightly larger than
+    with a single thread.
+
+    The default is 1, which means compressing the data with zlib's gzwrite()
+    in the calling thread. Has no effect on reading.
+    */
+  void setMaxThreadCount(int threads);
+  /// Returns the number of threads used to compress the data.
+  /**
+    \sa setMaxThreadCount()
+    */
+  int getMaxThreadCount() const;
+  /// Sets whether to write the file in the blocked format.
+  /**
+    Takes effect the next time the file is opened for writing. In the
+    blocked format, the data is split into GZIP members of no more than
+    64 KB each, both compressed and uncompressed, and the extra field of
+    each member holds its compressed size, in the same way as in BGZF. The
+    file ends with an empty member. The members are compressed by the
+    number of threads set by setMaxThreadCount().
+
+    Opening a file for reading detects the format of the file, and sets
+    this property accordingly. The blocked files are then read by
+    inflating the next members ahead in setMaxThreadCount() threads, and
+    seekVirtual() can be used. Files in other formats are read by zlib
+    as usual.
+
+    The default is false.
+    */
+  void setBlocked(bool blocked);
+  /// Returns whether the file is in the blocked format.
+  /**
+    \sa setBlocked()
+    */
+  bool isBlocked() const;
+  /// Returns the virtual offset of the current position.
+  /**
+    The virtual offset is the position of the GZIP member in the file
+    shifted 16 bits left, plus the position in the uncompressed data of
+    that member, just as in BGZF. It can be saved, for example, in an
+    index, and passed to seekVirtual() later on.
+
+    Returns -1 unless the file is open for reading in the blocked format.
+    */
+  qint64 virtualOffset() const;
+  /// Moves to a virtual offset.
+  /**
+    As the virtual offset includes the position of the member in the file,
+    only that member has to be decompressed, regardless of how large the
+    file is.
+
+    Only works when the file is open for reading in the blocked format.
+    \param offset A virtual offset obtained from virtualOffset().
+    \return true on success, false if the offset is invalid or the file
+    is not open for reading in the blocked format.
+    */
+  bool seekVirtual(qint64 offset);
+  /// Sets the distance between the access points of the index.
+  /**
+    Takes effect the next time the file is opened for reading. If the span
+    is positive, the file is read with an index: once every \a span bytes
+    of the uncompressed data, an access point is added, from which the
+    decompression can start over. Then seek() starts decompressing from
+    the closest access point instead of the beginning of the file. Each
+    access point takes about 32 KB of memory.
+
+    The index is built as the file is read, whether by reading or by
+    seeking forward, and is complete once the end of the file is reached
+    for the first time. buildIndex() can be used to get there right away.
+
+    Blocked files are read as described in setBlocked() instead, and
+    sequential devices are read without an index.
+
+    The default is 0, which means reading without an index.
+    */
+  void setIndexSpan(qint64 span);
+  /// Returns the distance between the access points of the index.
+  /**
+    \sa setIndexSpan()
+    */
+  qint64 getIndexSpan() const;
+  /// Sets the name of the file to keep the index in.
+  /**
+    If set, the index is loaded from that file when the GZIP file is
+    opened with an index span set, and saved to it once it is complete.
+    Then the GZIP file doesn't have to be decompressed again to build the
+    index. An index saved for another file is ignored: one of another
+    size, or with another first member header or another CRC and size of
+    the last member.
+
+    Empty by default, which means the index is only kept in memory.
+    \sa setIndexSpan()
+    */
+  void setIndexFileName(const QString &indexFileName);
+  /// Returns the name of the file to keep the index in.
+  /**
+    \sa setIndexFileName()
+    */
+  QString getIndexFileName() const;
+  /// Completes the index.
+  /**
+    Decompresses the rest of the file from the last access point, then
+    returns to the current position. Does nothing if the index is
+    complete already, for example, if it was loaded from a file.
+
+    Only works when the file is open for reading with an index.
+    \return true on success, false on an error or if the file is not open
+    for reading with an index.
+    \sa setIndexSpan()
+    */
+  bool buildIndex();
+  /// Returns whether seeking is impossible.
   /**
     Strictly speaking, zlib supports seeking for GZIP files, but it is
     poorly implemented, because there is no way to implement it
     properly. For reading, seeking backwards is very slow, and for
     writing, it is downright impossible. Therefore, QuaGzipFile does not
-    support seeking at all.
+    support seeking, except for seekVirtual() in blocked files, and
+    returns true, unless the file is open for reading with an index, see
+    setIndexSpan().
     */
   virtual bool isSequential() const;
+  /// Moves to a position in the uncompressed data.
+  /**
+    Only works when the file is open for reading with an index, see
+    setIndexSpan(). Seeking beyond the part of the file indexed so far
+    extends the index.
+    */
+  virtual bool seek(qint64 pos);
+  /// Returns the size of the uncompressed data.
+  /**
+    When the file is open for reading with an index, returns the size of
+    the uncompressed data, if the index is complete, or 0 if it is not
+    known yet. Otherwise, returns what QIODevice::size() does.
+    */
+  virtual qint64 size() const;
+  /// Returns whether the end of the data is reached.
+  virtual bool atEnd() const;
   /// Opens the file.
   /**
     \param mode Can be either QIODevice::Write or QIODevice::Read.
@@ -88,7 +273,8 @@ public:
   /// Flushes data to file.
   /**
     The data is written using Z_SYNC_FLUSH mode. Doesn't make any sense
-    when reading.
+    when reading. When compressing by several threads, waits until all the
+    data written so far is compressed.
     */
   virtual bool flush();
   /// Closes the file.
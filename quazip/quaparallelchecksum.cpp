@@ -0,0 +1,335 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include "quaparallelchecksum.h"
+#include "quazip_adler32.h"
+#include "quazip_crc32.h"
+
+#define QUAZIP_PARALLEL_CHUNK (8 * 1024 * 1024)
+// keeps the chunk lengths within z_off_t and QByteArray
+#define QUAZIP_PARALLEL_MAX_CHUNK (1024 * 1024 * 1024)
+#define QUAZIP_PARALLEL_READ_SIZE (1024 * 1024)
+
+/// \cond internal
+/// One chunk, checksummed by a pool thread.
+class QuaParallelChecksumJob: public QRunnable {
+    Q_DECLARE_TR_FUNCTIONS(QuaParallelChecksum)
+public:
+    QuaParallelChecksumJob(QuaParallelChecksum::Algorithm algorithm,
+                           qint64 size);
+    virtual void run();
+    QuaParallelChecksum::Algorithm algorithm;
+    // the source: memory, data read from a device or a part of a file
+    const char *data;
+    QByteArray buffer;
+    QString fileName;
+    qint64 offset;
+    qint64 size;
+    // the results, valid once done is acquired
+    quint32 checksum;
+    QString error;
+    QSemaphore done;
+private:
+    void update(const char *buf, qint64 len);
+    void checksumFile();
+};
+
+class QuaParallelChecksumPrivate {
+    friend class QuaParallelChecksum;
+    Q_DECLARE_TR_FUNCTIONS(QuaParallelChecksum)
+private:
+    QuaParallelChecksumPrivate(QuaParallelChecksum::Algorithm algorithm);
+    QuaParallelChecksum::Algorithm algorithm;
+    qint64 chunkSize;
+    QThreadPool pool;
+    // in the order of the data
+    QList<QuaParallelChecksumJob*> jobs;
+    quint32 checksum;
+    QString errorString;
+    void begin();
+    bool submit(QuaParallelChecksumJob *job);
+    bool collect(int maxPending);
+    bool finish(quint32 *result);
+};
+
+QuaParallelChecksumJob::QuaParallelChecksumJob(
+        QuaParallelChecksum::Algorithm algorithm, qint64 size):
+    algorithm(algorithm),
+    data(nullptr),
+    offset(0),
+    size(size),
+    checksum(algorithm == QuaParallelChecksum::Crc32 ? 0 : 1)
+{
+    setAutoDelete(false);
+}
+
+void QuaParallelChecksumJob::run()
+{
+    if (!fileName.isEmpty()) {
+        checksumFile();
+    } else if (data != nullptr) {
+        update(data, size);
+    } else {
+        update(buffer.constData(), buffer.size());
+        buffer = QByteArray();
+    }
+    done.release();
+}
+
+void QuaParallelChecksumJob::update(const char *buf, qint64 len)
+{
+    const Bytef *bytes = reinterpret_cast<const Bytef*>(buf);
+    if (algorithm == QuaParallelChecksum::Crc32) {
+        checksum = static_cast<quint32>(quazip_crc32(checksum, bytes,
+                static_cast<size_t>(len)));
+    } else {
+        checksum = static_cast<quint32>(quazip_adler32(checksum, bytes,
+                static_cast<size_t>(len)));
+    }
+}
+
+void QuaParallelChecksumJob::checksumFile()
+{
+    // a QFile of its own, so that the threads don't share its position
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = tr("Can't open %1: %2").arg(fileName, file.errorString());
+        return;
+    }
+    uchar *mapped = file.map(offset, size);
+    if (mapped != nullptr) {
+        update(reinterpret_cast<const char*>(mapped), size);
+        file.unmap(mapped);
+        return;
+    }
+    if (!file.seek(offset)) {
+        error = tr("Can't read %1: %2").arg(fileName, file.errorString());
+        return;
+    }
+    QByteArray piece;
+    piece.resize(static_cast<int>(qMin(size,
+            static_cast<qint64>(QUAZIP_PARALLEL_READ_SIZE))));
+    qint64 left = size;
+    while (left > 0) {
+        qint64 read = file.read(piece.data(),
+                                qMin(left, static_cast<qint64>(piece.size())));
+        if (read <= 0) {
+            error = tr("Can't read %1: %2").arg(fileName,
+                    read < 0 ? file.errorString() : tr("unexpected end"));
+            return;
+        }
+        update(piece.constData(), read);
+        left -= read;
+    }
+}
+
+QuaParallelChecksumPrivate::QuaParallelChecksumPrivate(
+        QuaParallelChecksum::Algorithm algorithm):
+    algorithm(algorithm),
+    chunkSize(QUAZIP_PARALLEL_CHUNK),
+    checksum(0)
+{
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+void QuaParallelChecksumPrivate::begin()
+{
+    checksum = algorithm == QuaParallelChecksum::Crc32 ? 0 : 1;
+    errorString.clear();
+}
+
+bool QuaParallelChecksumPrivate::submit(QuaParallelChecksumJob *job)
+{
+    jobs.append(job);
+    pool.start(job);
+    return collect(2 * pool.maxThreadCount() - 1);
+}
+
+bool QuaParallelChecksumPrivate::collect(int maxPending)
+{
+    while (jobs.size() > maxPending) {
+        QuaParallelChecksumJob *job = jobs.takeFirst();
+        job->done.acquire();
+        if (errorString.isEmpty() && !job->error.isEmpty())
+            errorString = job->error;
+        if (errorString.isEmpty()) {
+            z_off_t size = static_cast<z_off_t>(job->size);
+            checksum = static_cast<quint32>(
+                algorithm == QuaParallelChecksum::Crc32
+                    ? crc32_combine(checksum, job->checksum, size)
+                    : adler32_combine(checksum, job->checksum, size));
+        }
+        delete job;
+    }
+    return errorString.isEmpty();
+}
+
+bool QuaParallelChecksumPrivate::finish(quint32 *result)
+{
+    if (!collect(0))
+        return false;
+    *result = checksum;
+    return true;
+}
+/// \endcond
+
+QuaParallelChecksum::QuaParallelChecksum(Algorithm algorithm):
+    p(new QuaParallelChecksumPrivate(algorithm))
+{
+}
+
+QuaParallelChecksum::~QuaParallelChecksum()
+{
+    delete p;
+}
+
+QuaParallelChecksum::Algorithm QuaParallelChecksum::getAlgorithm() const
+{
+    return p->algorithm;
+}
+
+void QuaParallelChecksum::setMaxThreadCount(int maxThreadCount)
+{
+    p->pool.setMaxThreadCount(qMax(1, maxThreadCount));
+}
+
+int QuaParallelChecksum::getMaxThreadCount() const
+{
+    return p->pool.maxThreadCount();
+}
+
+void QuaParallelChecksum::setChunkSize(qint64 chunkSize)
+{
+    p->chunkSize = qBound(static_cast<qint64>(1), chunkSize,
+                          static_cast<qint64>(QUAZIP_PARALLEL_MAX_CHUNK));
+}
+
+qint64 QuaParallelChecksum::getChunkSize() const
+{
+    return p->chunkSize;
+}
+
+bool QuaParallelChecksum::calculate(const char *data, qint64 size,
+                                    quint32 *result)
+{
+    if (result == nullptr || size < 0 || (data == nullptr && size != 0)) {
+        qWarning("QuaParallelChecksum::calculate(): invalid arguments");
+        return false;
+    }
+    p->begin();
+    for (qint64 offset = 0; offset < size; offset += p->chunkSize) {
+        QuaParallelChecksumJob *job = new QuaParallelChecksumJob(
+                p->algorithm, qMin(p->chunkSize, size - offset));
+        job->data = data + offset;
+        if (!p->submit(job))
+            break;
+    }
+    return p->finish(result);
+}
+
+bool QuaParallelChecksum::calculateFile(const QString &fileName,
+                                        quint32 *result)
+{
+    if (result == nullptr) {
+        qWarning("QuaParallelChecksum::calculateFile(): result is null");
+        return false;
+    }
+    p->begin();
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        p->errorString = QuaParallelChecksumPrivate::tr("Can't open %1: %2")
+                .arg(fileName, file.errorString());
+        return false;
+    }
+    qint64 size = file.size();
+    file.close();
+    for (qint64 offset = 0; offset < size; offset += p->chunkSize) {
+        QuaParallelChecksumJob *job = new QuaParallelChecksumJob(
+                p->algorithm, qMin(p->chunkSize, size - offset));
+        job->fileName = fileName;
+        job->offset = offset;
+        if (!p->submit(job))
+            break;
+    }
+    return p->finish(result);
+}
+
+bool QuaParallelChecksum::calculateDevice(QIODevice *device, quint32 *result)
+{
+    if (result == nullptr || device == nullptr) {
+        qWarning("QuaParallelChecksum::calculateDevice(): invalid arguments");
+        return false;
+    }
+    p->begin();
+    if (!device->isReadable()) {
+        p->errorString = QuaParallelChecksumPrivate::tr(
+                "The device is not open for reading");
+        return false;
+    }
+    bool atEnd = false;
+    while (!atEnd) {
+        QByteArray chunk;
+        chunk.resize(static_cast<int>(p->chunkSize));
+        qint64 size = 0;
+        while (size < p->chunkSize) {
+            qint64 read = device->read(chunk.data() + size,
+                                       p->chunkSize - size);
+            if (read < 0) {
+                p->errorString = device->errorString();
+                p->collect(0);
+                return false;
+            }
+            if (read == 0) {
+                // a socket or a process may have more to come
+                if (device->isSequential() && device->waitForReadyRead(-1))
+                    continue;
+                atEnd = true;
+                break;
+            }
+            size += read;
+        }
+        if (size == 0)
+            break;
+        chunk.resize(static_cast<int>(size));
+        QuaParallelChecksumJob *job = new QuaParallelChecksumJob(
+                p->algorithm, size);
+        job->buffer = chunk;
+        if (!p->submit(job))
+            break;
+    }
+    return p->finish(result);
+}
+
+QString QuaParallelChecksum::getErrorString() const
+{
+    return p->errorString;
+}
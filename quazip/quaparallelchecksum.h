@@ -0,0 +1,121 @@
+#ifndef QUAZIP_QUAPARALLELCHECKSUM_H
+#define QUAZIP_QUAPARALLELCHECKSUM_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QIODevice>
+#include <QtCore/QString>
+
+#include "quazip_global.h"
+
+class QuaParallelChecksumPrivate;
+
+/// Calculates the checksum of large data using several threads.
+/** \class QuaParallelChecksum quaparallelchecksum.h <quazip/quaparallelchecksum.h>
+ * The data is split into chunks (see setChunkSize()), the CRC-32 or
+ * Adler-32 of each chunk is calculated by a thread pool, and the
+ * checksums of the chunks are joined with \c crc32_combine() or
+ * \c adler32_combine(). The result is the same as the one of QuaCrc32
+ * or QuaAdler32 for the whole data.
+ *
+ * The data may be a memory range, a file or a device:
+ * - calculate() reads the memory directly from the pool threads;
+ * - calculateFile() opens the file in each thread and maps the chunk
+ *   into memory, or reads it with a positional read if the file can't
+ *   be mapped, so the threads never wait for each other and the speed
+ *   scales with the number of cores as long as the disk keeps up;
+ * - calculateDevice() reads the device sequentially from the calling
+ *   thread, while the chunks read so far are checksummed in the pool.
+ *
+ * Only a limited number of chunks is in flight at any time: twice the
+ * maximum thread count. Therefore, the memory used by calculateDevice()
+ * and by the positional reads stays bounded.
+ *
+ * Usage:
+ * \code
+ * QuaParallelChecksum checksum;
+ * quint32 crc;
+ * if (!checksum.calculateFile("backup.img", &crc))
+ *     qWarning() << checksum.getErrorString();
+ * \endcode
+ */
+class QUAZIP_EXPORT QuaParallelChecksum {
+  friend class QuaParallelChecksumPrivate;
+public:
+    /// The checksum algorithm.
+    enum Algorithm {
+        Crc32, ///< CRC-32, as calculated by QuaCrc32.
+        Adler32 ///< Adler-32, as calculated by QuaAdler32.
+    };
+    /// Constructs an object calculating the specified checksum.
+    explicit QuaParallelChecksum(Algorithm algorithm = Crc32);
+    /// Destructor.
+    ~QuaParallelChecksum();
+    /// Returns the checksum algorithm.
+    Algorithm getAlgorithm() const;
+    /// Sets the maximum number of threads.
+    /** The default is QThread::idealThreadCount(). */
+    void setMaxThreadCount(int maxThreadCount);
+    /// Returns the maximum number of threads.
+    int getMaxThreadCount() const;
+    /// Sets the size of the chunks the data is split into.
+    /** The default is 8 MB, small enough to balance the load and large
+     * enough for the cost of each chunk to be negligible.
+     */
+    void setChunkSize(qint64 chunkSize);
+    /// Returns the size of the chunks the data is split into.
+    qint64 getChunkSize() const;
+    /// Calculates the checksum of \a size bytes at \a data.
+    /**
+     * \param data The data, which must stay unchanged until this
+     * function returns.
+     * \param size The size of the data.
+     * \param result Where to store the checksum.
+     * \return \c true on success. This version can't fail unless it is
+     * given invalid arguments.
+     */
+    bool calculate(const char *data, qint64 size, quint32 *result);
+    /// Calculates the checksum of a file.
+    /** See calculate() for the parameters.
+     * \return \c true on success, otherwise getErrorString() tells what
+     * went wrong.
+     */
+    bool calculateFile(const QString &fileName, quint32 *result);
+    /// Calculates the checksum of the data read from a device.
+    /** The device is read from its current position to its end, from the
+     * calling thread. It must be open for reading.
+     * See calculate() for the parameters and calculateFile() for the
+     * return value.
+     */
+    bool calculateDevice(QIODevice *device, quint32 *result);
+    /// Returns the description of the last error.
+    /** An empty string means there was no error. */
+    QString getErrorString() const;
+private:
+    QuaParallelChecksumPrivate *p;
+    Q_DISABLE_COPY(QuaParallelChecksum)
+};
+
+#endif // QUAZIP_QUAPARALLELCHECKSUM_H
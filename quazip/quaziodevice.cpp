@@ -24,8 +24,14 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include "quaziodevice.h"
 
-#define QUAZIO_INBUFSIZE 4096
-#define QUAZIO_OUTBUFSIZE 4096
+#include <QtCore/QElapsedTimer>
+
+#include "quazip_blockdeflater.h"
+
+/// The default size of the buffers for the compressed data.
+#define QUAZIO_BUFSIZE 4096
+/// The largest piece of data read or written at once in the direct mode.
+#define QUAZIO_DIRECT_MAX (64 * 1024 * 1024)
 
 /// \cond internal
 class QuaZIODevicePrivate {
@@ -36,29 +42,57 @@ class QuaZIODevicePrivate {
     QuaZIODevice *q;
     z_stream zins;
     z_stream zouts;
+    int bufferSize;
+    // bufferSize as of the last reset(), used until the device is closed
+    int openBufferSize;
+    bool direct;
+    int threads;
+    // compresses the data instead of zouts if threads > 1
+    QuaBlockDeflater *writer;
     char *inBuf;
+    int inBufCapacity;
     int inBufPos;
     int inBufSize;
+    // compressed data waiting for the device when writing, decompressed
+    // data read ahead when reading
     char *outBuf;
+    int outBufCapacity;
     int outBufPos;
     int outBufSize;
     bool zBufError;
     bool atEnd;
+    // a flush that is to be finished once the device takes more data
+    int pendingFlush;
+    void reset();
+    int pieceSize(qint64 request) const;
+    static void grow(char *&buf, int &capacity, int size, int used);
+    void takeOutput();
     bool flush(int sync);
     int doFlush(QString &error);
+    qint64 inflateData(char *data, qint64 maxSize);
+    int readAhead();
+    bool readAvailable();
 };
 
 QuaZIODevicePrivate::QuaZIODevicePrivate(QIODevice *io, QuaZIODevice *q):
   io(io),
   q(q),
+  bufferSize(QUAZIO_BUFSIZE),
+  openBufferSize(QUAZIO_BUFSIZE),
+  direct(false),
+  threads(1),
+  writer(nullptr),
   inBuf(nullptr),
+  inBufCapacity(0),
   inBufPos(0),
   inBufSize(0),
   outBuf(nullptr),
+  outBufCapacity(0),
   outBufPos(0),
   outBufSize(0),
   zBufError(false),
-  atEnd(false)
+  atEnd(false),
+  pendingFlush(Z_NO_FLUSH)
 {
   zins.zalloc = (alloc_func) nullptr;
   zins.zfree = (free_func) nullptr;
@@ -66,8 +100,7 @@ QuaZIODevicePrivate::QuaZIODevicePrivate(QIODevice *io, QuaZIODevice *q):
   zouts.zalloc = (alloc_func) nullptr;
   zouts.zfree = (free_func) nullptr;
   zouts.opaque = nullptr;
-  inBuf = new char[QUAZIO_INBUFSIZE];
-  outBuf = new char[QUAZIO_OUTBUFSIZE];
+  reset();
 #ifdef QUAZIP_ZIODEVICE_DEBUG_OUTPUT
   debug.setFileName("debug.out");
   debug.open(QIODevice::WriteOnly);
@@ -86,20 +119,92 @@ QuaZIODevicePrivate::~QuaZIODevicePrivate()
 #ifdef QUAZIP_ZIODEVICE_DEBUG_INPUT
   indebug.close();
 #endif
+  delete writer;
   if (inBuf != nullptr)
     delete[] inBuf;
   if (outBuf != nullptr)
       delete[] outBuf;
 }
 
+void QuaZIODevicePrivate::reset()
+{
+    // the size may have been changed, or grown by the direct mode
+    openBufferSize = bufferSize;
+    if (inBufCapacity != openBufferSize) {
+        delete[] inBuf;
+        inBuf = new char[openBufferSize];
+        inBufCapacity = openBufferSize;
+    }
+    if (outBufCapacity != openBufferSize) {
+        delete[] outBuf;
+        outBuf = new char[openBufferSize];
+        outBufCapacity = openBufferSize;
+    }
+    inBufPos = inBufSize = 0;
+    outBufPos = outBufSize = 0;
+    zBufError = false;
+    atEnd = false;
+    pendingFlush = Z_NO_FLUSH;
+}
+
+int QuaZIODevicePrivate::pieceSize(qint64 request) const
+{
+    if (!direct || request <= openBufferSize)
+        return openBufferSize;
+    return static_cast<int>(qMin(request,
+                                 static_cast<qint64>(QUAZIO_DIRECT_MAX)));
+}
+
+void QuaZIODevicePrivate::grow(char *&buf, int &capacity, int size, int used)
+{
+    if (size <= capacity)
+        return;
+    char *grown = new char[size];
+    memcpy(grown, buf, static_cast<size_t>(used));
+    delete[] buf;
+    buf = grown;
+    capacity = size;
+}
+
+void QuaZIODevicePrivate::takeOutput()
+{
+    if (writer->output.isEmpty())
+        return;
+    // keeps what the device didn't take yet
+    if (outBufPos > 0) {
+        memmove(outBuf, outBuf + outBufPos, outBufSize - outBufPos);
+        outBufSize -= outBufPos;
+        outBufPos = 0;
+    }
+    grow(outBuf, outBufCapacity, outBufSize + writer->output.size(),
+         outBufSize);
+    memcpy(outBuf + outBufSize, writer->output.constData(),
+           writer->output.size());
+    outBufSize += writer->output.size();
+    writer->output.clear();
+}
+
 bool QuaZIODevicePrivate::flush(int sync)
 {
     QString error;
+    if (writer != nullptr) {
+        // the blocks end with sync flushes anyway
+        bool ok = sync == Z_FINISH ? writer->finish() : writer->flush();
+        takeOutput();
+        if (!ok) {
+            q->setErrorString(QuaZIODevice::tr("Failed to compress the"
+                        " data"));
+            return false;
+        }
+    }
     if (doFlush(error) < 0) {
         q->setErrorString(error);
         return false;
     }
+    if (writer != nullptr)
+        return true;
     // can't flush buffer, some data is still waiting
+    pendingFlush = sync;
     if (outBufPos < outBufSize)
         return true;
     Bytef c = 0;
@@ -107,7 +212,7 @@ bool QuaZIODevicePrivate::flush(int sync)
     zouts.avail_in = 0; // of zero size
     do {
         zouts.next_out = (Bytef *) outBuf;
-        zouts.avail_out = QUAZIO_OUTBUFSIZE;
+        zouts.avail_out = outBufCapacity;
         int result = deflate(&zouts, sync);
         switch (result) {
         case Z_OK:
@@ -121,12 +226,14 @@ bool QuaZIODevicePrivate::flush(int sync)
               return true;
           break;
         case Z_BUF_ERROR: // nothing to write?
+          pendingFlush = Z_NO_FLUSH;
           return true;
         default:
           q->setErrorString(QString::fromLocal8Bit(zouts.msg));
           return false;
         }
     } while (zouts.avail_out == 0);
+    pendingFlush = Z_NO_FLUSH;
     return true;
 }
 
@@ -150,6 +257,90 @@ int QuaZIODevicePrivate::doFlush(QString &error)
   return flushed;
 }
 
+qint64 QuaZIODevicePrivate::inflateData(char *data, qint64 maxSize)
+{
+  int read = 0;
+  while (read < maxSize) {
+    if (inBufPos == inBufSize) {
+      // a large read takes as much compressed data in the direct mode
+      int size = pieceSize(maxSize - read);
+      grow(inBuf, inBufCapacity, size, 0);
+      inBufPos = 0;
+      inBufSize = io->read(inBuf, size);
+      if (inBufSize == -1) {
+        inBufSize = 0;
+        q->setErrorString(io->errorString());
+        return -1;
+      }
+      if (inBufSize == 0)
+        break;
+    }
+    while (read < maxSize && inBufPos < inBufSize) {
+      zins.next_in = (Bytef *) (inBuf + inBufPos);
+      zins.avail_in = inBufSize - inBufPos;
+      zins.next_out = (Bytef *) (data + read);
+      zins.avail_out = (uInt) (maxSize - read); // hope it's less than 2GB
+      int more = 0;
+      switch (inflate(&zins, Z_SYNC_FLUSH)) {
+      case Z_OK:
+        read = (char *) zins.next_out - data;
+        inBufPos = (char *) zins.next_in - inBuf;
+        break;
+      case Z_STREAM_END:
+        read = (char *) zins.next_out - data;
+        inBufPos = (char *) zins.next_in - inBuf;
+        atEnd = true;
+        return read;
+      case Z_BUF_ERROR: // this should never happen, but just in case
+        if (!zBufError) {
+          qWarning("Z_BUF_ERROR detected with %d/%d in/out, weird",
+              zins.avail_in, zins.avail_out);
+          zBufError = true;
+        }
+        memmove(inBuf, inBuf + inBufPos, inBufSize - inBufPos);
+        inBufSize -= inBufPos;
+        inBufPos = 0;
+        more = io->read(inBuf + inBufSize, inBufCapacity - inBufSize);
+        if (more == -1) {
+          q->setErrorString(io->errorString());
+          return -1;
+        }
+        if (more == 0)
+          return read;
+        inBufSize += more;
+        break;
+      default:
+        q->setErrorString(QString::fromLocal8Bit(zins.msg));
+        return -1;
+      }
+    }
+  }
+  return read;
+}
+
+int QuaZIODevicePrivate::readAhead()
+{
+  if (atEnd || outBufPos < outBufSize)
+    return 0;
+  qint64 more = inflateData(outBuf, outBufCapacity);
+  outBufPos = 0;
+  outBufSize = more > 0 ? static_cast<int>(more) : 0;
+  return outBufSize;
+}
+
+// Decompresses what the device has got, emitting the signals. Returns
+// whether there is anything new to read.
+bool QuaZIODevicePrivate::readAvailable()
+{
+  bool ended = atEnd;
+  bool ready = readAhead() > 0;
+  if (ready)
+    emit q->readyRead();
+  if (atEnd && !ended)
+    emit q->readChannelFinished();
+  return ready;
+}
+
 /// \endcond
 
 // #define QUAZIP_ZIODEVICE_DEBUG_OUTPUT
@@ -167,7 +358,8 @@ QuaZIODevice::QuaZIODevice(QIODevice *io, QObject *parent):
     QIODevice(parent),
     d(new QuaZIODevicePrivate(io, this))
 {
-  connect(io, SIGNAL(readyRead()), SIGNAL(readyRead()));
+  connect(io, SIGNAL(readyRead()), SLOT(ioReadyRead()));
+  connect(io, SIGNAL(bytesWritten(qint64)), SLOT(ioBytesWritten(qint64)));
 }
 
 QuaZIODevice::~QuaZIODevice()
@@ -182,6 +374,37 @@ QIODevice *QuaZIODevice::getIoDevice() const
     return d->io;
 }
 
+void QuaZIODevice::setBufferSize(int bufferSize)
+{
+    // deflate needs a few bytes of room for a sync flush marker
+    d->bufferSize = qMax(bufferSize, 64);
+}
+
+int QuaZIODevice::getBufferSize() const
+{
+    return d->bufferSize;
+}
+
+void QuaZIODevice::setDirectEnabled(bool direct)
+{
+    d->direct = direct;
+}
+
+bool QuaZIODevice::isDirectEnabled() const
+{
+    return d->direct;
+}
+
+void QuaZIODevice::setMaxThreadCount(int threads)
+{
+    d->threads = qMax(threads, 1);
+}
+
+int QuaZIODevice::getMaxThreadCount() const
+{
+    return d->threads;
+}
+
 bool QuaZIODevice::open(QIODevice::OpenMode mode)
 {
     if ((mode & QIODevice::Append) != 0) {
@@ -194,6 +417,7 @@ bool QuaZIODevice::open(QIODevice::OpenMode mode)
                     " QuaZIODevice"));
         return false;
     }
+    d->reset();
     if ((mode & QIODevice::ReadOnly) != 0) {
         if (inflateInit(&d->zins) != Z_OK) {
             setErrorString(QString::fromLocal8Bit(d->zins.msg));
@@ -201,7 +425,14 @@ bool QuaZIODevice::open(QIODevice::OpenMode mode)
         }
     }
     if ((mode & QIODevice::WriteOnly) != 0) {
-        if (deflateInit(&d->zouts, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        if (d->threads > 1) {
+            d->writer = new QuaBlockDeflater(QuaBlockDeflaterZlib,
+                                             d->threads);
+            // what deflateInit() writes for the default level
+            static const char header[] = {'\x78', '\x9C'};
+            d->writer->output = QByteArray(header, sizeof(header));
+            d->takeOutput();
+        } else if (deflateInit(&d->zouts, Z_DEFAULT_COMPRESSION) != Z_OK) {
             setErrorString(QString::fromLocal8Bit(d->zouts.msg));
             return false;
         }
@@ -218,68 +449,36 @@ void QuaZIODevice::close()
     }
     if ((openMode() & QIODevice::WriteOnly) != 0) {
         d->flush(Z_FINISH);
-        if (deflateEnd(&d->zouts) != Z_OK) {
+        if (d->writer != nullptr) {
+            delete d->writer;
+            d->writer = nullptr;
+        } else if (deflateEnd(&d->zouts) != Z_OK) {
             setErrorString(QString::fromLocal8Bit(d->zouts.msg));
         }
     }
+    // gives back the memory taken by the direct mode
+    d->reset();
     QIODevice::close();
 }
 
 qint64 QuaZIODevice::readData(char *data, qint64 maxSize)
 {
-  int read = 0;
-  while (read < maxSize) {
-    if (d->inBufPos == d->inBufSize) {
-      d->inBufPos = 0;
-      d->inBufSize = d->io->read(d->inBuf, QUAZIO_INBUFSIZE);
-      if (d->inBufSize == -1) {
-        d->inBufSize = 0;
-        setErrorString(d->io->errorString());
-        return -1;
-      }
-      if (d->inBufSize == 0)
-        break;
-    }
-    while (read < maxSize && d->inBufPos < d->inBufSize) {
-      d->zins.next_in = (Bytef *) (d->inBuf + d->inBufPos);
-      d->zins.avail_in = d->inBufSize - d->inBufPos;
-      d->zins.next_out = (Bytef *) (data + read);
-      d->zins.avail_out = (uInt) (maxSize - read); // hope it's less than 2GB
-      int more = 0;
-      switch (inflate(&d->zins, Z_SYNC_FLUSH)) {
-      case Z_OK:
-        read = (char *) d->zins.next_out - data;
-        d->inBufPos = (char *) d->zins.next_in - d->inBuf;
-        break;
-      case Z_STREAM_END:
-        read = (char *) d->zins.next_out - data;
-        d->inBufPos = (char *) d->zins.next_in - d->inBuf;
-        d->atEnd = true;
-        return read;
-      case Z_BUF_ERROR: // this should never happen, but just in case
-        if (!d->zBufError) {
-          qWarning("Z_BUF_ERROR detected with %d/%d in/out, weird",
-              d->zins.avail_in, d->zins.avail_out);
-          d->zBufError = true;
-        }
-        memmove(d->inBuf, d->inBuf + d->inBufPos, d->inBufSize - d->inBufPos);
-        d->inBufSize -= d->inBufPos;
-        d->inBufPos = 0;
-        more = d->io->read(d->inBuf + d->inBufSize, QUAZIO_INBUFSIZE - d->inBufSize);
-        if (more == -1) {
-          setErrorString(d->io->errorString());
-          return -1;
-        }
-        if (more == 0)
-          return read;
-        d->inBufSize += more;
-        break;
-      default:
-        setErrorString(QString::fromLocal8Bit(d->zins.msg));
-        return -1;
-      }
-    }
+  // what was decompressed ahead goes first
+  qint64 read = qMin(static_cast<qint64>(d->outBufSize - d->outBufPos),
+                     maxSize);
+  memcpy(data, d->outBuf + d->outBufPos, static_cast<size_t>(read));
+  d->outBufPos += static_cast<int>(read);
+  if (d->outBufPos == d->outBufSize)
+    d->outBufPos = d->outBufSize = 0;
+  if (read < maxSize && !d->atEnd) {
+    qint64 more = d->inflateData(data + read, maxSize - read);
+    if (more == -1)
+      return read == 0 ? -1 : read;
+    read += more;
   }
+  // the device may have more, but won't say so again
+  if (read == maxSize)
+    d->readAhead();
 #ifdef QUAZIP_ZIODEVICE_DEBUG_INPUT
   indebug.write(data, read);
 #endif
@@ -294,6 +493,32 @@ qint64 QuaZIODevice::writeData(const char *data, qint64 maxSize)
     setErrorString(error);
     return -1;
   }
+  if (d->writer != nullptr) {
+    // block by block, so that the device can hold the rest back
+    while (written < maxSize && d->outBufPos == d->outBufSize) {
+      qint64 count = qMin(maxSize - written,
+                          static_cast<qint64>(QuaBlockDeflater::BlockSize));
+      if (!d->writer->write(data + written, count)) {
+        setErrorString(tr("Failed to compress the data"));
+        return -1;
+      }
+      written += count;
+      d->takeOutput();
+      if (d->doFlush(error) == -1) {
+        setErrorString(error);
+        return -1;
+      }
+    }
+#ifdef QUAZIP_ZIODEVICE_DEBUG_OUTPUT
+    debug.write(data, written);
+#endif
+    return written;
+  }
+  // a large write is deflated in one go in the direct mode
+  if (d->direct && maxSize > d->openBufferSize) {
+    d->grow(d->outBuf, d->outBufCapacity, d->pieceSize(static_cast<qint64>(
+        deflateBound(&d->zouts, static_cast<uLong>(maxSize)))), d->outBufSize);
+  }
   while (written < maxSize) {
       // there is some data waiting in the output buffer
     if (d->outBufPos < d->outBufSize)
@@ -301,7 +526,7 @@ qint64 QuaZIODevice::writeData(const char *data, qint64 maxSize)
     d->zouts.next_in = (Bytef *) (data + written);
     d->zouts.avail_in = (uInt) (maxSize - written); // hope it's less than 2GB
     d->zouts.next_out = (Bytef *) d->outBuf;
-    d->zouts.avail_out = QUAZIO_OUTBUFSIZE;
+    d->zouts.avail_out = d->outBufCapacity;
     switch (deflate(&d->zouts, Z_NO_FLUSH)) {
     case Z_OK:
       written = (char *) d->zouts.next_in - data;
@@ -337,13 +562,82 @@ bool QuaZIODevice::atEnd() const
     // Here we MUST check QIODevice::bytesAvailable() because WE
     // might have reached the end, but QIODevice didn't--
     // it could have simply pre-buffered all remaining data.
-    return (openMode() == NotOpen) || (QIODevice::bytesAvailable() == 0 && d->atEnd);
+    return (openMode() == NotOpen) || (bytesAvailable() == 0 && d->atEnd);
 }
 
 qint64 QuaZIODevice::bytesAvailable() const
 {
-    // If we haven't recevied Z_STREAM_END, it means that
-    // we have at least one more input byte available.
-    // Plus whatever QIODevice has buffered.
-    return (d->atEnd ? 0 : 1) + QIODevice::bytesAvailable();
+    // Whatever QIODevice has buffered, plus what we decompressed ahead.
+    qint64 available = QIODevice::bytesAvailable();
+    if ((openMode() & QIODevice::ReadOnly) != 0)
+        available += d->outBufSize - d->outBufPos;
+    return available;
+}
+
+qint64 QuaZIODevice::bytesToWrite() const
+{
+    qint64 waiting = QIODevice::bytesToWrite() + d->io->bytesToWrite();
+    if ((openMode() & QIODevice::WriteOnly) != 0)
+        waiting += d->outBufSize - d->outBufPos;
+    return waiting;
+}
+
+bool QuaZIODevice::waitForReadyRead(int msecs)
+{
+    if ((openMode() & QIODevice::ReadOnly) == 0)
+        return false;
+    if (bytesAvailable() > 0)
+        return true;
+    QElapsedTimer timer;
+    timer.start();
+    bool waited = false;
+    forever {
+        // the device may have had something already
+        if (d->readAvailable() || bytesAvailable() > 0)
+            return true;
+        if (d->atEnd || (waited && msecs >= 0 && timer.elapsed() >= msecs))
+            return false;
+        qint64 remaining = msecs < 0 ? -1
+            : qMax(msecs - timer.elapsed(), static_cast<qint64>(0));
+        if (!d->io->waitForReadyRead(static_cast<int>(remaining)))
+            return false;
+        waited = true;
+    }
+}
+
+bool QuaZIODevice::waitForBytesWritten(int msecs)
+{
+    if ((openMode() & QIODevice::WriteOnly) == 0)
+        return false;
+    QString error;
+    if (d->doFlush(error) < 0) {
+        setErrorString(error);
+        return false;
+    }
+    // ioBytesWritten() writes the rest
+    return d->io->waitForBytesWritten(msecs);
+}
+
+void QuaZIODevice::ioReadyRead()
+{
+    if ((openMode() & QIODevice::ReadOnly) != 0)
+        d->readAvailable();
+}
+
+void QuaZIODevice::ioBytesWritten(qint64 bytes)
+{
+    if ((openMode() & QIODevice::WriteOnly) == 0)
+        return;
+    // the data the device didn't take before, and the rest of a flush
+    QString error;
+    if (d->writer != nullptr && d->outBufPos == d->outBufSize) {
+        // the blocks compressed meanwhile
+        if (d->writer->write(nullptr, 0))
+            d->takeOutput();
+    }
+    if (d->doFlush(error) < 0)
+        setErrorString(error);
+    else if (d->outBufPos == d->outBufSize && d->pendingFlush != Z_NO_FLUSH)
+        d->flush(d->pendingFlush);
+    emit bytesWritten(bytes);
 }
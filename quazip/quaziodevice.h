@@ -28,7 +28,7 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QtCore/QIODevice>
 #include "quazip_global.h"
 
-#include <zlib.h>
+#include "quazip_zlib.h"
 
 class QuaZIODevicePrivate;
 
@@ -37,6 +37,19 @@ class QuaZIODevicePrivate;
   This class can be used to compress any data written to QIODevice or
   decompress it back. Compressing data sent over a QTcpSocket is a good
   example.
+
+  Neither reading nor writing ever waits for the underlying device, so
+  this class can be used in event-driven code the same way as the
+  device itself. When reading, the data that arrives is decompressed as
+  soon as the device emits readyRead(), and readyRead() is emitted only
+  if that results in some decompressed data, which bytesAvailable() then
+  reports. When writing, whatever the device doesn't take is kept and
+  written once it emits bytesWritten(), which is then emitted too. The
+  waitForReadyRead() and waitForBytesWritten() functions wait for the
+  underlying device, for use without an event loop.
+
+  For writing, the data may be compressed by several threads, see
+  setMaxThreadCount().
   */
 class QUAZIP_EXPORT QuaZIODevice: public QIODevice {
   friend class QuaZIODevicePrivate;
@@ -86,17 +99,114 @@ public:
   virtual void close();
   /// Returns the underlying device.
   QIODevice *getIoDevice() const;
+  /// Sets the size of the buffers for the compressed data.
+  /**
+    The default is 4096 bytes, which keeps the device cheap, but costs a
+    call to the underlying device and to zlib for every 4 KB of
+    compressed data. Larger buffers speed up bulk transfers at the cost
+    of memory. Sizes less than 64 bytes are rounded up to 64.
+
+    Takes effect when the device is opened next time.
+    \sa setDirectEnabled()
+    */
+  void setBufferSize(int bufferSize);
+  /// Returns the size of the buffers for the compressed data.
+  /**
+    \sa setBufferSize()
+    */
+  int getBufferSize() const;
+  /// Enables or disables the direct mode for large reads and writes.
+  /**
+    Off by default. When on, a read or a write of more than the buffer
+    size is done in one piece instead of buffer-sized ones: a large read
+    takes as much compressed data from the underlying device in a single
+    call, and a large write is deflated in a single call and given to
+    the device in another one. The buffers grow as needed, up to 64 MB,
+    until the device is closed. Smaller reads and writes are buffered as
+    usual.
+
+    Meant for bulk transfers with large buffers, such as copying files.
+    \sa setBufferSize()
+    */
+  void setDirectEnabled(bool direct);
+  /// Returns whether the direct mode is on.
+  /**
+    \sa setDirectEnabled()
+    */
+  bool isDirectEnabled() const;
+  /// Sets the number of threads used to compress the data.
+  /**
+    Takes effect the next time the device is opened for writing. With
+    more than one thread, the data is split into 128 KB blocks that are
+    deflated concurrently while the compressed ones are written to the
+    underlying device, each block using the last 32 KB of the data before
+    it as the dictionary. The blocks are joined with sync flushes into a
+    single zlib stream with the combined Adler-32, so the result is read
+    back by this class, or by zlib's uncompress(), as usual. It is
+    slightly larger than with a single thread.
+
+    A write returns once the data is handed over to the threads, and
+    flush() waits for them to compress everything written so far, so the
+    data can be decompressed up to that point just like with a single
+    thread.
+
+    The default is 1, which means compressing the data in the calling
+    thread. Has no effect on reading.
+    */
+  void setMaxThreadCount(int threads);
+  /// Returns the number of threads used to compress the data.
+  /**
+    \sa setMaxThreadCount()
+    */
+  int getMaxThreadCount() const;
   /// Returns true.
   virtual bool isSequential() const;
   /// Returns true iff the end of the compressed stream is reached.
   virtual bool atEnd() const;
-  /// Returns the number of the bytes buffered.
+  /// Returns the number of the bytes that can be read without waiting.
+  /**
+    That is, the decompressed bytes buffered. There may be more, as the
+    compressed data is decompressed ahead in small pieces only, but if
+    this returns 0, reading returns nothing until the underlying device
+    gets more data.
+    */
   virtual qint64 bytesAvailable() const;
+  /// Returns the number of the compressed bytes waiting to be written.
+  /**
+    Includes what is buffered by the underlying device. Just like with
+    that device, this can be used to stop writing when too much data is
+    waiting, and resume when bytesWritten() is emitted. The data kept by
+    zlib until the next flush() is not counted.
+
+    Note that, just like this count, the argument of bytesWritten() is the
+    number of the compressed bytes written by the underlying device, not
+    the number of the bytes passed to write().
+    */
+  virtual qint64 bytesToWrite() const;
+  /// Waits until some decompressed data can be read.
+  /**
+    Waits for the underlying device as many times as needed to get at
+    least one decompressed byte, but no longer than \a msecs in total,
+    or forever if \a msecs is -1. Emits readyRead() once it gets some.
+
+    \return \c true if some data can be read, \c false on timeout, on
+    an error, or at the end of the compressed stream.
+    */
+  virtual bool waitForReadyRead(int msecs);
+  /// Waits until the underlying device writes some data.
+  /**
+    Writes out whatever the device didn't take before, and calls its
+    waitForBytesWritten().
+    */
+  virtual bool waitForBytesWritten(int msecs);
 protected:
   /// Implementation of QIODevice::readData().
   virtual qint64 readData(char *data, qint64 maxSize);
   /// Implementation of QIODevice::writeData().
   virtual qint64 writeData(const char *data, qint64 maxSize);
+private slots:
+  void ioReadyRead();
+  void ioBytesWritten(qint64 bytes);
 private:
   QuaZIODevicePrivate *d;
 };
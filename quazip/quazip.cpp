@@ -22,13 +22,22 @@ Original ZIP package is copyrighted by Gilles Vollant, see
 quazip/(un)zip.h files for details, basically it's zlib license.
  **/
 
+#include <QtCore/QBuffer>
 #include <QtCore/QFile>
 #include <QtCore/QFlags>
 #include <QtCore/QHash>
+#include <QtCore/QThread>
+
+#include <climits>
 
 #include "quazip.h"
+#include "quazipcodec.h"
+#include "quazipfile.h"
+#include "quazip_crc32.h"
 
 #define QUAZIP_OS_UNIX 3u
+/// The size of the pieces of data copied between ZIP and GZIP files.
+#define QUAZIP_GZIP_COPY_SIZE (64 * 1024)
 
 /// All the internal stuff for the QuaZip class.
 /**
@@ -76,6 +85,8 @@ class QuaZipPrivate {
     bool utf8;
     /// The OS code.
     uint osCode;
+    /// The number of threads compressing each new file.
+    int threadCount;
     inline QTextCodec *getDefaultFileNameCodec()
     {
         if (defaultFileNameCodec == nullptr) {
@@ -97,7 +108,8 @@ class QuaZipPrivate {
       zip64(false),
       autoClose(true),
       utf8(false),
-      osCode(defaultOsCode)
+      osCode(defaultOsCode),
+      threadCount(1)
     {
         unzFile_f = nullptr;
         zipFile_f = nullptr;
@@ -118,7 +130,8 @@ class QuaZipPrivate {
       zip64(false),
       autoClose(true),
       utf8(false),
-      osCode(defaultOsCode)
+      osCode(defaultOsCode),
+      threadCount(1)
     {
         unzFile_f = nullptr;
         zipFile_f = nullptr;
@@ -138,7 +151,8 @@ class QuaZipPrivate {
       zip64(false),
       autoClose(true),
       utf8(false),
-      osCode(defaultOsCode)
+      osCode(defaultOsCode),
+      threadCount(1)
     {
         unzFile_f = nullptr;
         zipFile_f = nullptr;
@@ -149,6 +163,15 @@ class QuaZipPrivate {
     template<typename TFileInfo>
         bool getFileInfoList(QList<TFileInfo> *result) const;
 
+    /// Sets the current file and returns its uncompressed size.
+    /** \a caller is the name of the public method, for the warnings. */
+    qint64 locateEntry(const char *caller, const QString &fileName,
+                       QuaZip::CaseSensitivity cs, unz_file_info64 *info);
+    /// Decompresses the current file into the buffer of exactly its size.
+    bool readCurrentEntry(char *data, const unz_file_info64 &info);
+    /// Reads the open current file, raw or not, into the buffer.
+    bool readCurrentFile(char *data, qint64 size);
+
     /// Stores map of filenames and file locations for unzipping
       inline void clearDirectoryMap();
       inline void addCurrentFileToDirectoryMap(const QString &fileName);
@@ -615,6 +638,18 @@ uint QuaZip::getOsCode() const
     return p->osCode;
 }
 
+void QuaZip::setThreadCount(int threadCount)
+{
+    if (threadCount == 0)
+        threadCount = QThread::idealThreadCount();
+    p->threadCount = qMax(threadCount, 1);
+}
+
+int QuaZip::getThreadCount() const
+{
+    return p->threadCount;
+}
+
 QTextCodec *QuaZip::getFileNameCodec()const
 {
   return p->fileNameCodec;
@@ -780,6 +815,391 @@ QList<QuaZipFileInfo64> QuaZip::getFileInfoList64() const
         return QList<QuaZipFileInfo64>();
 }
 
+qint64 QuaZipPrivate::locateEntry(const char *caller,
+                                  const QString &fileName,
+                                  QuaZip::CaseSensitivity cs,
+                                  unz_file_info64 *info)
+{
+  zipError=UNZ_OK;
+  if (mode!=QuaZip::mdUnzip) {
+    qWarning("%s: ZIP is not open in mdUnzip mode", caller);
+    return -1;
+  }
+  if (!q->setCurrentFile(fileName, cs) || !hasCurrentFile_f)
+    return -1;
+  if ((zipError=unzGetCurrentFileInfo64(unzFile_f, info,
+          nullptr, 0, nullptr, 0, nullptr, 0))!=UNZ_OK)
+    return -1;
+  if ((info->flag & 1) != 0) {
+    qWarning("%s: %s is encrypted", caller,
+             fileName.toLocal8Bit().constData());
+    zipError=UNZ_PARAMERROR;
+    return -1;
+  }
+  return static_cast<qint64>(info->uncompressed_size);
+}
+
+bool QuaZipPrivate::readCurrentEntry(char *data, const unz_file_info64 &info)
+{
+  qint64 size = static_cast<qint64>(info.uncompressed_size);
+  qint64 compressedSize = static_cast<qint64>(info.compressed_size);
+  if (QuaZipCodec::getBackend()==QuaZipCodec::Zlib
+      || info.compression_method!=Z_DEFLATED
+      || compressedSize > INT_MAX) {
+    if ((zipError=unzOpenCurrentFile(unzFile_f))!=UNZ_OK)
+      return false;
+    if (!readCurrentFile(data, size))
+      return false;
+    // checks the CRC
+    zipError=unzCloseCurrentFile(unzFile_f);
+    return zipError==UNZ_OK;
+  }
+  // Another backend decompresses whole buffers faster than zlib can
+  // inflate the stream, so the compressed data is read as is.
+  QByteArray compressed;
+  compressed.resize(static_cast<int>(compressedSize));
+  if ((zipError=unzOpenCurrentFile2(unzFile_f, nullptr, nullptr, 1))!=UNZ_OK)
+    return false;
+  if (!readCurrentFile(compressed.data(), compressedSize))
+    return false;
+  if ((zipError=unzCloseCurrentFile(unzFile_f))!=UNZ_OK)
+    return false;
+  if ((zipError=QuaZipCodec::inflateRaw(compressed.constData(),
+          compressedSize, data, size))!=Z_OK)
+    return false;
+  uLong crc = quazip_crc32(0L, reinterpret_cast<const Bytef*>(data),
+                           static_cast<size_t>(size));
+  if (crc!=info.crc) {
+    zipError=UNZ_CRCERROR;
+    return false;
+  }
+  return true;
+}
+
+bool QuaZipPrivate::readCurrentFile(char *data, qint64 size)
+{
+  // unzReadCurrentFile() keeps inflating until the buffer is full,
+  // so this is a single call unless the entry is larger than 2 GB
+  qint64 done = 0;
+  while (done < size) {
+    int read = unzReadCurrentFile(unzFile_f, data + done,
+        static_cast<unsigned>(qMin(size - done, static_cast<qint64>(INT_MAX))));
+    if (read <= 0) {
+      zipError = read < 0 ? read : UNZ_BADZIPFILE;
+      unzCloseCurrentFile(unzFile_f);
+      return false;
+    }
+    done += read;
+  }
+  return true;
+}
+
+QByteArray QuaZip::readEntry(const QString &fileName, CaseSensitivity cs)
+{
+  unz_file_info64 info;
+  qint64 size = p->locateEntry("QuaZip::readEntry()", fileName, cs, &info);
+  if (size < 0)
+    return QByteArray();
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  if (size > INT_MAX) {
+    p->zipError=UNZ_PARAMERROR;
+    return QByteArray();
+  }
+#endif
+  QByteArray data;
+  data.resize(size);
+  if (!p->readCurrentEntry(data.data(), info))
+    return QByteArray();
+  return data;
+}
+
+qint64 QuaZip::readEntry(const QString &fileName, char *data, qint64 maxSize,
+                         CaseSensitivity cs)
+{
+  unz_file_info64 info;
+  qint64 size = p->locateEntry("QuaZip::readEntry()", fileName, cs, &info);
+  if (size < 0)
+    return -1;
+  if (size > maxSize) {
+    p->zipError=UNZ_PARAMERROR;
+    return -1;
+  }
+  if (!p->readCurrentEntry(data, info))
+    return -1;
+  return size;
+}
+
+QList<QByteArray> QuaZip::readEntries(const QStringList &fileNames,
+                                      CaseSensitivity cs)
+{
+  QList<QByteArray> result;
+#if QT_VERSION >= 0x040700
+  result.reserve(fileNames.size());
+#endif
+  for (int i = 0; i < fileNames.size(); ++i) {
+    QByteArray data = readEntry(fileNames.at(i), cs);
+    if (data.isNull())
+      return QList<QByteArray>();
+    result.append(data);
+  }
+  return result;
+}
+
+bool QuaZip::addEntry(const QuaZipNewInfo &info, const QByteArray &data,
+                      int level)
+{
+  p->zipError=UNZ_OK;
+  if (p->mode!=mdCreate && p->mode!=mdAppend && p->mode!=mdAdd) {
+    qWarning("QuaZip::addEntry(): ZIP is not open in mdCreate, mdAppend or mdAdd mode");
+    return false;
+  }
+  if (static_cast<qint64>(data.size()) > INT_MAX) {
+    qWarning("QuaZip::addEntry(): the data is too large");
+    return false;
+  }
+  uInt size = static_cast<uInt>(data.size());
+  uLong crc = quazip_crc32(0L,
+                    reinterpret_cast<const Bytef*>(data.constData()), size);
+  int method = 0;
+  QByteArray compressed;
+  if (level != 0 && size != 0) {
+    // if it doesn't get any smaller, it doesn't fit and is stored
+    compressed.resize(static_cast<int>(size - 1));
+    qint64 compressedSize = QuaZipCodec::deflateRaw(data.constData(), size,
+        compressed.data(), compressed.size(), level);
+    if (compressedSize < 0) {
+      p->zipError=static_cast<int>(compressedSize);
+      return false;
+    }
+    if (compressedSize > 0) {
+      compressed.resize(static_cast<int>(compressedSize));
+      method = Z_DEFLATED;
+    }
+  }
+  const QByteArray &payload = method==Z_DEFLATED ? compressed : data;
+  QuaZipNewInfo rawInfo(info);
+  rawInfo.uncompressedSize = size;
+  if ((p->zipError=zipSetKnownSizes(p->zipFile_f, crc, payload.size(), size))!=ZIP_OK)
+    return false;
+  QuaZipFile file(this);
+  if (!file.open(QIODevice::WriteOnly, rawInfo, nullptr, crc, method,
+                 method==Z_DEFLATED ? level : 0, true)) {
+    p->zipError=file.getZipError();
+    return false;
+  }
+  if (file.write(payload)!=payload.size()) {
+    p->zipError=file.getZipError();
+    file.close();
+    return false;
+  }
+  file.close();
+  p->zipError=file.getZipError();
+  return p->zipError==ZIP_OK;
+}
+
+static quint32 quazip_gzip_get_uint16(const char *data)
+{
+  const uchar *bytes = reinterpret_cast<const uchar*>(data);
+  return static_cast<quint32>(bytes[0]) | (static_cast<quint32>(bytes[1]) << 8);
+}
+
+static quint32 quazip_gzip_get_uint32(const char *data)
+{
+  return quazip_gzip_get_uint16(data) | (quazip_gzip_get_uint16(data + 2) << 16);
+}
+
+static void quazip_gzip_put_uint32(char *data, quint32 value)
+{
+  for (int i = 0; i < 4; ++i)
+    data[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+}
+
+/// Skips the header of a GZIP file, and returns the compression level.
+/**
+  \internal
+
+  Returns -2 if it isn't a GZIP header, or one of the blocked format.
+  */
+static int quazip_gzip_skip_header(QIODevice *gzip)
+{
+  QByteArray header = gzip->read(10);
+  if (header.size()!=10 || header.at(0)!='\x1F' || header.at(1)!='\x8B'
+      || header.at(2)!=Z_DEFLATED || (header.at(3) & 0xE0)!=0)
+    return -2;
+  int flags = static_cast<uchar>(header.at(3));
+  if ((flags & 4)!=0) {
+    // FEXTRA
+    QByteArray length = gzip->read(2);
+    if (length.size()!=2)
+      return -2;
+    int extraSize = static_cast<int>(quazip_gzip_get_uint16(length.constData()));
+    QByteArray extra = gzip->read(extraSize);
+    if (extra.size()!=extraSize)
+      return -2;
+    for (int pos = 0; pos + 4 <= extraSize; ) {
+      if (extra.at(pos)=='B' && extra.at(pos + 1)=='C') {
+        qWarning("QuaZip::addGzipEntry(): blocked GZIP files have many members");
+        return -2;
+      }
+      pos += 4 + static_cast<int>(
+          quazip_gzip_get_uint16(extra.constData() + pos + 2));
+    }
+  }
+  // FNAME and FCOMMENT
+  for (int field = 8; field <= 16; field *= 2) {
+    if ((flags & field)==0)
+      continue;
+    char c;
+    do {
+      if (!gzip->getChar(&c))
+        return -2;
+    } while (c!='\0');
+  }
+  // FHCRC
+  if ((flags & 2)!=0 && gzip->read(2).size()!=2)
+    return -2;
+  // the extra flags tell about the level, much like the ZIP flags do
+  switch (static_cast<uchar>(header.at(8))) {
+  case 2:
+    return 9;
+  case 4:
+    return 1;
+  default:
+    return Z_DEFAULT_COMPRESSION;
+  }
+}
+
+bool QuaZip::readEntryAsGzip(const QString &fileName, QIODevice *gzip,
+                             CaseSensitivity cs)
+{
+  p->zipError=UNZ_OK;
+  if (gzip==nullptr || !gzip->isWritable()) {
+    qWarning("QuaZip::readEntryAsGzip(): the device is not open for writing");
+    return false;
+  }
+  unz_file_info64 info;
+  if (p->locateEntry("QuaZip::readEntryAsGzip()", fileName, cs, &info) < 0)
+    return false;
+  bool stored = info.compression_method==0;
+  if (!stored && info.compression_method!=Z_DEFLATED) {
+    qWarning("QuaZip::readEntryAsGzip(): %s is neither deflated nor stored",
+             fileName.toLocal8Bit().constData());
+    p->zipError=UNZ_PARAMERROR;
+    return false;
+  }
+  if ((p->zipError=unzOpenCurrentFile2(p->unzFile_f, nullptr, nullptr, 1))!=UNZ_OK)
+    return false;
+  // no time or name, the OS is unknown
+  char header[10] = {'\x1F', '\x8B', Z_DEFLATED, 0, 0, 0, 0, 0, 0, '\xFF'};
+  switch ((info.flag >> 1) & 3) {
+  case 1:
+    header[8] = 2;
+    break;
+  case 2:
+  case 3:
+    header[8] = 4;
+    break;
+  }
+  if (gzip->write(header, sizeof(header))!=static_cast<qint64>(sizeof(header))) {
+    p->zipError=UNZ_ERRNO;
+    unzCloseCurrentFile(p->unzFile_f);
+    return false;
+  }
+  // a stored deflate block takes at most 64 KB - 1, after a 5-byte header
+  const qint64 pieceSize = stored ? 0xFFFF : QUAZIP_GZIP_COPY_SIZE;
+  QByteArray buffer(static_cast<int>(pieceSize) + 5, '\0');
+  qint64 remaining = static_cast<qint64>(info.compressed_size);
+  do {
+    qint64 count = qMin(remaining, pieceSize);
+    char *data = buffer.data() + (stored ? 5 : 0);
+    if (count > 0 && !p->readCurrentFile(data, count))
+      return false;
+    remaining -= count;
+    if (stored) {
+      buffer[0] = static_cast<char>(remaining==0 ? 1 : 0);
+      quint32 length = static_cast<quint32>(count);
+      quazip_gzip_put_uint32(buffer.data() + 1, length | ((~length) << 16));
+      count += 5;
+    }
+    if (gzip->write(buffer.constData(), count)!=count) {
+      p->zipError=UNZ_ERRNO;
+      unzCloseCurrentFile(p->unzFile_f);
+      return false;
+    }
+  } while (remaining > 0);
+  if ((p->zipError=unzCloseCurrentFile(p->unzFile_f))!=UNZ_OK)
+    return false;
+  char trailer[8];
+  quazip_gzip_put_uint32(trailer, static_cast<quint32>(info.crc));
+  quazip_gzip_put_uint32(trailer + 4,
+                         static_cast<quint32>(info.uncompressed_size));
+  if (gzip->write(trailer, sizeof(trailer))!=static_cast<qint64>(sizeof(trailer))) {
+    p->zipError=UNZ_ERRNO;
+    return false;
+  }
+  return true;
+}
+
+bool QuaZip::addGzipEntry(const QuaZipNewInfo &info, QIODevice *gzip)
+{
+  p->zipError=UNZ_OK;
+  if (p->mode!=mdCreate && p->mode!=mdAppend && p->mode!=mdAdd) {
+    qWarning("QuaZip::addGzipEntry(): ZIP is not open in mdCreate, mdAppend or mdAdd mode");
+    return false;
+  }
+  if (gzip==nullptr || !gzip->isReadable()) {
+    qWarning("QuaZip::addGzipEntry(): the device is not open for reading");
+    return false;
+  }
+  if (gzip->isSequential()) {
+    // the trailer is needed first
+    QByteArray data = gzip->readAll();
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    return addGzipEntry(info, &buffer);
+  }
+  int level = quazip_gzip_skip_header(gzip);
+  qint64 start = gzip->pos();
+  // the smallest deflate stream is 2 bytes long
+  qint64 compressedSize = gzip->size() - start - 8;
+  QByteArray trailer;
+  if (level==-2 || compressedSize < 2 || !gzip->seek(start + compressedSize)
+      || (trailer = gzip->read(8)).size()!=8 || !gzip->seek(start)) {
+    p->zipError=Z_DATA_ERROR;
+    return false;
+  }
+  quint32 crc = quazip_gzip_get_uint32(trailer.constData());
+  quint32 size = quazip_gzip_get_uint32(trailer.constData() + 4);
+  QuaZipNewInfo rawInfo(info);
+  rawInfo.uncompressedSize = size;
+  if ((p->zipError=zipSetKnownSizes(p->zipFile_f, crc, compressedSize, size))!=ZIP_OK)
+    return false;
+  QuaZipFile file(this);
+  if (!file.open(QIODevice::WriteOnly, rawInfo, nullptr, crc, Z_DEFLATED,
+                 level, true)) {
+    p->zipError=file.getZipError();
+    return false;
+  }
+  QByteArray buffer(QUAZIP_GZIP_COPY_SIZE, '\0');
+  for (qint64 remaining = compressedSize; remaining > 0; ) {
+    qint64 count = qMin(remaining, static_cast<qint64>(buffer.size()));
+    if (gzip->read(buffer.data(), count)!=count) {
+      p->zipError=ZIP_ERRNO;
+      file.close();
+      return false;
+    }
+    if (file.write(buffer.constData(), count)!=count) {
+      p->zipError=file.getZipError();
+      file.close();
+      return false;
+    }
+    remaining -= count;
+  }
+  file.close();
+  p->zipError=file.getZipError();
+  return p->zipError==ZIP_OK;
+}
+
 Qt::CaseSensitivity QuaZip::convertCaseSensitivity(QuaZip::CaseSensitivity cs)
 {
   if (cs == csDefault) {
@@ -42,6 +42,7 @@ quazip/(un)zip.h files for details, basically it's zlib license.
 #endif
 
 class QuaZipPrivate;
+struct QuaZipNewInfo;
 
 /// ZIP archive.
 /** \class QuaZip quazip.h <quazip/quazip.h>
@@ -240,6 +241,20 @@ class QUAZIP_EXPORT QuaZip {
     void setOsCode(uint osCode);
     /// Returns the OS code for new files.
     uint getOsCode() const;
+    /// Sets the number of threads compressing each new file.
+    /** This applies to the methods that can split their data into
+     * independent blocks: Z_XZ, whose blocks are several megabytes large,
+     * and Z_BZIP2ED, whose blocks are a bit less than 100 KB times the
+     * compression level, but only when written with QuaZipFile. Only
+     * files larger than a block benefit from it. Other methods always
+     * use the thread writing the file.
+     *
+     * The default is 1. Passing 0 uses QThread::idealThreadCount(). Takes
+     * effect when the next file is opened for writing.
+     */
+    void setThreadCount(int threadCount);
+    /// Returns the number of threads compressing each new file.
+    int getThreadCount() const;
     /// Returns the codec used to encode/decode comments inside archive.
     QTextCodec* getFileNameCodec() const;
     /// Sets the codec used to encode/decode comments inside archive.
@@ -493,6 +508,149 @@ class QUAZIP_EXPORT QuaZip {
       \sa getFileInfoList()
       */
     QList<QuaZipFileInfo64> getFileInfoList64() const;
+    /// Reads the whole contents of a file inside the archive.
+    /**
+      This is a faster alternative to opening the file with QuaZipFile
+      and calling QIODevice::readAll(). The uncompressed size is known
+      from the central directory, so the resulting array is allocated
+      once and the data is decompressed right into it. The CRC is
+      verified. If a faster backend is selected with
+      QuaZipCodec::setBackend(), the compressed data is read first and
+      decompressed in one go.
+
+      Should be used only in QuaZip::mdUnzip mode, and only when no
+      QuaZipFile instance has a file of this archive open. Encrypted
+      files can't be read this way, getZipError() returns
+      \c UNZ_PARAMERROR for them. On return, the current file is set
+      to \a fileName if it was found.
+
+      \param fileName The name of the file to read.
+      \param cs The case sensitivity, as in setCurrentFile().
+      \return The contents of the file, or a null QByteArray if there
+      was an error or the file wasn't found. In the latter case,
+      getZipError() returns \c UNZ_OK. An empty file results in an
+      empty, but non-null array.
+
+      \sa readEntries()
+      */
+    QByteArray readEntry(const QString &fileName, CaseSensitivity cs =csDefault);
+    /// Reads the whole contents of a file into a caller-provided buffer.
+    /**
+      \overload
+
+      No memory is allocated by this function, so a buffer can be
+      reused to read many files. If the file doesn't fit into the
+      buffer, nothing is read, the function returns -1 and getZipError()
+      returns \c UNZ_PARAMERROR. The required size is
+      QuaZipFileInfo64::uncompressedSize.
+
+      \param fileName The name of the file to read.
+      \param data The buffer to read the data into.
+      \param maxSize The size of the buffer.
+      \param cs The case sensitivity, as in setCurrentFile().
+      \return The number of bytes read, or -1 if there was an error or
+      the file wasn't found.
+      */
+    qint64 readEntry(const QString &fileName, char *data, qint64 maxSize,
+                     CaseSensitivity cs =csDefault);
+    /// Reads the whole contents of several files inside the archive.
+    /**
+      Works like readEntry() for each file in turn.
+
+      \return The contents of the files, in the order of \a fileNames,
+      or an empty list if one of the files couldn't be read or found.
+      */
+    QList<QByteArray> readEntries(const QStringList &fileNames,
+                                  CaseSensitivity cs =csDefault);
+    /// Adds a file with the specified contents to the archive.
+    /**
+      This is a faster alternative to writing the data with QuaZipFile.
+      Since all the data is available at once, it is compressed with a
+      single deflate call, and the CRC and the sizes are known before
+      anything is written. So the local header is written only once,
+      with the final values, and without a data descriptor, even if the
+      archive is written to a sequential device.
+
+      If compression doesn't make the data smaller, or \a level is 0,
+      the data is stored uncompressed instead.
+
+      The data is compressed by the backend selected with
+      QuaZipCodec::setBackend().
+
+      Should be used only in QuaZip::mdCreate, QuaZip::mdAppend and
+      QuaZip::mdAdd modes, and only when no QuaZipFile instance has a
+      file of this archive open.
+
+      \param info The information about the new file. The
+      \ref QuaZipNewInfo::uncompressedSize "uncompressedSize" field is
+      ignored.
+      \param data The contents of the new file.
+      \param level The compression level, from 0 to 9, or
+      \c Z_DEFAULT_COMPRESSION.
+      \return \c true on success. Otherwise, getZipError() returns the
+      error code.
+      */
+    bool addEntry(const QuaZipNewInfo &info, const QByteArray &data,
+                  int level =Z_DEFAULT_COMPRESSION);
+    /// Writes a file inside the archive to a device as a GZIP stream.
+    /**
+      The deflated data of a file in a ZIP archive, along with its CRC
+      and size, is what a GZIP member consists of. So the compressed data
+      is copied to \a gzip as is, between a GZIP header and trailer, and
+      nothing is decompressed or compressed again. This is useful to serve
+      files in an archive with the \c gzip content encoding, for example.
+      A stored file is written in stored deflate blocks.
+
+      The data isn't checked, so a corrupt file results in a corrupt
+      GZIP stream.
+
+      Should be used only in QuaZip::mdUnzip mode, and only when no
+      QuaZipFile instance has a file of this archive open. Encrypted
+      files and files compressed with other methods can't be written
+      this way.
+
+      \param fileName The name of the file to write.
+      \param gzip The device to write to, open for writing.
+      \param cs The case sensitivity, as in setCurrentFile().
+      \return \c true on success. Otherwise, getZipError() returns the
+      error code, which is \c UNZ_OK if the file wasn't found.
+
+      \sa addGzipEntry()
+      */
+    bool readEntryAsGzip(const QString &fileName, QIODevice *gzip,
+                         CaseSensitivity cs =csDefault);
+    /// Adds the contents of a GZIP file to the archive.
+    /**
+      The reverse of readEntryAsGzip(): the deflated data in \a gzip is
+      copied to a new deflated file as is, with the CRC and the size from
+      the GZIP trailer, and nothing is decompressed or compressed again.
+      As with addEntry(), the local header is written only once.
+
+      The GZIP file must consist of a single member, as written by
+      \c gzip, \c pigz or QuaGzipFile without the blocked format, and
+      must be smaller than 4 GB uncompressed, since a GZIP trailer has
+      only the lower 32 bits of the size. Files in the blocked format
+      are rejected, but other members following the first one can't be
+      detected without decompressing them, and end up in the archive as
+      a file that fails the CRC check. The compression level recorded in
+      the GZIP header is kept.
+
+      A sequential device is read into memory first, since the sizes and
+      the CRC must be known before the data is written.
+
+      Should be used only in QuaZip::mdCreate, QuaZip::mdAppend and
+      QuaZip::mdAdd modes, and only when no QuaZipFile instance has a
+      file of this archive open.
+
+      \param info The information about the new file. The
+      \ref QuaZipNewInfo::uncompressedSize "uncompressedSize" field is
+      ignored.
+      \param gzip The device to read the GZIP file from, open for
+      reading and positioned at its start.
+      \return \c true on success. Otherwise, getZipError() returns the
+      error code, \c Z_DATA_ERROR if \a gzip isn't a GZIP file.
+      */
+    bool addGzipEntry(const QuaZipNewInfo &info, QIODevice *gzip);
     /// Enables the zip64 mode.
     /**
      * @param zip64 If \c true, the zip64 mode is enabled, disabled otherwise.
@@ -0,0 +1,366 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+  The vector versions follow the one in Chromium's zlib: the data is
+  taken 32 bytes at a time, s1 is the sum of the bytes and s2 gets the
+  bytes multiplied by their distance from the end of the block, plus 32
+  times s1 before the block. The sums are reduced modulo 65521 every
+  NMAX bytes, like zlib does, so that they never overflow.
+*/
+
+#include "quazip_adler32.h"
+
+#ifndef local
+#  define local static
+#endif
+
+#ifndef QUAZIP_ADLER32_NO_SIMD
+#  if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+#      define QUAZIP_ADLER32_X86
+#    endif
+#  elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#    define QUAZIP_ADLER32_NEON
+#  endif
+#endif
+
+#ifdef QUAZIP_ADLER32_X86
+#  include <emmintrin.h>
+#  include <tmmintrin.h>
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    define QUAZIP_ADLER32_TARGET_SSSE3
+#    define QUAZIP_ADLER32_TARGET_AVX2
+#  else
+#    include <cpuid.h>
+#    define QUAZIP_ADLER32_TARGET_SSSE3 __attribute__((target("ssse3")))
+#    define QUAZIP_ADLER32_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+
+#ifdef QUAZIP_ADLER32_NEON
+#  include <arm_neon.h>
+#endif
+
+#define QUAZIP_ADLER32_C 1
+#define QUAZIP_ADLER32_SSSE3 2
+#define QUAZIP_ADLER32_AVX2 3
+#define QUAZIP_ADLER32_NEON_IMPL 4
+
+#define QUAZIP_ADLER32_BASE 65521U
+/* the largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1 */
+#define QUAZIP_ADLER32_NMAX 5552
+#define QUAZIP_ADLER32_BLOCK 32
+/* Shorter buffers are left to the plain C version. */
+#define QUAZIP_ADLER32_SIMD_MIN 64
+
+local uLong quazip_adler32_c(uLong adler, const Bytef* buf, size_t len)
+{
+    unsigned long s1 = adler & 0xffff;
+    unsigned long s2 = (adler >> 16) & 0xffff;
+    while (len != 0)
+    {
+        size_t n = len < QUAZIP_ADLER32_NMAX ? len : QUAZIP_ADLER32_NMAX;
+        len -= n;
+        while (n >= 8)
+        {
+            s1 += buf[0]; s2 += s1;
+            s1 += buf[1]; s2 += s1;
+            s1 += buf[2]; s2 += s1;
+            s1 += buf[3]; s2 += s1;
+            s1 += buf[4]; s2 += s1;
+            s1 += buf[5]; s2 += s1;
+            s1 += buf[6]; s2 += s1;
+            s1 += buf[7]; s2 += s1;
+            buf += 8;
+            n -= 8;
+        }
+        while (n-- != 0)
+        {
+            s1 += *buf++;
+            s2 += s1;
+        }
+        s1 %= QUAZIP_ADLER32_BASE;
+        s2 %= QUAZIP_ADLER32_BASE;
+    }
+    return (s2 << 16) | s1;
+}
+
+#ifdef QUAZIP_ADLER32_X86
+QUAZIP_ADLER32_TARGET_SSSE3
+local uLong quazip_adler32_ssse3(uLong adler, const Bytef* buf, size_t len)
+{
+    unsigned long s1 = adler & 0xffff;
+    unsigned long s2 = (adler >> 16) & 0xffff;
+    size_t blocks = len / QUAZIP_ADLER32_BLOCK;
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    len -= blocks * QUAZIP_ADLER32_BLOCK;
+    while (blocks != 0)
+    {
+        size_t n = QUAZIP_ADLER32_NMAX / QUAZIP_ADLER32_BLOCK;
+        __m128i v_ps, v_s1, v_s2;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+        /* s1 before each block, added to s2 32 times at the end */
+        v_ps = _mm_cvtsi32_si128((int)(s1 * n));
+        v_s2 = _mm_cvtsi32_si128((int)s2);
+        v_s1 = zero;
+        do
+        {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i*)buf);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i*)(buf + 16));
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2,
+                _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            buf += QUAZIP_ADLER32_BLOCK;
+        } while (--n != 0);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 = (s1 + (unsigned)_mm_cvtsi128_si32(v_s1)) % QUAZIP_ADLER32_BASE;
+        s2 = (unsigned)_mm_cvtsi128_si32(v_s2) % QUAZIP_ADLER32_BASE;
+    }
+    return quazip_adler32_c((s2 << 16) | s1, buf, len);
+}
+
+QUAZIP_ADLER32_TARGET_AVX2
+local uLong quazip_adler32_avx2(uLong adler, const Bytef* buf, size_t len)
+{
+    unsigned long s1 = adler & 0xffff;
+    unsigned long s2 = (adler >> 16) & 0xffff;
+    size_t blocks = len / QUAZIP_ADLER32_BLOCK;
+    const __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                         24, 23, 22, 21, 20, 19, 18, 17,
+                                         16, 15, 14, 13, 12, 11, 10, 9,
+                                         8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    len -= blocks * QUAZIP_ADLER32_BLOCK;
+    while (blocks != 0)
+    {
+        size_t n = QUAZIP_ADLER32_NMAX / QUAZIP_ADLER32_BLOCK;
+        __m256i v_ps, v_s1, v_s2;
+        __m128i h_s1, h_s2;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+        v_ps = _mm256_setr_epi32((int)(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+        v_s2 = _mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0);
+        v_s1 = zero;
+        do
+        {
+            const __m256i bytes = _mm256_loadu_si256((const __m256i*)buf);
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+            v_s2 = _mm256_add_epi32(v_s2,
+                _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, tap), ones));
+            buf += QUAZIP_ADLER32_BLOCK;
+        } while (--n != 0);
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+        h_s1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                             _mm256_extracti128_si256(v_s1, 1));
+        h_s2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                             _mm256_extracti128_si256(v_s2, 1));
+        h_s1 = _mm_add_epi32(h_s1, _mm_shuffle_epi32(h_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        h_s1 = _mm_add_epi32(h_s1, _mm_shuffle_epi32(h_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 = (s1 + (unsigned)_mm_cvtsi128_si32(h_s1)) % QUAZIP_ADLER32_BASE;
+        s2 = (unsigned)_mm_cvtsi128_si32(h_s2) % QUAZIP_ADLER32_BASE;
+    }
+    return quazip_adler32_c((s2 << 16) | s1, buf, len);
+}
+
+local int quazip_adler32_detect_x86(void)
+{
+    unsigned ecx, ebx7 = 0;
+    int xsave_ymm = 0;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        ebx7 = (unsigned)info[1];
+    }
+    __cpuid(info, 1);
+    ecx = (unsigned)info[2];
+    if ((ecx & (1U << 27)) != 0)
+        xsave_ymm = (_xgetbv(0) & 6) == 6;
+#else
+    unsigned eax, ebx, edx;
+    if (__get_cpuid_max(0, NULL) >= 7)
+    {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        ebx7 = ebx;
+    }
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return QUAZIP_ADLER32_C;
+    if ((ecx & (1U << 27)) != 0)
+    {
+        /* the OS saves the YMM registers */
+        unsigned xcr0_lo, xcr0_hi;
+        __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        xsave_ymm = (xcr0_lo & 6) == 6;
+    }
+#endif
+    if (xsave_ymm && (ecx & (1U << 28)) != 0 && (ebx7 & (1U << 5)) != 0)
+        return QUAZIP_ADLER32_AVX2;
+    if ((ecx & (1U << 9)) != 0)
+        return QUAZIP_ADLER32_SSSE3;
+    return QUAZIP_ADLER32_C;
+}
+#endif /* QUAZIP_ADLER32_X86 */
+
+#ifdef QUAZIP_ADLER32_NEON
+local uLong quazip_adler32_neon(uLong adler, const Bytef* buf, size_t len)
+{
+    static const uint16_t taps[16] = {
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17
+    };
+    static const uint16_t taps2[16] = {
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
+    };
+    unsigned long s1 = adler & 0xffff;
+    unsigned long s2 = (adler >> 16) & 0xffff;
+    size_t blocks = len / QUAZIP_ADLER32_BLOCK;
+    len -= blocks * QUAZIP_ADLER32_BLOCK;
+    while (blocks != 0)
+    {
+        size_t n = QUAZIP_ADLER32_NMAX / QUAZIP_ADLER32_BLOCK;
+        uint32x4_t v_s1 = vdupq_n_u32(0);
+        uint32x4_t v_s2 = vdupq_n_u32(0);
+        uint16x8_t v_col1 = vdupq_n_u16(0);
+        uint16x8_t v_col2 = vdupq_n_u16(0);
+        uint16x8_t v_col3 = vdupq_n_u16(0);
+        uint16x8_t v_col4 = vdupq_n_u16(0);
+        uint32x2_t sum1, sum2, sums;
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+        v_s2 = vsetq_lane_u32((uint32_t)(s1 * n), v_s2, 3);
+        do
+        {
+            const uint8x16_t bytes1 = vld1q_u8(buf);
+            const uint8x16_t bytes2 = vld1q_u8(buf + 16);
+            v_s2 = vaddq_u32(v_s2, v_s1);
+            v_s1 = vpadalq_u16(v_s1, vpadalq_u8(vpaddlq_u8(bytes1), bytes2));
+            /* the bytes of each column, weighted at the end */
+            v_col1 = vaddw_u8(v_col1, vget_low_u8(bytes1));
+            v_col2 = vaddw_u8(v_col2, vget_high_u8(bytes1));
+            v_col3 = vaddw_u8(v_col3, vget_low_u8(bytes2));
+            v_col4 = vaddw_u8(v_col4, vget_high_u8(bytes2));
+            buf += QUAZIP_ADLER32_BLOCK;
+        } while (--n != 0);
+        v_s2 = vshlq_n_u32(v_s2, 5);
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(v_col1), vld1_u16(taps));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(v_col1), vld1_u16(taps + 4));
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(v_col2), vld1_u16(taps + 8));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(v_col2), vld1_u16(taps + 12));
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(v_col3), vld1_u16(taps2));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(v_col3), vld1_u16(taps2 + 4));
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(v_col4), vld1_u16(taps2 + 8));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(v_col4), vld1_u16(taps2 + 12));
+        sum1 = vpadd_u32(vget_low_u32(v_s1), vget_high_u32(v_s1));
+        sum2 = vpadd_u32(vget_low_u32(v_s2), vget_high_u32(v_s2));
+        sums = vpadd_u32(sum1, sum2);
+        s1 = (s1 + vget_lane_u32(sums, 0)) % QUAZIP_ADLER32_BASE;
+        s2 = (s2 + vget_lane_u32(sums, 1)) % QUAZIP_ADLER32_BASE;
+    }
+    return quazip_adler32_c((s2 << 16) | s1, buf, len);
+}
+#endif /* QUAZIP_ADLER32_NEON */
+
+/* Detecting the same CPU twice does no harm, so there's no locking. */
+local volatile int quazip_adler32_impl = 0;
+
+local int quazip_adler32_detect(void)
+{
+    int impl = quazip_adler32_impl;
+    if (impl != 0)
+        return impl;
+#if defined(QUAZIP_ADLER32_X86)
+    impl = quazip_adler32_detect_x86();
+#elif defined(QUAZIP_ADLER32_NEON)
+    /* always there on AArch64, and a compile-time choice on 32-bit ARM */
+    impl = QUAZIP_ADLER32_NEON_IMPL;
+#else
+    impl = QUAZIP_ADLER32_C;
+#endif
+    quazip_adler32_impl = impl;
+    return impl;
+}
+
+extern uLong quazip_adler32(uLong adler, const Bytef* buf, size_t len)
+{
+    if (buf == NULL)
+        return 1;
+    adler &= 0xffffffffUL;
+    if (len < QUAZIP_ADLER32_SIMD_MIN)
+        return quazip_adler32_c(adler, buf, len);
+    switch (quazip_adler32_detect())
+    {
+#ifdef QUAZIP_ADLER32_X86
+    case QUAZIP_ADLER32_AVX2:
+        return quazip_adler32_avx2(adler, buf, len);
+    case QUAZIP_ADLER32_SSSE3:
+        return quazip_adler32_ssse3(adler, buf, len);
+#endif
+#ifdef QUAZIP_ADLER32_NEON
+    case QUAZIP_ADLER32_NEON_IMPL:
+        return quazip_adler32_neon(adler, buf, len);
+#endif
+    default:
+        return quazip_adler32_c(adler, buf, len);
+    }
+}
+
+extern const char* quazip_adler32_implementation(void)
+{
+    switch (quazip_adler32_detect())
+    {
+    case QUAZIP_ADLER32_AVX2:
+        return "avx2";
+    case QUAZIP_ADLER32_SSSE3:
+        return "ssse3";
+    case QUAZIP_ADLER32_NEON_IMPL:
+        return "neon";
+    default:
+        return "c";
+    }
+}
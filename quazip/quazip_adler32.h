@@ -0,0 +1,60 @@
+#ifndef QUAZIP_ADLER32_H
+#define QUAZIP_ADLER32_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+ * The Adler-32 used by QuaAdler32, instead of zlib's adler32(). The
+ * implementation is chosen on the first call, depending on the CPU:
+ * - AVX2 or SSSE3 on x86 and x86-64;
+ * - NEON on ARM;
+ * - plain C otherwise.
+ * Defining QUAZIP_ADLER32_NO_SIMD leaves only the plain C one.
+ *
+ * This file must stay valid C.
+ */
+
+#include <stddef.h>
+
+#include "quazip_zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  Same as zlib's adler32(): updates adler with len bytes of buf, returns
+  the initial value, 1, if buf is NULL.
+*/
+extern uLong quazip_adler32 OF((uLong adler, const Bytef* buf, size_t len));
+
+/* The name of the implementation in use: "avx2", "ssse3", "neon" or "c". */
+extern const char* quazip_adler32_implementation OF((void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QUAZIP_ADLER32_H */
@@ -0,0 +1,624 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+  The portable AES uses a single T-table and rotations of it. In the
+  CTR mode the keystream blocks don't depend on each other, so the
+  AES-NI version encrypts eight counters at a time, keeping the AES unit
+  busy instead of waiting for each round in turn. The counter is a 64-bit
+  little-endian number in the first half of the block, starting at 1,
+  like in the reference implementation of WinZip AES by Brian Gladman.
+*/
+
+#ifdef _WIN32
+/* for rand_s() */
+#  define _CRT_RAND_S
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "quazip_aes.h"
+
+#ifndef local
+#  define local static
+#endif
+
+typedef unsigned int quazip_aes_u32;
+
+#include "quazip_aes_table.h"
+
+#ifndef QUAZIP_AES_NO_SIMD
+#  if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+#      define QUAZIP_AES_X86
+#    endif
+#  endif
+#endif
+
+#ifdef QUAZIP_AES_X86
+#  include <emmintrin.h>
+#  include <wmmintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    define QUAZIP_AES_TARGET_X86
+#  else
+#    include <cpuid.h>
+#    define QUAZIP_AES_TARGET_X86 __attribute__((target("sse2,aes")))
+#  endif
+#endif
+
+#define QUAZIP_AES_C 1
+#define QUAZIP_AES_AESNI 2
+
+#define QUAZIP_AES_MAX_ROUNDS 14
+#define QUAZIP_AES_ITERATIONS 1000
+
+#define QUAZIP_SHA1_SIZE 20
+#define QUAZIP_SHA1_BLOCK 64
+
+#define QUAZIP_AES_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define QUAZIP_AES_GET32(p) (((quazip_aes_u32)(p)[0] << 24) \
+    | ((quazip_aes_u32)(p)[1] << 16) | ((quazip_aes_u32)(p)[2] << 8) \
+    | (quazip_aes_u32)(p)[3])
+#define QUAZIP_AES_PUT32(p, v) do { \
+    (p)[0] = (unsigned char)((v) >> 24); (p)[1] = (unsigned char)((v) >> 16); \
+    (p)[2] = (unsigned char)((v) >> 8); (p)[3] = (unsigned char)(v); \
+} while (0)
+
+typedef struct
+{
+    quazip_aes_u32 h[5];
+    unsigned char block[QUAZIP_SHA1_BLOCK];
+    size_t used;
+    unsigned long long total;
+} quazip_sha1;
+
+typedef struct
+{
+    quazip_sha1 inner;
+    quazip_sha1 outer;
+} quazip_hmac;
+
+struct quazip_aes_s
+{
+    int impl;
+    int rounds;
+    /* the round keys, as big-endian words and as bytes for AES-NI */
+    quazip_aes_u32 w[4 * (QUAZIP_AES_MAX_ROUNDS + 1)];
+    unsigned char rk[16 * (QUAZIP_AES_MAX_ROUNDS + 1)];
+    unsigned long long counter;
+    unsigned char keystream[16];
+    size_t keystream_used;
+    quazip_hmac hmac;
+};
+
+/* SHA-1, as in FIPS 180-4 */
+
+local void quazip_sha1_init(quazip_sha1* sha)
+{
+    sha->h[0] = 0x67452301U;
+    sha->h[1] = 0xefcdab89U;
+    sha->h[2] = 0x98badcfeU;
+    sha->h[3] = 0x10325476U;
+    sha->h[4] = 0xc3d2e1f0U;
+    sha->used = 0;
+    sha->total = 0;
+}
+
+local void quazip_sha1_compress(quazip_aes_u32* h, const unsigned char* p)
+{
+    quazip_aes_u32 w[80];
+    quazip_aes_u32 a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], t;
+    int i;
+    for (i = 0; i < 16; i++)
+        w[i] = QUAZIP_AES_GET32(p + 4 * i);
+    for (; i < 80; i++)
+    {
+        t = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+        w[i] = (t << 1) | (t >> 31);
+    }
+    for (i = 0; i < 80; i++)
+    {
+        if (i < 20)
+            t = ((b & c) | (~b & d)) + 0x5a827999U;
+        else if (i < 40)
+            t = (b ^ c ^ d) + 0x6ed9eba1U;
+        else if (i < 60)
+            t = ((b & c) | (b & d) | (c & d)) + 0x8f1bbcdcU;
+        else
+            t = (b ^ c ^ d) + 0xca62c1d6U;
+        t += ((a << 5) | (a >> 27)) + e + w[i];
+        e = d;
+        d = c;
+        c = (b << 30) | (b >> 2);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+local void quazip_sha1_update(quazip_sha1* sha, const unsigned char* p,
+                              size_t len)
+{
+    if (len == 0)
+        return;
+    sha->total += len;
+    if (sha->used != 0)
+    {
+        size_t n = QUAZIP_SHA1_BLOCK - sha->used;
+        if (n > len)
+            n = len;
+        memcpy(sha->block + sha->used, p, n);
+        sha->used += n;
+        p += n;
+        len -= n;
+        if (sha->used < QUAZIP_SHA1_BLOCK)
+            return;
+        quazip_sha1_compress(sha->h, sha->block);
+        sha->used = 0;
+    }
+    while (len >= QUAZIP_SHA1_BLOCK)
+    {
+        quazip_sha1_compress(sha->h, p);
+        p += QUAZIP_SHA1_BLOCK;
+        len -= QUAZIP_SHA1_BLOCK;
+    }
+    memcpy(sha->block, p, len);
+    sha->used = len;
+}
+
+local void quazip_sha1_final(quazip_sha1* sha, unsigned char* digest)
+{
+    unsigned long long bits = sha->total * 8;
+    int i;
+    sha->block[sha->used++] = 0x80;
+    if (sha->used > QUAZIP_SHA1_BLOCK - 8)
+    {
+        memset(sha->block + sha->used, 0, QUAZIP_SHA1_BLOCK - sha->used);
+        quazip_sha1_compress(sha->h, sha->block);
+        sha->used = 0;
+    }
+    memset(sha->block + sha->used, 0, QUAZIP_SHA1_BLOCK - 8 - sha->used);
+    for (i = 0; i < 8; i++)
+        sha->block[QUAZIP_SHA1_BLOCK - 1 - i] = (unsigned char)(bits >> (8 * i));
+    quazip_sha1_compress(sha->h, sha->block);
+    for (i = 0; i < 5; i++)
+        QUAZIP_AES_PUT32(digest + 4 * i, sha->h[i]);
+}
+
+/* HMAC-SHA1, as in RFC 2104 */
+
+local void quazip_hmac_init(quazip_hmac* hmac, const unsigned char* key,
+                            size_t len)
+{
+    unsigned char pad[QUAZIP_SHA1_BLOCK];
+    unsigned char digest[QUAZIP_SHA1_SIZE];
+    size_t i;
+    if (len > QUAZIP_SHA1_BLOCK)
+    {
+        quazip_sha1_init(&hmac->inner);
+        quazip_sha1_update(&hmac->inner, key, len);
+        quazip_sha1_final(&hmac->inner, digest);
+        key = digest;
+        len = QUAZIP_SHA1_SIZE;
+    }
+    memset(pad, 0x36, sizeof(pad));
+    for (i = 0; i < len; i++)
+        pad[i] ^= key[i];
+    quazip_sha1_init(&hmac->inner);
+    quazip_sha1_update(&hmac->inner, pad, sizeof(pad));
+    memset(pad, 0x5c, sizeof(pad));
+    for (i = 0; i < len; i++)
+        pad[i] ^= key[i];
+    quazip_sha1_init(&hmac->outer);
+    quazip_sha1_update(&hmac->outer, pad, sizeof(pad));
+}
+
+/* Doesn't change hmac, so that the keyed state can be used again. */
+local void quazip_hmac_final(const quazip_hmac* hmac, const unsigned char* p,
+                             size_t len, unsigned char* mac)
+{
+    quazip_sha1 sha = hmac->inner;
+    quazip_sha1_update(&sha, p, len);
+    quazip_sha1_final(&sha, mac);
+    sha = hmac->outer;
+    quazip_sha1_update(&sha, mac, QUAZIP_SHA1_SIZE);
+    quazip_sha1_final(&sha, mac);
+}
+
+/* PBKDF2-HMAC-SHA1, as in RFC 2898 */
+
+local void quazip_pbkdf2(const char* password, const unsigned char* salt,
+                         size_t salt_len, unsigned char* out, size_t len)
+{
+    quazip_hmac hmac;
+    unsigned char buf[QUAZIP_AES_MAX_SALT_SIZE + 4];
+    unsigned char u[QUAZIP_SHA1_SIZE], t[QUAZIP_SHA1_SIZE];
+    unsigned long index = 1;
+    quazip_hmac_init(&hmac, (const unsigned char*)password, strlen(password));
+    memcpy(buf, salt, salt_len);
+    while (len != 0)
+    {
+        size_t n = len < QUAZIP_SHA1_SIZE ? len : QUAZIP_SHA1_SIZE;
+        int i, j;
+        QUAZIP_AES_PUT32(buf + salt_len, index);
+        quazip_hmac_final(&hmac, buf, salt_len + 4, u);
+        memcpy(t, u, sizeof(t));
+        for (i = 1; i < QUAZIP_AES_ITERATIONS; i++)
+        {
+            quazip_hmac_final(&hmac, u, sizeof(u), u);
+            for (j = 0; j < QUAZIP_SHA1_SIZE; j++)
+                t[j] ^= u[j];
+        }
+        memcpy(out, t, n);
+        out += n;
+        len -= n;
+        index++;
+    }
+}
+
+/* AES, as in FIPS-197 */
+
+local void quazip_aes_expand_key(quazip_aes* aes, const unsigned char* key,
+                                 int key_len)
+{
+    int nk = key_len / 4;
+    int total = 4 * (aes->rounds + 1);
+    quazip_aes_u32 rcon = 0x01;
+    int i;
+    for (i = 0; i < nk; i++)
+        aes->w[i] = QUAZIP_AES_GET32(key + 4 * i);
+    for (; i < total; i++)
+    {
+        quazip_aes_u32 t = aes->w[i - 1];
+        if (i % nk == 0)
+        {
+            t = ((quazip_aes_u32)quazip_aes_sbox[(t >> 16) & 0xff] << 24)
+                ^ ((quazip_aes_u32)quazip_aes_sbox[(t >> 8) & 0xff] << 16)
+                ^ ((quazip_aes_u32)quazip_aes_sbox[t & 0xff] << 8)
+                ^ (quazip_aes_u32)quazip_aes_sbox[t >> 24]
+                ^ (rcon << 24);
+            rcon = (rcon << 1) ^ ((rcon & 0x80) != 0 ? 0x11b : 0);
+        }
+        else if (nk > 6 && i % nk == 4)
+        {
+            t = ((quazip_aes_u32)quazip_aes_sbox[t >> 24] << 24)
+                ^ ((quazip_aes_u32)quazip_aes_sbox[(t >> 16) & 0xff] << 16)
+                ^ ((quazip_aes_u32)quazip_aes_sbox[(t >> 8) & 0xff] << 8)
+                ^ (quazip_aes_u32)quazip_aes_sbox[t & 0xff];
+        }
+        aes->w[i] = aes->w[i - nk] ^ t;
+    }
+    for (i = 0; i < total; i++)
+        QUAZIP_AES_PUT32(aes->rk + 4 * i, aes->w[i]);
+}
+
+#define QUAZIP_AES_TE(a, b, c, d) (quazip_aes_te0[(a) >> 24] \
+    ^ QUAZIP_AES_ROR(quazip_aes_te0[((b) >> 16) & 0xff], 8) \
+    ^ QUAZIP_AES_ROR(quazip_aes_te0[((c) >> 8) & 0xff], 16) \
+    ^ QUAZIP_AES_ROR(quazip_aes_te0[(d) & 0xff], 24))
+#define QUAZIP_AES_SB(a, b, c, d) \
+    (((quazip_aes_u32)quazip_aes_sbox[(a) >> 24] << 24) \
+    ^ ((quazip_aes_u32)quazip_aes_sbox[((b) >> 16) & 0xff] << 16) \
+    ^ ((quazip_aes_u32)quazip_aes_sbox[((c) >> 8) & 0xff] << 8) \
+    ^ (quazip_aes_u32)quazip_aes_sbox[(d) & 0xff])
+
+local void quazip_aes_encrypt_block(const quazip_aes* aes,
+                                    const unsigned char* in,
+                                    unsigned char* out)
+{
+    const quazip_aes_u32* w = aes->w;
+    quazip_aes_u32 s0, s1, s2, s3, t0, t1, t2, t3;
+    int r;
+    s0 = QUAZIP_AES_GET32(in) ^ w[0];
+    s1 = QUAZIP_AES_GET32(in + 4) ^ w[1];
+    s2 = QUAZIP_AES_GET32(in + 8) ^ w[2];
+    s3 = QUAZIP_AES_GET32(in + 12) ^ w[3];
+    for (r = 1; r < aes->rounds; r++)
+    {
+        w += 4;
+        t0 = QUAZIP_AES_TE(s0, s1, s2, s3) ^ w[0];
+        t1 = QUAZIP_AES_TE(s1, s2, s3, s0) ^ w[1];
+        t2 = QUAZIP_AES_TE(s2, s3, s0, s1) ^ w[2];
+        t3 = QUAZIP_AES_TE(s3, s0, s1, s2) ^ w[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+    w += 4;
+    t0 = QUAZIP_AES_SB(s0, s1, s2, s3) ^ w[0];
+    t1 = QUAZIP_AES_SB(s1, s2, s3, s0) ^ w[1];
+    t2 = QUAZIP_AES_SB(s2, s3, s0, s1) ^ w[2];
+    t3 = QUAZIP_AES_SB(s3, s0, s1, s2) ^ w[3];
+    QUAZIP_AES_PUT32(out, t0);
+    QUAZIP_AES_PUT32(out + 4, t1);
+    QUAZIP_AES_PUT32(out + 8, t2);
+    QUAZIP_AES_PUT32(out + 12, t3);
+}
+
+local void quazip_aes_counter_block(unsigned long long counter,
+                                    unsigned char* block)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+        block[i] = (unsigned char)(counter >> (8 * i));
+    memset(block + 8, 0, 8);
+}
+
+/* XORs blocks * 16 bytes of buf with the keystream */
+local void quazip_aes_ctr_c(quazip_aes* aes, unsigned char* buf,
+                            size_t blocks)
+{
+    unsigned char ctr[16], ks[16];
+    int i;
+    while (blocks-- != 0)
+    {
+        quazip_aes_counter_block(aes->counter++, ctr);
+        quazip_aes_encrypt_block(aes, ctr, ks);
+        for (i = 0; i < 16; i++)
+            buf[i] ^= ks[i];
+        buf += 16;
+    }
+}
+
+#ifdef QUAZIP_AES_X86
+QUAZIP_AES_TARGET_X86
+local void quazip_aes_ctr_aesni(quazip_aes* aes, unsigned char* buf,
+                                size_t blocks)
+{
+    __m128i k[QUAZIP_AES_MAX_ROUNDS + 1];
+    __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+    unsigned long long c = aes->counter;
+    int rounds = aes->rounds;
+    int r;
+    for (r = 0; r <= rounds; r++)
+        k[r] = _mm_loadu_si128((const __m128i*)(aes->rk + 16 * r));
+    while (blocks >= 8)
+    {
+        b0 = _mm_xor_si128(_mm_set_epi64x(0, (long long)c), k[0]);
+        b1 = _mm_xor_si128(_mm_set_epi64x(0, (long long)(c + 1)), k[0]);
+        b2 = _mm_xor_si128(_mm_set_epi64x(0, (long long)(c + 2)), k[0]);
+        b3 = _mm_xor_si128(_mm_set_epi64x(0, (long long)(c + 3)), k[0]);
+        b4 = _mm_xor_si128(_mm_set_epi64x(0, (long long)(c + 4)), k[0]);
+        b5 = _mm_xor_si128(_mm_set_epi64x(0, (long long)(c + 5)), k[0]);
+        b6 = _mm_xor_si128(_mm_set_epi64x(0, (long long)(c + 6)), k[0]);
+        b7 = _mm_xor_si128(_mm_set_epi64x(0, (long long)(c + 7)), k[0]);
+        for (r = 1; r < rounds; r++)
+        {
+            b0 = _mm_aesenc_si128(b0, k[r]);
+            b1 = _mm_aesenc_si128(b1, k[r]);
+            b2 = _mm_aesenc_si128(b2, k[r]);
+            b3 = _mm_aesenc_si128(b3, k[r]);
+            b4 = _mm_aesenc_si128(b4, k[r]);
+            b5 = _mm_aesenc_si128(b5, k[r]);
+            b6 = _mm_aesenc_si128(b6, k[r]);
+            b7 = _mm_aesenc_si128(b7, k[r]);
+        }
+        b0 = _mm_aesenclast_si128(b0, k[rounds]);
+        b1 = _mm_aesenclast_si128(b1, k[rounds]);
+        b2 = _mm_aesenclast_si128(b2, k[rounds]);
+        b3 = _mm_aesenclast_si128(b3, k[rounds]);
+        b4 = _mm_aesenclast_si128(b4, k[rounds]);
+        b5 = _mm_aesenclast_si128(b5, k[rounds]);
+        b6 = _mm_aesenclast_si128(b6, k[rounds]);
+        b7 = _mm_aesenclast_si128(b7, k[rounds]);
+        _mm_storeu_si128((__m128i*)(buf + 0x00), _mm_xor_si128(b0, _mm_loadu_si128((const __m128i*)(buf + 0x00))));
+        _mm_storeu_si128((__m128i*)(buf + 0x10), _mm_xor_si128(b1, _mm_loadu_si128((const __m128i*)(buf + 0x10))));
+        _mm_storeu_si128((__m128i*)(buf + 0x20), _mm_xor_si128(b2, _mm_loadu_si128((const __m128i*)(buf + 0x20))));
+        _mm_storeu_si128((__m128i*)(buf + 0x30), _mm_xor_si128(b3, _mm_loadu_si128((const __m128i*)(buf + 0x30))));
+        _mm_storeu_si128((__m128i*)(buf + 0x40), _mm_xor_si128(b4, _mm_loadu_si128((const __m128i*)(buf + 0x40))));
+        _mm_storeu_si128((__m128i*)(buf + 0x50), _mm_xor_si128(b5, _mm_loadu_si128((const __m128i*)(buf + 0x50))));
+        _mm_storeu_si128((__m128i*)(buf + 0x60), _mm_xor_si128(b6, _mm_loadu_si128((const __m128i*)(buf + 0x60))));
+        _mm_storeu_si128((__m128i*)(buf + 0x70), _mm_xor_si128(b7, _mm_loadu_si128((const __m128i*)(buf + 0x70))));
+        c += 8;
+        buf += 128;
+        blocks -= 8;
+    }
+    while (blocks-- != 0)
+    {
+        b0 = _mm_xor_si128(_mm_set_epi64x(0, (long long)c), k[0]);
+        for (r = 1; r < rounds; r++)
+            b0 = _mm_aesenc_si128(b0, k[r]);
+        b0 = _mm_aesenclast_si128(b0, k[rounds]);
+        _mm_storeu_si128((__m128i*)buf, _mm_xor_si128(b0, _mm_loadu_si128((const __m128i*)buf)));
+        c++;
+        buf += 16;
+    }
+    aes->counter = c;
+}
+
+local int quazip_aes_has_aesni(void)
+{
+    unsigned ecx, edx;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    ecx = (unsigned)info[2];
+    edx = (unsigned)info[3];
+#else
+    unsigned eax, ebx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+#endif
+    /* SSE2 and AES */
+    return (edx & (1U << 26)) != 0 && (ecx & (1U << 25)) != 0;
+}
+#endif /* QUAZIP_AES_X86 */
+
+/* Detecting the same CPU twice does no harm, so there's no locking. */
+local volatile int quazip_aes_impl = 0;
+
+local int quazip_aes_detect(void)
+{
+    int impl = quazip_aes_impl;
+    if (impl != 0)
+        return impl;
+#ifdef QUAZIP_AES_X86
+    impl = quazip_aes_has_aesni() ? QUAZIP_AES_AESNI : QUAZIP_AES_C;
+#else
+    impl = QUAZIP_AES_C;
+#endif
+    quazip_aes_impl = impl;
+    return impl;
+}
+
+local void quazip_aes_ctr_blocks(quazip_aes* aes, unsigned char* buf,
+                                 size_t blocks)
+{
+#ifdef QUAZIP_AES_X86
+    if (aes->impl == QUAZIP_AES_AESNI)
+    {
+        quazip_aes_ctr_aesni(aes, buf, blocks);
+        return;
+    }
+#endif
+    quazip_aes_ctr_c(aes, buf, blocks);
+}
+
+local void quazip_aes_ctr(quazip_aes* aes, unsigned char* buf, size_t len)
+{
+    size_t blocks;
+    while (len != 0 && aes->keystream_used < sizeof(aes->keystream))
+    {
+        *buf++ ^= aes->keystream[aes->keystream_used++];
+        len--;
+    }
+    blocks = len / 16;
+    if (blocks != 0)
+    {
+        quazip_aes_ctr_blocks(aes, buf, blocks);
+        buf += blocks * 16;
+        len -= blocks * 16;
+    }
+    if (len != 0)
+    {
+        /* the rest of the block is kept for the next call */
+        memset(aes->keystream, 0, sizeof(aes->keystream));
+        quazip_aes_ctr_blocks(aes, aes->keystream, 1);
+        aes->keystream_used = 0;
+        while (len-- != 0)
+            *buf++ ^= aes->keystream[aes->keystream_used++];
+    }
+}
+
+extern int quazip_aes_salt_size(int strength)
+{
+    if (strength < QUAZIP_AES_128 || strength > QUAZIP_AES_256)
+        return 0;
+    return 4 + 4 * strength;
+}
+
+extern int quazip_aes_random(unsigned char* buf, size_t len)
+{
+#ifdef _WIN32
+    while (len != 0)
+    {
+        unsigned int r;
+        size_t n = len < sizeof(r) ? len : sizeof(r);
+        if (rand_s(&r) != 0)
+            return -1;
+        memcpy(buf, &r, n);
+        buf += n;
+        len -= n;
+    }
+    return 0;
+#else
+    FILE* f = fopen("/dev/urandom", "rb");
+    size_t n;
+    if (f == NULL)
+        return -1;
+    n = fread(buf, 1, len, f);
+    fclose(f);
+    return n == len ? 0 : -1;
+#endif
+}
+
+extern quazip_aes* quazip_aes_open(int strength, const char* password,
+                                   const unsigned char* salt,
+                                   unsigned char* pwv)
+{
+    unsigned char keys[2 * 32 + QUAZIP_AES_PWV_SIZE];
+    int salt_len = quazip_aes_salt_size(strength);
+    int key_len = salt_len * 2;
+    quazip_aes* aes;
+    if (salt_len == 0 || password == NULL)
+        return NULL;
+    aes = (quazip_aes*)malloc(sizeof(quazip_aes));
+    if (aes == NULL)
+        return NULL;
+    /* the AES key, the HMAC key, and the password verification value */
+    quazip_pbkdf2(password, salt, (size_t)salt_len, keys,
+                  (size_t)(2 * key_len + QUAZIP_AES_PWV_SIZE));
+    aes->impl = quazip_aes_detect();
+    aes->rounds = key_len / 4 + 6;
+    quazip_aes_expand_key(aes, keys, key_len);
+    aes->counter = 1;
+    aes->keystream_used = sizeof(aes->keystream);
+    quazip_hmac_init(&aes->hmac, keys + key_len, (size_t)key_len);
+    if (pwv != NULL)
+        memcpy(pwv, keys + 2 * key_len, QUAZIP_AES_PWV_SIZE);
+    memset(keys, 0, sizeof(keys));
+    return aes;
+}
+
+extern void quazip_aes_encrypt(quazip_aes* aes, unsigned char* buf,
+                               size_t len)
+{
+    quazip_aes_ctr(aes, buf, len);
+    quazip_sha1_update(&aes->hmac.inner, buf, len);
+}
+
+extern void quazip_aes_decrypt(quazip_aes* aes, unsigned char* buf,
+                               size_t len)
+{
+    quazip_sha1_update(&aes->hmac.inner, buf, len);
+    quazip_aes_ctr(aes, buf, len);
+}
+
+extern void quazip_aes_close(quazip_aes* aes, unsigned char* mac)
+{
+    if (aes == NULL)
+        return;
+    if (mac != NULL)
+    {
+        unsigned char digest[QUAZIP_SHA1_SIZE];
+        quazip_hmac_final(&aes->hmac, NULL, 0, digest);
+        memcpy(mac, digest, QUAZIP_AES_MAC_SIZE);
+    }
+    /* don't leave the keys in the freed memory */
+    memset(aes, 0, sizeof(quazip_aes));
+    free(aes);
+}
+
+extern const char* quazip_aes_implementation(void)
+{
+    return quazip_aes_detect() == QUAZIP_AES_AESNI ? "aesni" : "c";
+}
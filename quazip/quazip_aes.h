@@ -0,0 +1,107 @@
+#ifndef QUAZIP_AES_H
+#define QUAZIP_AES_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+ * WinZip AES encryption (AE-1 and AE-2), as described in
+ * http://www.winzip.com/win/en/aes_info.html
+ *
+ * The entry data is encrypted with AES in CTR mode, the keys are derived
+ * from the password with PBKDF2-HMAC-SHA1, and the encrypted data is
+ * authenticated with HMAC-SHA1 truncated to 10 bytes. The encrypted data
+ * are preceded by a salt and a 2-byte password verification value, and
+ * followed by the authentication code. The AES rounds use the AES-NI
+ * instructions on the x86 CPUs that have them, and tables otherwise.
+ * Defining QUAZIP_AES_NO_SIMD leaves only the tables.
+ *
+ * This file must stay valid C, as it is included by zip.c and unzip.c.
+ */
+
+#include <stddef.h>
+
+#include "quazip_zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The compression method stored in the headers of the AES-encrypted entries. */
+#define QUAZIP_AES_METHOD 99
+/* The ID of the extra field holding the actual method and the key strength. */
+#define QUAZIP_AES_EXTRA_ID 0x9901
+/* The size of that extra field, the 4-byte header included. */
+#define QUAZIP_AES_EXTRA_SIZE 11
+/* The vendor versions: AE-1 stores the CRC-32, AE-2 stores 0 instead. */
+#define QUAZIP_AES_AE1 1
+#define QUAZIP_AES_AE2 2
+/* The key strengths: 1, 2 and 3 for AES-128, AES-192 and AES-256. */
+#define QUAZIP_AES_128 1
+#define QUAZIP_AES_192 2
+#define QUAZIP_AES_256 3
+
+#define QUAZIP_AES_PWV_SIZE 2
+#define QUAZIP_AES_MAC_SIZE 10
+#define QUAZIP_AES_MAX_SALT_SIZE 16
+
+typedef struct quazip_aes_s quazip_aes;
+
+/* The size of the salt for the given strength, 0 if the strength is invalid. */
+extern int quazip_aes_salt_size OF((int strength));
+
+/* Fills buf with random bytes for a salt. Returns 0 on success. */
+extern int quazip_aes_random OF((unsigned char* buf, size_t len));
+
+/*
+  Derives the keys for the password and the salt, whose size must match
+  the strength, and writes the password verification value to pwv.
+  Returns NULL if the strength is invalid or memory can't be allocated.
+*/
+extern quazip_aes* quazip_aes_open OF((int strength, const char* password,
+                                       const unsigned char* salt,
+                                       unsigned char* pwv));
+
+/* Encrypts len bytes of buf in place, and authenticates the result. */
+extern void quazip_aes_encrypt OF((quazip_aes* aes, unsigned char* buf,
+                                   size_t len));
+
+/* Authenticates len bytes of buf, and decrypts them in place. */
+extern void quazip_aes_decrypt OF((quazip_aes* aes, unsigned char* buf,
+                                   size_t len));
+
+/*
+  Writes the authentication code of all the data encrypted or decrypted
+  so far to mac, unless it is NULL, and frees aes.
+*/
+extern void quazip_aes_close OF((quazip_aes* aes, unsigned char* mac));
+
+/* The name of the AES implementation in use: "aesni" or "c". */
+extern const char* quazip_aes_implementation OF((void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QUAZIP_AES_H */
@@ -0,0 +1,229 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "quazip_blockdeflater.h"
+
+#include "quazip_adler32.h"
+#include "quazip_crc32.h"
+
+/// \cond internal
+QuaBlockDeflateJob::QuaBlockDeflateJob(const QByteArray &data,
+        const QByteArray &dictionary, bool last,
+        QuaBlockDeflaterFormat format):
+    data(data), dictionary(dictionary), last(last), format(format),
+    checksum(0), size(0), ok(false)
+{
+    setAutoDelete(false);
+}
+
+void QuaBlockDeflateJob::run()
+{
+    z_stream stream;
+    stream.zalloc = (alloc_func) nullptr;
+    stream.zfree = (free_func) nullptr;
+    stream.opaque = nullptr;
+    // the same settings as deflateInit() uses, without the zlib header
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY) == Z_OK) {
+        int result = Z_OK;
+        if (!dictionary.isEmpty()) {
+            result = deflateSetDictionary(&stream,
+                    reinterpret_cast<const Bytef*>(dictionary.constData()),
+                    static_cast<uInt>(dictionary.size()));
+        }
+        // deflateBound() doesn't count the empty block of the sync flush
+        compressed.resize(static_cast<int>(deflateBound(&stream,
+                static_cast<uLong>(data.size()))) + 16);
+        stream.next_in = reinterpret_cast<Bytef*>(
+                const_cast<char*>(data.constData()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+        stream.avail_out = static_cast<uInt>(compressed.size());
+        while (result == Z_OK) {
+            result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+            if (result == Z_STREAM_END
+                    || (result == Z_OK && !last && stream.avail_out != 0)) {
+                ok = true;
+                break;
+            }
+            if (stream.avail_out != 0)
+                break;
+            // shouldn't happen, but the bound is for one flush only
+            int used = compressed.size();
+            compressed.resize(used * 2);
+            stream.next_out = reinterpret_cast<Bytef*>(compressed.data())
+                    + used;
+            stream.avail_out = static_cast<uInt>(used);
+            result = Z_OK;
+        }
+        compressed.resize(ok ? static_cast<int>(stream.total_out) : 0);
+        deflateEnd(&stream);
+    }
+    const Bytef *bytes = reinterpret_cast<const Bytef*>(data.constData());
+    size_t length = static_cast<size_t>(data.size());
+    if (format == QuaBlockDeflaterGzip)
+        checksum = quazip_crc32(0, bytes, length);
+    else
+        checksum = quazip_adler32(1L, bytes, length);
+    size = data.size();
+    data = QByteArray();
+    dictionary = QByteArray();
+    done.release();
+}
+
+QuaBlockDeflater::QuaBlockDeflater(QuaBlockDeflaterFormat format,
+                                   int threads, int blockSize,
+                                   bool independent):
+    format(format),
+    independent(independent),
+    checksum(format == QuaBlockDeflaterGzip ? 0 : 1),
+    size(0),
+    threads(threads),
+    blockSize(blockSize)
+{
+    pool.setMaxThreadCount(threads);
+}
+
+QuaBlockDeflater::~QuaBlockDeflater()
+{
+    pool.waitForDone();
+    qDeleteAll(jobs);
+}
+
+bool QuaBlockDeflater::write(const char *data, qint64 size)
+{
+    while (size > 0) {
+        int count = static_cast<int>(qMin(static_cast<qint64>(
+                blockSize - chunk.size()), size));
+        chunk.append(data, count);
+        data += count;
+        size -= count;
+        if (chunk.size() == blockSize) {
+            submit(false);
+            // keeps the memory bounded if the writer is faster
+            if (!collect(threads * 2))
+                return false;
+        }
+    }
+    // takes the blocks done meanwhile
+    return collect(threads * 2) && writeOutput();
+}
+
+bool QuaBlockDeflater::flush()
+{
+    if (!chunk.isEmpty())
+        submit(false);
+    return collect(0) && writeOutput();
+}
+
+bool QuaBlockDeflater::finish()
+{
+    if (independent) {
+        if (!chunk.isEmpty())
+            submit(true);
+        if (!collect(0))
+            return false;
+    } else if (jobs.isEmpty()) {
+        // the rest is small, not worth another thread
+        QuaBlockDeflateJob job(chunk, dictionary, true, format);
+        chunk.clear();
+        job.run();
+        if (!appendBlock(job))
+            return false;
+    } else {
+        submit(true);
+        if (!collect(0))
+            return false;
+    }
+    return appendTrailer() && writeOutput();
+}
+
+bool QuaBlockDeflater::appendBlock(const QuaBlockDeflateJob &job)
+{
+    if (!job.ok)
+        return false;
+    output.append(job.compressed);
+    if (format == QuaBlockDeflaterGzip) {
+        checksum = crc32_combine(checksum, job.checksum,
+                                 static_cast<z_off_t>(job.size));
+    } else {
+        checksum = adler32_combine(checksum, job.checksum,
+                                   static_cast<z_off_t>(job.size));
+    }
+    size += static_cast<quint64>(job.size);
+    return true;
+}
+
+bool QuaBlockDeflater::appendTrailer()
+{
+    if (format == QuaBlockDeflaterGzip) {
+        // the size modulo 2^32
+        for (int shift = 0; shift < 32; shift += 8)
+            output.append(static_cast<char>((checksum >> shift) & 0xFF));
+        for (int shift = 0; shift < 32; shift += 8)
+            output.append(static_cast<char>((size >> shift) & 0xFF));
+    } else {
+        // the Adler-32 goes in the big-endian order
+        for (int shift = 24; shift >= 0; shift -= 8)
+            output.append(static_cast<char>((checksum >> shift) & 0xFF));
+    }
+    return true;
+}
+
+bool QuaBlockDeflater::writeOutput()
+{
+    return true;
+}
+
+void QuaBlockDeflater::submit(bool last)
+{
+    QuaBlockDeflateJob *job;
+    if (independent) {
+        job = new QuaBlockDeflateJob(chunk, QByteArray(), true, format);
+    } else {
+        job = new QuaBlockDeflateJob(chunk, dictionary, last, format);
+        if (chunk.size() >= DictionarySize)
+            dictionary = chunk.right(DictionarySize);
+        else
+            dictionary = (dictionary + chunk).right(DictionarySize);
+    }
+    chunk.clear();
+    jobs.append(job);
+    pool.start(job);
+}
+
+bool QuaBlockDeflater::collect(int maxPending)
+{
+    while (jobs.size() > maxPending
+           || (!jobs.isEmpty() && jobs.first()->done.available() > 0)) {
+        QuaBlockDeflateJob *job = jobs.takeFirst();
+        job->done.acquire();
+        bool ok = appendBlock(*job);
+        delete job;
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+/// \endcond
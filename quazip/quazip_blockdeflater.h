@@ -0,0 +1,127 @@
+#ifndef QUAZIP_BLOCKDEFLATER_H
+#define QUAZIP_BLOCKDEFLATER_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+ * The multithreaded deflate shared by QuaGzipFile and QuaZIODevice. Not
+ * installed, not a part of the API.
+ */
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
+#include "quazip_zlib.h"
+
+/// \cond internal
+/// The checksum and the trailer of a stream deflated by QuaBlockDeflater.
+enum QuaBlockDeflaterFormat {
+    /// CRC-32, then it and the size, little-endian, as in a GZIP member.
+    QuaBlockDeflaterGzip,
+    /// Adler-32, then it big-endian, as in a zlib stream.
+    QuaBlockDeflaterZlib
+};
+
+/// One block of the data, deflated by a pool thread.
+class QuaBlockDeflateJob: public QRunnable {
+public:
+    QuaBlockDeflateJob(const QByteArray &data, const QByteArray &dictionary,
+                       bool last, QuaBlockDeflaterFormat format);
+    virtual void run();
+    QByteArray data;
+    QByteArray dictionary;
+    bool last;
+    QuaBlockDeflaterFormat format;
+    // the results, valid once done is acquired
+    QByteArray compressed;
+    uLong checksum;
+    qint64 size;
+    bool ok;
+    QSemaphore done;
+};
+
+/// Deflates a stream by several threads.
+/**
+  The data is split into blocks, and each block is deflated into a raw
+  stream of its own, primed with the last 32 KB of the data before it, so
+  the compression ratio barely suffers. Each stream but the last one ends
+  with a sync flush, which leaves it byte-aligned and not final, so they
+  are simply concatenated into a single deflate stream. The checksum of
+  the stream is combined from the ones of the blocks, and goes to the
+  trailer after them. The header, if any, is up to the subclass.
+
+  As every block ends with a sync flush, flush() only has to compress the
+  data added so far as a shorter block.
+
+  With independent blocks, each one is a complete deflate stream without
+  a dictionary instead, and the subclass is to frame them in
+  appendBlock() and to end the output in appendTrailer().
+  */
+class QuaBlockDeflater {
+public:
+    enum {
+        BlockSize = 128 * 1024,
+        DictionarySize = 32 * 1024
+    };
+    QuaBlockDeflater(QuaBlockDeflaterFormat format, int threads,
+                     int blockSize = BlockSize, bool independent = false);
+    virtual ~QuaBlockDeflater();
+    /// Adds data, moves whatever is compressed already to the output.
+    bool write(const char *data, qint64 size);
+    /// Compresses everything added so far.
+    bool flush();
+    /// Compresses the rest and adds the end of the stream.
+    bool finish();
+    /// The compressed data, in order.
+    QByteArray output;
+protected:
+    /// Adds a compressed block to the output.
+    virtual bool appendBlock(const QuaBlockDeflateJob &job);
+    /// Adds the trailer to the output.
+    virtual bool appendTrailer();
+    /// Called whenever something may have been added to the output.
+    virtual bool writeOutput();
+    QuaBlockDeflaterFormat format;
+    bool independent;
+    // of the whole stream, unless the blocks are independent
+    uLong checksum;
+    quint64 size;
+private:
+    Q_DISABLE_COPY(QuaBlockDeflater)
+    int threads;
+    int blockSize;
+    QByteArray chunk;
+    QByteArray dictionary;
+    QThreadPool pool;
+    QList<QuaBlockDeflateJob*> jobs;
+    void submit(bool last);
+    bool collect(int maxPending);
+};
+/// \endcond
+
+#endif // QUAZIP_BLOCKDEFLATER_H
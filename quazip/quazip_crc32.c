@@ -0,0 +1,327 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+  The folding follows Intel's "Fast CRC Computation for Generic
+  Polynomials Using PCLMULQDQ Instruction" paper, the same way as
+  Chromium's zlib does, with the constants for the reflected CRC-32
+  polynomial given at its end.
+
+  All the implementations work on the inverted CRC, the inversions are
+  done once in quazip_crc32().
+*/
+
+#include <string.h>
+
+#include "quazip_crc32.h"
+
+#ifndef local
+#  define local static
+#endif
+
+#include "quazip_crc32_table.h"
+
+#ifndef QUAZIP_CRC32_NO_SIMD
+#  if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+#      define QUAZIP_CRC32_X86
+#    endif
+#  elif (defined(__aarch64__) || defined(_M_ARM64)) && !defined(__AARCH64EB__)
+#    if defined(__ARM_FEATURE_CRC32) || defined(_MSC_VER) || defined(__clang__) \
+        || (defined(__GNUC__) && __GNUC__ >= 10)
+#      define QUAZIP_CRC32_ARM
+#    endif
+#  endif
+#endif
+
+#ifdef QUAZIP_CRC32_X86
+#  include <emmintrin.h>
+#  include <wmmintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    define QUAZIP_CRC32_TARGET_X86
+#  else
+#    include <cpuid.h>
+#    define QUAZIP_CRC32_TARGET_X86 __attribute__((target("sse2,pclmul")))
+#  endif
+#endif
+
+#ifdef QUAZIP_CRC32_ARM
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#    include <windows.h>
+#    define QUAZIP_CRC32_TARGET_ARM
+#  else
+#    include <arm_acle.h>
+#    if defined(__ARM_FEATURE_CRC32)
+#      define QUAZIP_CRC32_TARGET_ARM
+#    elif defined(__clang__)
+#      define QUAZIP_CRC32_TARGET_ARM __attribute__((target("crc")))
+#    else
+#      define QUAZIP_CRC32_TARGET_ARM __attribute__((target("+crc")))
+#    endif
+#    if defined(__linux__)
+#      include <sys/auxv.h>
+#      ifndef HWCAP_CRC32
+#        define HWCAP_CRC32 (1 << 7)
+#      endif
+#    endif
+#  endif
+#endif
+
+#define QUAZIP_CRC32_SLICE16 1
+#define QUAZIP_CRC32_PCLMUL 2
+#define QUAZIP_CRC32_ARMV8 3
+
+/* Shorter buffers are left to the tables, which are faster for them. */
+#define QUAZIP_CRC32_PCLMUL_MIN 64
+
+local z_crc_t quazip_crc32_slice16(z_crc_t c, const Bytef* buf, size_t len)
+{
+    const z_crc_t (*t)[256] = quazip_crc32_table;
+    while (len >= 16)
+    {
+        c ^= (z_crc_t)buf[0] | ((z_crc_t)buf[1] << 8)
+            | ((z_crc_t)buf[2] << 16) | ((z_crc_t)buf[3] << 24);
+        c = t[15][c & 0xff] ^ t[14][(c >> 8) & 0xff]
+            ^ t[13][(c >> 16) & 0xff] ^ t[12][(c >> 24) & 0xff]
+            ^ t[11][buf[4]] ^ t[10][buf[5]] ^ t[9][buf[6]] ^ t[8][buf[7]]
+            ^ t[7][buf[8]] ^ t[6][buf[9]] ^ t[5][buf[10]] ^ t[4][buf[11]]
+            ^ t[3][buf[12]] ^ t[2][buf[13]] ^ t[1][buf[14]] ^ t[0][buf[15]];
+        buf += 16;
+        len -= 16;
+    }
+    while (len-- != 0)
+        c = t[0][(c ^ *buf++) & 0xff] ^ (c >> 8);
+    return c;
+}
+
+#ifdef QUAZIP_CRC32_X86
+/* len must be at least 64 and a multiple of 16 */
+QUAZIP_CRC32_TARGET_X86
+local z_crc_t quazip_crc32_pclmul(z_crc_t crc, const Bytef* buf, size_t len)
+{
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+    const __m128i k1k2 = _mm_set_epi32(0x00000001, 0xc6e41596, 0x00000001, 0x54442bd4);
+    const __m128i k3k4 = _mm_set_epi32(0x00000000, 0xccaa009e, 0x00000001, 0x751997d0);
+    const __m128i k5k0 = _mm_set_epi32(0x00000000, 0x00000000, 0x00000001, 0x63cd6124);
+    const __m128i poly = _mm_set_epi32(0x00000001, 0xf7011641, 0x00000001, 0xdb710641);
+    const __m128i mask32 = _mm_set_epi32(0, -1, 0, -1);
+
+    x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    buf += 64;
+    len -= 64;
+
+    /* four 128-bit lanes, folded over 64 bytes at a time */
+    x0 = k1k2;
+    while (len >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        y5 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+        buf += 64;
+        len -= 64;
+    }
+
+    /* the lanes into one */
+    x0 = k3k4;
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    /* the remaining 16-byte blocks */
+    while (len >= 16)
+    {
+        x2 = _mm_loadu_si128((const __m128i*)buf);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        buf += 16;
+        len -= 16;
+    }
+
+    /* 128 bits to 64 */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = k5k0;
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits */
+    x0 = poly;
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (z_crc_t)(unsigned)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+local int quazip_crc32_has_pclmul(void)
+{
+    unsigned ecx, edx;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    ecx = (unsigned)info[2];
+    edx = (unsigned)info[3];
+#else
+    unsigned eax, ebx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+#endif
+    /* SSE2 and PCLMULQDQ */
+    return (edx & (1U << 26)) != 0 && (ecx & (1U << 1)) != 0;
+}
+#endif /* QUAZIP_CRC32_X86 */
+
+#ifdef QUAZIP_CRC32_ARM
+QUAZIP_CRC32_TARGET_ARM
+local z_crc_t quazip_crc32_armv8(z_crc_t crc, const Bytef* buf, size_t len)
+{
+    unsigned int c = (unsigned int)crc;
+    while (len != 0 && ((size_t)buf & 7) != 0)
+    {
+        c = __crc32b(c, *buf++);
+        len--;
+    }
+    while (len >= 8)
+    {
+        /* a single load, aligned by now */
+        unsigned long long v;
+        memcpy(&v, buf, 8);
+        c = __crc32d(c, v);
+        buf += 8;
+        len -= 8;
+    }
+    while (len-- != 0)
+        c = __crc32b(c, *buf++);
+    return (z_crc_t)c;
+}
+
+local int quazip_crc32_has_armv8(void)
+{
+#if defined(__ARM_FEATURE_CRC32) || defined(__APPLE__)
+    return 1;
+#elif defined(_MSC_VER)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return 0;
+#endif
+}
+#endif /* QUAZIP_CRC32_ARM */
+
+/* Detecting the same CPU twice does no harm, so there's no locking. */
+local volatile int quazip_crc32_impl = 0;
+
+local int quazip_crc32_detect(void)
+{
+    int impl = quazip_crc32_impl;
+    if (impl != 0)
+        return impl;
+    impl = QUAZIP_CRC32_SLICE16;
+#ifdef QUAZIP_CRC32_X86
+    if (quazip_crc32_has_pclmul())
+        impl = QUAZIP_CRC32_PCLMUL;
+#endif
+#ifdef QUAZIP_CRC32_ARM
+    if (quazip_crc32_has_armv8())
+        impl = QUAZIP_CRC32_ARMV8;
+#endif
+    quazip_crc32_impl = impl;
+    return impl;
+}
+
+extern uLong quazip_crc32(uLong crc, const Bytef* buf, size_t len)
+{
+    z_crc_t c;
+    if (buf == NULL)
+        return 0;
+    c = (z_crc_t)(crc ^ 0xffffffffUL) & 0xffffffffUL;
+    switch (quazip_crc32_detect())
+    {
+#ifdef QUAZIP_CRC32_X86
+    case QUAZIP_CRC32_PCLMUL:
+        if (len >= QUAZIP_CRC32_PCLMUL_MIN)
+        {
+            size_t blocks = len & ~(size_t)15;
+            c = quazip_crc32_pclmul(c, buf, blocks);
+            buf += blocks;
+            len -= blocks;
+        }
+        break;
+#endif
+#ifdef QUAZIP_CRC32_ARM
+    case QUAZIP_CRC32_ARMV8:
+        c = quazip_crc32_armv8(c, buf, len);
+        len = 0;
+        break;
+#endif
+    default:
+        break;
+    }
+    c = quazip_crc32_slice16(c, buf, len);
+    return (uLong)(c ^ 0xffffffffUL);
+}
+
+extern const char* quazip_crc32_implementation(void)
+{
+    switch (quazip_crc32_detect())
+    {
+    case QUAZIP_CRC32_PCLMUL:
+        return "pclmul";
+    case QUAZIP_CRC32_ARMV8:
+        return "armv8";
+    default:
+        return "slice16";
+    }
+}
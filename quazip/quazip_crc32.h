@@ -0,0 +1,61 @@
+#ifndef QUAZIP_CRC32_H
+#define QUAZIP_CRC32_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+ * The CRC-32 used for all the data QuaZip checksums, instead of zlib's
+ * table-driven crc32(). The implementation is chosen on the first call,
+ * depending on the CPU:
+ * - PCLMULQDQ folding on x86 and x86-64;
+ * - the CRC32 instructions on ARMv8;
+ * - slicing-by-16 tables otherwise.
+ * Defining QUAZIP_CRC32_NO_SIMD leaves only the tables.
+ *
+ * This file must stay valid C, as it is included by zip.c and unzip.c.
+ */
+
+#include <stddef.h>
+
+#include "quazip_zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  Same as zlib's crc32(): updates crc with len bytes of buf, returns the
+  initial value, 0, if buf is NULL.
+*/
+extern uLong quazip_crc32 OF((uLong crc, const Bytef* buf, size_t len));
+
+/* The name of the implementation in use: "pclmul", "armv8" or "slice16". */
+extern const char* quazip_crc32_implementation OF((void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QUAZIP_CRC32_H */
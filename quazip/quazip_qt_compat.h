@@ -134,6 +134,18 @@ inline qint64 quazip_to_time64_t(const QDateTime &time) {
 }
 #endif
 
+// Qt 4 has no plain atomic loads, only the fetch-and-modify operations
+#include <QtCore/QAtomicInt>
+#if (QT_VERSION >= 0x050000)
+inline int quazip_atomic_load(QAtomicInt &value) {
+    return value.loadAcquire();
+}
+#else
+inline int quazip_atomic_load(QAtomicInt &value) {
+    return value.fetchAndAddOrdered(0);
+}
+#endif
+
 #include <QtCore/QTextStream>
 // and another stupid move
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
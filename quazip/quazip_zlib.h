@@ -0,0 +1,110 @@
+#ifndef QUAZIP_ZLIB_H
+#define QUAZIP_ZLIB_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+/*
+ * The only place where the zlib header is included. Everything else
+ * includes this file instead, so QuaZip can be built either against zlib
+ * (or anything providing its API, such as zlib-ng in the compatibility
+ * mode) or against the native zlib-ng API (QUAZIP_USE_ZLIB_NG in CMake,
+ * which defines QUAZIP_ZLIB_NG). In the latter case, the zlib names used
+ * by QuaZip are mapped to the zng_ ones here.
+ *
+ * This file must stay valid C, as it is included by zip.c and unzip.c.
+ */
+
+#ifdef QUAZIP_ZLIB_NG
+
+#include <stdint.h>
+#include <zlib-ng.h>
+
+typedef unsigned char Byte;
+typedef Byte Bytef;
+typedef unsigned int uInt;
+typedef unsigned long uLong;
+typedef uLong uLongf;
+typedef void *voidp;
+typedef void *voidpf;
+typedef uint32_t z_crc_t;
+typedef zng_stream z_stream;
+typedef zng_streamp z_streamp;
+
+#ifndef OF
+#define OF(args) args
+#endif
+#ifndef ZEXPORT
+#define ZEXPORT
+#endif
+#ifndef FAR
+#define FAR
+#endif
+#ifndef Z_ASCII
+#define Z_ASCII Z_TEXT
+#endif
+
+#define zlibVersion() zng_version()
+#define deflateInit(strm, level) zng_deflateInit(strm, level)
+#define deflateInit2(strm, level, method, windowBits, memLevel, strategy) \
+    zng_deflateInit2(strm, level, method, windowBits, memLevel, strategy)
+#define deflate(strm, flush) zng_deflate(strm, flush)
+#define deflateEnd(strm) zng_deflateEnd(strm)
+#define deflateReset(strm) zng_deflateReset(strm)
+#define deflateBound(strm, sourceLen) zng_deflateBound(strm, sourceLen)
+#define deflateSetDictionary(strm, dictionary, dictLength) \
+    zng_deflateSetDictionary(strm, dictionary, dictLength)
+#define inflateInit(strm) zng_inflateInit(strm)
+#define inflateInit2(strm, windowBits) zng_inflateInit2(strm, windowBits)
+#define inflate(strm, flush) zng_inflate(strm, flush)
+#define inflateEnd(strm) zng_inflateEnd(strm)
+#define inflateReset(strm) zng_inflateReset(strm)
+#define inflateReset2(strm, windowBits) zng_inflateReset2(strm, windowBits)
+#define inflatePrime(strm, bits, value) zng_inflatePrime(strm, bits, value)
+#define inflateSetDictionary(strm, dictionary, dictLength) \
+    zng_inflateSetDictionary(strm, dictionary, dictLength)
+#define crc32(crc, buf, len) zng_crc32(crc, buf, len)
+#define crc32_combine(crc1, crc2, len2) zng_crc32_combine(crc1, crc2, len2)
+#define adler32(adler, buf, len) zng_adler32(adler, buf, len)
+#define adler32_combine(adler1, adler2, len2) \
+    zng_adler32_combine(adler1, adler2, len2)
+#define get_crc_table() zng_get_crc_table()
+#define gzopen(path, mode) zng_gzopen(path, mode)
+#define gzdopen(fd, mode) zng_gzdopen(fd, mode)
+#define gzbuffer(file, size) zng_gzbuffer(file, size)
+#define gzread(file, buf, len) zng_gzread(file, buf, len)
+#define gzwrite(file, buf, len) zng_gzwrite(file, buf, len)
+#define gzflush(file, flush) zng_gzflush(file, flush)
+#define gzclose(file) zng_gzclose(file)
+
+#else // QUAZIP_ZLIB_NG
+
+#include <zlib.h>
+#if (ZLIB_VERNUM < 0x1270)
+typedef uLongf z_crc_t;
+#endif
+
+#endif // QUAZIP_ZLIB_NG
+
+#endif // QUAZIP_ZLIB_H
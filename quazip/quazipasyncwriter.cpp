@@ -0,0 +1,601 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QQueue>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#include "quazipasyncwriter.h"
+#include "quazip.h"
+#include "quazipfile.h"
+
+#define QUAZIP_ASYNC_COPY_BUFSIZE 65536
+// how much data a socket may have pending before the worker waits for it
+#define QUAZIP_ASYNC_MAX_PENDING (1024 * 1024)
+
+/// \cond internal
+class QuaZipAsyncWriterPrivate;
+
+/// One queued entry.
+struct QuaZipAsyncWriterJob {
+    QuaZipAsyncWriterJob(): info(QString()), source(nullptr), method(0),
+        level(0) {}
+    QuaZipNewInfo info;
+    QByteArray data;
+    QIODevice *source;
+    int method;
+    int level;
+};
+
+/// The worker thread.
+class QuaZipAsyncWriterThread: public QThread {
+public:
+    inline QuaZipAsyncWriterThread(QuaZipAsyncWriterPrivate *d): d(d) {}
+protected:
+    virtual void run();
+private:
+    QuaZipAsyncWriterPrivate *d;
+};
+
+/// The device QuaZip writes to, counting the bytes on the way.
+/**
+  It also keeps the amount of data pending in the target device (such
+  as a socket) at bay by waiting for it to be written.
+  */
+class QuaZipAsyncWriterDevice: public QIODevice {
+public:
+    inline QuaZipAsyncWriterDevice(QIODevice *target,
+                                   QuaZipAsyncWriterPrivate *d):
+        target(target), d(d) {}
+    virtual bool isSequential() const {return target->isSequential();}
+    virtual qint64 size() const {return target->size();}
+    virtual bool seek(qint64 pos)
+    {
+        return QIODevice::seek(pos) && target->seek(pos);
+    }
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize)
+    {
+        return target->read(data, maxSize);
+    }
+    virtual qint64 writeData(const char *data, qint64 maxSize);
+private:
+    QIODevice *target;
+    QuaZipAsyncWriterPrivate *d;
+};
+
+class QuaZipAsyncWriterPrivate {
+    friend class QuaZipAsyncWriter;
+    friend class QuaZipAsyncWriterThread;
+    friend class QuaZipAsyncWriterDevice;
+    Q_DISABLE_COPY(QuaZipAsyncWriterPrivate)
+private:
+    QuaZipAsyncWriterPrivate(QuaZipAsyncWriter *q, QIODevice *io,
+                             bool ownsIo);
+    ~QuaZipAsyncWriterPrivate();
+    QuaZipAsyncWriter *q;
+    QIODevice *io;
+    bool ownsIo;
+    bool closeIo;
+    QThread *ioThread;
+    QuaZipAsyncWriterDevice device;
+    QuaZip zip;
+    QuaZipAsyncWriterThread worker;
+    int maxQueueSize;
+    qint64 maxQueueBytes;
+    QuaZipAsyncWriter::QueueFullPolicy policy;
+    // everything below is protected by the mutex
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<QuaZipAsyncWriterJob> queue;
+    bool running;
+    bool closing;
+    bool fullReported;
+    QString comment;
+    int zipError;
+    QString errorString;
+    qint64 queuedBytes;
+    int peakQueueDepth;
+    int entriesWritten;
+    qint64 uncompressedBytes;
+    qint64 compressedBytes;
+    QElapsedTimer timer;
+    qint64 elapsed;
+    bool isFull(const QuaZipAsyncWriterJob &job) const;
+    bool enqueue(const QuaZipAsyncWriterJob &job);
+    void setError(int error, const QString &description);
+    bool writeEntry(QuaZipAsyncWriterJob &job);
+    bool copySource(QuaZipFile &file, QIODevice *source);
+    void waitForDevice(qint64 maxPending);
+    void run();
+};
+
+QuaZipAsyncWriterPrivate::QuaZipAsyncWriterPrivate(QuaZipAsyncWriter *q,
+                                                   QIODevice *io,
+                                                   bool ownsIo):
+    q(q),
+    io(io),
+    ownsIo(ownsIo),
+    closeIo(false),
+    ioThread(nullptr),
+    device(io, this),
+    zip(&device),
+    worker(this),
+    maxQueueSize(64),
+    maxQueueBytes(32 * 1024 * 1024),
+    policy(QuaZipAsyncWriter::qfBlock),
+    running(false),
+    closing(false),
+    fullReported(false),
+    zipError(UNZ_OK),
+    queuedBytes(0),
+    peakQueueDepth(0),
+    entriesWritten(0),
+    uncompressedBytes(0),
+    compressedBytes(0),
+    elapsed(0)
+{
+}
+
+QuaZipAsyncWriterPrivate::~QuaZipAsyncWriterPrivate()
+{
+    if (ownsIo)
+        delete io;
+}
+
+bool QuaZipAsyncWriterPrivate::isFull(const QuaZipAsyncWriterJob &job) const
+{
+    if (queue.size() >= maxQueueSize)
+        return true;
+    return maxQueueBytes > 0 && !queue.isEmpty()
+        && queuedBytes + job.data.size() > maxQueueBytes;
+}
+
+bool QuaZipAsyncWriterPrivate::enqueue(const QuaZipAsyncWriterJob &job)
+{
+    QMutexLocker locker(&mutex);
+    if (!running || closing) {
+        qWarning("QuaZipAsyncWriter::addEntry(): the writer is not open");
+        return false;
+    }
+    while (zipError == UNZ_OK && isFull(job)) {
+        if (!fullReported) {
+            fullReported = true;
+            locker.unlock();
+            emit q->queueFull();
+            locker.relock();
+            continue; // the state may have changed meanwhile
+        }
+        if (policy == QuaZipAsyncWriter::qfReject)
+            return false;
+        notFull.wait(&mutex);
+    }
+    if (zipError != UNZ_OK)
+        return false;
+    queue.enqueue(job);
+    queuedBytes += job.data.size();
+    peakQueueDepth = qMax(peakQueueDepth, queue.size());
+    notEmpty.wakeOne();
+    return true;
+}
+
+void QuaZipAsyncWriterPrivate::setError(int error, const QString &description)
+{
+    QMutexLocker locker(&mutex);
+    if (zipError != UNZ_OK)
+        return; // keep the first one
+    zipError = error;
+    errorString = description;
+    // Nobody is going to write the rest, and the producers
+    // shouldn't be waiting for it.
+    queue.clear();
+    queuedBytes = 0;
+    notFull.wakeAll();
+}
+
+void QuaZipAsyncWriterPrivate::waitForDevice(qint64 maxPending)
+{
+    // Only does something for the devices that buffer writes
+    // internally, such as sockets and processes.
+    while (io->bytesToWrite() > maxPending) {
+        if (!io->waitForBytesWritten(30000))
+            break;
+    }
+}
+
+qint64 QuaZipAsyncWriterDevice::writeData(const char *data, qint64 maxSize)
+{
+    qint64 written = target->write(data, maxSize);
+    if (written < 0) {
+        setErrorString(target->errorString());
+        return -1;
+    }
+    d->waitForDevice(QUAZIP_ASYNC_MAX_PENDING);
+    QMutexLocker locker(&d->mutex);
+    if (isSequential()) {
+        d->compressedBytes += written;
+    } else {
+        // local headers are patched in place, don't count them twice
+        d->compressedBytes = qMax(d->compressedBytes, pos() + written);
+    }
+    return written;
+}
+
+bool QuaZipAsyncWriterPrivate::writeEntry(QuaZipAsyncWriterJob &job)
+{
+    QuaZipFile file(&zip);
+    if (!file.open(QIODevice::WriteOnly, job.info, nullptr, 0, job.method,
+                   job.level)) {
+        setError(file.getZipError(), QuaZipAsyncWriter::tr(
+                    "Couldn't add %1 to the archive").arg(job.info.name));
+        return false;
+    }
+    if (job.source == nullptr) {
+        if (file.write(job.data) != job.data.size()) {
+            setError(file.getZipError(), file.errorString());
+            return false;
+        }
+        QMutexLocker locker(&mutex);
+        uncompressedBytes += job.data.size();
+    } else {
+        bool closeSource = false;
+        if (!job.source->isOpen()) {
+            if (!job.source->open(QIODevice::ReadOnly)) {
+                setError(UNZ_ERRNO, job.source->errorString());
+                return false;
+            }
+            closeSource = true;
+        }
+        bool ok = copySource(file, job.source);
+        // whether the copy succeeded or not
+        if (closeSource)
+            job.source->close();
+        if (!ok)
+            return false;
+    }
+    file.close();
+    if (file.getZipError() != UNZ_OK) {
+        setError(file.getZipError(), QuaZipAsyncWriter::tr(
+                    "Couldn't add %1 to the archive").arg(job.info.name));
+        return false;
+    }
+    QMutexLocker locker(&mutex);
+    ++entriesWritten;
+    return true;
+}
+
+bool QuaZipAsyncWriterPrivate::copySource(QuaZipFile &file,
+                                          QIODevice *source)
+{
+    QByteArray buf(QUAZIP_ASYNC_COPY_BUFSIZE, '\0');
+    qint64 read;
+    while ((read = source->read(buf.data(), buf.size())) > 0) {
+        if (file.write(buf.constData(), read) != read) {
+            setError(file.getZipError(), file.errorString());
+            return false;
+        }
+        QMutexLocker locker(&mutex);
+        uncompressedBytes += read;
+    }
+    if (read < 0) {
+        setError(UNZ_ERRNO, source->errorString());
+        return false;
+    }
+    return true;
+}
+
+void QuaZipAsyncWriterPrivate::run()
+{
+    for (;;) {
+        QuaZipAsyncWriterJob job;
+        bool notify = false;
+        {
+            QMutexLocker locker(&mutex);
+            while (queue.isEmpty() && !closing)
+                notEmpty.wait(&mutex);
+            if (queue.isEmpty())
+                break;
+            job = queue.dequeue();
+            queuedBytes -= job.data.size();
+            notFull.wakeAll();
+            if (fullReported && !isFull(QuaZipAsyncWriterJob())) {
+                fullReported = false;
+                notify = true;
+            }
+        }
+        if (notify)
+            emit q->queueAvailable();
+        if (writeEntry(job))
+            emit q->entryWritten(job.info.name);
+    }
+    {
+        QMutexLocker locker(&mutex);
+        zip.setComment(comment);
+    }
+    zip.close();
+    if (zip.getZipError() != UNZ_OK) {
+        setError(zip.getZipError(),
+                 QuaZipAsyncWriter::tr("Couldn't close the archive"));
+    }
+    waitForDevice(0);
+    if (closeIo)
+        io->close();
+    if (ioThread != nullptr)
+        io->moveToThread(ioThread);
+    QMutexLocker locker(&mutex);
+    elapsed = timer.elapsed();
+    running = false;
+}
+
+void QuaZipAsyncWriterThread::run()
+{
+    d->run();
+}
+/// \endcond
+
+QuaZipAsyncWriter::QuaZipAsyncWriter(QIODevice *ioDevice, QObject *parent):
+    QObject(parent),
+    d(new QuaZipAsyncWriterPrivate(this, ioDevice, false))
+{
+}
+
+QuaZipAsyncWriter::QuaZipAsyncWriter(const QString &zipName, QObject *parent):
+    QObject(parent),
+    d(new QuaZipAsyncWriterPrivate(this, new QFile(zipName), true))
+{
+}
+
+QuaZipAsyncWriter::~QuaZipAsyncWriter()
+{
+    if (isOpen())
+        close();
+    delete d;
+}
+
+void QuaZipAsyncWriter::setMaxQueueSize(int entries)
+{
+    d->maxQueueSize = qMax(entries, 1);
+}
+
+int QuaZipAsyncWriter::getMaxQueueSize() const
+{
+    return d->maxQueueSize;
+}
+
+void QuaZipAsyncWriter::setMaxQueueBytes(qint64 bytes)
+{
+    d->maxQueueBytes = bytes;
+}
+
+qint64 QuaZipAsyncWriter::getMaxQueueBytes() const
+{
+    return d->maxQueueBytes;
+}
+
+void QuaZipAsyncWriter::setQueueFullPolicy(QueueFullPolicy policy)
+{
+    QMutexLocker locker(&d->mutex);
+    d->policy = policy;
+}
+
+QuaZipAsyncWriter::QueueFullPolicy QuaZipAsyncWriter::getQueueFullPolicy()
+    const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->policy;
+}
+
+void QuaZipAsyncWriter::setZip64Enabled(bool zip64)
+{
+    if (isOpen()) {
+        qWarning("QuaZipAsyncWriter::setZip64Enabled(): the writer is open");
+        return;
+    }
+    d->zip.setZip64Enabled(zip64);
+}
+
+void QuaZipAsyncWriter::setUtf8Enabled(bool utf8)
+{
+    if (isOpen()) {
+        qWarning("QuaZipAsyncWriter::setUtf8Enabled(): the writer is open");
+        return;
+    }
+    d->zip.setUtf8Enabled(utf8);
+}
+
+void QuaZipAsyncWriter::setComment(const QString &comment)
+{
+    QMutexLocker locker(&d->mutex);
+    d->comment = comment;
+}
+
+bool QuaZipAsyncWriter::open()
+{
+    if (isOpen()) {
+        qWarning("QuaZipAsyncWriter::open(): already opened");
+        return false;
+    }
+    // Make sure the previous run is completely over.
+    d->worker.wait();
+    d->zipError = UNZ_OK;
+    d->errorString.clear();
+    d->queuedBytes = 0;
+    d->peakQueueDepth = 0;
+    d->entriesWritten = 0;
+    d->uncompressedBytes = 0;
+    d->compressedBytes = 0;
+    d->elapsed = 0;
+    d->closing = false;
+    d->fullReported = false;
+    d->closeIo = false;
+    d->ioThread = nullptr;
+    if (!d->io->isOpen()) {
+        if (!d->io->open(QIODevice::WriteOnly)) {
+            d->zipError = UNZ_OPENERROR;
+            d->errorString = d->io->errorString();
+            return false;
+        }
+        d->closeIo = true;
+    } else if (!d->io->isWritable()) {
+        qWarning("QuaZipAsyncWriter::open(): the device is not writable");
+        return false;
+    }
+    if (!d->device.open(QIODevice::WriteOnly)
+            || !d->zip.open(QuaZip::mdCreate)) {
+        d->zipError = d->zip.getZipError() != UNZ_OK
+            ? d->zip.getZipError() : UNZ_OPENERROR;
+        d->errorString = tr("Couldn't create the archive");
+        if (d->device.isOpen())
+            d->device.close();
+        if (d->closeIo)
+            d->io->close();
+        return false;
+    }
+    if (d->io->parent() == nullptr
+            && d->io->thread() == QThread::currentThread()) {
+        d->ioThread = d->io->thread();
+        d->io->moveToThread(&d->worker);
+    }
+    d->timer.start();
+    d->running = true;
+    d->worker.start();
+    return true;
+}
+
+bool QuaZipAsyncWriter::isOpen() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->running && !d->closing;
+}
+
+bool QuaZipAsyncWriter::addEntry(const QuaZipNewInfo &info,
+                                 const QByteArray &data, int method,
+                                 int level)
+{
+    QuaZipAsyncWriterJob job;
+    job.info = info;
+    job.data = data;
+    job.method = method;
+    job.level = level;
+    return d->enqueue(job);
+}
+
+bool QuaZipAsyncWriter::addEntry(const QuaZipNewInfo &info,
+                                 QIODevice *source, int method, int level)
+{
+    if (source == nullptr) {
+        qWarning("QuaZipAsyncWriter::addEntry(): source is null");
+        return false;
+    }
+    QuaZipAsyncWriterJob job;
+    job.info = info;
+    job.source = source;
+    job.method = method;
+    job.level = level;
+    return d->enqueue(job);
+}
+
+bool QuaZipAsyncWriter::close()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        if (!d->running || d->closing) {
+            qWarning("QuaZipAsyncWriter::close(): the writer is not open");
+            return false;
+        }
+        d->closing = true;
+        d->notEmpty.wakeAll();
+    }
+    d->worker.wait();
+    return getZipError() == UNZ_OK;
+}
+
+int QuaZipAsyncWriter::getZipError() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->zipError;
+}
+
+QString QuaZipAsyncWriter::getErrorString() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->errorString;
+}
+
+int QuaZipAsyncWriter::getQueueDepth() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->queue.size();
+}
+
+int QuaZipAsyncWriter::getPeakQueueDepth() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->peakQueueDepth;
+}
+
+qint64 QuaZipAsyncWriter::getQueuedBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->queuedBytes;
+}
+
+int QuaZipAsyncWriter::getEntriesWritten() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->entriesWritten;
+}
+
+qint64 QuaZipAsyncWriter::getUncompressedBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->uncompressedBytes;
+}
+
+qint64 QuaZipAsyncWriter::getCompressedBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->compressedBytes;
+}
+
+qint64 QuaZipAsyncWriter::getElapsedTime() const
+{
+    QMutexLocker locker(&d->mutex);
+    if (d->running)
+        return d->timer.elapsed();
+    return d->elapsed;
+}
+
+double QuaZipAsyncWriter::getThroughput() const
+{
+    qint64 msecs = getElapsedTime();
+    if (msecs <= 0)
+        return 0.0;
+    return getUncompressedBytes() * 1000.0 / msecs;
+}
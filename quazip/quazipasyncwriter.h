@@ -0,0 +1,200 @@
+#ifndef QUAZIP_QUAZIPASYNCWRITER_H
+#define QUAZIP_QUAZIPASYNCWRITER_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include "quazip_global.h"
+#include "quazipnewinfo.h"
+
+#include "quazip_zlib.h"
+
+class QuaZipAsyncWriterPrivate;
+
+/// Writes a ZIP archive in a background thread.
+/** \class QuaZipAsyncWriter quazipasyncwriter.h <quazip/quazipasyncwriter.h>
+ * Compressing the data and writing it to the device is done by a worker
+ * thread, so a slow device (typically a socket with a slow client on the
+ * other end) doesn't stall the thread producing the data. Entries are
+ * put into a bounded queue by addEntry() and written in the same order.
+ *
+ * When the queue is full, addEntry() either blocks until the worker
+ * catches up or fails immediately, depending on the
+ * \ref setQueueFullPolicy() "queue full policy". In both cases,
+ * queueFull() is emitted, and queueAvailable() is emitted once there is
+ * room in the queue again.
+ *
+ * The archive is written in the QuaZip::mdCreate mode. Between open() and
+ * close(), the device is only accessed from the worker thread. If the
+ * device has no parent and lives in the thread calling open(), it is
+ * moved to the worker thread for that time, so sockets can be used as
+ * well. Otherwise, the device must be safe to use from another thread,
+ * like QFile or QBuffer are if nobody else uses them in the meantime.
+ *
+ * Usage:
+ * \code
+ * QuaZipAsyncWriter writer(&socket);
+ * writer.setMaxQueueSize(8);
+ * if (!writer.open())
+ *     return false;
+ * for (int i = 0; i < reports.size(); ++i) {
+ *     writer.addEntry(QuaZipNewInfo(reports[i].name), reports[i].data);
+ * }
+ * return writer.close();
+ * \endcode
+ *
+ * The writer collects some statistics: the number of entries written,
+ * the amount of uncompressed data consumed and compressed data produced,
+ * the throughput and the current and the peak queue depth. They can be
+ * queried at any time from any thread.
+ */
+class QUAZIP_EXPORT QuaZipAsyncWriter: public QObject {
+  friend class QuaZipAsyncWriterPrivate;
+  Q_OBJECT
+public:
+  /// What addEntry() does when the queue is full.
+  enum QueueFullPolicy {
+    qfBlock, ///< Wait until there is room in the queue. This is the default.
+    qfReject ///< Return \c false immediately.
+  };
+  /// Constructs a writer for the specified device.
+  /**
+    If the device is not open, open() opens it in the QIODevice::WriteOnly
+    mode and close() closes it. The device must outlive the writer.
+    */
+  explicit QuaZipAsyncWriter(QIODevice *ioDevice, QObject *parent = nullptr);
+  /// Constructs a writer for the specified file.
+  explicit QuaZipAsyncWriter(const QString &zipName, QObject *parent = nullptr);
+  /// Destructor.
+  /**
+    Closes the writer if it is open, waiting for the queued entries to be
+    written.
+    */
+  virtual ~QuaZipAsyncWriter();
+  /// Sets the maximum number of entries waiting in the queue.
+  /** The default is 64. Must be called before open(). */
+  void setMaxQueueSize(int entries);
+  /// Returns the maximum number of entries waiting in the queue.
+  int getMaxQueueSize() const;
+  /// Sets the maximum amount of data waiting in the queue.
+  /**
+    Only the data passed as QByteArray is counted. An entry larger than
+    the limit is still accepted when the queue is empty. Zero means no
+    limit. The default is 32 MB. Must be called before open().
+    */
+  void setMaxQueueBytes(qint64 bytes);
+  /// Returns the maximum amount of data waiting in the queue.
+  qint64 getMaxQueueBytes() const;
+  /// Sets what addEntry() does when the queue is full.
+  void setQueueFullPolicy(QueueFullPolicy policy);
+  /// Returns what addEntry() does when the queue is full.
+  QueueFullPolicy getQueueFullPolicy() const;
+  /// Enables the Zip64 mode for all entries.
+  /** \sa QuaZip::setZip64Enabled(). Must be called before open(). */
+  void setZip64Enabled(bool zip64);
+  /// Enables the UTF-8 flag for all entries.
+  /** \sa QuaZip::setUtf8Enabled(). Must be called before open(). */
+  void setUtf8Enabled(bool utf8);
+  /// Sets the global comment of the archive.
+  /** The comment is written when the archive is closed. */
+  void setComment(const QString &comment);
+  /// Creates the archive and starts the worker thread.
+  /**
+    \return \c false if the archive couldn't be created. Call
+    getZipError() to find out why.
+    */
+  bool open();
+  /// Returns \c true if the writer is open.
+  bool isOpen() const;
+  /// Queues an entry with the specified data.
+  /**
+    \param info The entry information.
+    \param data The uncompressed data.
+    \param method The compression method, 0 or \c Z_DEFLATED.
+    \param level The compression level.
+    \return \c false if the writer is not open, an error occurred
+    while writing one of the previous entries, or the queue is full and
+    the policy is qfReject.
+    */
+  bool addEntry(const QuaZipNewInfo &info, const QByteArray &data,
+                int method = Z_DEFLATED, int level = Z_DEFAULT_COMPRESSION);
+  /// Queues an entry with the data read from a device.
+  /**
+    \overload
+    The device is read to the end from the worker thread, so it must
+    remain valid until entryWritten() is emitted or close() returns, and
+    it must be safe to read from another thread. If it's not open, it is
+    opened in the QIODevice::ReadOnly mode and closed afterwards.
+    */
+  bool addEntry(const QuaZipNewInfo &info, QIODevice *source,
+                int method = Z_DEFLATED, int level = Z_DEFAULT_COMPRESSION);
+  /// Writes the queued entries, closes the archive and stops the worker.
+  /**
+    Blocks until everything is written.
+    \return \c false if an error occurred while writing any of the entries
+    or the central directory.
+    */
+  bool close();
+  /// Returns the error code of the first failed operation.
+  /** \c UNZ_OK (or \c ZIP_OK) means there was no error. */
+  int getZipError() const;
+  /// Returns the description of the first error.
+  QString getErrorString() const;
+  /// Returns the number of entries waiting in the queue.
+  int getQueueDepth() const;
+  /// Returns the largest number of entries ever waiting in the queue.
+  int getPeakQueueDepth() const;
+  /// Returns the amount of data waiting in the queue.
+  qint64 getQueuedBytes() const;
+  /// Returns the number of entries written so far.
+  int getEntriesWritten() const;
+  /// Returns the amount of uncompressed data written so far.
+  qint64 getUncompressedBytes() const;
+  /// Returns the amount of data written to the device so far.
+  /** This includes the ZIP headers and the central directory. */
+  qint64 getCompressedBytes() const;
+  /// Returns the time elapsed since open(), in milliseconds.
+  /** After close(), the time it took to write the whole archive. */
+  qint64 getElapsedTime() const;
+  /// Returns the average throughput, in uncompressed bytes per second.
+  double getThroughput() const;
+signals:
+  /// Emitted when addEntry() finds the queue full.
+  void queueFull();
+  /// Emitted when there is room in the queue after queueFull().
+  /** Emitted from the worker thread. */
+  void queueAvailable();
+  /// Emitted when an entry has been written.
+  /** Emitted from the worker thread. */
+  void entryWritten(const QString &name);
+private:
+  QuaZipAsyncWriterPrivate *d;
+};
+
+#endif // QUAZIP_QUAZIPASYNCWRITER_H
@@ -0,0 +1,554 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QQueue>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
+
+#include "quazipbatchbuilder.h"
+#include "quazip.h"
+#include "quazipcodec.h"
+#include "quazipfile.h"
+#include "quazip_crc32.h"
+
+#define QUAZIP_BATCH_BUFSIZE 65536
+// The largest entry compressed in memory. Leaves enough room for the
+// deflate overhead and the buffer growth in a QByteArray.
+#define QUAZIP_BATCH_MAX_SIZE (1 << 30)
+
+/// \cond internal
+class QuaZipBatchBuilderPrivate;
+
+/// One submitted entry, compressed by a pool thread.
+class QuaZipBatchBuilderJob: public QRunnable {
+public:
+    enum Source {srcFile, srcData, srcDevice, srcGenerator};
+    QuaZipBatchBuilderJob(QuaZipBatchBuilderPrivate *d, Source source,
+                          const QuaZipNewInfo &info, int method, int level);
+    virtual void run();
+    QuaZipBatchBuilderPrivate *d;
+    Source source;
+    QuaZipNewInfo info;
+    int method;
+    int level;
+    QString fileName;
+    QByteArray data;
+    QIODevice *device;
+    QuaZipBatchBuilder::Generator generator;
+    // the results, valid once done is set
+    QByteArray compressed;
+    quint32 crc;
+    qint64 uncompressedSize;
+    int zipError;
+    QString errorString;
+    bool done;
+private:
+    Q_DECLARE_TR_FUNCTIONS(QuaZipBatchBuilder)
+    z_stream stream;
+    int outPos;
+    void setError(int error, const QString &description);
+    bool checkSize(qint64 size);
+    bool begin(qint64 sizeHint);
+    bool feed(const char *chunk, qint64 size, bool last);
+    bool compressDevice(QIODevice *io);
+    bool compressData();
+    void end();
+};
+
+class QuaZipBatchBuilderPrivate {
+    friend class QuaZipBatchBuilder;
+    friend class QuaZipBatchBuilderJob;
+    Q_DISABLE_COPY(QuaZipBatchBuilderPrivate)
+private:
+    QuaZipBatchBuilderPrivate(QuaZipBatchBuilder *q, QuaZip *zip);
+    QuaZipBatchBuilder *q;
+    QuaZip *zip;
+    QThreadPool pool;
+    int maxPendingEntries;
+    QQueue<QuaZipBatchBuilderJob*> jobs;
+    bool failed;
+    int zipError;
+    QString errorString;
+    int entriesWritten;
+    // protected by the mutex
+    QMutex mutex;
+    QWaitCondition jobDone;
+    bool aborted;
+    Q_DECLARE_TR_FUNCTIONS(QuaZipBatchBuilder)
+    bool checkZip();
+    bool submit(QuaZipBatchBuilderJob *job);
+    bool writeJobs(int maxPending);
+    bool writeJob(QuaZipBatchBuilderJob *job);
+    void setError(int error, const QString &description);
+    void discard();
+};
+
+QuaZipBatchBuilderJob::QuaZipBatchBuilderJob(QuaZipBatchBuilderPrivate *d,
+                                             Source source,
+                                             const QuaZipNewInfo &info,
+                                             int method, int level):
+    d(d), source(source), info(info), method(method), level(level),
+    device(nullptr), crc(0), uncompressedSize(0), zipError(UNZ_OK),
+    done(false), outPos(0)
+{
+    setAutoDelete(false);
+}
+
+void QuaZipBatchBuilderJob::setError(int error, const QString &description)
+{
+    if (zipError == UNZ_OK) {
+        zipError = error;
+        errorString = description;
+    }
+}
+
+bool QuaZipBatchBuilderJob::checkSize(qint64 size)
+{
+    if (size <= QUAZIP_BATCH_MAX_SIZE)
+        return true;
+    setError(UNZ_PARAMERROR, tr("The entry %1 is too large to be compressed"
+                                " in memory").arg(info.name));
+    return false;
+}
+
+bool QuaZipBatchBuilderJob::begin(qint64 sizeHint)
+{
+    crc = 0;
+    uncompressedSize = 0;
+    outPos = 0;
+    if (!checkSize(sizeHint))
+        return false;
+    if (method != Z_DEFLATED) {
+        if (sizeHint > 0)
+            compressed.reserve(static_cast<int>(sizeHint));
+        return true;
+    }
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    int result = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS,
+                              DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (result != Z_OK) {
+        setError(result, tr("Failed to initialize the compressor"));
+        return false;
+    }
+    // A single pass is enough if the size is known in advance.
+    if (sizeHint >= 0)
+        compressed.resize(static_cast<int>(
+            deflateBound(&stream, static_cast<uLong>(sizeHint))));
+    return true;
+}
+
+bool QuaZipBatchBuilderJob::feed(const char *chunk, qint64 size, bool last)
+{
+    crc = quazip_crc32(crc, reinterpret_cast<const Bytef*>(chunk),
+                       static_cast<size_t>(size));
+    uncompressedSize += size;
+    // sequential devices may turn out to be larger than QByteArray allows
+    if (!checkSize(uncompressedSize))
+        return false;
+    if (method != Z_DEFLATED) {
+        compressed.append(chunk, static_cast<int>(size));
+        return true;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(chunk));
+    stream.avail_in = static_cast<uInt>(size);
+    for (;;) {
+        if (compressed.size() - outPos < QUAZIP_BATCH_BUFSIZE / 4)
+            compressed.resize(outPos + qMax(QUAZIP_BATCH_BUFSIZE,
+                                            compressed.size() / 2));
+        stream.next_out = reinterpret_cast<Bytef*>(compressed.data()) + outPos;
+        stream.avail_out = static_cast<uInt>(compressed.size() - outPos);
+        int result = deflate(&stream, last ? Z_FINISH : Z_NO_FLUSH);
+        outPos = compressed.size() - static_cast<int>(stream.avail_out);
+        if (result == Z_STREAM_END)
+            return true;
+        if (result != Z_OK) {
+            setError(result, tr("Failed to compress the entry %1")
+                     .arg(info.name));
+            return false;
+        }
+        if (!last && stream.avail_in == 0)
+            return true;
+    }
+}
+
+void QuaZipBatchBuilderJob::end()
+{
+    if (method == Z_DEFLATED) {
+        deflateEnd(&stream);
+        compressed.resize(outPos);
+    }
+}
+
+bool QuaZipBatchBuilderJob::compressDevice(QIODevice *io)
+{
+    if (!begin(io->isSequential() ? -1 : io->size() - io->pos()))
+        return false;
+    QByteArray buffer(QUAZIP_BATCH_BUFSIZE, '\0');
+    bool ok = true;
+    for (;;) {
+        qint64 read = io->read(buffer.data(), buffer.size());
+        if (read < 0) {
+            setError(UNZ_ERRNO, io->errorString());
+            ok = false;
+            break;
+        }
+        if (read == 0 && !io->atEnd() && io->waitForReadyRead(-1))
+            continue;
+        bool last = read == 0;
+        if (!feed(buffer.constData(), read, last)) {
+            ok = false;
+            break;
+        }
+        if (last)
+            break;
+    }
+    end();
+    return ok;
+}
+
+bool QuaZipBatchBuilderJob::compressData()
+{
+    if (method != Z_DEFLATED
+            || QuaZipCodec::getBackend() == QuaZipCodec::Zlib) {
+        if (!begin(data.size()))
+            return false;
+        bool ok = feed(data.constData(), data.size(), true);
+        end();
+        return ok;
+    }
+    // the other backends only work on whole buffers, which is the case here
+    if (!checkSize(data.size()))
+        return false;
+    crc = quazip_crc32(0L,
+                       reinterpret_cast<const Bytef*>(data.constData()),
+                       static_cast<size_t>(data.size()));
+    uncompressedSize = data.size();
+    compressed.resize(static_cast<int>(
+        QuaZipCodec::deflateRawBound(data.size(), level)));
+    qint64 size = QuaZipCodec::deflateRaw(data.constData(), data.size(),
+                                          compressed.data(),
+                                          compressed.size(), level);
+    if (size <= 0) {
+        compressed = QByteArray();
+        setError(size < 0 ? static_cast<int>(size) : Z_BUF_ERROR,
+                 tr("Failed to compress the entry %1").arg(info.name));
+        return false;
+    }
+    compressed.resize(static_cast<int>(size));
+    return true;
+}
+
+void QuaZipBatchBuilderJob::run()
+{
+    bool skip;
+    {
+        QMutexLocker locker(&d->mutex);
+        skip = d->aborted;
+    }
+    if (!skip) {
+        switch (source) {
+        case srcFile: {
+            QFile file(fileName);
+            if (!file.open(QIODevice::ReadOnly)) {
+                setError(UNZ_ERRNO, tr("Can't open %1: %2")
+                         .arg(fileName, file.errorString()));
+                break;
+            }
+            compressDevice(&file);
+            break;
+        }
+        case srcDevice:
+            compressDevice(device);
+            break;
+        case srcGenerator:
+            data = generator();
+            generator = QuaZipBatchBuilder::Generator();
+            if (data.isNull()) {
+                setError(UNZ_INTERNALERROR,
+                         tr("Failed to generate the entry %1").arg(info.name));
+                break;
+            }
+            // fall through
+        case srcData:
+            compressData();
+            data = QByteArray();
+            break;
+        }
+    }
+    QMutexLocker locker(&d->mutex);
+    done = true;
+    d->jobDone.wakeAll();
+}
+
+QuaZipBatchBuilderPrivate::QuaZipBatchBuilderPrivate(QuaZipBatchBuilder *q,
+                                                     QuaZip *zip):
+    q(q), zip(zip), maxPendingEntries(0), failed(false), zipError(UNZ_OK),
+    entriesWritten(0), aborted(false)
+{
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+bool QuaZipBatchBuilderPrivate::checkZip()
+{
+    if (zip == nullptr) {
+        qWarning("QuaZipBatchBuilder: zip is null");
+        return false;
+    }
+    if (zip->getMode() != QuaZip::mdCreate
+            && zip->getMode() != QuaZip::mdAppend
+            && zip->getMode() != QuaZip::mdAdd) {
+        qWarning("QuaZipBatchBuilder: ZIP open mode %d doesn't allow"
+                 " adding entries", static_cast<int>(zip->getMode()));
+        return false;
+    }
+    return true;
+}
+
+void QuaZipBatchBuilderPrivate::setError(int error,
+                                         const QString &description)
+{
+    if (!failed) {
+        failed = true;
+        zipError = error;
+        errorString = description;
+    }
+}
+
+bool QuaZipBatchBuilderPrivate::submit(QuaZipBatchBuilderJob *job)
+{
+    if (job->method != 0 && job->method != Z_DEFLATED) {
+        qWarning("QuaZipBatchBuilder: unsupported compression method %d",
+                 job->method);
+        delete job;
+        return false;
+    }
+    if (!checkZip() || failed) {
+        delete job;
+        return false;
+    }
+    if (jobs.isEmpty()) {
+        zipError = UNZ_OK;
+        errorString.clear();
+    }
+    jobs.enqueue(job);
+    pool.start(job);
+    return writeJobs(q->getMaxPendingEntries());
+}
+
+bool QuaZipBatchBuilderPrivate::writeJobs(int maxPending)
+{
+    while (!jobs.isEmpty()) {
+        QuaZipBatchBuilderJob *job = jobs.head();
+        {
+            QMutexLocker locker(&mutex);
+            if (!job->done) {
+                if (jobs.size() <= maxPending)
+                    break;
+                while (!job->done)
+                    jobDone.wait(&mutex);
+            }
+        }
+        jobs.dequeue();
+        bool ok = writeJob(job);
+        delete job;
+        if (!ok) {
+            discard();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QuaZipBatchBuilderPrivate::writeJob(QuaZipBatchBuilderJob *job)
+{
+    if (job->zipError != UNZ_OK) {
+        setError(job->zipError, job->errorString);
+        return false;
+    }
+    QuaZipNewInfo info(job->info);
+    info.uncompressedSize = static_cast<ulong>(job->uncompressedSize);
+    QuaZipFile file(zip);
+    if (!file.open(QIODevice::WriteOnly, info, nullptr, job->crc,
+                   job->method, job->level, true)) {
+        setError(file.getZipError(), tr("Failed to add the entry %1")
+                 .arg(info.name));
+        return false;
+    }
+    if (file.write(job->compressed) != job->compressed.size()) {
+        setError(file.getZipError() != UNZ_OK ? file.getZipError()
+                                              : UNZ_ERRNO,
+                 tr("Failed to write the entry %1").arg(info.name));
+        file.close();
+        return false;
+    }
+    file.close();
+    if (file.getZipError() != UNZ_OK) {
+        setError(file.getZipError(), tr("Failed to close the entry %1")
+                 .arg(info.name));
+        return false;
+    }
+    ++entriesWritten;
+    return true;
+}
+
+void QuaZipBatchBuilderPrivate::discard()
+{
+    {
+        QMutexLocker locker(&mutex);
+        aborted = true;
+    }
+    // the jobs still reference the sources, so they must finish first
+    pool.waitForDone();
+    qDeleteAll(jobs);
+    jobs.clear();
+    QMutexLocker locker(&mutex);
+    aborted = false;
+}
+/// \endcond
+
+QuaZipBatchBuilder::QuaZipBatchBuilder(QuaZip *zip):
+    p(new QuaZipBatchBuilderPrivate(this, zip))
+{
+}
+
+QuaZipBatchBuilder::~QuaZipBatchBuilder()
+{
+    if (!p->jobs.isEmpty())
+        finish();
+    delete p;
+}
+
+void QuaZipBatchBuilder::setMaxThreadCount(int maxThreadCount)
+{
+    if (!p->jobs.isEmpty()) {
+        qWarning("QuaZipBatchBuilder::setMaxThreadCount(): can't change"
+                 " the thread count while there are unfinished entries");
+        return;
+    }
+    p->pool.setMaxThreadCount(qMax(1, maxThreadCount));
+}
+
+int QuaZipBatchBuilder::getMaxThreadCount() const
+{
+    return p->pool.maxThreadCount();
+}
+
+void QuaZipBatchBuilder::setMaxPendingEntries(int maxPendingEntries)
+{
+    p->maxPendingEntries = maxPendingEntries;
+}
+
+int QuaZipBatchBuilder::getMaxPendingEntries() const
+{
+    if (p->maxPendingEntries > 0)
+        return p->maxPendingEntries;
+    return 2 * p->pool.maxThreadCount();
+}
+
+bool QuaZipBatchBuilder::addFile(const QString &nameInZip,
+                                 const QString &fileName,
+                                 int method, int level)
+{
+    QuaZipBatchBuilderJob *job = new QuaZipBatchBuilderJob(p,
+        QuaZipBatchBuilderJob::srcFile, QuaZipNewInfo(nameInZip, fileName),
+        method, level);
+    job->fileName = fileName;
+    return p->submit(job);
+}
+
+bool QuaZipBatchBuilder::addData(const QuaZipNewInfo &info,
+                                 const QByteArray &data,
+                                 int method, int level)
+{
+    QuaZipBatchBuilderJob *job = new QuaZipBatchBuilderJob(p,
+        QuaZipBatchBuilderJob::srcData, info, method, level);
+    job->data = data;
+    return p->submit(job);
+}
+
+bool QuaZipBatchBuilder::addDevice(const QuaZipNewInfo &info,
+                                   QIODevice *device,
+                                   int method, int level)
+{
+    if (device == nullptr || !device->isReadable()) {
+        qWarning("QuaZipBatchBuilder::addDevice(): the device must be open"
+                 " for reading");
+        return false;
+    }
+    QuaZipBatchBuilderJob *job = new QuaZipBatchBuilderJob(p,
+        QuaZipBatchBuilderJob::srcDevice, info, method, level);
+    job->device = device;
+    return p->submit(job);
+}
+
+bool QuaZipBatchBuilder::addGenerated(const QuaZipNewInfo &info,
+                                      Generator generator,
+                                      int method, int level)
+{
+    if (!generator) {
+        qWarning("QuaZipBatchBuilder::addGenerated(): the generator is empty");
+        return false;
+    }
+    QuaZipBatchBuilderJob *job = new QuaZipBatchBuilderJob(p,
+        QuaZipBatchBuilderJob::srcGenerator, info, method, level);
+    job->generator = generator;
+    return p->submit(job);
+}
+
+int QuaZipBatchBuilder::getPendingEntries() const
+{
+    return p->jobs.size();
+}
+
+int QuaZipBatchBuilder::getEntriesWritten() const
+{
+    return p->entriesWritten;
+}
+
+bool QuaZipBatchBuilder::finish()
+{
+    if (!p->failed)
+        p->writeJobs(0);
+    bool ok = !p->failed;
+    p->failed = false;
+    return ok;
+}
+
+int QuaZipBatchBuilder::getZipError() const
+{
+    return p->zipError;
+}
+
+QString QuaZipBatchBuilder::getErrorString() const
+{
+    return p->errorString;
+}
@@ -0,0 +1,193 @@
+#ifndef QUAZIP_QUAZIPBATCHBUILDER_H
+#define QUAZIP_QUAZIPBATCHBUILDER_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <functional>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+#include <QtCore/QString>
+
+#include "quazip_global.h"
+#include "quazipnewinfo.h"
+
+#include "quazip_zlib.h"
+
+class QuaZip;
+class QuaZipBatchBuilderPrivate;
+
+/// Builds a ZIP archive from many sources, compressing them in parallel.
+/** \class QuaZipBatchBuilder quazipbatchbuilder.h <quazip/quazipbatchbuilder.h>
+ * Entries are submitted one by one with the add*() functions. Each
+ * source is read and compressed by a thread pool, and the compressed
+ * entries are written to the archive in the order they were submitted,
+ * so the result is exactly the same as if they were written one after
+ * another with QuaZipFile.
+ *
+ * A source may be a file, a QByteArray, a QIODevice or a
+ * \ref Generator "generator" function that produces the data when it
+ * is about to be compressed. Generators are the way to assemble a large
+ * number of generated documents without keeping all of them in memory
+ * or writing them to temporary files first.
+ *
+ * Only a limited number of entries is in flight at any time (see
+ * setMaxPendingEntries()). When the limit is reached, the add*()
+ * functions write the oldest entry to the archive, waiting for it to be
+ * compressed if needed. Therefore, the archive is only accessed from the
+ * thread calling add*() and finish(), and the number of entries held in
+ * memory doesn't depend on how many entries are added.
+ *
+ * Each entry in flight is compressed into a memory buffer holding the
+ * whole compressed entry, so the memory used is roughly the compressed
+ * size of the largest entries times the maximum number of entries in
+ * flight. Entries larger than 1 GB are rejected with UNZ_PARAMERROR;
+ * add them with QuaZipFile instead.
+ *
+ * Usage:
+ * \code
+ * QuaZip zip("reports.zip");
+ * zip.open(QuaZip::mdCreate);
+ * QuaZipBatchBuilder builder(&zip);
+ * for (int i = 0; i < reports.size(); ++i) {
+ *     const Report &report = reports.at(i);
+ *     builder.addGenerated(QuaZipNewInfo(report.fileName()),
+ *                          [report]() { return report.render(); });
+ * }
+ * if (!builder.finish())
+ *     qWarning() << builder.getErrorString();
+ * zip.close();
+ * \endcode
+ *
+ * Only the stored (0) and deflated (\c Z_DEFLATED) methods are supported,
+ * and the entries can't be encrypted.
+ *
+ * Sources are read from the pool threads. File sources are opened there
+ * too. A QIODevice source must be open for reading and mustn't be used
+ * by anyone else until the builder is done with it; this is safe for
+ * QFile and QBuffer, but not for devices having thread affinity, such
+ * as sockets. Generators are called from the pool threads as well and
+ * must be safe to call concurrently with each other.
+ *
+ * If an error occurs, the remaining entries are discarded without being
+ * written and all further add*() calls fail until finish() is called.
+ */
+class QUAZIP_EXPORT QuaZipBatchBuilder {
+  friend class QuaZipBatchBuilderPrivate;
+public:
+    /// A function producing the data of an entry.
+    /** It is called from a pool thread once. A null QByteArray return
+     * value indicates an error, while an empty but non-null one means an
+     * empty entry.
+     */
+    typedef std::function<QByteArray()> Generator;
+    /// Constructs a builder adding entries to the specified archive.
+    /** The archive must be open in the QuaZip::mdCreate,
+     * QuaZip::mdAppend or QuaZip::mdAdd mode, must outlive the builder
+     * and must not be used by anyone else until finish() is called.
+     */
+    explicit QuaZipBatchBuilder(QuaZip *zip);
+    /// Destroys the builder.
+    /** Calls finish() if there are unfinished entries. */
+    ~QuaZipBatchBuilder();
+    /// Sets the maximum number of threads used for compression.
+    /** The default is QThread::idealThreadCount(). Can't be changed
+     * while there are unfinished entries.
+     */
+    void setMaxThreadCount(int maxThreadCount);
+    /// Returns the maximum number of threads used for compression.
+    int getMaxThreadCount() const;
+    /// Sets the maximum number of entries in flight.
+    /** This includes the entries waiting for a thread, being compressed
+     * and waiting to be written. The default is twice the maximum
+     * thread count. The larger this number, the less likely a single
+     * large entry stalls the threads, but the more memory is used.
+     */
+    void setMaxPendingEntries(int maxPendingEntries);
+    /// Returns the maximum number of entries in flight.
+    int getMaxPendingEntries() const;
+    /// Adds an entry with the contents of a file.
+    /** The file information (time, permissions) is taken from the file
+     * immediately, but the file itself is read later in a pool thread.
+     * \param nameInZip The name of the entry.
+     * \param fileName The name of the file to read.
+     * \param method The compression method, 0 or \c Z_DEFLATED.
+     * \param level The compression level.
+     * \return \c false if an error has occurred while writing one of the
+     * previous entries. Since the entry is written later, errors related
+     * to it are only reported by the subsequent calls.
+     */
+    bool addFile(const QString &nameInZip, const QString &fileName,
+                 int method = Z_DEFLATED,
+                 int level = Z_DEFAULT_COMPRESSION);
+    /// Adds an entry with the specified contents.
+    /** QByteArray is implicitly shared, so the data isn't copied.
+     * See addFile() for the parameters and the return value.
+     */
+    bool addData(const QuaZipNewInfo &info, const QByteArray &data,
+                 int method = Z_DEFLATED,
+                 int level = Z_DEFAULT_COMPRESSION);
+    /// Adds an entry with the data read from a device.
+    /** The device is read to the end from a pool thread. It is neither
+     * owned nor closed by the builder and must stay alive until the
+     * entry is written (at the latest, until finish() returns).
+     * See addFile() for the parameters and the return value.
+     */
+    bool addDevice(const QuaZipNewInfo &info, QIODevice *device,
+                   int method = Z_DEFLATED,
+                   int level = Z_DEFAULT_COMPRESSION);
+    /// Adds an entry with the data produced by a generator.
+    /** See addFile() for the parameters and the return value.
+     */
+    bool addGenerated(const QuaZipNewInfo &info, Generator generator,
+                      int method = Z_DEFLATED,
+                      int level = Z_DEFAULT_COMPRESSION);
+    /// Returns the number of entries submitted, but not written yet.
+    int getPendingEntries() const;
+    /// Returns the number of entries written so far.
+    int getEntriesWritten() const;
+    /// Waits for all entries to be compressed and writes them.
+    /** The archive is not closed, so more entries can be added to it
+     * either with this builder or with QuaZipFile.
+     *
+     * \return \c true if all entries were written successfully.
+     * Otherwise, getZipError() and getErrorString() describe the first
+     * error. Either way, the builder is ready to accept new entries
+     * afterwards, and the error state is reset by the next add*() call.
+     */
+    bool finish();
+    /// Returns the error code of the first error.
+    /** \c UNZ_OK means there was no error. Otherwise, it is either an
+     * \c UNZ_* or \c ZIP_* code or a zlib error code.
+     */
+    int getZipError() const;
+    /// Returns the description of the first error.
+    QString getErrorString() const;
+private:
+    QuaZipBatchBuilderPrivate *p;
+    Q_DISABLE_COPY(QuaZipBatchBuilder)
+};
+
+#endif // QUAZIP_QUAZIPBATCHBUILDER_H
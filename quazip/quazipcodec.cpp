@@ -0,0 +1,320 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <climits>
+
+#include "quazipcodec.h"
+#include "quazip_qt_compat.h"
+#include "zip.h"
+
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+/// \cond internal
+// may be changed while the pool threads of QuaZipBatchBuilder read it
+static QAtomicInt quazip_codec_backend(QuaZipCodec::Zlib);
+
+// zlib counts in uInt, so large buffers are passed in pieces
+static const qint64 QUAZIP_CODEC_MAX_CHUNK = UINT_MAX;
+
+static void quazip_codec_refill(qint64 &left, uInt &avail)
+{
+    uInt chunk = static_cast<uInt>(qMin(left, QUAZIP_CODEC_MAX_CHUNK));
+    avail = chunk;
+    left -= chunk;
+}
+
+static qint64 quazip_zlib_deflate_raw(const char *data, qint64 size,
+                                      char *out, qint64 maxSize, int level)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    int result = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS,
+                              DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (result != Z_OK)
+        return result;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = 0;
+    stream.next_out = reinterpret_cast<Bytef*>(out);
+    stream.avail_out = 0;
+    qint64 inLeft = size;
+    qint64 outLeft = maxSize;
+    bool full = false;
+    for (;;) {
+        if (stream.avail_in == 0 && inLeft > 0)
+            quazip_codec_refill(inLeft, stream.avail_in);
+        if (stream.avail_out == 0) {
+            if (outLeft == 0) {
+                full = true;
+                break;
+            }
+            quazip_codec_refill(outLeft, stream.avail_out);
+        }
+        result = deflate(&stream, inLeft == 0 ? Z_FINISH : Z_NO_FLUSH);
+        if (result != Z_OK)
+            break;
+    }
+    qint64 written = reinterpret_cast<char*>(stream.next_out) - out;
+    deflateEnd(&stream);
+    if (full)
+        return 0;
+    return result == Z_STREAM_END ? written : result;
+}
+
+static int quazip_zlib_inflate_raw(const char *data, qint64 size,
+                                   char *out, qint64 outSize)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    int result = inflateInit2(&stream, -MAX_WBITS);
+    if (result != Z_OK)
+        return result;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.next_out = reinterpret_cast<Bytef*>(out);
+    stream.avail_out = 0;
+    qint64 inLeft = size;
+    qint64 outLeft = outSize;
+    // One byte past the end, to tell whether the data is larger than
+    // expected without writing past the buffer.
+    char extra;
+    bool extraUsed = false;
+    for (;;) {
+        if (stream.avail_in == 0 && inLeft > 0)
+            quazip_codec_refill(inLeft, stream.avail_in);
+        if (stream.avail_out == 0) {
+            if (outLeft > 0) {
+                quazip_codec_refill(outLeft, stream.avail_out);
+            } else if (!extraUsed) {
+                stream.next_out = reinterpret_cast<Bytef*>(&extra);
+                stream.avail_out = 1;
+                extraUsed = true;
+            } else {
+                result = Z_DATA_ERROR;
+                break;
+            }
+        }
+        result = inflate(&stream, Z_NO_FLUSH);
+        if (result != Z_OK)
+            break;
+        if (stream.avail_in == 0 && inLeft == 0 && stream.avail_out != 0) {
+            // truncated
+            result = Z_DATA_ERROR;
+            break;
+        }
+    }
+    inflateEnd(&stream);
+    if (result == Z_STREAM_END) {
+        bool exact = extraUsed ? stream.avail_out == 1
+            : reinterpret_cast<char*>(stream.next_out) - out == outSize;
+        return exact ? Z_OK : Z_DATA_ERROR;
+    }
+    return result == Z_BUF_ERROR ? Z_DATA_ERROR : result;
+}
+
+#ifdef HAVE_LIBDEFLATE
+// libdeflate's (de)compressors can't be shared between threads, and
+// allocating them is expensive, so each thread keeps its own.
+class QuaZipLibDeflate {
+public:
+    QuaZipLibDeflate(): compressor(nullptr), level(0), decompressor(nullptr) {}
+    ~QuaZipLibDeflate()
+    {
+        if (compressor != nullptr)
+            libdeflate_free_compressor(compressor);
+        if (decompressor != nullptr)
+            libdeflate_free_decompressor(decompressor);
+    }
+    libdeflate_compressor *getCompressor(int level)
+    {
+        if (level == Z_DEFAULT_COMPRESSION)
+            level = 6;
+        if (compressor != nullptr && this->level != level) {
+            libdeflate_free_compressor(compressor);
+            compressor = nullptr;
+        }
+        if (compressor == nullptr) {
+            compressor = libdeflate_alloc_compressor(level);
+            this->level = level;
+        }
+        return compressor;
+    }
+    libdeflate_decompressor *getDecompressor()
+    {
+        if (decompressor == nullptr)
+            decompressor = libdeflate_alloc_decompressor();
+        return decompressor;
+    }
+    static QuaZipLibDeflate &instance()
+    {
+        static thread_local QuaZipLibDeflate state;
+        return state;
+    }
+private:
+    Q_DISABLE_COPY(QuaZipLibDeflate)
+    libdeflate_compressor *compressor;
+    int level;
+    libdeflate_decompressor *decompressor;
+};
+#endif // HAVE_LIBDEFLATE
+
+// libdeflate has no real equivalent of level 0, so zlib stores the data
+static bool quazip_codec_use_libdeflate(int level)
+{
+    return QuaZipCodec::getBackend() == QuaZipCodec::LibDeflate
+        && level != 0;
+}
+/// \endcond
+
+bool QuaZipCodec::setBackend(Backend backend)
+{
+    if (!isBackendAvailable(backend))
+        return false;
+    quazip_codec_backend.fetchAndStoreOrdered(backend);
+    return true;
+}
+
+QuaZipCodec::Backend QuaZipCodec::getBackend()
+{
+    return static_cast<Backend>(quazip_atomic_load(quazip_codec_backend));
+}
+
+bool QuaZipCodec::isBackendAvailable(Backend backend)
+{
+    switch (backend) {
+    case Zlib:
+        return true;
+    case LibDeflate:
+#ifdef HAVE_LIBDEFLATE
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+QList<QuaZipCodec::Backend> QuaZipCodec::getAvailableBackends()
+{
+    QList<Backend> backends;
+    backends << Zlib;
+    if (isBackendAvailable(LibDeflate))
+        backends << LibDeflate;
+    return backends;
+}
+
+bool QuaZipCodec::isMethodSupported(int method)
+{
+    switch (method) {
+    case 0:
+    case Z_DEFLATED:
+        return true;
+#ifdef HAVE_BZIP2
+    case Z_BZIP2ED:
+        return true;
+#endif
+#ifdef HAVE_ZSTD
+    case Z_ZSTD:
+        return true;
+#endif
+#ifdef HAVE_LZMA
+    case Z_LZMA:
+    case Z_XZ:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+qint64 QuaZipCodec::deflateRawBound(qint64 size, int level)
+{
+    if (level < Z_DEFAULT_COMPRESSION || level > 9)
+        return -1;
+#ifdef HAVE_LIBDEFLATE
+    if (quazip_codec_use_libdeflate(level)) {
+        libdeflate_compressor *compressor =
+            QuaZipLibDeflate::instance().getCompressor(level);
+        if (compressor == nullptr)
+            return -1;
+        return static_cast<qint64>(libdeflate_deflate_compress_bound(
+            compressor, static_cast<size_t>(size)));
+    }
+#endif
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS,
+                     DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+        return -1;
+    qint64 bound = static_cast<qint64>(
+        deflateBound(&stream, static_cast<uLong>(size)));
+    deflateEnd(&stream);
+    return bound;
+}
+
+qint64 QuaZipCodec::deflateRaw(const char *data, qint64 size, char *out,
+                               qint64 maxSize, int level)
+{
+    if (level < Z_DEFAULT_COMPRESSION || level > 9)
+        return Z_STREAM_ERROR;
+#ifdef HAVE_LIBDEFLATE
+    if (quazip_codec_use_libdeflate(level)) {
+        libdeflate_compressor *compressor =
+            QuaZipLibDeflate::instance().getCompressor(level);
+        if (compressor == nullptr)
+            return Z_MEM_ERROR;
+        return static_cast<qint64>(libdeflate_deflate_compress(compressor,
+            data, static_cast<size_t>(size),
+            out, static_cast<size_t>(maxSize)));
+    }
+#endif
+    return quazip_zlib_deflate_raw(data, size, out, maxSize, level);
+}
+
+int QuaZipCodec::inflateRaw(const char *data, qint64 size, char *out,
+                            qint64 outSize)
+{
+#ifdef HAVE_LIBDEFLATE
+    if (getBackend() == LibDeflate) {
+        libdeflate_decompressor *decompressor =
+            QuaZipLibDeflate::instance().getDecompressor();
+        if (decompressor == nullptr)
+            return Z_MEM_ERROR;
+        // with no actual size given, anything but exactly outSize fails
+        return libdeflate_deflate_decompress(decompressor,
+            data, static_cast<size_t>(size),
+            out, static_cast<size_t>(outSize), nullptr)
+                == LIBDEFLATE_SUCCESS ? Z_OK : Z_DATA_ERROR;
+    }
+#endif
+    return quazip_zlib_inflate_raw(data, size, out, outSize);
+}
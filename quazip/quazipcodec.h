@@ -0,0 +1,115 @@
+#ifndef QUAZIP_QUAZIPCODEC_H
+#define QUAZIP_QUAZIPCODEC_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QList>
+
+#include "quazip_global.h"
+#include "quazip_zlib.h"
+
+/// Selects the implementation of Deflate used for whole buffers.
+/** \class QuaZipCodec quazipcodec.h <quazip/quazipcodec.h>
+ * Streams are always compressed and decompressed by the zlib QuaZip is
+ * built against. This is either zlib itself or, with the
+ * \c QUAZIP_USE_ZLIB_NG CMake option, zlib-ng through its native API.
+ *
+ * Whenever the whole data is available at once, however, QuaZip goes
+ * through this class instead, which may use a faster implementation
+ * working on whole buffers only. Currently, these places are:
+ * - QuaZip::addEntry();
+ * - QuaZip::readEntry() and QuaZip::readEntries();
+ * - QuaZipBatchBuilder::addData() and QuaZipBatchBuilder::addGenerated().
+ *
+ * The only such implementation is libdeflate, available if QuaZip is
+ * built with the \c QUAZIP_ENABLE_LIBDEFLATE CMake option. It is not
+ * used unless selected with setBackend(). The compressed data it produces
+ * is a valid raw Deflate stream like any other, so the archives can be
+ * read by anything, but it isn't byte-for-byte the same as zlib's.
+ *
+ * All functions work with raw Deflate streams, without the zlib or gzip
+ * wrappers, and use zlib's compression levels and error codes.
+ *
+ * Besides, this class tells which compression methods are available,
+ * as some of them depend on optional libraries.
+ */
+class QUAZIP_EXPORT QuaZipCodec {
+public:
+  /// The implementation.
+  enum Backend {
+    Zlib, ///< zlib or zlib-ng, whichever QuaZip is built against.
+    LibDeflate ///< libdeflate, if available.
+  };
+  /// Selects the implementation for the whole process.
+  /** The default is QuaZipCodec::Zlib. This function is thread-safe. The
+   * data that another thread is compressing or decompressing at the
+   * moment may still go through the previous backend, which only affects
+   * how it is compressed.
+   * \return \c false if \a backend isn't available, in which case the
+   * current backend is kept.
+   */
+  static bool setBackend(Backend backend);
+  /// Returns the current implementation.
+  static Backend getBackend();
+  /// Returns \c true if \a backend has been built in.
+  static bool isBackendAvailable(Backend backend);
+  /// Returns the implementations that have been built in.
+  static QList<Backend> getAvailableBackends();
+  /// Returns \c true if entries compressed with \a method can be read and written.
+  /** This is always the case for the stored (0) and Z_DEFLATED methods.
+   * Z_BZIP2ED needs the \c QUAZIP_ENABLE_BZIP2 CMake option, Z_ZSTD needs
+   * \c QUAZIP_ENABLE_ZSTD, Z_LZMA and Z_XZ need \c QUAZIP_ENABLE_LZMA.
+   * Entries compressed with any method can still be copied in the raw
+   * mode.
+   *
+   * Z_DEFLATE64 (9) entries can always be read, but not written, so
+   * this returns \c false for it.
+   */
+  static bool isMethodSupported(int method);
+  /// Returns the maximum size of \a size bytes compressed at \a level.
+  static qint64 deflateRawBound(qint64 size,
+                                int level = Z_DEFAULT_COMPRESSION);
+  /// Compresses \a size bytes of \a data in one go.
+  /** The compressed data is written to \a out, which can hold up to
+   * \a maxSize bytes. A buffer of deflateRawBound() bytes is always
+   * enough. If the buffer is too small, 0 is returned, which makes it
+   * easy to store the data instead of compressing it if compression
+   * doesn't make it smaller.
+   * \return The size of the compressed data, 0 if it doesn't fit into
+   * \a maxSize bytes, or a negative zlib error code.
+   */
+  static qint64 deflateRaw(const char *data, qint64 size, char *out,
+                           qint64 maxSize, int level = Z_DEFAULT_COMPRESSION);
+  /// Decompresses \a size bytes of \a data in one go.
+  /** The decompressed size must be known in advance. It is an error if
+   * the data decompresses to anything but exactly \a outSize bytes.
+   * \return \c Z_OK, or a zlib error code, \c Z_DATA_ERROR if the data is
+   * corrupt or its size is not \a outSize.
+   */
+  static int inflateRaw(const char *data, qint64 size, char *out,
+                        qint64 outSize);
+};
+
+#endif // QUAZIP_QUAZIPCODEC_H
@@ -24,12 +24,242 @@ quazip/(un)zip.h files for details, basically it's zlib license.
 
 #include "quazipfile.h"
 
+#include <QtCore/QList>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
+#include "quazipcodec.h"
 #include "quazipfileinfo.h"
+#include "quazip_aes.h"
+#include "quazip_crc32.h"
 
 using namespace std;
 
 #define QUAZIP_VERSION_MADE_BY 0x1Eu
 
+#ifdef HAVE_BZIP2
+/// \cond internal
+/// One chunk of a bzip2 entry, compressed by a pool thread.
+class QuaZipFileBzip2Job: public QRunnable {
+public:
+    QuaZipFileBzip2Job(const QByteArray &data, int level);
+    virtual void run();
+    QByteArray data;
+    int level;
+    // the results, valid once done is acquired
+    QByteArray compressed;
+    bool ok;
+    QSemaphore done;
+};
+
+/// Compresses a bzip2 entry by several threads.
+/**
+  The data is split into chunks small enough to fit into a single bzip2
+  block each, even after bzip2's initial run-length encoding, and each
+  chunk is compressed into a separate stream. As the blocks of a bzip2
+  stream are independent, they are then joined into a single stream,
+  which is what the ZIP readers expect. Blocks are not byte-aligned, so
+  this is done bit by bit, and the CRC of the stream is combined from
+  the ones of the blocks.
+  */
+class QuaZipFileBzip2 {
+public:
+    QuaZipFileBzip2(int level, int threads);
+    ~QuaZipFileBzip2();
+    /// Adds data, returns the compressed bytes ready to be written.
+    bool write(const char *data, qint64 size, QByteArray *out);
+    /// Compresses the rest and returns the end of the stream.
+    bool finish(QByteArray *out);
+    quint32 crc;
+    quint64 size;
+private:
+    Q_DISABLE_COPY(QuaZipFileBzip2)
+    int level;
+    int threads;
+    int chunkSize;
+    QByteArray chunk;
+    QThreadPool pool;
+    QList<QuaZipFileBzip2Job*> jobs;
+    quint32 combinedCrc;
+    quint64 bitBuffer;
+    int bitCount;
+    QByteArray output;
+    void submit();
+    bool collect(int maxPending);
+    bool appendBlock(const QByteArray &compressed);
+    void writeBits(quint32 bits, int count);
+};
+
+QuaZipFileBzip2Job::QuaZipFileBzip2Job(const QByteArray &data, int level):
+    data(data), level(level), ok(false)
+{
+    setAutoDelete(false);
+}
+
+void QuaZipFileBzip2Job::run()
+{
+    // the documented worst case
+    unsigned int size = static_cast<unsigned int>(
+        data.size() + data.size() / 100 + 600);
+    compressed.resize(static_cast<int>(size));
+    ok = BZ2_bzBuffToBuffCompress(compressed.data(), &size, data.data(),
+                                  static_cast<unsigned int>(data.size()),
+                                  level, 0, 0) == BZ_OK;
+    compressed.resize(ok ? static_cast<int>(size) : 0);
+    data = QByteArray();
+    done.release();
+}
+
+QuaZipFileBzip2::QuaZipFileBzip2(int level, int threads):
+    crc(0),
+    size(0),
+    level(level),
+    threads(threads),
+    // bzip2's run-length encoding may grow the data by a quarter
+    chunkSize((100000 * level - 19) / 5 * 4 - 64),
+    combinedCrc(0),
+    bitBuffer(0),
+    bitCount(0)
+{
+    pool.setMaxThreadCount(threads);
+    output = QByteArray("BZh") + static_cast<char>('0' + level);
+}
+
+QuaZipFileBzip2::~QuaZipFileBzip2()
+{
+    pool.waitForDone();
+    qDeleteAll(jobs);
+}
+
+bool QuaZipFileBzip2::write(const char *data, qint64 size, QByteArray *out)
+{
+    crc = quazip_crc32(crc, reinterpret_cast<const Bytef*>(data),
+                       static_cast<size_t>(size));
+    this->size += size;
+    while (size > 0) {
+        int count = static_cast<int>(qMin(static_cast<qint64>(
+                chunkSize - chunk.size()), size));
+        chunk.append(data, count);
+        data += count;
+        size -= count;
+        if (chunk.size() == chunkSize) {
+            submit();
+            // keeps the memory bounded if the writer is faster
+            if (!collect(threads * 2))
+                return false;
+        }
+    }
+    *out = output;
+    output.clear();
+    return true;
+}
+
+bool QuaZipFileBzip2::finish(QByteArray *out)
+{
+    if (!chunk.isEmpty()) {
+        if (jobs.isEmpty()) {
+            // a small entry, not worth another thread
+            QuaZipFileBzip2Job job(chunk, level);
+            chunk.clear();
+            job.run();
+            if (!job.ok || !appendBlock(job.compressed))
+                return false;
+        } else {
+            submit();
+        }
+    }
+    if (!collect(0))
+        return false;
+    writeBits(0x177245, 24); // the end of stream magic, sqrt(pi)
+    writeBits(0x385090, 24);
+    writeBits(combinedCrc, 32);
+    if (bitCount > 0)
+        writeBits(0, 8 - bitCount);
+    *out = output;
+    output.clear();
+    return true;
+}
+
+void QuaZipFileBzip2::submit()
+{
+    QuaZipFileBzip2Job *job = new QuaZipFileBzip2Job(chunk, level);
+    chunk.clear();
+    jobs.append(job);
+    pool.start(job);
+}
+
+bool QuaZipFileBzip2::collect(int maxPending)
+{
+    while (jobs.size() > maxPending
+           || (!jobs.isEmpty() && jobs.first()->done.available() > 0)) {
+        QuaZipFileBzip2Job *job = jobs.takeFirst();
+        job->done.acquire();
+        bool ok = job->ok && appendBlock(job->compressed);
+        delete job;
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+static quint32 quazip_bzip2_bits(const QByteArray &data, quint64 pos,
+                                 int count)
+{
+    quint32 bits = 0;
+    for (int i = 0; i < count; ++i, ++pos) {
+        bits = (bits << 1) | ((static_cast<uchar>(data.at(
+                static_cast<int>(pos >> 3))) >> (7 - (pos & 7))) & 1);
+    }
+    return bits;
+}
+
+bool QuaZipFileBzip2::appendBlock(const QByteArray &compressed)
+{
+    // "BZh?", then the block: 48 bits of magic and 32 bits of CRC, ...
+    const quint64 blockStart = 32;
+    const quint64 total = static_cast<quint64>(compressed.size()) * 8;
+    if (total < blockStart + 80 + 80)
+        return false;
+    quint32 blockCrc = quazip_bzip2_bits(compressed, blockStart + 48, 32);
+    // ... and the end of stream: 48 bits of magic, the combined CRC,
+    // which is the block CRC for a single block, and up to 7 bits of
+    // padding
+    quint64 end = 0;
+    for (int padding = 0; padding < 8 && end == 0; ++padding) {
+        quint64 pos = total - padding - 80;
+        if (quazip_bzip2_bits(compressed, pos, 24) == 0x177245
+                && quazip_bzip2_bits(compressed, pos + 24, 24) == 0x385090
+                && quazip_bzip2_bits(compressed, pos + 48, 32) == blockCrc)
+            end = pos;
+    }
+    if (end == 0)
+        return false;
+    const uchar *bytes = reinterpret_cast<const uchar*>(compressed.constData());
+    int fullBytes = static_cast<int>(end / 8);
+    for (int i = static_cast<int>(blockStart / 8); i < fullBytes; ++i)
+        writeBits(bytes[i], 8);
+    int rest = static_cast<int>(end % 8);
+    if (rest > 0)
+        writeBits(bytes[fullBytes] >> (8 - rest), rest);
+    combinedCrc = ((combinedCrc << 1) | (combinedCrc >> 31)) ^ blockCrc;
+    return true;
+}
+
+void QuaZipFileBzip2::writeBits(quint32 bits, int count)
+{
+    bitBuffer = (bitBuffer << count) | bits;
+    bitCount += count;
+    while (bitCount >= 8) {
+        bitCount -= 8;
+        output.append(static_cast<char>((bitBuffer >> bitCount) & 0xFF));
+    }
+}
+/// \endcond
+#else
+class QuaZipFileBzip2;
+#endif // HAVE_BZIP2
+
 /// The implementation class for QuaZip.
 /**
 \internal
@@ -70,6 +300,10 @@ class QuaZipFilePrivate {
     bool internal;
     /// The last error.
     int zipError;
+    /// The parallel bzip2 compressor, if used for the current entry.
+    QuaZipFileBzip2 *bzip2;
+    /// The encryption of the files written with a password.
+    QuaZipFile::Encryption encryption;
     /// Resets \ref zipError.
     inline void resetZipError() const {setZipError(UNZ_OK);}
     /// Sets the zip error.
@@ -89,7 +323,9 @@ class QuaZipFilePrivate {
       uncompressedSize(0),
       crc(0),
       internal(true),
-      zipError(UNZ_OK) {}
+      zipError(UNZ_OK),
+      bzip2(nullptr),
+      encryption(QuaZipFile::etTraditional) {}
     /// The constructor for the corresponding QuaZipFile constructor.
     inline QuaZipFilePrivate(QuaZipFile *q, const QString &zipName):
       q(q),
@@ -99,7 +335,9 @@ class QuaZipFilePrivate {
       uncompressedSize(0),
       crc(0),
       internal(true),
-      zipError(UNZ_OK)
+      zipError(UNZ_OK),
+      bzip2(nullptr),
+      encryption(QuaZipFile::etTraditional)
       {
         zip=new QuaZip(zipName);
       }
@@ -112,7 +350,9 @@ class QuaZipFilePrivate {
       uncompressedSize(0),
       crc(0),
       internal(true),
-      zipError(UNZ_OK)
+      zipError(UNZ_OK),
+      bzip2(nullptr),
+      encryption(QuaZipFile::etTraditional)
       {
         zip=new QuaZip(zipName);
         this->fileName=fileName;
@@ -129,13 +369,20 @@ class QuaZipFilePrivate {
       uncompressedSize(0),
       crc(0),
       internal(false),
-      zipError(UNZ_OK) {}
+      zipError(UNZ_OK),
+      bzip2(nullptr),
+      encryption(QuaZipFile::etTraditional) {}
     /// The destructor.
     inline ~QuaZipFilePrivate()
     {
+#ifdef HAVE_BZIP2
+      delete bzip2;
+#endif
       if (internal)
         delete zip;
     }
+    /// Finishes the entry written by \ref bzip2.
+    void closeBzip2();
 };
 
 QuaZipFile::QuaZipFile():
@@ -251,6 +498,23 @@ void QuaZipFilePrivate::setZipError(int zipError) const
     q->setErrorString(QuaZipFile::tr("ZIP/UNZIP API error %1").arg(zipError));
 }
 
+void QuaZipFilePrivate::closeBzip2()
+{
+#ifdef HAVE_BZIP2
+  QByteArray tail;
+  if(bzip2->finish(&tail))
+    setZipError(zipWriteInFileInZip(zip->getZipFile(), tail.constData(), (uint)tail.size()));
+  else
+    setZipError(ZIP_INTERNALERROR);
+  // the entry is closed anyway, so it doesn't stay half-written
+  int closeError=zipCloseFileInZipRaw64(zip->getZipFile(), bzip2->size, bzip2->crc);
+  if(zipError==ZIP_OK)
+    setZipError(closeError);
+  delete bzip2;
+  bzip2=nullptr;
+#endif
+}
+
 bool QuaZipFile::open(OpenMode mode)
 {
   return open(mode, nullptr);
@@ -343,6 +607,25 @@ bool QuaZipFile::open(OpenMode mode, const QuaZipNewInfo& info,
         zipSetFlags(p->zip->getZipFile(), ZIP_WRITE_DATA_DESCRIPTOR);
     else
         zipClearFlags(p->zip->getZipFile(), ZIP_WRITE_DATA_DESCRIPTOR);
+    zipSetThreadCount(p->zip->getZipFile(), p->zip->getThreadCount());
+    bool parallel = false;
+#ifdef HAVE_BZIP2
+    // compressed here by several threads and written raw
+    if (method == Z_BZIP2ED && !raw && p->zip->getThreadCount() > 1) {
+      if (level > 9) {
+        p->setZipError(ZIP_PARAMERROR);
+        return false;
+      }
+      if (level < 1)
+        level = 9;
+      parallel = true;
+    }
+#endif
+    if (password != nullptr && p->encryption != etTraditional) {
+      // AES-128, AES-192 and AES-256 are the strengths 1, 2 and 3
+      zipSetAesEncryption(p->zip->getZipFile(),
+                          static_cast<int>(p->encryption), QUAZIP_AES_AE1);
+    }
     p->setZipError(zipOpenNewFileInZip4_64(p->zip->getZipFile(),
           p->zip->isUtf8Enabled()
             ? info.name.toUtf8().constData()
@@ -353,7 +636,7 @@ bool QuaZipFile::open(OpenMode mode, const QuaZipNewInfo& info,
           p->zip->isUtf8Enabled()
             ? info.comment.toUtf8().constData()
             : p->zip->getCommentCodec()->fromUnicode(info.comment).constData(),
-          method, level, (int)raw,
+          method, level, (int)(raw || parallel),
           windowBits, memLevel, strategy,
           password, (uLong)crc,
           (p->zip->getOsCode() << 8) | QUAZIP_VERSION_MADE_BY,
@@ -367,6 +650,10 @@ bool QuaZipFile::open(OpenMode mode, const QuaZipNewInfo& info,
         p->crc=crc;
         p->uncompressedSize=info.uncompressedSize;
       }
+#ifdef HAVE_BZIP2
+      if(parallel)
+        p->bzip2=new QuaZipFileBzip2(level, p->zip->getThreadCount());
+#endif
       return true;
     } else
       return false;
@@ -480,10 +767,11 @@ void QuaZipFile::close()
   }
   if(openMode()&ReadOnly)
     p->setZipError(unzCloseCurrentFile(p->zip->getUnzFile()));
-  else if(openMode()&WriteOnly)
+  else if(openMode()&WriteOnly) {
     if(isRaw()) p->setZipError(zipCloseFileInZipRaw64(p->zip->getZipFile(), p->uncompressedSize, p->crc));
+    else if(p->bzip2!=nullptr) p->closeBzip2();
     else p->setZipError(zipCloseFileInZip(p->zip->getZipFile()));
-  else {
+  } else {
     qWarning("Wrong open mode: %d", (int)openMode());
     return;
   }
@@ -509,6 +797,16 @@ qint64 QuaZipFile::readData(char *data, qint64 maxSize)
 qint64 QuaZipFile::writeData(const char* data, qint64 maxSize)
 {
   p->setZipError(ZIP_OK);
+#ifdef HAVE_BZIP2
+  if(p->bzip2!=nullptr) {
+    QByteArray compressed;
+    if(!p->bzip2->write(data, maxSize, &compressed))
+      p->setZipError(ZIP_INTERNALERROR);
+    else if(!compressed.isEmpty())
+      p->setZipError(zipWriteInFileInZip(p->zip->getZipFile(), compressed.constData(),
+                                         (uint)compressed.size()));
+  } else
+#endif
   p->setZipError(zipWriteInFileInZip(p->zip->getZipFile(), data, (uint)maxSize));
   if(p->zipError!=ZIP_OK) return -1;
   else {
@@ -532,6 +830,16 @@ bool QuaZipFile::isRaw() const
   return p->raw;
 }
 
+void QuaZipFile::setEncryption(Encryption encryption)
+{
+  p->encryption = encryption;
+}
+
+QuaZipFile::Encryption QuaZipFile::getEncryption() const
+{
+  return p->encryption;
+}
+
 int QuaZipFile::getZipError() const
 {
   return p->zipError;
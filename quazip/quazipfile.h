@@ -85,6 +85,16 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
     /// Implementation of the QIODevice::writeData().
     qint64 writeData(const char *data, qint64 maxSize);
   public:
+    /// The encryption of the files written with a password.
+    /** \sa setEncryption()
+     **/
+    enum Encryption {
+      /// The traditional PKWARE encryption: weak, but read by any tool.
+      etTraditional,
+      etAes128, ///< WinZip AES with a 128-bit key.
+      etAes192, ///< WinZip AES with a 192-bit key.
+      etAes256 ///< WinZip AES with a 256-bit key.
+    };
     /// Constructs a QuaZipFile instance.
     /** You should use setZipName() and setFileName() or setZip() before
      * trying to call open() on the constructed object.
@@ -258,6 +268,23 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
      * \sa open(OpenMode,int*,int*,bool,const char*)
      **/
     bool isRaw() const;
+    /// Sets the encryption of the files written with a password.
+    /** Applies to the next open() for writing. The default is
+     * etTraditional, the traditional PKWARE encryption, which is easy
+     * to break.
+     *
+     * The AES encryptions make WinZip AES entries (AE-1), which store
+     * method 99 in their headers and the actual method in an extra
+     * field. The keys are derived from the password with PBKDF2, and
+     * the data is authenticated with HMAC-SHA1. The AES rounds use the
+     * AES-NI instructions on the CPUs that have them.
+     *
+     * Such entries are read like any other, by passing the password to
+     * open(), which recognizes the encryption by itself.
+     **/
+    void setEncryption(Encryption encryption);
+    /// Returns the encryption set by setEncryption().
+    Encryption getEncryption() const;
     /// Binds to the existing QuaZip instance.
     /** This function destroys internal QuaZip object, if any, and makes
      * this QuaZipFile to use current file in the \a zip object for any
@@ -306,6 +333,19 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
      *
      * If raw is \c true then no decompression is performed.
      *
+     * Besides the methods that can be written (see the other open()),
+     * Z_DEFLATE64 (9) entries, made by Windows for large files, for
+     * example, can be decompressed.
+     *
+     * WinZip AES entries (AE-1 and AE-2) are decrypted with the given
+     * password, and \a method receives their actual method. If the
+     * password is wrong, the open fails with \c UNZ_BADPASSWORD. If the
+     * data turns out to be altered, close() sets \c UNZ_CRCERROR, as
+     * it does for the CRC errors. Without a password, such entries can
+     * only be opened in the raw mode, to be copied as they are: \a
+     * method is then 99, and the extra fields of the entry must be
+     * copied along with it.
+     *
      * \a method should not be \c NULL. \a level can be \c NULL if you
      * don't want to know the compression level.
      **/
@@ -323,7 +363,18 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
      * use the raw mode (see below).
      *
      * Arguments \a method and \a level specify compression method and
-     * level. The only method supported is Z_DEFLATED, but you may also
+     * level. The methods supported are Z_DEFLATED and, depending on the
+     * libraries QuaZip is built with (see QuaZipCodec::isMethodSupported()):
+     * - Z_BZIP2ED (12), whose levels from 1 to 9 set the block size,
+     *   \c Z_DEFAULT_COMPRESSION and 0 meaning 9. Large entries can be
+     *   compressed by several threads, see QuaZip::setThreadCount();
+     * - Z_ZSTD (93), whose levels go from 1 to 22, \c Z_DEFAULT_COMPRESSION
+     *   and 0 meaning zstd's default level;
+     * - Z_LZMA (14) and Z_XZ (95), whose levels are LZMA presets from 0 to 9,
+     *   \c Z_DEFAULT_COMPRESSION meaning 6. Only XZ can be compressed by
+     *   several threads, see QuaZip::setThreadCount().
+     *
+     * You may also
      * specify 0 for no compression. If all of the files in the archive
      * use both method 0 and either level 0 is explicitly specified or
      * data descriptor writing is disabled with
@@ -334,6 +385,8 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
      *
      * If \a raw is \c true, no compression is performed. In this case,
      * \a crc and uncompressedSize field of the \a info are required.
+     * Raw data compressed with any of the methods above can be written
+     * even if QuaZip is built without the corresponding library.
      *
      * Arguments \a windowBits, \a memLevel, \a strategy provide zlib
      * algorithms tuning. See deflateInit2() in zlib.
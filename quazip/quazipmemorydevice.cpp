@@ -0,0 +1,241 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <string.h>
+
+#include "quazipmemorydevice.h"
+
+#define QUAZIP_MEMORY_MIN_CHUNK (64 * 1024)
+#define QUAZIP_MEMORY_MAX_CHUNK (64 * 1024 * 1024)
+
+/// \cond internal
+class QuaZipMemoryDevicePrivate {
+    friend class QuaZipMemoryDevice;
+private:
+    inline QuaZipMemoryDevicePrivate(): size(0) {}
+    // The whole of each chunk is usable, only the last one may be
+    // filled partially.
+    QList<QByteArray> chunks;
+    // Where each chunk starts.
+    QList<qint64> offsets;
+    qint64 size;
+    qint64 capacity() const;
+    int chunkAt(qint64 pos) const;
+    void grow(qint64 needed);
+    void trim();
+    void clear();
+    void copyFrom(qint64 pos, char *data, qint64 len) const;
+    void copyTo(qint64 pos, const char *data, qint64 len);
+};
+
+qint64 QuaZipMemoryDevicePrivate::capacity() const
+{
+    return chunks.isEmpty() ? 0 : offsets.last() + chunks.last().size();
+}
+
+int QuaZipMemoryDevicePrivate::chunkAt(qint64 pos) const
+{
+    return static_cast<int>(std::upper_bound(offsets.constBegin(),
+                                             offsets.constEnd(), pos)
+                            - offsets.constBegin()) - 1;
+}
+
+void QuaZipMemoryDevicePrivate::grow(qint64 needed)
+{
+    qint64 cap = capacity();
+    while (cap < needed) {
+        // doubling keeps the number of chunks logarithmic
+        qint64 chunkSize = qMax(qBound(static_cast<qint64>(QUAZIP_MEMORY_MIN_CHUNK),
+                                       cap,
+                                       static_cast<qint64>(QUAZIP_MEMORY_MAX_CHUNK)),
+                                needed - cap);
+        chunkSize = qMin(chunkSize, static_cast<qint64>(INT_MAX - 64));
+        QByteArray chunk;
+        chunk.resize(static_cast<int>(chunkSize));
+        offsets.append(cap);
+        chunks.append(chunk);
+        cap += chunkSize;
+    }
+}
+
+void QuaZipMemoryDevicePrivate::trim()
+{
+    while (!chunks.isEmpty() && offsets.last() >= size && size != 0) {
+        chunks.removeLast();
+        offsets.removeLast();
+    }
+    if (size == 0) {
+        clear();
+    } else if (capacity() > size) {
+        // shrinking keeps the allocation, so nothing is copied
+        chunks.last().resize(static_cast<int>(size - offsets.last()));
+    }
+}
+
+void QuaZipMemoryDevicePrivate::clear()
+{
+    chunks.clear();
+    offsets.clear();
+    size = 0;
+}
+
+void QuaZipMemoryDevicePrivate::copyFrom(qint64 pos, char *data,
+                                         qint64 len) const
+{
+    for (int i = chunkAt(pos); len > 0; ++i) {
+        const QByteArray &chunk = chunks.at(i);
+        qint64 offset = pos - offsets.at(i);
+        qint64 count = qMin(len, chunk.size() - offset);
+        memcpy(data, chunk.constData() + offset, static_cast<size_t>(count));
+        data += count;
+        pos += count;
+        len -= count;
+    }
+}
+
+void QuaZipMemoryDevicePrivate::copyTo(qint64 pos, const char *data,
+                                       qint64 len)
+{
+    for (int i = chunkAt(pos); len > 0; ++i) {
+        QByteArray &chunk = chunks[i];
+        qint64 offset = pos - offsets.at(i);
+        qint64 count = qMin(len, chunk.size() - offset);
+        if (data != nullptr)
+            memcpy(chunk.data() + offset, data, static_cast<size_t>(count));
+        else
+            memset(chunk.data() + offset, 0, static_cast<size_t>(count));
+        if (data != nullptr)
+            data += count;
+        pos += count;
+        len -= count;
+    }
+}
+/// \endcond
+
+QuaZipMemoryDevice::QuaZipMemoryDevice(QObject *parent):
+    QIODevice(parent),
+    d(new QuaZipMemoryDevicePrivate())
+{
+}
+
+QuaZipMemoryDevice::QuaZipMemoryDevice(const QByteArray &data,
+                                       QObject *parent):
+    QIODevice(parent),
+    d(new QuaZipMemoryDevicePrivate())
+{
+    setData(data);
+}
+
+QuaZipMemoryDevice::~QuaZipMemoryDevice()
+{
+    if (isOpen())
+        close();
+    delete d;
+}
+
+void QuaZipMemoryDevice::setData(const QByteArray &data)
+{
+    if (isOpen()) {
+        qWarning("QuaZipMemoryDevice::setData(): device is open");
+        return;
+    }
+    d->clear();
+    if (!data.isEmpty()) {
+        d->chunks.append(data);
+        d->offsets.append(0);
+        d->size = data.size();
+    }
+}
+
+QByteArray QuaZipMemoryDevice::data() const
+{
+    d->trim();
+    if (d->chunks.isEmpty())
+        return QByteArray();
+    if (d->chunks.size() == 1)
+        return d->chunks.first();
+    QByteArray joined;
+    joined.resize(static_cast<int>(d->size));
+    d->copyFrom(0, joined.data(), d->size);
+    d->chunks.clear();
+    d->offsets.clear();
+    d->chunks.append(joined);
+    d->offsets.append(0);
+    return joined;
+}
+
+QList<QByteArray> QuaZipMemoryDevice::chunks() const
+{
+    d->trim();
+    return d->chunks;
+}
+
+void QuaZipMemoryDevice::reserve(qint64 size)
+{
+    d->grow(size);
+}
+
+bool QuaZipMemoryDevice::open(QIODevice::OpenMode mode)
+{
+    if ((mode & QIODevice::Truncate) != 0
+            || ((mode & QIODevice::WriteOnly) != 0
+                && (mode & (QIODevice::ReadOnly | QIODevice::Append)) == 0)) {
+        // the chunks are kept to be overwritten, including reserved ones
+        d->size = 0;
+    }
+    if (!QIODevice::open(mode | QIODevice::Unbuffered))
+        return false;
+    if ((mode & QIODevice::Append) != 0)
+        seek(d->size);
+    return true;
+}
+
+qint64 QuaZipMemoryDevice::size() const
+{
+    return d->size;
+}
+
+qint64 QuaZipMemoryDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 count = qMin(maxSize, d->size - pos());
+    if (count <= 0)
+        return 0;
+    d->copyFrom(pos(), data, count);
+    return count;
+}
+
+qint64 QuaZipMemoryDevice::writeData(const char *data, qint64 maxSize)
+{
+    qint64 start = pos();
+    d->grow(start + maxSize);
+    if (start > d->size) {
+        // fill the gap left by seeking past the end
+        d->copyTo(d->size, nullptr, start - d->size);
+    }
+    d->copyTo(start, data, maxSize);
+    d->size = qMax(d->size, start + maxSize);
+    return maxSize;
+}
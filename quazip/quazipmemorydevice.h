@@ -0,0 +1,118 @@
+#ifndef QUAZIP_QUAZIPMEMORYDEVICE_H
+#define QUAZIP_QUAZIPMEMORYDEVICE_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+#include <QtCore/QList>
+
+#include "quazip_global.h"
+
+class QuaZipMemoryDevicePrivate;
+
+/// An in-memory device for building and reading archives.
+/** \class QuaZipMemoryDevice quazipmemorydevice.h <quazip/quazipmemorydevice.h>
+ * This device is a replacement for QBuffer tuned for the way QuaZip
+ * accesses the archive:
+ * - When writing, the data is stored in a list of chunks growing
+ *   geometrically, so the data written so far is never reallocated or
+ *   copied. When the archive is complete, data() joins the chunks into
+ *   a single array, copying the data exactly once, or chunks() returns
+ *   them as they are. If the final size is known approximately, reserve()
+ *   makes the device use a single chunk from the start, and data()
+ *   returns it without copying anything.
+ * - When reading, the device reads directly from the QByteArray passed to
+ *   the constructor or setData(), which is neither copied nor detached.
+ * - The device is always open in the QIODevice::Unbuffered mode, so the
+ *   data isn't copied through QIODevice's internal buffer.
+ *
+ * Usage:
+ * \code
+ * QuaZipMemoryDevice output;
+ * QuaZip zip(&output);
+ * zip.open(QuaZip::mdCreate);
+ * zip.addEntry(QuaZipNewInfo("report.txt"), report);
+ * zip.close();
+ * reply->write(output.data());
+ *
+ * QuaZipMemoryDevice input(request->readAll());
+ * QuaZip received(&input);
+ * received.open(QuaZip::mdUnzip);
+ * \endcode
+ */
+class QUAZIP_EXPORT QuaZipMemoryDevice: public QIODevice {
+  friend class QuaZipMemoryDevicePrivate;
+  Q_OBJECT
+public:
+  /// Constructs an empty device.
+  explicit QuaZipMemoryDevice(QObject *parent = nullptr);
+  /// Constructs a device containing \a data.
+  /** The data is shared, not copied. It is only copied if the device is
+   * written to.
+   */
+  explicit QuaZipMemoryDevice(const QByteArray &data,
+                              QObject *parent = nullptr);
+  /// Destructor.
+  ~QuaZipMemoryDevice();
+  /// Replaces the contents of the device.
+  /** Can only be called when the device is closed. The data is shared,
+   * not copied.
+   */
+  void setData(const QByteArray &data);
+  /// Returns the contents of the device as a single array.
+  /** If the data is stored in more than one chunk, the chunks are joined
+   * once and the result is kept, so calling this function again is
+   * cheap.
+   */
+  QByteArray data() const;
+  /// Returns the contents of the device as a list of chunks.
+  /** Nothing is copied. The chunks, concatenated, make up data().
+   */
+  QList<QByteArray> chunks() const;
+  /// Makes room for at least \a size bytes.
+  /** If the device is empty, this makes it store up to \a size bytes in
+   * a single chunk, so data() doesn't need to join anything.
+   */
+  void reserve(qint64 size);
+  /// Opens the device.
+  /** QIODevice::Unbuffered is always added to \a mode. Like QFile, the
+   * device is truncated when opened with QIODevice::Truncate or
+   * QIODevice::WriteOnly without QIODevice::ReadOnly and
+   * QIODevice::Append.
+   */
+  virtual bool open(QIODevice::OpenMode mode);
+  /// Returns the size of the contents.
+  virtual qint64 size() const;
+protected:
+  /// Implementation of QIODevice::readData().
+  virtual qint64 readData(char *data, qint64 maxSize);
+  /// Implementation of QIODevice::writeData().
+  virtual qint64 writeData(const char *data, qint64 maxSize);
+private:
+  QuaZipMemoryDevicePrivate *d;
+};
+
+#endif // QUAZIP_QUAZIPMEMORYDEVICE_H
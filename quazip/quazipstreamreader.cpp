@@ -0,0 +1,738 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QtEndian>
+
+#include <string.h>
+
+#include "quazipstreamreader.h"
+#include "unzip.h"
+
+#include "quazip_zlib.h"
+#include "quazip_crc32.h"
+
+#define QUAZIP_STREAM_BUFSIZE 65536
+
+#define QUAZIP_LOCAL_HEADER_MAGIC 0x04034b50u
+#define QUAZIP_DATA_DESCRIPTOR_MAGIC 0x08074b50u
+#define QUAZIP_CENTRAL_HEADER_MAGIC 0x02014b50u
+#define QUAZIP_DIGITAL_SIGNATURE_MAGIC 0x05054b50u
+#define QUAZIP_END_OF_CENTRAL_DIR_MAGIC 0x06054b50u
+#define QUAZIP_ZIP64_END_OF_CENTRAL_DIR_MAGIC 0x06064b50u
+#define QUAZIP_SPANNING_MARKER_MAGIC 0x30304b50u
+
+/// \cond internal
+class QuaZipStreamReaderPrivate;
+
+/// The device returned by QuaZipStreamReader::currentEntry().
+class QuaZipStreamEntryDevice: public QIODevice {
+public:
+    inline QuaZipStreamEntryDevice(QuaZipStreamReaderPrivate *p): p(p) {}
+    virtual bool isSequential() const {return true;}
+    virtual bool atEnd() const;
+    virtual qint64 bytesAvailable() const;
+    using QIODevice::setErrorString;
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize);
+    virtual qint64 writeData(const char *, qint64) {return -1;}
+private:
+    QuaZipStreamReaderPrivate *p;
+};
+
+class QuaZipStreamReaderPrivate {
+    friend class QuaZipStreamReader;
+    friend class QuaZipStreamEntryDevice;
+    Q_DECLARE_TR_FUNCTIONS(QuaZipStreamReader)
+    Q_DISABLE_COPY(QuaZipStreamReaderPrivate)
+private:
+    QuaZipStreamReaderPrivate(QIODevice *io);
+    ~QuaZipStreamReaderPrivate();
+    QIODevice *io;
+    QTextCodec *fileNameCodec;
+    int readTimeout;
+    char *inBuf;
+    int inBufPos;
+    int inBufSize;
+    z_stream zins;
+    bool zinsInitialized;
+    QuaZipStreamEntryDevice *entry;
+    QuaZipFileInfo64 info;
+    bool hasEntry;
+    bool entryDone;
+    bool zip64Entry;
+    bool descriptorRead;
+    bool atEnd;
+    quint32 crc;
+    quint64 compressedRead;
+    quint64 uncompressedRead;
+    int zipError;
+    QString errorString;
+    void reset();
+    void setError(int error, const QString &description);
+    bool fill(int need);
+    bool unexpectedEnd();
+    bool readBytes(char *dest, qint64 size);
+    bool skipBytes(qint64 size);
+    bool readLocalHeader();
+    bool skipEntry();
+    bool readDataDescriptor();
+    bool finishEntry();
+    qint64 readEntry(char *data, qint64 maxSize);
+    qint64 readDeflated(char *data, qint64 maxSize);
+    qint64 readStored(char *data, qint64 maxSize);
+    qint64 readStoredWithDescriptor(char *data, qint64 maxSize);
+    bool isStoredDataDescriptor();
+    inline bool hasDataDescriptor() const {return (info.flags & 8) != 0;}
+    inline bool isEncrypted() const {return (info.flags & 1) != 0;}
+    inline bool hasKnownSize() const
+    {
+        // With the data descriptor, the sizes in the local header are
+        // zero unless the writer was able to seek back and patch them.
+        return !hasDataDescriptor() || info.compressedSize != 0;
+    }
+    inline void consume(char *data, int size)
+    {
+        memcpy(data, inBuf + inBufPos, size);
+        crc = quazip_crc32(crc, reinterpret_cast<const Bytef*>(data), size);
+        inBufPos += size;
+        compressedRead += size;
+        uncompressedRead += size;
+    }
+};
+
+static inline quint16 quazip_le16(const char *data)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(data));
+}
+
+static inline quint32 quazip_le32(const char *data)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data));
+}
+
+static inline quint64 quazip_le64(const char *data)
+{
+    return qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(data));
+}
+
+static QDateTime quazip_dos_date_time(quint16 dosTime, quint16 dosDate)
+{
+    return QDateTime(
+        QDate(((dosDate >> 9) & 0x7F) + 1980, (dosDate >> 5) & 0x0F,
+              dosDate & 0x1F),
+        QTime(dosTime >> 11, (dosTime >> 5) & 0x3F, (dosTime & 0x1F) * 2));
+}
+
+QuaZipStreamReaderPrivate::QuaZipStreamReaderPrivate(QIODevice *io):
+    io(io),
+    fileNameCodec(QTextCodec::codecForLocale()),
+    readTimeout(30000),
+    inBuf(new char[QUAZIP_STREAM_BUFSIZE]),
+    inBufPos(0),
+    inBufSize(0),
+    zinsInitialized(false),
+    entry(nullptr),
+    hasEntry(false),
+    entryDone(false),
+    zip64Entry(false),
+    descriptorRead(false),
+    atEnd(false),
+    crc(0),
+    compressedRead(0),
+    uncompressedRead(0),
+    zipError(UNZ_OK)
+{
+    zins.zalloc = (alloc_func) nullptr;
+    zins.zfree = (free_func) nullptr;
+    zins.opaque = nullptr;
+}
+
+QuaZipStreamReaderPrivate::~QuaZipStreamReaderPrivate()
+{
+    delete entry;
+    if (zinsInitialized)
+        inflateEnd(&zins);
+    delete[] inBuf;
+}
+
+void QuaZipStreamReaderPrivate::reset()
+{
+    if (entry != nullptr && entry->isOpen())
+        entry->close();
+    inBufPos = inBufSize = 0;
+    info = QuaZipFileInfo64();
+    hasEntry = false;
+    entryDone = false;
+    zip64Entry = false;
+    atEnd = false;
+    zipError = UNZ_OK;
+    errorString.clear();
+}
+
+void QuaZipStreamReaderPrivate::setError(int error, const QString &description)
+{
+    zipError = error;
+    errorString = description;
+    if (entry != nullptr && entry->isOpen())
+        entry->setErrorString(description);
+}
+
+bool QuaZipStreamReaderPrivate::fill(int need)
+{
+    if (inBufSize - inBufPos >= need)
+        return true;
+    if (inBufPos != 0) {
+        memmove(inBuf, inBuf + inBufPos, inBufSize - inBufPos);
+        inBufSize -= inBufPos;
+        inBufPos = 0;
+    }
+    while (inBufSize < need) {
+        qint64 got = io->read(inBuf + inBufSize,
+                              QUAZIP_STREAM_BUFSIZE - inBufSize);
+        if (got < 0) {
+            setError(UNZ_ERRNO, io->errorString());
+            return false;
+        }
+        if (got == 0) {
+            // Nothing buffered right now. For a socket or a process
+            // that doesn't mean the end of the stream yet.
+            if (!io->waitForReadyRead(readTimeout))
+                return false;
+            continue;
+        }
+        inBufSize += static_cast<int>(got);
+    }
+    return true;
+}
+
+bool QuaZipStreamReaderPrivate::unexpectedEnd()
+{
+    if (zipError == UNZ_OK)
+        setError(UNZ_BADZIPFILE, tr("Unexpected end of the ZIP stream"));
+    return false;
+}
+
+bool QuaZipStreamReaderPrivate::readBytes(char *dest, qint64 size)
+{
+    while (size > 0) {
+        if (!fill(1))
+            return unexpectedEnd();
+        int chunk = static_cast<int>(qMin<qint64>(size, inBufSize - inBufPos));
+        memcpy(dest, inBuf + inBufPos, chunk);
+        inBufPos += chunk;
+        dest += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool QuaZipStreamReaderPrivate::skipBytes(qint64 size)
+{
+    while (size > 0) {
+        if (!fill(1))
+            return unexpectedEnd();
+        int chunk = static_cast<int>(qMin<qint64>(size, inBufSize - inBufPos));
+        inBufPos += chunk;
+        compressedRead += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool QuaZipStreamReaderPrivate::readLocalHeader()
+{
+    quint32 magic;
+    for (;;) {
+        if (!fill(4))
+            return unexpectedEnd();
+        magic = quazip_le32(inBuf + inBufPos);
+        // Split archives written as a single segment start with
+        // one of these markers. Nothing to do with them.
+        if (magic == QUAZIP_SPANNING_MARKER_MAGIC
+                || magic == QUAZIP_DATA_DESCRIPTOR_MAGIC) {
+            inBufPos += 4;
+            continue;
+        }
+        break;
+    }
+    if (magic == QUAZIP_CENTRAL_HEADER_MAGIC
+            || magic == QUAZIP_END_OF_CENTRAL_DIR_MAGIC
+            || magic == QUAZIP_ZIP64_END_OF_CENTRAL_DIR_MAGIC
+            || magic == QUAZIP_DIGITAL_SIGNATURE_MAGIC) {
+        atEnd = true;
+        return false;
+    }
+    if (magic != QUAZIP_LOCAL_HEADER_MAGIC) {
+        setError(UNZ_BADZIPFILE, tr("Invalid local file header signature"));
+        return false;
+    }
+    char header[30];
+    if (!readBytes(header, sizeof(header)))
+        return false;
+    info = QuaZipFileInfo64();
+    info.versionCreated = 0;
+    info.versionNeeded = quazip_le16(header + 4);
+    info.flags = quazip_le16(header + 6);
+    info.method = quazip_le16(header + 8);
+    info.dateTime = quazip_dos_date_time(quazip_le16(header + 10),
+                                         quazip_le16(header + 12));
+    info.crc = quazip_le32(header + 14);
+    info.compressedSize = quazip_le32(header + 18);
+    info.uncompressedSize = quazip_le32(header + 22);
+    info.diskNumberStart = 0;
+    info.internalAttr = 0;
+    info.externalAttr = 0;
+    quint16 nameLength = quazip_le16(header + 26);
+    quint16 extraLength = quazip_le16(header + 28);
+    QByteArray name(nameLength, '\0');
+    if (!readBytes(name.data(), nameLength))
+        return false;
+    info.name = (info.flags & UNZ_ENCODING_UTF8) ? QString::fromUtf8(name)
+        : fileNameCodec->toUnicode(name);
+    info.extra.resize(extraLength);
+    if (!readBytes(info.extra.data(), extraLength))
+        return false;
+    zip64Entry = false;
+    const char *extra = info.extra.constData();
+    for (int i = 0; i + 4 <= extraLength; ) {
+        quint16 id = quazip_le16(extra + i);
+        quint16 size = quazip_le16(extra + i + 2);
+        i += 4;
+        if (i + size > extraLength)
+            break;
+        if (id == 0x0001) {
+            zip64Entry = true;
+            int pos = i;
+            if (info.uncompressedSize == 0xFFFFFFFFu && pos + 8 <= i + size) {
+                info.uncompressedSize = quazip_le64(extra + pos);
+                pos += 8;
+            }
+            if (info.compressedSize == 0xFFFFFFFFu && pos + 8 <= i + size) {
+                info.compressedSize = quazip_le64(extra + pos);
+            }
+        }
+        i += size;
+    }
+    descriptorRead = false;
+    crc = 0;
+    compressedRead = 0;
+    uncompressedRead = 0;
+    return true;
+}
+
+bool QuaZipStreamReaderPrivate::isStoredDataDescriptor()
+{
+    // Data that happens to contain a signature won't have the right
+    // CRC and sizes right after it, so this is reliable enough.
+    if (!fill(16))
+        return false;
+    const char *dd = inBuf + inBufPos;
+    if (quazip_le32(dd) != QUAZIP_DATA_DESCRIPTOR_MAGIC
+            || quazip_le32(dd + 4) != crc)
+        return false;
+    if (quazip_le32(dd + 8) == uncompressedRead
+            && quazip_le32(dd + 12) == uncompressedRead) {
+        info.crc = crc;
+        info.compressedSize = info.uncompressedSize = uncompressedRead;
+        inBufPos += 16;
+        descriptorRead = true;
+        return true;
+    }
+    if (!fill(24))
+        return false;
+    dd = inBuf + inBufPos;
+    if (quazip_le64(dd + 8) == uncompressedRead
+            && quazip_le64(dd + 16) == uncompressedRead) {
+        info.crc = crc;
+        info.compressedSize = info.uncompressedSize = uncompressedRead;
+        inBufPos += 24;
+        descriptorRead = true;
+        return true;
+    }
+    return false;
+}
+
+bool QuaZipStreamReaderPrivate::readDataDescriptor()
+{
+    if (!fill(4))
+        return unexpectedEnd();
+    // The signature is optional, but everybody writes it.
+    if (quazip_le32(inBuf + inBufPos) == QUAZIP_DATA_DESCRIPTOR_MAGIC)
+        inBufPos += 4;
+    if (!fill(12))
+        return unexpectedEnd();
+    const char *dd = inBuf + inBufPos;
+    info.crc = quazip_le32(dd);
+    bool useZip64 = zip64Entry;
+    if (!useZip64 && (quazip_le32(dd + 4) != compressedRead
+                || quazip_le32(dd + 8) != uncompressedRead)) {
+        // Some writers use 64-bit sizes without the Zip64 extra field
+        // in the local header, so try that before giving up.
+        if (fill(20)) {
+            dd = inBuf + inBufPos;
+            useZip64 = quazip_le64(dd + 4) == compressedRead
+                && quazip_le64(dd + 12) == uncompressedRead;
+        }
+    }
+    if (useZip64) {
+        if (!fill(20))
+            return unexpectedEnd();
+        dd = inBuf + inBufPos;
+        info.compressedSize = quazip_le64(dd + 4);
+        info.uncompressedSize = quazip_le64(dd + 12);
+        inBufPos += 20;
+    } else {
+        info.compressedSize = quazip_le32(dd + 4);
+        info.uncompressedSize = quazip_le32(dd + 8);
+        inBufPos += 12;
+    }
+    descriptorRead = true;
+    return true;
+}
+
+bool QuaZipStreamReaderPrivate::finishEntry()
+{
+    entryDone = true;
+    if (hasDataDescriptor() && !descriptorRead && !readDataDescriptor())
+        return false;
+    if (compressedRead != info.compressedSize
+            || uncompressedRead != info.uncompressedSize) {
+        setError(UNZ_BADZIPFILE, tr("The size of the entry %1 doesn't match"
+                    " the size in its header").arg(info.name));
+        return false;
+    }
+    if (crc != info.crc) {
+        setError(UNZ_CRCERROR, tr("CRC error in the entry %1")
+                .arg(info.name));
+        return false;
+    }
+    return true;
+}
+
+qint64 QuaZipStreamReaderPrivate::readDeflated(char *data, qint64 maxSize)
+{
+    qint64 read = 0;
+    while (read < maxSize) {
+        if (inBufPos == inBufSize) {
+            // Don't block if we already have something to return.
+            if (read > 0 && io->bytesAvailable() <= 0)
+                break;
+            if (!fill(1)) {
+                unexpectedEnd();
+                return -1;
+            }
+        }
+        zins.next_in = reinterpret_cast<Bytef*>(inBuf + inBufPos);
+        zins.avail_in = static_cast<uInt>(inBufSize - inBufPos);
+        zins.next_out = reinterpret_cast<Bytef*>(data + read);
+        zins.avail_out = static_cast<uInt>(qMin<qint64>(maxSize - read,
+                                                        0x7FFFFFFF));
+        int result = inflate(&zins, Z_SYNC_FLUSH);
+        int consumed = static_cast<int>(
+                reinterpret_cast<char*>(zins.next_in) - (inBuf + inBufPos));
+        qint64 produced = reinterpret_cast<char*>(zins.next_out)
+            - (data + read);
+        inBufPos += consumed;
+        compressedRead += consumed;
+        crc = quazip_crc32(crc, reinterpret_cast<const Bytef*>(data + read),
+                static_cast<size_t>(produced));
+        uncompressedRead += produced;
+        read += produced;
+        if (result == Z_STREAM_END) {
+            if (!finishEntry())
+                return -1;
+            break;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            setError(result, QString::fromLocal8Bit(zins.msg));
+            return -1;
+        }
+    }
+    return read;
+}
+
+qint64 QuaZipStreamReaderPrivate::readStored(char *data, qint64 maxSize)
+{
+    qint64 read = 0;
+    while (read < maxSize && compressedRead < info.compressedSize) {
+        if (inBufPos == inBufSize) {
+            if (read > 0 && io->bytesAvailable() <= 0)
+                return read;
+            if (!fill(1)) {
+                unexpectedEnd();
+                return -1;
+            }
+        }
+        int chunk = static_cast<int>(qMin<qint64>(qMin<qint64>(
+                maxSize - read, inBufSize - inBufPos),
+                info.compressedSize - compressedRead));
+        consume(data + read, chunk);
+        read += chunk;
+    }
+    if (compressedRead == info.compressedSize && !finishEntry())
+        return -1;
+    return read;
+}
+
+qint64 QuaZipStreamReaderPrivate::readStoredWithDescriptor(char *data,
+                                                           qint64 maxSize)
+{
+    qint64 read = 0;
+    while (read < maxSize) {
+        if (inBufPos == inBufSize) {
+            if (read > 0 && io->bytesAvailable() <= 0)
+                break;
+            if (!fill(1)) {
+                unexpectedEnd();
+                return -1;
+            }
+        }
+        const char *start = inBuf + inBufPos;
+        int available = inBufSize - inBufPos;
+        const char *signature = static_cast<const char*>(
+                memchr(start, 'P', available));
+        int plain = signature == nullptr ? available
+            : static_cast<int>(signature - start);
+        if (plain > 0) {
+            int chunk = static_cast<int>(qMin<qint64>(plain, maxSize - read));
+            consume(data + read, chunk);
+            read += chunk;
+            continue;
+        }
+        if (isStoredDataDescriptor()) {
+            if (!finishEntry())
+                return -1;
+            break;
+        }
+        if (zipError != UNZ_OK)
+            return -1;
+        // fill() may have moved the buffer, but not past this byte
+        consume(data + read, 1);
+        ++read;
+    }
+    return read;
+}
+
+qint64 QuaZipStreamReaderPrivate::readEntry(char *data, qint64 maxSize)
+{
+    if (zipError != UNZ_OK)
+        return -1;
+    if (entryDone || maxSize == 0)
+        return 0;
+    if (isEncrypted()) {
+        setError(UNZ_PARAMERROR, tr("Encrypted entries can't be read"
+                    " from a ZIP stream"));
+        return -1;
+    }
+    if (info.method == Z_DEFLATED)
+        return readDeflated(data, maxSize);
+    if (info.method == 0) {
+        if (hasKnownSize())
+            return readStored(data, maxSize);
+        else
+            return readStoredWithDescriptor(data, maxSize);
+    }
+    setError(UNZ_BADZIPFILE, tr("Unsupported compression method %1")
+            .arg(info.method));
+    return -1;
+}
+
+bool QuaZipStreamReaderPrivate::skipEntry()
+{
+    if (entryDone)
+        return true;
+    if (hasKnownSize()) {
+        // No need to decompress anything, just skip the data. There is
+        // nothing to verify the CRC against, though.
+        entryDone = true;
+        if (!skipBytes(info.compressedSize - compressedRead))
+            return false;
+        return !hasDataDescriptor() || readDataDescriptor();
+    }
+    if (isEncrypted() || (info.method != 0 && info.method != Z_DEFLATED)) {
+        setError(UNZ_BADZIPFILE, tr("Can't find the end of the entry %1")
+                .arg(info.name));
+        return false;
+    }
+    char buf[4096];
+    while (!entryDone) {
+        if (readEntry(buf, sizeof(buf)) < 0)
+            return false;
+    }
+    return true;
+}
+
+bool QuaZipStreamEntryDevice::atEnd() const
+{
+    return p->entryDone && QIODevice::bytesAvailable() == 0;
+}
+
+qint64 QuaZipStreamEntryDevice::bytesAvailable() const
+{
+    qint64 buffered = p->entryDone ? 0 : p->inBufSize - p->inBufPos;
+    if (p->info.method == 0 && p->hasKnownSize())
+        buffered = qMin<qint64>(buffered,
+                p->info.compressedSize - p->compressedRead);
+    return buffered + QIODevice::bytesAvailable();
+}
+
+qint64 QuaZipStreamEntryDevice::readData(char *data, qint64 maxSize)
+{
+    return p->readEntry(data, maxSize);
+}
+/// \endcond
+
+QuaZipStreamReader::QuaZipStreamReader():
+    p(new QuaZipStreamReaderPrivate(nullptr))
+{
+}
+
+QuaZipStreamReader::QuaZipStreamReader(QIODevice *ioDevice):
+    p(new QuaZipStreamReaderPrivate(ioDevice))
+{
+}
+
+QuaZipStreamReader::~QuaZipStreamReader()
+{
+    delete p;
+}
+
+void QuaZipStreamReader::setIoDevice(QIODevice *ioDevice)
+{
+    p->reset();
+    p->io = ioDevice;
+}
+
+QIODevice *QuaZipStreamReader::getIoDevice() const
+{
+    return p->io;
+}
+
+void QuaZipStreamReader::setFileNameCodec(QTextCodec *fileNameCodec)
+{
+    p->fileNameCodec = fileNameCodec;
+}
+
+QTextCodec *QuaZipStreamReader::getFileNameCodec() const
+{
+    return p->fileNameCodec;
+}
+
+void QuaZipStreamReader::setReadTimeout(int msecs)
+{
+    p->readTimeout = msecs;
+}
+
+int QuaZipStreamReader::getReadTimeout() const
+{
+    return p->readTimeout;
+}
+
+bool QuaZipStreamReader::nextEntry()
+{
+    if (p->io == nullptr) {
+        qWarning("QuaZipStreamReader::nextEntry(): no device to read from");
+        return false;
+    }
+    if (p->atEnd)
+        return false;
+    if (p->zipError != UNZ_OK && p->zipError != UNZ_CRCERROR)
+        return false;
+    if (p->entry != nullptr && p->entry->isOpen())
+        p->entry->close();
+    if (p->hasEntry && !p->skipEntry()) {
+        p->hasEntry = false;
+        return false;
+    }
+    p->hasEntry = false;
+    p->zipError = UNZ_OK;
+    p->errorString.clear();
+    if (!p->io->isOpen() && !p->io->open(QIODevice::ReadOnly)) {
+        p->setError(UNZ_ERRNO, p->io->errorString());
+        return false;
+    }
+    if (!p->io->isReadable()) {
+        qWarning("QuaZipStreamReader::nextEntry(): the device is not"
+                 " open for reading");
+        return false;
+    }
+    if (!p->readLocalHeader())
+        return false;
+    if (p->zinsInitialized) {
+        inflateReset(&p->zins);
+    } else {
+        if (inflateInit2(&p->zins, -MAX_WBITS) != Z_OK) {
+            p->setError(UNZ_INTERNALERROR,
+                    QString::fromLocal8Bit(p->zins.msg));
+            return false;
+        }
+        p->zinsInitialized = true;
+    }
+    p->hasEntry = true;
+    p->entryDone = false;
+    if (p->entry == nullptr)
+        p->entry = new QuaZipStreamEntryDevice(p);
+    p->entry->open(QIODevice::ReadOnly);
+    return true;
+}
+
+bool QuaZipStreamReader::hasCurrentEntry() const
+{
+    return p->hasEntry;
+}
+
+bool QuaZipStreamReader::atEnd() const
+{
+    return p->atEnd;
+}
+
+QString QuaZipStreamReader::getCurrentFileName() const
+{
+    return p->hasEntry ? p->info.name : QString();
+}
+
+bool QuaZipStreamReader::getCurrentFileInfo(QuaZipFileInfo64 *info) const
+{
+    if (!p->hasEntry || info == nullptr)
+        return false;
+    *info = p->info;
+    return true;
+}
+
+QIODevice *QuaZipStreamReader::currentEntry()
+{
+    return p->hasEntry ? p->entry : nullptr;
+}
+
+int QuaZipStreamReader::getZipError() const
+{
+    return p->zipError;
+}
+
+QString QuaZipStreamReader::getErrorString() const
+{
+    return p->errorString;
+}
@@ -0,0 +1,160 @@
+#ifndef QUAZIP_QUAZIPSTREAMREADER_H
+#define QUAZIP_QUAZIPSTREAMREADER_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QtCore/QIODevice>
+#include <QtCore/QString>
+#include "quazip_qt_compat.h"
+
+#include "quazip_global.h"
+#include "quazipfileinfo.h"
+
+class QuaZipStreamReaderPrivate;
+
+/// Forward-only ZIP archive reader.
+/** \class QuaZipStreamReader quazipstreamreader.h <quazip/quazipstreamreader.h>
+ * QuaZip needs random access to the archive because it starts by
+ * reading the central directory at the end of the file. This class
+ * doesn't: it walks the local file headers one after another, so it
+ * can read an archive from any sequential QIODevice, such as a
+ * QTcpSocket, a QProcess or a pipe, while the data is still arriving.
+ *
+ * Usage:
+ * \code
+ * QuaZipStreamReader reader(&socket);
+ * while (reader.nextEntry()) {
+ *     QuaZipFileInfo64 info;
+ *     reader.getCurrentFileInfo(&info);
+ *     QIODevice *entry = reader.currentEntry();
+ *     QByteArray data = entry->readAll();
+ *     // ...
+ * }
+ * if (reader.getZipError() != UNZ_OK) {
+ *     // handle the error
+ * }
+ * \endcode
+ *
+ * Entries written with the data descriptor (general purpose flag bit 3,
+ * which is what QuaZip writes by default and what any streaming writer
+ * produces) are supported. For deflated entries, the end of the entry
+ * is found by detecting the end of the deflate stream. For stored
+ * entries, the data is scanned for a data descriptor whose CRC and sizes
+ * match the data read so far. The CRC and the sizes are verified when
+ * the end of each entry is reached.
+ *
+ * Since the central directory is never read, the information available
+ * for each entry is limited to what the local header contains: there are
+ * no comments, no file attributes and no "version made by" field. If the
+ * entry uses the data descriptor, the CRC and the sizes become known only
+ * after the entry has been read to the end.
+ *
+ * Only stored and deflated entries can be read. Entries using other
+ * compression methods or encryption can be skipped, provided their sizes
+ * are known from the local header.
+ */
+class QUAZIP_EXPORT QuaZipStreamReader {
+  friend class QuaZipStreamReaderPrivate;
+  public:
+    /// Constructs a reader that has no device to read from.
+    /** Call setIoDevice() before calling nextEntry(). */
+    QuaZipStreamReader();
+    /// Constructs a reader for the specified device.
+    /** The device must be open for reading, or nextEntry() will open it
+     * in the QIODevice::ReadOnly mode. The device is not owned by the
+     * reader and must outlive it.
+     */
+    explicit QuaZipStreamReader(QIODevice *ioDevice);
+    /// Destroys the reader and the current entry device.
+    ~QuaZipStreamReader();
+    /// Sets the device to read the archive from.
+    /** Resets the reader state, making it ready to read a new archive. */
+    void setIoDevice(QIODevice *ioDevice);
+    /// Returns the device the archive is read from.
+    QIODevice *getIoDevice() const;
+    /// Sets the codec used to decode file names.
+    /** It is only used for the entries that don't have the UTF-8 flag set.
+     * The default is QTextCodec::codecForLocale().
+     */
+    void setFileNameCodec(QTextCodec *fileNameCodec);
+    /// Returns the codec used to decode file names.
+    QTextCodec *getFileNameCodec() const;
+    /// Sets the timeout for waiting for more data.
+    /** When the underlying device has no more data available, the reader
+     * calls QIODevice::waitForReadyRead() with this timeout before
+     * deciding that the end of the stream is reached. The default is
+     * 30000 milliseconds. -1 means wait forever.
+     */
+    void setReadTimeout(int msecs);
+    /// Returns the timeout for waiting for more data.
+    int getReadTimeout() const;
+    /// Moves to the next entry of the archive.
+    /** If the current entry hasn't been read to the end, the rest of it is
+     * skipped. The current entry device is closed.
+     *
+     * \return \c true if the next entry's local header was read
+     * successfully, \c false if the end of the entries (the central
+     * directory) was reached or an error occurred. In the former case,
+     * getZipError() returns \c UNZ_OK.
+     */
+    bool nextEntry();
+    /// Returns \c true if there is a current entry.
+    bool hasCurrentEntry() const;
+    /// Returns \c true if the central directory has been reached.
+    bool atEnd() const;
+    /// Returns the name of the current entry.
+    QString getCurrentFileName() const;
+    /// Retrieves information about the current entry.
+    /** Only the fields present in the local header are filled. The CRC
+     * and the sizes of the entries having a data descriptor are updated
+     * once the entry has been read to the end.
+     *
+     * \return \c false if there is no current entry.
+     */
+    bool getCurrentFileInfo(QuaZipFileInfo64 *info) const;
+    /// Returns the device to read the current entry from.
+    /** The returned device is open in the QIODevice::ReadOnly mode and
+     * yields the uncompressed data of the current entry. It is owned by
+     * the reader and is only valid until the next call to nextEntry().
+     * If the end of the entry is reached and the CRC doesn't match,
+     * the read call returns -1 and getZipError() returns
+     * \c UNZ_CRCERROR.
+     *
+     * \return \c nullptr if there is no current entry.
+     */
+    QIODevice *currentEntry();
+    /// Returns the error code of the last operation.
+    /** \c UNZ_OK means there was no error. Otherwise, this is either one
+     * of the \c UNZ_* codes or a zlib error code.
+     */
+    int getZipError() const;
+    /// Returns the description of the last error.
+    QString getErrorString() const;
+  private:
+    QuaZipStreamReaderPrivate *p;
+    Q_DISABLE_COPY(QuaZipStreamReader)
+};
+
+#endif // QUAZIP_QUAZIPSTREAMREADER_H
@@ -73,11 +73,18 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <zlib.h>
-#if (ZLIB_VERNUM < 0x1270)
-typedef uLongf z_crc_t;
-#endif
+#include "quazip_zlib.h"
+#include "quazip_crc32.h"
+#include "quazip_aes.h"
 #include "unzip.h"
+#include "inflate64.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
 
 #ifdef STDC
 #  include <stddef.h>
@@ -127,6 +134,9 @@ const char unz_copyright[] =
    " unzip 1.01 Copyright 1998-2004 Gilles Vollant - http://www.winimage.com/zLibDll";
 
 /* unz_file_info_interntal contain internal info about a file in zipfile*/
+/* the LZMA SDK version, the size of the properties and the properties */
+#define UNZ_LZMA_HEADER_SIZE (9)
+
 typedef struct unz_file_info64_internal_s
 {
     ZPOS64_T offset_curfile;/* relative offset of local header 8 bytes */
@@ -143,6 +153,15 @@ typedef struct
 #ifdef HAVE_BZIP2
     bz_stream bstream;          /* bzLib stream structure for bziped */
 #endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstream;      /* zstd stream structure for method 93 */
+#endif
+#ifdef HAVE_LZMA
+    lzma_stream lstream;        /* liblzma stream structure for methods 14 and 95 */
+    Byte lzma_header[UNZ_LZMA_HEADER_SIZE]; /* the version and the properties */
+    uInt lzma_header_size;      /* how much of lzma_header has been read */
+#endif
+    inflate64_state* i64state;  /* Deflate64 decompressor for method 9 */
 
     ZPOS64_T pos_in_zipfile;       /* position in byte on the zipfile, for fseek*/
     uLong stream_initialised;   /* flag set if stream structure is initialised*/
@@ -161,6 +180,8 @@ typedef struct
     uLong compression_method;   /* compression method (0==store) */
     ZPOS64_T byte_before_the_zipfile;/* byte before the zipfile, (>0 for sfx)*/
     int   raw;
+    quazip_aes* aes;            /* WinZip AES decryption, if used */
+    int   aes_version;          /* AE-1 or AE-2, 0 if not decrypting AES */
 } file_in_zip64_read_info_s;
 
 
@@ -1449,6 +1470,11 @@ local int unz64local_CheckCurrentFileCoherencyHeader (unz64_s* s, uInt* piSizeVa
 /* #ifdef HAVE_BZIP2 */
                          (s->cur_file_info.compression_method!=Z_BZIP2ED) &&
 /* #endif */
+                         (s->cur_file_info.compression_method!=Z_ZSTD) &&
+                         (s->cur_file_info.compression_method!=Z_LZMA) &&
+                         (s->cur_file_info.compression_method!=Z_XZ) &&
+                         (s->cur_file_info.compression_method!=Z_DEFLATE64) &&
+                         (s->cur_file_info.compression_method!=QUAZIP_AES_METHOD) &&
                          (s->cur_file_info.compression_method!=Z_DEFLATED))
         err=UNZ_BADZIPFILE;
 
@@ -1488,6 +1514,55 @@ local int unz64local_CheckCurrentFileCoherencyHeader (unz64_s* s, uInt* piSizeVa
     return err;
 }
 
+/*
+  Read the WinZip AES extra field of the current file from its local
+  header: the vendor version, the key strength and the actual method.
+*/
+local int unz64local_getAesExtra (unz64_s* s, ZPOS64_T offset_local_extrafield,
+                                  uInt size_local_extrafield, int* pversion,
+                                  int* pstrength, uLong* pmethod)
+{
+    unsigned char* extra;
+    uInt pos = 0;
+    int err = UNZ_BADZIPFILE;
+
+    if (size_local_extrafield == 0)
+        return UNZ_BADZIPFILE;
+    extra = (unsigned char*)ALLOC(size_local_extrafield);
+    if (extra == NULL)
+        return UNZ_INTERNALERROR;
+    if (ZSEEK64(s->z_filefunc, s->filestream,
+                offset_local_extrafield + s->byte_before_the_zipfile,
+                ZLIB_FILEFUNC_SEEK_SET) != 0
+        || ZREAD64(s->z_filefunc, s->filestream, extra,
+                   size_local_extrafield) != size_local_extrafield)
+    {
+        TRYFREE(extra);
+        return UNZ_ERRNO;
+    }
+    while (pos + 4 <= size_local_extrafield)
+    {
+        uLong id = (uLong)extra[pos] | ((uLong)extra[pos + 1] << 8);
+        uLong size = (uLong)extra[pos + 2] | ((uLong)extra[pos + 3] << 8);
+        if (pos + 4 + size > size_local_extrafield)
+            break;
+        if ((id == QUAZIP_AES_EXTRA_ID) && (size >= QUAZIP_AES_EXTRA_SIZE - 4)
+            && (extra[pos + 6] == 'A') && (extra[pos + 7] == 'E'))
+        {
+            *pversion = (int)extra[pos + 4] | ((int)extra[pos + 5] << 8);
+            *pstrength = (int)extra[pos + 8];
+            *pmethod = (uLong)extra[pos + 9] | ((uLong)extra[pos + 10] << 8);
+            if (((*pversion == QUAZIP_AES_AE1) || (*pversion == QUAZIP_AES_AE2))
+                && (quazip_aes_salt_size(*pstrength) != 0))
+                err = UNZ_OK;
+            break;
+        }
+        pos += 4 + (uInt)size;
+    }
+    TRYFREE(extra);
+    return err;
+}
+
 /*
   Open for reading data the current file in the zipfile.
   If there is no error and the file is opened, the return value is UNZ_OK.
@@ -1501,6 +1576,9 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
     file_in_zip64_read_info_s* pfile_in_zip_read_info;
     ZPOS64_T offset_local_extrafield;  /* offset of the local extra field */
     uInt  size_local_extrafield;    /* size of the local extra field */
+    uLong compression_method;
+    int aes_version = 0;
+    int aes_strength = 0;
 #    ifndef NOUNCRYPT
     char source[12];
 #    else
@@ -1520,6 +1598,22 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
     if (unz64local_CheckCurrentFileCoherencyHeader(s,&iSizeVar, &offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
         return UNZ_BADZIPFILE;
 
+    compression_method = s->cur_file_info.compression_method;
+    if (compression_method == QUAZIP_AES_METHOD)
+    {
+        uLong aes_method;
+        err = unz64local_getAesExtra(s, offset_local_extrafield, size_local_extrafield,
+                                     &aes_version, &aes_strength, &aes_method);
+        if (err != UNZ_OK)
+            return err;
+        if (password != NULL)
+            compression_method = aes_method;
+        else if (!raw)
+            return UNZ_PARAMERROR; /* there's no way to read it */
+        else
+            aes_version = 0; /* copied as is, still encrypted */
+    }
+
     pfile_in_zip_read_info = (file_in_zip64_read_info_s*)ALLOC(sizeof(file_in_zip64_read_info_s));
     if (pfile_in_zip_read_info==NULL)
         return UNZ_INTERNALERROR;
@@ -1529,6 +1623,8 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
     pfile_in_zip_read_info->size_local_extrafield = size_local_extrafield;
     pfile_in_zip_read_info->pos_local_extrafield=0;
     pfile_in_zip_read_info->raw=raw;
+    pfile_in_zip_read_info->aes=NULL;
+    pfile_in_zip_read_info->aes_version=0;
 
     if (pfile_in_zip_read_info->read_buffer==NULL)
     {
@@ -1539,7 +1635,7 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
     pfile_in_zip_read_info->stream_initialised=0;
 
     if (method!=NULL)
-        *method = (int)s->cur_file_info.compression_method;
+        *method = (int)compression_method;
 
     if (level!=NULL)
     {
@@ -1552,25 +1648,29 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
         }
     }
 
-    if ((s->cur_file_info.compression_method!=0) &&
+    if ((compression_method!=0) &&
 /* #ifdef HAVE_BZIP2 */
-        (s->cur_file_info.compression_method!=Z_BZIP2ED) &&
+        (compression_method!=Z_BZIP2ED) &&
 /* #endif */
-        (s->cur_file_info.compression_method!=Z_DEFLATED))
+        (compression_method!=Z_ZSTD) &&
+        (compression_method!=Z_LZMA) &&
+        (compression_method!=Z_XZ) &&
+        (compression_method!=Z_DEFLATE64) &&
+        (compression_method!=Z_DEFLATED))
 
         err=UNZ_BADZIPFILE;
 
     pfile_in_zip_read_info->crc32_wait=s->cur_file_info.crc;
     pfile_in_zip_read_info->crc32=0;
     pfile_in_zip_read_info->total_out_64=0;
-    pfile_in_zip_read_info->compression_method = s->cur_file_info.compression_method;
+    pfile_in_zip_read_info->compression_method = compression_method;
     pfile_in_zip_read_info->filestream=s->filestream;
     pfile_in_zip_read_info->z_filefunc=s->z_filefunc;
     pfile_in_zip_read_info->byte_before_the_zipfile=s->byte_before_the_zipfile;
 
     pfile_in_zip_read_info->stream.total_out = 0;
 
-    if ((s->cur_file_info.compression_method==Z_BZIP2ED) && (!raw))
+    if ((compression_method==Z_BZIP2ED) && (!raw))
     {
 #ifdef HAVE_BZIP2
       pfile_in_zip_read_info->bstream.bzalloc = (void *(*) (void *, int, int))0;
@@ -1585,18 +1685,22 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
       pfile_in_zip_read_info->stream.avail_in = 0;
 
       err=BZ2_bzDecompressInit(&pfile_in_zip_read_info->bstream, 0, 0);
-      if (err == Z_OK)
+      if (err == BZ_OK)
         pfile_in_zip_read_info->stream_initialised=Z_BZIP2ED;
       else
       {
+        TRYFREE(pfile_in_zip_read_info->read_buffer);
         TRYFREE(pfile_in_zip_read_info);
-        return err;
+        return UNZ_INTERNALERROR;
       }
 #else
-      pfile_in_zip_read_info->raw=1;
+      /* bzip2 data can only be read in the raw mode */
+      TRYFREE(pfile_in_zip_read_info->read_buffer);
+      TRYFREE(pfile_in_zip_read_info);
+      return UNZ_BADZIPFILE;
 #endif
     }
-    else if ((s->cur_file_info.compression_method==Z_DEFLATED) && (!raw))
+    else if ((compression_method==Z_DEFLATED) && (!raw))
     {
       pfile_in_zip_read_info->stream.zalloc = (alloc_func)0;
       pfile_in_zip_read_info->stream.zfree = (free_func)0;
@@ -1621,6 +1725,84 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
          * size of both compressed and uncompressed data
          */
     }
+    else if ((compression_method==Z_DEFLATE64) && (!raw))
+    {
+      pfile_in_zip_read_info->stream.next_in = 0;
+      pfile_in_zip_read_info->stream.avail_in = 0;
+      pfile_in_zip_read_info->stream.total_in = 0;
+
+      pfile_in_zip_read_info->i64state = inflate64New();
+      if (pfile_in_zip_read_info->i64state != NULL)
+        pfile_in_zip_read_info->stream_initialised=Z_DEFLATE64;
+      else
+      {
+        TRYFREE(pfile_in_zip_read_info->read_buffer);
+        TRYFREE(pfile_in_zip_read_info);
+        return UNZ_INTERNALERROR;
+      }
+    }
+    else if ((compression_method==Z_ZSTD) && (!raw))
+    {
+#ifdef HAVE_ZSTD
+      pfile_in_zip_read_info->stream.next_in = 0;
+      pfile_in_zip_read_info->stream.avail_in = 0;
+      pfile_in_zip_read_info->stream.total_in = 0;
+
+      pfile_in_zip_read_info->zstream = ZSTD_createDStream();
+      if (pfile_in_zip_read_info->zstream != NULL
+          && ZSTD_isError(ZSTD_initDStream(pfile_in_zip_read_info->zstream)))
+      {
+        ZSTD_freeDStream(pfile_in_zip_read_info->zstream);
+        pfile_in_zip_read_info->zstream = NULL;
+      }
+      if (pfile_in_zip_read_info->zstream != NULL)
+        pfile_in_zip_read_info->stream_initialised=Z_ZSTD;
+      else
+      {
+        TRYFREE(pfile_in_zip_read_info->read_buffer);
+        TRYFREE(pfile_in_zip_read_info);
+        return UNZ_INTERNALERROR;
+      }
+#else
+      /* zstd data can only be read in the raw mode */
+      TRYFREE(pfile_in_zip_read_info->read_buffer);
+      TRYFREE(pfile_in_zip_read_info);
+      return UNZ_BADZIPFILE;
+#endif
+    }
+    else if (((compression_method==Z_LZMA) ||
+              (compression_method==Z_XZ)) && (!raw))
+    {
+#ifdef HAVE_LZMA
+      lzma_stream init = LZMA_STREAM_INIT;
+      pfile_in_zip_read_info->lstream = init;
+      pfile_in_zip_read_info->stream.next_in = 0;
+      pfile_in_zip_read_info->stream.avail_in = 0;
+      pfile_in_zip_read_info->stream.total_in = 0;
+
+      if (compression_method==Z_XZ)
+      {
+        pfile_in_zip_read_info->lzma_header_size = UNZ_LZMA_HEADER_SIZE;
+        if (lzma_stream_decoder(&pfile_in_zip_read_info->lstream, UINT64_MAX, 0) != LZMA_OK)
+        {
+          TRYFREE(pfile_in_zip_read_info->read_buffer);
+          TRYFREE(pfile_in_zip_read_info);
+          return UNZ_INTERNALERROR;
+        }
+      }
+      else
+      {
+        /* the decoder is set up once the header has been read */
+        pfile_in_zip_read_info->lzma_header_size = 0;
+      }
+      pfile_in_zip_read_info->stream_initialised=Z_LZMA;
+#else
+      /* LZMA data can only be read in the raw mode */
+      TRYFREE(pfile_in_zip_read_info->read_buffer);
+      TRYFREE(pfile_in_zip_read_info);
+      return UNZ_BADZIPFILE;
+#endif
+    }
     pfile_in_zip_read_info->rest_read_compressed =
             s->cur_file_info.compressed_size ;
     pfile_in_zip_read_info->rest_read_uncompressed =
@@ -1636,6 +1818,36 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
     s->pfile_in_zip_read = pfile_in_zip_read_info;
                 s->encrypted = 0;
 
+    if (aes_version != 0)
+    {
+        /* the salt and the password verification value precede the data */
+        unsigned char head[QUAZIP_AES_MAX_SALT_SIZE + QUAZIP_AES_PWV_SIZE];
+        unsigned char pwv[QUAZIP_AES_PWV_SIZE];
+        uInt size_head = (uInt)quazip_aes_salt_size(aes_strength) + QUAZIP_AES_PWV_SIZE;
+        if (pfile_in_zip_read_info->rest_read_compressed < size_head + QUAZIP_AES_MAC_SIZE)
+            err = UNZ_BADZIPFILE;
+        else if (ZSEEK64(s->z_filefunc, s->filestream,
+                    pfile_in_zip_read_info->pos_in_zipfile +
+                       pfile_in_zip_read_info->byte_before_the_zipfile,
+                    SEEK_SET)!=0
+                 || ZREAD64(s->z_filefunc, s->filestream, head, size_head) != size_head)
+            err = UNZ_ERRNO;
+        else if ((pfile_in_zip_read_info->aes = quazip_aes_open(aes_strength, password, head, pwv)) == NULL)
+            err = UNZ_INTERNALERROR;
+        else if (memcmp(pwv, head + size_head - QUAZIP_AES_PWV_SIZE, QUAZIP_AES_PWV_SIZE) != 0)
+            err = UNZ_BADPASSWORD;
+        if (err != UNZ_OK)
+        {
+            unzCloseCurrentFile(file);
+            return err;
+        }
+        pfile_in_zip_read_info->aes_version = aes_version;
+        pfile_in_zip_read_info->pos_in_zipfile += size_head;
+        /* the authentication code follows the data */
+        pfile_in_zip_read_info->rest_read_compressed -= size_head + QUAZIP_AES_MAC_SIZE;
+        return UNZ_OK;
+    }
+
 #    ifndef NOUNCRYPT
     if (password != NULL)
     {
@@ -1695,6 +1907,35 @@ extern ZPOS64_T ZEXPORT unzGetCurrentFileZStreamPos64( unzFile file)
 
 /** Addition for GDAL : END */
 
+#ifdef HAVE_LZMA
+/*
+  Sets up the LZMA (14) decoder from the header preceding the data: the
+  LZMA SDK version (2 bytes), the size of the properties (2 bytes, always
+  5 for LZMA1) and the properties.
+*/
+local int unz64local_initLzmaDecoder(file_in_zip64_read_info_s* pfile_in_zip_read_info)
+{
+    lzma_filter filters[2];
+    lzma_ret ret;
+    const Byte *header = pfile_in_zip_read_info->lzma_header;
+
+    if ((header[2] | (header[3] << 8)) != UNZ_LZMA_HEADER_SIZE - 4)
+        return Z_DATA_ERROR;
+    filters[0].id = LZMA_FILTER_LZMA1;
+    filters[0].options = NULL;
+    filters[1].id = LZMA_VLI_UNKNOWN;
+    filters[1].options = NULL;
+    if (lzma_properties_decode(&filters[0], NULL, header + 4,
+                               UNZ_LZMA_HEADER_SIZE - 4) != LZMA_OK)
+        return Z_DATA_ERROR;
+    ret = lzma_raw_decoder(&pfile_in_zip_read_info->lstream, filters);
+    free(filters[0].options);
+    if (ret == LZMA_MEM_ERROR)
+        return Z_MEM_ERROR;
+    return ret == LZMA_OK ? UNZ_OK : Z_DATA_ERROR;
+}
+#endif
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1764,6 +2005,10 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
                 return UNZ_ERRNO;
 
 
+            if (pfile_in_zip_read_info->aes != NULL)
+                quazip_aes_decrypt(pfile_in_zip_read_info->aes,
+                                   (unsigned char*)pfile_in_zip_read_info->read_buffer,
+                                   uReadThis);
 #            ifndef NOUNCRYPT
             if(s->encrypted)
             {
@@ -1805,7 +2050,7 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
 
             pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uDoCopy;
 
-            pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,
+            pfile_in_zip_read_info->crc32 = quazip_crc32(pfile_in_zip_read_info->crc32,
                                 pfile_in_zip_read_info->stream.next_out,
                                 uDoCopy);
             pfile_in_zip_read_info->rest_read_uncompressed-=uDoCopy;
@@ -1819,46 +2064,200 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
         else if (pfile_in_zip_read_info->compression_method==Z_BZIP2ED)
         {
 #ifdef HAVE_BZIP2
-            uLong uTotalOutBefore,uTotalOutAfter;
-            const Bytef *bufBefore;
-            uLong uOutThis;
+            uInt uInThis, uOutThis;
 
             pfile_in_zip_read_info->bstream.next_in        = (char*)pfile_in_zip_read_info->stream.next_in;
             pfile_in_zip_read_info->bstream.avail_in       = pfile_in_zip_read_info->stream.avail_in;
-            pfile_in_zip_read_info->bstream.total_in_lo32  = pfile_in_zip_read_info->stream.total_in;
-            pfile_in_zip_read_info->bstream.total_in_hi32  = 0;
             pfile_in_zip_read_info->bstream.next_out       = (char*)pfile_in_zip_read_info->stream.next_out;
             pfile_in_zip_read_info->bstream.avail_out      = pfile_in_zip_read_info->stream.avail_out;
-            pfile_in_zip_read_info->bstream.total_out_lo32 = pfile_in_zip_read_info->stream.total_out;
-            pfile_in_zip_read_info->bstream.total_out_hi32 = 0;
-
-            uTotalOutBefore = pfile_in_zip_read_info->bstream.total_out_lo32;
-            bufBefore = (const Bytef *)pfile_in_zip_read_info->bstream.next_out;
 
             err=BZ2_bzDecompress(&pfile_in_zip_read_info->bstream);
 
-            uTotalOutAfter = pfile_in_zip_read_info->bstream.total_out_lo32;
-            uOutThis = uTotalOutAfter-uTotalOutBefore;
+            /* the totals are 32-bit halves, so the progress is measured by the buffers */
+            uInThis = pfile_in_zip_read_info->stream.avail_in - pfile_in_zip_read_info->bstream.avail_in;
+            uOutThis = pfile_in_zip_read_info->stream.avail_out - pfile_in_zip_read_info->bstream.avail_out;
 
             pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
 
-            pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,bufBefore, (uInt)(uOutThis));
+            pfile_in_zip_read_info->crc32 = quazip_crc32(pfile_in_zip_read_info->crc32,
+                                pfile_in_zip_read_info->stream.next_out, uOutThis);
             pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
-            iRead += (uInt)(uTotalOutAfter - uTotalOutBefore);
+            iRead += uOutThis;
 
-            pfile_in_zip_read_info->stream.next_in   = (Bytef*)pfile_in_zip_read_info->bstream.next_in;
-            pfile_in_zip_read_info->stream.avail_in  = pfile_in_zip_read_info->bstream.avail_in;
-            pfile_in_zip_read_info->stream.total_in  = pfile_in_zip_read_info->bstream.total_in_lo32;
-            pfile_in_zip_read_info->stream.next_out  = (Bytef*)pfile_in_zip_read_info->bstream.next_out;
-            pfile_in_zip_read_info->stream.avail_out = pfile_in_zip_read_info->bstream.avail_out;
-            pfile_in_zip_read_info->stream.total_out = pfile_in_zip_read_info->bstream.total_out_lo32;
+            pfile_in_zip_read_info->stream.next_in   += uInThis;
+            pfile_in_zip_read_info->stream.avail_in  -= uInThis;
+            pfile_in_zip_read_info->stream.total_in  += uInThis;
+            pfile_in_zip_read_info->stream.next_out  += uOutThis;
+            pfile_in_zip_read_info->stream.avail_out -= uOutThis;
+            pfile_in_zip_read_info->stream.total_out += uOutThis;
 
             if (err==BZ_STREAM_END)
               return (iRead==0) ? UNZ_EOF : iRead;
             if (err!=BZ_OK)
+            {
+              err = (err == BZ_MEM_ERROR) ? Z_MEM_ERROR : Z_DATA_ERROR;
               break;
+            }
+            if ((pfile_in_zip_read_info->stream.avail_in == 0) &&
+                (pfile_in_zip_read_info->rest_read_compressed == 0) &&
+                (uInThis == 0) && (uOutThis == 0))
+            {
+              /* truncated */
+              err = Z_DATA_ERROR;
+              break;
+            }
 #endif
         } /* end Z_BZIP2ED */
+        else if (pfile_in_zip_read_info->compression_method==Z_DEFLATE64)
+        {
+            uInt uAvailInBefore, uAvailOutBefore, uOutThis;
+            const Bytef *bufBefore;
+
+            uAvailInBefore = pfile_in_zip_read_info->stream.avail_in;
+            uAvailOutBefore = pfile_in_zip_read_info->stream.avail_out;
+            bufBefore = pfile_in_zip_read_info->stream.next_out;
+
+            err = inflate64(pfile_in_zip_read_info->i64state, &pfile_in_zip_read_info->stream);
+
+            uOutThis = uAvailOutBefore - pfile_in_zip_read_info->stream.avail_out;
+            pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
+            pfile_in_zip_read_info->crc32 = quazip_crc32(pfile_in_zip_read_info->crc32, bufBefore, uOutThis);
+            pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
+            iRead += uOutThis;
+
+            if (err == Z_STREAM_END)
+                return (iRead==0) ? UNZ_EOF : iRead;
+            if (err != Z_OK)
+                break;
+            if ((pfile_in_zip_read_info->stream.avail_in == 0) &&
+                (pfile_in_zip_read_info->rest_read_compressed == 0) &&
+                (uAvailInBefore == 0) && (uOutThis == 0))
+            {
+                /* truncated */
+                err = Z_DATA_ERROR;
+                break;
+            }
+        }
+#ifdef HAVE_LZMA
+        else if ((pfile_in_zip_read_info->compression_method==Z_LZMA) ||
+                 (pfile_in_zip_read_info->compression_method==Z_XZ))
+        {
+            lzma_ret ret;
+            uInt uInThis, uOutThis;
+
+            if (pfile_in_zip_read_info->lzma_header_size < UNZ_LZMA_HEADER_SIZE)
+            {
+                while ((pfile_in_zip_read_info->lzma_header_size < UNZ_LZMA_HEADER_SIZE) &&
+                       (pfile_in_zip_read_info->stream.avail_in > 0))
+                {
+                    pfile_in_zip_read_info->lzma_header[pfile_in_zip_read_info->lzma_header_size++] =
+                        *pfile_in_zip_read_info->stream.next_in++;
+                    pfile_in_zip_read_info->stream.avail_in--;
+                    pfile_in_zip_read_info->stream.total_in++;
+                }
+                if (pfile_in_zip_read_info->lzma_header_size < UNZ_LZMA_HEADER_SIZE)
+                {
+                    if (pfile_in_zip_read_info->rest_read_compressed == 0)
+                    {
+                        err = Z_DATA_ERROR;
+                        break;
+                    }
+                    continue;
+                }
+                err = unz64local_initLzmaDecoder(pfile_in_zip_read_info);
+                if (err != UNZ_OK)
+                    break;
+            }
+
+            pfile_in_zip_read_info->lstream.next_in = pfile_in_zip_read_info->stream.next_in;
+            pfile_in_zip_read_info->lstream.avail_in = pfile_in_zip_read_info->stream.avail_in;
+            pfile_in_zip_read_info->lstream.next_out = pfile_in_zip_read_info->stream.next_out;
+            pfile_in_zip_read_info->lstream.avail_out = pfile_in_zip_read_info->stream.avail_out;
+
+            ret = lzma_code(&pfile_in_zip_read_info->lstream, LZMA_RUN);
+
+            uInThis = pfile_in_zip_read_info->stream.avail_in - (uInt)pfile_in_zip_read_info->lstream.avail_in;
+            uOutThis = pfile_in_zip_read_info->stream.avail_out - (uInt)pfile_in_zip_read_info->lstream.avail_out;
+            pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
+            pfile_in_zip_read_info->crc32 = quazip_crc32(pfile_in_zip_read_info->crc32,
+                                pfile_in_zip_read_info->stream.next_out, uOutThis);
+            pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
+            iRead += uOutThis;
+
+            pfile_in_zip_read_info->stream.next_in += uInThis;
+            pfile_in_zip_read_info->stream.avail_in -= uInThis;
+            pfile_in_zip_read_info->stream.total_in += uInThis;
+            pfile_in_zip_read_info->stream.next_out += uOutThis;
+            pfile_in_zip_read_info->stream.avail_out -= uOutThis;
+            pfile_in_zip_read_info->stream.total_out += uOutThis;
+
+            if (ret == LZMA_STREAM_END)
+                return (iRead==0) ? UNZ_EOF : iRead;
+            if (ret != LZMA_OK)
+            {
+                err = Z_DATA_ERROR;
+                break;
+            }
+            if ((pfile_in_zip_read_info->stream.avail_in == 0) &&
+                (pfile_in_zip_read_info->rest_read_compressed == 0) &&
+                (uInThis == 0) && (uOutThis == 0))
+            {
+                /* truncated */
+                err = Z_DATA_ERROR;
+                break;
+            }
+        }
+#endif
+#ifdef HAVE_ZSTD
+        else if (pfile_in_zip_read_info->compression_method==Z_ZSTD)
+        {
+            ZSTD_inBuffer in;
+            ZSTD_outBuffer out;
+            size_t ret;
+            uInt uOutThis;
+
+            in.src = pfile_in_zip_read_info->stream.next_in;
+            in.size = pfile_in_zip_read_info->stream.avail_in;
+            in.pos = 0;
+            out.dst = pfile_in_zip_read_info->stream.next_out;
+            out.size = pfile_in_zip_read_info->stream.avail_out;
+            out.pos = 0;
+
+            ret = ZSTD_decompressStream(pfile_in_zip_read_info->zstream, &out, &in);
+            if (ZSTD_isError(ret))
+            {
+                err = Z_DATA_ERROR;
+                break;
+            }
+
+            uOutThis = (uInt)out.pos;
+            pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
+            pfile_in_zip_read_info->crc32 = quazip_crc32(pfile_in_zip_read_info->crc32,
+                                pfile_in_zip_read_info->stream.next_out, uOutThis);
+            pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
+            iRead += uOutThis;
+
+            pfile_in_zip_read_info->stream.next_in += in.pos;
+            pfile_in_zip_read_info->stream.avail_in -= (uInt)in.pos;
+            pfile_in_zip_read_info->stream.total_in += (uLong)in.pos;
+            pfile_in_zip_read_info->stream.next_out += uOutThis;
+            pfile_in_zip_read_info->stream.avail_out -= uOutThis;
+            pfile_in_zip_read_info->stream.total_out += uOutThis;
+
+            if ((pfile_in_zip_read_info->stream.avail_in == 0) &&
+                (pfile_in_zip_read_info->rest_read_compressed == 0))
+            {
+                /* a complete frame, or truncated data */
+                if (ret == 0)
+                    return (iRead==0) ? UNZ_EOF : iRead;
+                if ((uOutThis == 0) && (in.pos == 0))
+                {
+                    err = Z_DATA_ERROR;
+                    break;
+                }
+            }
+        }
+#endif
         else
         {
             uInt uAvailOutBefore,uAvailOutAfter;
@@ -1880,7 +2279,7 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
             pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
 
             pfile_in_zip_read_info->crc32
-                    = crc32(pfile_in_zip_read_info->crc32,bufBefore, uOutThis);
+                    = quazip_crc32(pfile_in_zip_read_info->crc32,bufBefore, uOutThis);
 
             pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
 
@@ -2013,9 +2412,51 @@ extern int ZEXPORT unzGetLocalExtrafield (unzFile file, voidp buf, unsigned len)
     return (int)read_now;
 }
 
+/*
+  Authenticate the rest of the AES-encrypted data of the current file,
+  if it wasn't all read, and compare the result with the code that
+  follows the data. Frees the decryption state.
+*/
+local int unz64local_CheckAesMac (file_in_zip64_read_info_s* pfile_in_zip_read_info)
+{
+    unsigned char mac[QUAZIP_AES_MAC_SIZE];
+    unsigned char stored_mac[QUAZIP_AES_MAC_SIZE];
+
+    if (ZSEEK64(pfile_in_zip_read_info->z_filefunc,
+                pfile_in_zip_read_info->filestream,
+                pfile_in_zip_read_info->pos_in_zipfile +
+                   pfile_in_zip_read_info->byte_before_the_zipfile,
+                ZLIB_FILEFUNC_SEEK_SET)!=0)
+        return UNZ_ERRNO;
+    while (pfile_in_zip_read_info->rest_read_compressed > 0)
+    {
+        uInt uReadThis = UNZ_BUFSIZE;
+        if (pfile_in_zip_read_info->rest_read_compressed < uReadThis)
+            uReadThis = (uInt)pfile_in_zip_read_info->rest_read_compressed;
+        if (ZREAD64(pfile_in_zip_read_info->z_filefunc,
+                    pfile_in_zip_read_info->filestream,
+                    pfile_in_zip_read_info->read_buffer,
+                    uReadThis)!=uReadThis)
+            return UNZ_ERRNO;
+        quazip_aes_decrypt(pfile_in_zip_read_info->aes,
+                           (unsigned char*)pfile_in_zip_read_info->read_buffer,
+                           uReadThis);
+        pfile_in_zip_read_info->pos_in_zipfile += uReadThis;
+        pfile_in_zip_read_info->rest_read_compressed -= uReadThis;
+    }
+    if (ZREAD64(pfile_in_zip_read_info->z_filefunc,
+                pfile_in_zip_read_info->filestream,
+                stored_mac, QUAZIP_AES_MAC_SIZE) != QUAZIP_AES_MAC_SIZE)
+        return UNZ_ERRNO;
+    quazip_aes_close(pfile_in_zip_read_info->aes, mac);
+    pfile_in_zip_read_info->aes = NULL;
+    return memcmp(mac, stored_mac, QUAZIP_AES_MAC_SIZE) == 0 ? UNZ_OK : UNZ_CRCERROR;
+}
+
 /*
   Close the file in zip opened with unzipOpenCurrentFile
-  Return UNZ_CRCERROR if all the file was read but the CRC is not good
+  Return UNZ_CRCERROR if all the file was read but the CRC is not good,
+  or if the authentication code of an AES-encrypted file is not good
 */
 extern int ZEXPORT unzCloseCurrentFile (unzFile file)
 {
@@ -2035,19 +2476,46 @@ extern int ZEXPORT unzCloseCurrentFile (unzFile file)
     if ((pfile_in_zip_read_info->rest_read_uncompressed == 0) &&
         (!pfile_in_zip_read_info->raw))
     {
-        if (pfile_in_zip_read_info->crc32 != pfile_in_zip_read_info->crc32_wait)
+        /* AE-2 stores no CRC, only the authentication code */
+        if ((pfile_in_zip_read_info->aes_version != QUAZIP_AES_AE2) &&
+            (pfile_in_zip_read_info->crc32 != pfile_in_zip_read_info->crc32_wait))
             err=UNZ_CRCERROR;
     }
 
+    if (pfile_in_zip_read_info->aes != NULL)
+    {
+        if (((pfile_in_zip_read_info->rest_read_uncompressed == 0) &&
+             (!pfile_in_zip_read_info->raw)) ||
+            ((pfile_in_zip_read_info->rest_read_compressed == 0) &&
+             (pfile_in_zip_read_info->stream.avail_in == 0)))
+        {
+            int mac_err = unz64local_CheckAesMac(pfile_in_zip_read_info);
+            if (err == UNZ_OK)
+                err = mac_err;
+        }
+        quazip_aes_close(pfile_in_zip_read_info->aes, NULL);
+        pfile_in_zip_read_info->aes = NULL;
+    }
+
 
     TRYFREE(pfile_in_zip_read_info->read_buffer);
     pfile_in_zip_read_info->read_buffer = NULL;
     if (pfile_in_zip_read_info->stream_initialised == Z_DEFLATED)
         inflateEnd(&pfile_in_zip_read_info->stream);
+    else if (pfile_in_zip_read_info->stream_initialised == Z_DEFLATE64)
+        inflate64Free(pfile_in_zip_read_info->i64state);
 #ifdef HAVE_BZIP2
     else if (pfile_in_zip_read_info->stream_initialised == Z_BZIP2ED)
         BZ2_bzDecompressEnd(&pfile_in_zip_read_info->bstream);
 #endif
+#ifdef HAVE_ZSTD
+    else if (pfile_in_zip_read_info->stream_initialised == Z_ZSTD)
+        ZSTD_freeDStream(pfile_in_zip_read_info->zstream);
+#endif
+#ifdef HAVE_LZMA
+    else if (pfile_in_zip_read_info->stream_initialised == Z_LZMA)
+        lzma_end(&pfile_in_zip_read_info->lstream);
+#endif
 
 
     pfile_in_zip_read_info->stream_initialised = 0;
@@ -52,9 +52,7 @@
 extern "C" {
 #endif
 
-#ifndef _ZLIB_H
-#include <zlib.h>
-#endif
+#include "quazip_zlib.h"
 
 #ifndef  _ZLIBIOAPI_H
 #include "ioapi.h"
@@ -65,6 +63,10 @@ extern "C" {
 #endif
 
 #define Z_BZIP2ED 12
+#define Z_ZSTD 93 /* needs HAVE_ZSTD, except in the raw mode */
+#define Z_LZMA 14 /* needs HAVE_LZMA, except in the raw mode */
+#define Z_XZ 95 /* needs HAVE_LZMA, except in the raw mode */
+#define Z_DEFLATE64 9 /* can only be read */
 
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
@@ -84,6 +86,7 @@ typedef voidp unzFile;
 #define UNZ_BADZIPFILE                  (-103)
 #define UNZ_INTERNALERROR               (-104)
 #define UNZ_CRCERROR                    (-105)
+#define UNZ_BADPASSWORD                 (-106)
 
 #define UNZ_AUTO_CLOSE 0x01u
 #define UNZ_DEFAULT_FLAGS UNZ_AUTO_CLOSE
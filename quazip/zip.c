@@ -33,12 +33,18 @@
 #include <string.h>
 #include <time.h>
 
-#include <zlib.h>
-#if (ZLIB_VERNUM < 0x1270)
-typedef uLongf z_crc_t;
-#endif
+#include "quazip_zlib.h"
+#include "quazip_crc32.h"
+#include "quazip_aes.h"
 #include "zip.h"
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
 #ifdef STDC
 #  include <stddef.h>
 #  include <string.h>
@@ -144,6 +150,13 @@ typedef struct
 #ifdef HAVE_BZIP2
     bz_stream bstream;          /* bzLib stream structure for bziped */
 #endif
+#ifdef HAVE_ZSTD
+    ZSTD_CStream *zstream;      /* zstd stream structure for method 93 */
+#endif
+#ifdef HAVE_LZMA
+    lzma_stream lstream;        /* liblzma stream structure for methods 14 and 95 */
+    lzma_options_lzma lzma_options;
+#endif
 
     int  stream_initialised;    /* 1 is stream is initialised */
     uInt pos_in_buffered_data;  /* last written byte in buffered_data */
@@ -166,11 +179,16 @@ typedef struct
     ZPOS64_T pos_zip64extrainfo;
     ZPOS64_T totalCompressedData;
     ZPOS64_T totalUncompressedData;
+    int  known_sizes;         /* 1 if the local header has the final values */
 #ifndef NOCRYPT
     unsigned long keys[3];     /* keys defining the pseudo-random sequence */
     const z_crc_t FAR * pcrc_32_tab;
     int crypt_header_size;
 #endif
+    quazip_aes* aes;           /* WinZip AES encryption, if used */
+    int aes_version;           /* AE-1 or AE-2, 0 if not encrypted with AES */
+    int aes_strength;
+    int aes_header_size;       /* the salt and the password verifier */
 } curfile64_info;
 
 typedef struct
@@ -191,6 +209,16 @@ typedef struct
 
     unsigned flags;
 
+    int known_sizes;          /* 1 if the values below apply to the next file */
+    uLong known_crc32;
+    ZPOS64_T known_compressed_size;
+    ZPOS64_T known_uncompressed_size;
+
+    int aes_strength;         /* see zipSetAesEncryption(), for the next file */
+    int aes_version;
+
+    int thread_count;         /* see zipSetThreadCount() */
+
 } zip64_internal;
 
 
@@ -896,6 +924,10 @@ extern zipFile ZEXPORT zipOpen3 (voidpf file, int append, zipcharpc* globalcomme
     ziinit.ci.stream_initialised = 0;
     ziinit.number_entry = 0;
     ziinit.add_position_when_writting_offset = 0;
+    ziinit.known_sizes = 0;
+    ziinit.aes_strength = 0;
+    ziinit.aes_version = 0;
+    ziinit.thread_count = 1;
     init_linkedlist(&(ziinit.central_dir));
 
 
@@ -979,6 +1011,21 @@ extern zipFile ZEXPORT zipOpen64 (voidpf file, int append)
     return zipOpen3(file,append,NULL,NULL, ZIP_DEFAULT_FLAGS);
 }
 
+/*
+ The WinZip AES extra field: the vendor version, the vendor ID "AE",
+ the key strength, and the actual compression method.
+ */
+local void zip64local_putAesExtra(const zip64_internal* zi, char* p)
+{
+  zip64local_putValue_inmemory(p, QUAZIP_AES_EXTRA_ID, 2);
+  zip64local_putValue_inmemory(p + 2, QUAZIP_AES_EXTRA_SIZE - 4, 2);
+  zip64local_putValue_inmemory(p + 4, (uLong)zi->ci.aes_version, 2);
+  p[6] = 'A';
+  p[7] = 'E';
+  p[8] = (char)zi->ci.aes_strength;
+  zip64local_putValue_inmemory(p + 9, (uLong)zi->ci.method, 2);
+}
+
 int Write_LocalFileHeader(zip64_internal* zi, const char* filename,
                           uInt size_extrafield_local,
                           const void* extrafield_local,
@@ -995,7 +1042,7 @@ int Write_LocalFileHeader(zip64_internal* zi, const char* filename,
   {
     if(zi->ci.flag & ZIP_ENCODING_UTF8)
       err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)63,2);/* Version 6.3 is required for Unicode support */
-    else if(zi->ci.zip64)
+    else if(zi->ci.zip64 && version_to_extract < 45)
       err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)45,2);/* version needed to extract */
     else
       err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)version_to_extract,2);
@@ -1005,27 +1052,32 @@ int Write_LocalFileHeader(zip64_internal* zi, const char* filename,
     err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)zi->ci.flag,2);
 
   if (err==ZIP_OK)
-    err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)zi->ci.method,2);
+    err = zip64local_putValue(&zi->z_filefunc,zi->filestream,
+                              zi->ci.aes_version != 0 ? (uLong)QUAZIP_AES_METHOD : (uLong)zi->ci.method,2);
 
   if (err==ZIP_OK)
     err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)zi->ci.dosDate,4);
 
-  /* CRC / Compressed size / Uncompressed size will be filled in later and rewritten later */
+  /* CRC / Compressed size / Uncompressed size will be filled in later and rewritten later,
+     unless they are known in advance */
   if (err==ZIP_OK)
-    err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)0,4); /* crc 32, unknown */
+    err = zip64local_putValue(&zi->z_filefunc,zi->filestream,
+                              zi->ci.known_sizes ? zi->known_crc32 : (uLong)0,4); /* crc 32 */
   if (err==ZIP_OK)
   {
     if(zi->ci.zip64)
-      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)0xFFFFFFFF,4); /* compressed size, unknown */
+      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)0xFFFFFFFF,4); /* compressed size, in the extra field */
     else
-      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)0,4); /* compressed size, unknown */
+      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,
+                                zi->ci.known_sizes ? zi->known_compressed_size : 0,4); /* compressed size */
   }
   if (err==ZIP_OK)
   {
     if(zi->ci.zip64)
-      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)0xFFFFFFFF,4); /* uncompressed size, unknown */
+      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)0xFFFFFFFF,4); /* uncompressed size, in the extra field */
     else
-      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)0,4); /* uncompressed size, unknown */
+      err = zip64local_putValue(&zi->z_filefunc,zi->filestream,
+                                zi->ci.known_sizes ? zi->known_uncompressed_size : 0,4); /* uncompressed size */
   }
 
   if (err==ZIP_OK)
@@ -1035,6 +1087,8 @@ int Write_LocalFileHeader(zip64_internal* zi, const char* filename,
   {
     size_extrafield += 20;
   }
+  if (zi->ci.aes_version != 0)
+    size_extrafield += QUAZIP_AES_EXTRA_SIZE;
 
   if (err==ZIP_OK)
     err = zip64local_putValue(&zi->z_filefunc,zi->filestream,(uLong)size_extrafield,2);
@@ -1051,14 +1105,21 @@ int Write_LocalFileHeader(zip64_internal* zi, const char* filename,
       err = ZIP_ERRNO;
   }
 
+  if ((err==ZIP_OK) && (zi->ci.aes_version != 0))
+  {
+    char aesExtra[QUAZIP_AES_EXTRA_SIZE];
+    zip64local_putAesExtra(zi, aesExtra);
+    if (ZWRITE64(zi->z_filefunc, zi->filestream, aesExtra, QUAZIP_AES_EXTRA_SIZE) != QUAZIP_AES_EXTRA_SIZE)
+      err = ZIP_ERRNO;
+  }
 
   if ((err==ZIP_OK) && (zi->ci.zip64))
   {
       /* write the Zip64 extended info */
       short HeaderID = 1;
       short DataSize = 16;
-      ZPOS64_T CompressedSize = 0;
-      ZPOS64_T UncompressedSize = 0;
+      ZPOS64_T CompressedSize = zi->ci.known_sizes ? zi->known_compressed_size : 0;
+      ZPOS64_T UncompressedSize = zi->ci.known_sizes ? zi->known_uncompressed_size : 0;
 
       /* Remember position of Zip64 extended info for the local file header. (needed when we update size after done with file) */
       zi->ci.pos_zip64extrainfo = ZTELL64(zi->z_filefunc,zi->filestream);
@@ -1073,6 +1134,66 @@ int Write_LocalFileHeader(zip64_internal* zi, const char* filename,
   return err;
 }
 
+#ifdef HAVE_LZMA
+/*
+ Starts the LZMA (14) or XZ (95) stream of the current file. LZMA data
+ starts with the LZMA SDK version (2 bytes), the size of the properties
+ (2 bytes) and the properties themselves (5 bytes), which are placed in
+ buffered_data so they are encrypted along with the rest.
+ */
+local int zip64local_initLzma(zip64_internal* zi, int level)
+{
+    lzma_stream init = LZMA_STREAM_INIT;
+    uint32_t preset;
+    lzma_ret ret;
+
+    if (level > 9)
+        return ZIP_PARAMERROR;
+    preset = level < 0 ? LZMA_PRESET_DEFAULT : (uint32_t)level;
+    zi->ci.lstream = init;
+    if (zi->ci.method == Z_LZMA)
+    {
+        lzma_filter filters[2];
+        uint32_t props_size;
+        if (lzma_lzma_preset(&zi->ci.lzma_options, preset))
+            return ZIP_PARAMERROR;
+        filters[0].id = LZMA_FILTER_LZMA1;
+        filters[0].options = &zi->ci.lzma_options;
+        filters[1].id = LZMA_VLI_UNKNOWN;
+        filters[1].options = NULL;
+        if ((lzma_properties_size(&props_size, &filters[0]) != LZMA_OK) || (props_size != 5))
+            return ZIP_INTERNALERROR;
+        zi->ci.buffered_data[0] = (Byte)LZMA_VERSION_MAJOR;
+        zi->ci.buffered_data[1] = (Byte)LZMA_VERSION_MINOR;
+        zi->ci.buffered_data[2] = (Byte)props_size;
+        zi->ci.buffered_data[3] = 0;
+        if (lzma_properties_encode(&filters[0], zi->ci.buffered_data + 4) != LZMA_OK)
+            return ZIP_INTERNALERROR;
+        zi->ci.pos_in_buffered_data = 4 + props_size;
+        ret = lzma_raw_encoder(&zi->ci.lstream, filters);
+    }
+    else if (zi->thread_count > 1)
+    {
+        lzma_mt mt;
+        memset(&mt, 0, sizeof(mt));
+        mt.threads = (uint32_t)zi->thread_count;
+        mt.preset = preset;
+        mt.check = LZMA_CHECK_CRC32;
+        ret = lzma_stream_encoder_mt(&zi->ci.lstream, &mt);
+    }
+    else
+    {
+        ret = lzma_easy_encoder(&zi->ci.lstream, preset, LZMA_CHECK_CRC32);
+    }
+    if (ret == LZMA_OPTIONS_ERROR)
+        return ZIP_PARAMERROR;
+    if (ret != LZMA_OK)
+        return ZIP_INTERNALERROR;
+    zi->ci.stream_initialised = zi->ci.method;
+    return ZIP_OK;
+}
+#endif
+
 /*
  NOTE.
  When writing RAW the ZIP64 extended information in extrafield_local and extrafield_global needs to be stripped
@@ -1095,24 +1216,54 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     uInt i;
     int err = ZIP_OK;
     uLong version_to_extract;
+    int known_sizes;
+    int aes_strength;
+    uInt size_aes_extra;
+
+    if (file == NULL)
+        return ZIP_PARAMERROR;
+
+    /* the sizes set by zipSetKnownSizes() only apply to this file */
+    zi = (zip64_internal*)file;
+    known_sizes = zi->known_sizes && raw && password == NULL;
+    zi->known_sizes = 0;
+    /* and so does the AES encryption set by zipSetAesEncryption() */
+    aes_strength = password != NULL ? zi->aes_strength : 0;
+    zi->aes_strength = 0;
+    size_aes_extra = aes_strength != 0 ? QUAZIP_AES_EXTRA_SIZE : 0;
 
 #    ifdef NOCRYPT
     if (password != NULL)
         return ZIP_PARAMERROR;
 #    endif
 
-    if (file == NULL)
-        return ZIP_PARAMERROR;
-
 #ifdef HAVE_BZIP2
-    if ((method!=0) && (method!=Z_DEFLATED) && (method!=Z_BZIP2ED))
+    if ((method!=0) && (method!=Z_DEFLATED) && (method!=Z_BZIP2ED) && (method!=Z_ZSTD)
+        && (method!=Z_LZMA) && (method!=Z_XZ) && (method!=Z_DEFLATE64)
+        && (method!=QUAZIP_AES_METHOD))
       return ZIP_PARAMERROR;
 #else
-    if ((method!=0) && (method!=Z_DEFLATED))
+    if ((method!=0) && (method!=Z_DEFLATED) && (method!=Z_ZSTD)
+        && (method!=Z_LZMA) && (method!=Z_XZ) && (method!=Z_DEFLATE64)
+        && (method!=QUAZIP_AES_METHOD))
+      return ZIP_PARAMERROR;
+#endif
+    /* AES-encrypted data can only be copied as is, along with its extra
+       field; the actual method is used to encrypt with AES */
+    if ((method==QUAZIP_AES_METHOD) && ((!raw) || (password != NULL)))
+      return ZIP_PARAMERROR;
+    /* there is no Deflate64 compressor, the data can only be copied as is */
+    if ((method==Z_DEFLATE64) && (!raw))
+      return ZIP_PARAMERROR;
+#ifndef HAVE_ZSTD
+    /* without libzstd, zstd data can only be copied as is */
+    if ((method==Z_ZSTD) && (!raw))
+      return ZIP_PARAMERROR;
+#endif
+#ifndef HAVE_LZMA
+    if (((method==Z_LZMA) || (method==Z_XZ)) && (!raw))
       return ZIP_PARAMERROR;
 #endif
-
-    zi = (zip64_internal*)file;
 
     if (zi->in_opened_file_inzip == 1)
     {
@@ -1122,15 +1273,30 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     }
 
     if (method == 0
-            && (level == 0 || (zi->flags & ZIP_WRITE_DATA_DESCRIPTOR) == 0)
-            && (zi->flags & ZIP_SEQUENTIAL) == 0)
+            && (level == 0 || (zi->flags & ZIP_WRITE_DATA_DESCRIPTOR) == 0
+                || known_sizes)
+            && ((zi->flags & ZIP_SEQUENTIAL) == 0 || known_sizes))
     {
         version_to_extract = 10;
     }
+    else if (method == Z_BZIP2ED)
+    {
+        version_to_extract = 46;
+    }
+    else if ((method == Z_ZSTD) || (method == Z_LZMA) || (method == Z_XZ))
+    {
+        version_to_extract = 63;
+    }
+    else if (method == Z_DEFLATE64)
+    {
+        version_to_extract = 21;
+    }
     else
     {
         version_to_extract = 20;
     }
+    if ((aes_strength != 0 || method == QUAZIP_AES_METHOD) && version_to_extract < 51)
+        version_to_extract = 51;
 
     if (filename==NULL)
         filename="-";
@@ -1155,15 +1321,22 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     zi->ci.flag = flagBase;
     if (zi->flags & ZIP_ENCODING_UTF8)
         zi->ci.flag |= ZIP_ENCODING_UTF8;
-    if ((level==8) || (level==9))
+    /* these flags describe deflate levels only */
+    if ((method == 0) || (method == Z_DEFLATED))
+    {
+      if ((level==8) || (level==9))
+        zi->ci.flag |= 2;
+      if (level==2)
+        zi->ci.flag |= 4;
+      if (level==1)
+        zi->ci.flag |= 6;
+    }
+    /* our LZMA streams always end with the end of stream marker */
+    if ((method == Z_LZMA) && (!raw))
       zi->ci.flag |= 2;
-    if (level==2)
-      zi->ci.flag |= 4;
-    if (level==1)
-      zi->ci.flag |= 6;
-    if (password != NULL)
+    if (password != NULL || method == QUAZIP_AES_METHOD)
       zi->ci.flag |= 1;
-    if (version_to_extract >= 20
+    if (version_to_extract >= 20 && !known_sizes
             && ((zi->flags & ZIP_WRITE_DATA_DESCRIPTOR) != 0
                 || (zi->flags & ZIP_SEQUENTIAL) != 0))
       zi->ci.flag |= 8;
@@ -1171,12 +1344,17 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     zi->ci.crc32 = 0;
     zi->ci.method = method;
     zi->ci.encrypt = 0;
+    zi->ci.aes = NULL;
+    zi->ci.aes_strength = aes_strength;
+    zi->ci.aes_version = aes_strength != 0 ? zi->aes_version : 0;
+    zi->ci.aes_header_size = 0;
     zi->ci.stream_initialised = 0;
     zi->ci.pos_in_buffered_data = 0;
     zi->ci.raw = raw;
     zi->ci.pos_local_header = ZTELL64(zi->z_filefunc,zi->filestream);
 
-    zi->ci.size_centralheader = SIZECENTRALHEADER + size_filename + size_extrafield_global + size_comment;
+    zi->ci.size_centralheader = SIZECENTRALHEADER + size_filename + size_extrafield_global
+                                + size_aes_extra + size_comment;
     zi->ci.size_centralExtraFree = 32; /* Extra space we have reserved in case we need to add ZIP64 extra info data */
 
     zi->ci.central_header = (char*)ALLOC((uInt)zi->ci.size_centralheader + zi->ci.size_centralExtraFree);
@@ -1184,19 +1362,20 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
       return (Z_MEM_ERROR);
     }
 
-    zi->ci.size_centralExtra = size_extrafield_global;
+    zi->ci.size_centralExtra = size_extrafield_global + size_aes_extra;
     zip64local_putValue_inmemory(zi->ci.central_header,(uLong)CENTRALHEADERMAGIC,4);
     /* version info */
     zip64local_putValue_inmemory(zi->ci.central_header+4,(uLong)versionMadeBy,2);
     zip64local_putValue_inmemory(zi->ci.central_header+6,(uLong)version_to_extract,2);
     zip64local_putValue_inmemory(zi->ci.central_header+8,(uLong)zi->ci.flag,2);
-    zip64local_putValue_inmemory(zi->ci.central_header+10,(uLong)zi->ci.method,2);
+    zip64local_putValue_inmemory(zi->ci.central_header+10,
+                                 zi->ci.aes_version != 0 ? (uLong)QUAZIP_AES_METHOD : (uLong)zi->ci.method,2);
     zip64local_putValue_inmemory(zi->ci.central_header+12,(uLong)zi->ci.dosDate,4);
     zip64local_putValue_inmemory(zi->ci.central_header+16,(uLong)0,4); /*crc*/
     zip64local_putValue_inmemory(zi->ci.central_header+20,(uLong)0,4); /*compr size*/
     zip64local_putValue_inmemory(zi->ci.central_header+24,(uLong)0,4); /*uncompr size*/
     zip64local_putValue_inmemory(zi->ci.central_header+28,(uLong)size_filename,2);
-    zip64local_putValue_inmemory(zi->ci.central_header+30,(uLong)size_extrafield_global,2);
+    zip64local_putValue_inmemory(zi->ci.central_header+30,(uLong)zi->ci.size_centralExtra,2);
     zip64local_putValue_inmemory(zi->ci.central_header+32,(uLong)size_comment,2);
     zip64local_putValue_inmemory(zi->ci.central_header+34,(uLong)0,2); /*disk nm start*/
 
@@ -1222,9 +1401,13 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
         *(zi->ci.central_header+SIZECENTRALHEADER+size_filename+i) =
               *(((const char*)extrafield_global)+i);
 
+    if (size_aes_extra != 0)
+        zip64local_putAesExtra(zi, zi->ci.central_header+SIZECENTRALHEADER+size_filename+
+                               size_extrafield_global);
+
     for (i=0;i<size_comment;i++)
         *(zi->ci.central_header+SIZECENTRALHEADER+size_filename+
-              size_extrafield_global+i) = *(comment+i);
+              size_extrafield_global+size_aes_extra+i) = *(comment+i);
     if (zi->ci.central_header == NULL)
         return ZIP_INTERNALERROR;
 
@@ -1232,6 +1415,7 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     zi->ci.totalCompressedData = 0;
     zi->ci.totalUncompressedData = 0;
     zi->ci.pos_zip64extrainfo = 0;
+    zi->ci.known_sizes = known_sizes;
 
     err = Write_LocalFileHeader(zi, filename, size_extrafield_local,
                                 extrafield_local, version_to_extract);
@@ -1281,17 +1465,70 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
           zi->ci.bstream.bzfree = 0;
           zi->ci.bstream.opaque = (voidpf)0;
 
-          err = BZ2_bzCompressInit(&zi->ci.bstream, level, 0,35);
+          /* the block size, 9 (900k) by default */
+          if (level < 1)
+            level = 9;
+          if (level > 9)
+            err = ZIP_PARAMERROR;
+          else
+            err = BZ2_bzCompressInit(&zi->ci.bstream, level, 0,35);
           if(err == BZ_OK)
             zi->ci.stream_initialised = Z_BZIP2ED;
+          else if (err != ZIP_PARAMERROR)
+            err = ZIP_INTERNALERROR;
 #endif
         }
 
     }
+#ifdef HAVE_ZSTD
+    else if ((err==ZIP_OK) && (zi->ci.method == Z_ZSTD) && (!zi->ci.raw))
+    {
+        /* zstd's fast levels are negative, but -1 is Z_DEFAULT_COMPRESSION,
+           and 0 is zstd's default level anyway */
+        zi->ci.zstream = ZSTD_createCStream();
+        if (zi->ci.zstream == NULL)
+            err = ZIP_INTERNALERROR;
+        else if (ZSTD_isError(ZSTD_initCStream(zi->ci.zstream, level < 0 ? 0 : level)))
+        {
+            ZSTD_freeCStream(zi->ci.zstream);
+            zi->ci.zstream = NULL;
+            err = ZIP_PARAMERROR;
+        }
+        else
+            zi->ci.stream_initialised = Z_ZSTD;
+    }
+#endif
+#ifdef HAVE_LZMA
+    else if ((err==ZIP_OK) && ((zi->ci.method == Z_LZMA) || (zi->ci.method == Z_XZ)) && (!zi->ci.raw))
+    {
+        err = zip64local_initLzma(zi, level);
+    }
+#endif
 
 #    ifndef NOCRYPT
     zi->ci.crypt_header_size = 0;
-    if ((err==Z_OK) && (password != NULL))
+    if ((err==Z_OK) && (aes_strength != 0))
+    {
+        /* the salt and the password verification value precede the data */
+        unsigned char bufHead[QUAZIP_AES_MAX_SALT_SIZE + QUAZIP_AES_PWV_SIZE];
+        int sizeSalt = quazip_aes_salt_size(aes_strength);
+        if (quazip_aes_random(bufHead, (size_t)sizeSalt) != 0)
+            err = ZIP_INTERNALERROR;
+        if (err==ZIP_OK)
+        {
+            zi->ci.aes = quazip_aes_open(aes_strength, password, bufHead, bufHead + sizeSalt);
+            if (zi->ci.aes == NULL)
+                err = ZIP_INTERNALERROR;
+        }
+        if (err==ZIP_OK)
+        {
+            zi->ci.encrypt = 1;
+            zi->ci.aes_header_size = sizeSalt + QUAZIP_AES_PWV_SIZE;
+            if (ZWRITE64(zi->z_filefunc,zi->filestream,bufHead,(uLong)zi->ci.aes_header_size) != (uLong)zi->ci.aes_header_size)
+                err = ZIP_ERRNO;
+        }
+    }
+    else if ((err==Z_OK) && (password != NULL))
     {
         unsigned char bufHead[RAND_HEAD_LEN];
         unsigned int sizeHead;
@@ -1416,7 +1653,11 @@ local int zip64FlushWriteBuffer(zip64_internal* zi)
 {
     int err=ZIP_OK;
 
-    if (zi->ci.encrypt != 0)
+    if (zi->ci.aes != NULL)
+    {
+        quazip_aes_encrypt(zi->ci.aes, zi->ci.buffered_data, zi->ci.pos_in_buffered_data);
+    }
+    else if (zi->ci.encrypt != 0)
     {
 #ifndef NOCRYPT
         uInt i;
@@ -1463,7 +1704,7 @@ extern int ZEXPORT zipWriteInFileInZip (zipFile file,const void* buf,unsigned in
     if (zi->in_opened_file_inzip == 0)
         return ZIP_PARAMERROR;
 
-    zi->ci.crc32 = crc32(zi->ci.crc32,buf,(uInt)len);
+    zi->ci.crc32 = quazip_crc32(zi->ci.crc32,buf,(uInt)len);
 
 #ifdef HAVE_BZIP2
     if(zi->ci.method == Z_BZIP2ED && (!zi->ci.raw))
@@ -1501,6 +1742,74 @@ extern int ZEXPORT zipWriteInFileInZip (zipFile file,const void* buf,unsigned in
     }
     else
 #endif
+#ifdef HAVE_ZSTD
+    if ((zi->ci.method == Z_ZSTD) && (!zi->ci.raw))
+    {
+      ZSTD_inBuffer in;
+      in.src = buf;
+      in.size = len;
+      in.pos = 0;
+
+      while ((err==ZIP_OK) && (in.pos < in.size))
+      {
+        ZSTD_outBuffer out;
+        size_t ret;
+        if (zi->ci.pos_in_buffered_data == Z_BUFSIZE)
+        {
+          if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
+          {
+            err = ZIP_ERRNO;
+            break;
+          }
+        }
+        out.dst = zi->ci.buffered_data;
+        out.size = Z_BUFSIZE;
+        out.pos = zi->ci.pos_in_buffered_data;
+        ret = ZSTD_compressStream2(zi->ci.zstream, &out, &in, ZSTD_e_continue);
+        if (ZSTD_isError(ret))
+          err = ZIP_INTERNALERROR;
+        zi->ci.pos_in_buffered_data = (uInt)out.pos;
+      }
+      zi->ci.totalUncompressedData += in.pos;
+    }
+    else
+#endif
+#ifdef HAVE_LZMA
+    if (((zi->ci.method == Z_LZMA) || (zi->ci.method == Z_XZ)) && (!zi->ci.raw))
+    {
+      zi->ci.lstream.next_in = (const uint8_t*)buf;
+      zi->ci.lstream.avail_in = len;
+
+      while ((err==ZIP_OK) && (zi->ci.lstream.avail_in > 0))
+      {
+        if (zi->ci.pos_in_buffered_data == Z_BUFSIZE)
+        {
+          if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
+          {
+            err = ZIP_ERRNO;
+            break;
+          }
+        }
+        zi->ci.lstream.next_out = zi->ci.buffered_data + zi->ci.pos_in_buffered_data;
+        zi->ci.lstream.avail_out = Z_BUFSIZE - zi->ci.pos_in_buffered_data;
+        if (lzma_code(&zi->ci.lstream, LZMA_RUN) != LZMA_OK)
+          err = ZIP_INTERNALERROR;
+        zi->ci.pos_in_buffered_data = Z_BUFSIZE - (uInt)zi->ci.lstream.avail_out;
+      }
+      zi->ci.totalUncompressedData += len - zi->ci.lstream.avail_in;
+    }
+    else
+#endif
+    if (((zi->ci.method == 0) || (zi->ci.raw)) && (zi->ci.encrypt == 0)
+            && (zi->ci.pos_in_buffered_data == 0) && (len >= Z_BUFSIZE))
+    {
+      /* nothing to compress or encrypt, skip the buffer */
+      if (ZWRITE64(zi->z_filefunc,zi->filestream,buf,len) != len)
+        err = ZIP_ERRNO;
+      zi->ci.totalCompressedData += len;
+      zi->ci.totalUncompressedData += len;
+    }
+    else
     {
       zi->ci.stream.next_in = (Bytef*)buf;
       zi->ci.stream.avail_in = len;
@@ -1527,15 +1836,13 @@ extern int ZEXPORT zipWriteInFileInZip (zipFile file,const void* buf,unsigned in
           }
           else
           {
-              uInt copy_this,i;
+              uInt copy_this;
               if (zi->ci.stream.avail_in < zi->ci.stream.avail_out)
                   copy_this = zi->ci.stream.avail_in;
               else
                   copy_this = zi->ci.stream.avail_out;
 
-              for (i = 0; i < copy_this; i++)
-                  *(((char*)zi->ci.stream.next_out)+i) =
-                      *(((const char*)zi->ci.stream.next_in)+i);
+              memcpy(zi->ci.stream.next_out, zi->ci.stream.next_in, copy_this);
               {
                   zi->ci.stream.avail_in -= copy_this;
                   zi->ci.stream.avail_out-= copy_this;
@@ -1616,6 +1923,59 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
         err = ZIP_OK;
 #endif
     }
+#ifdef HAVE_ZSTD
+    else if ((zi->ci.method == Z_ZSTD) && (!zi->ci.raw))
+    {
+      ZSTD_inBuffer in;
+      size_t remaining = 1;
+      in.src = NULL;
+      in.size = 0;
+      in.pos = 0;
+      while ((err==ZIP_OK) && (remaining != 0))
+      {
+        ZSTD_outBuffer out;
+        if (zi->ci.pos_in_buffered_data == Z_BUFSIZE)
+        {
+          if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
+          {
+            err = ZIP_ERRNO;
+            break;
+          }
+        }
+        out.dst = zi->ci.buffered_data;
+        out.size = Z_BUFSIZE;
+        out.pos = zi->ci.pos_in_buffered_data;
+        remaining = ZSTD_compressStream2(zi->ci.zstream, &out, &in, ZSTD_e_end);
+        if (ZSTD_isError(remaining))
+          err = ZIP_INTERNALERROR;
+        zi->ci.pos_in_buffered_data = (uInt)out.pos;
+      }
+    }
+#endif
+#ifdef HAVE_LZMA
+    else if (((zi->ci.method == Z_LZMA) || (zi->ci.method == Z_XZ)) && (!zi->ci.raw))
+    {
+      lzma_ret ret = LZMA_OK;
+      zi->ci.lstream.avail_in = 0;
+      while ((err==ZIP_OK) && (ret != LZMA_STREAM_END))
+      {
+        if (zi->ci.pos_in_buffered_data == Z_BUFSIZE)
+        {
+          if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
+          {
+            err = ZIP_ERRNO;
+            break;
+          }
+        }
+        zi->ci.lstream.next_out = zi->ci.buffered_data + zi->ci.pos_in_buffered_data;
+        zi->ci.lstream.avail_out = Z_BUFSIZE - zi->ci.pos_in_buffered_data;
+        ret = lzma_code(&zi->ci.lstream, LZMA_FINISH);
+        if ((ret != LZMA_OK) && (ret != LZMA_STREAM_END))
+          err = ZIP_INTERNALERROR;
+        zi->ci.pos_in_buffered_data = Z_BUFSIZE - (uInt)zi->ci.lstream.avail_out;
+      }
+    }
+#endif
 
     if (err==Z_STREAM_END)
         err=ZIP_OK; /* this is normal */
@@ -1626,6 +1986,16 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
             err = ZIP_ERRNO;
                 }
 
+    if (zi->ci.aes != NULL)
+    {
+        /* the authentication code follows the encrypted data */
+        unsigned char mac[QUAZIP_AES_MAC_SIZE];
+        quazip_aes_close(zi->ci.aes, mac);
+        zi->ci.aes = NULL;
+        if ((err==ZIP_OK) && (ZWRITE64(zi->z_filefunc,zi->filestream,mac,QUAZIP_AES_MAC_SIZE) != QUAZIP_AES_MAC_SIZE))
+            err = ZIP_ERRNO;
+    }
+
     if ((zi->ci.method == Z_DEFLATED) && (!zi->ci.raw))
     {
         int tmp_err = deflateEnd(&zi->ci.stream);
@@ -1642,6 +2012,21 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
                         zi->ci.stream_initialised = 0;
     }
 #endif
+#ifdef HAVE_ZSTD
+    else if((zi->ci.method == Z_ZSTD) && (!zi->ci.raw))
+    {
+      ZSTD_freeCStream(zi->ci.zstream);
+      zi->ci.zstream = NULL;
+      zi->ci.stream_initialised = 0;
+    }
+#endif
+#ifdef HAVE_LZMA
+    else if(((zi->ci.method == Z_LZMA) || (zi->ci.method == Z_XZ)) && (!zi->ci.raw))
+    {
+      lzma_end(&zi->ci.lstream);
+      zi->ci.stream_initialised = 0;
+    }
+#endif
 
     if (!zi->ci.raw)
     {
@@ -1653,6 +2038,13 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
 #    ifndef NOCRYPT
     compressed_size += zi->ci.crypt_header_size;
 #    endif
+    if (zi->ci.aes_version != 0)
+    {
+        compressed_size += zi->ci.aes_header_size + QUAZIP_AES_MAC_SIZE;
+        /* AE-2 relies on the authentication code alone */
+        if (zi->ci.aes_version == QUAZIP_AES_AE2)
+            crc32 = 0;
+    }
 
     /* update Current Item crc and sizes, */
     if(compressed_size >= 0xffffffff || uncompressed_size >= 0xffffffff || zi->ci.pos_local_header >= 0xffffffff)
@@ -1660,7 +2052,10 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
       /*version Made by*/
       zip64local_putValue_inmemory(zi->ci.central_header+4,(uLong)45,2);
       /*version needed*/
-      zip64local_putValue_inmemory(zi->ci.central_header+6,(uLong)((zi->ci.flag & ZIP_ENCODING_UTF8) ? 63 : 45),2);
+      zip64local_putValue_inmemory(zi->ci.central_header+6,(uLong)(((zi->ci.flag & ZIP_ENCODING_UTF8) || zi->ci.method == Z_ZSTD
+                                                            || zi->ci.method == Z_LZMA || zi->ci.method == Z_XZ) ? 63
+                                                           : (zi->ci.aes_version != 0 || zi->ci.method == QUAZIP_AES_METHOD) ? 51
+                                                           : zi->ci.method == Z_BZIP2ED ? 46 : 45),2);
     }
 
     zip64local_putValue_inmemory(zi->ci.central_header+16,crc32,4); /*crc*/
@@ -1744,9 +2139,19 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
 
     TRYFREE(zi->ci.central_header);
 
+    if (zi->ci.known_sizes
+            && (crc32 != zi->known_crc32
+                || compressed_size != zi->known_compressed_size
+                || uncompressed_size != zi->known_uncompressed_size))
+    {
+        /* the local header is already written with wrong values */
+        if (err==ZIP_OK)
+            err = ZIP_PARAMERROR;
+    }
+
     if (err==ZIP_OK)
     {
-        if ((zi->flags & ZIP_SEQUENTIAL) == 0) {
+        if ((zi->flags & ZIP_SEQUENTIAL) == 0 && !zi->ci.known_sizes) {
             /* Update the LocalFileHeader with the new values. */
 
             ZPOS64_T cur_pos_inzip = ZTELL64(zi->z_filefunc,zi->filestream);
@@ -2082,6 +2487,53 @@ extern int ZEXPORT zipRemoveExtraInfoBlock (char* pData, int* dataLen, short sHe
   return retVal;
 }
 
+int ZEXPORT zipSetKnownSizes(zipFile file, uLong crc32,
+                             ZPOS64_T compressed_size,
+                             ZPOS64_T uncompressed_size)
+{
+    zip64_internal* zi;
+    if (file == NULL)
+        return ZIP_PARAMERROR;
+    zi = (zip64_internal*)file;
+    zi->known_sizes = 1;
+    zi->known_crc32 = crc32;
+    zi->known_compressed_size = compressed_size;
+    zi->known_uncompressed_size = uncompressed_size;
+    return ZIP_OK;
+}
+
+int ZEXPORT zipSetAesEncryption(zipFile file, int strength, int version)
+{
+    zip64_internal* zi;
+    if (file == NULL)
+        return ZIP_PARAMERROR;
+    if (strength != 0 && quazip_aes_salt_size(strength) == 0)
+        return ZIP_PARAMERROR;
+    if (version != QUAZIP_AES_AE1 && version != QUAZIP_AES_AE2)
+        return ZIP_PARAMERROR;
+    zi = (zip64_internal*)file;
+    zi->aes_strength = strength;
+    zi->aes_version = version;
+    return ZIP_OK;
+}
+
+int ZEXPORT zipSetThreadCount(zipFile file, int threads)
+{
+    zip64_internal* zi;
+    if (file == NULL)
+        return ZIP_PARAMERROR;
+    zi = (zip64_internal*)file;
+    zi->thread_count = threads < 1 ? 1 : threads;
+    return ZIP_OK;
+}
+
+int ZEXPORT zipGetThreadCount(zipFile file)
+{
+    if (file == NULL)
+        return ZIP_PARAMERROR;
+    return ((zip64_internal*)file)->thread_count;
+}
+
 int ZEXPORT zipSetFlags(zipFile file, unsigned flags)
 {
     zip64_internal* zi;
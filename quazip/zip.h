@@ -52,9 +52,7 @@ extern "C" {
 
 //#define HAVE_BZIP2
 
-#ifndef _ZLIB_H
-#include <zlib.h>
-#endif
+#include "quazip_zlib.h"
 
 #ifndef _ZLIBIOAPI_H
 #include "ioapi.h"
@@ -65,6 +63,10 @@ extern "C" {
 #endif
 
 #define Z_BZIP2ED 12
+#define Z_ZSTD 93 /* needs HAVE_ZSTD, except in the raw mode */
+#define Z_LZMA 14 /* needs HAVE_LZMA, except in the raw mode */
+#define Z_XZ 95 /* needs HAVE_LZMA, except in the raw mode */
+#define Z_DEFLATE64 9 /* can only be copied in the raw mode */
 
 #if defined(STRICTZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
@@ -384,6 +386,41 @@ extern int ZEXPORT zipRemoveExtraInfoBlock OF((char* pData, int* dataLen, short
 extern int ZEXPORT zipSetFlags(zipFile file, unsigned flags);
 extern int ZEXPORT zipClearFlags(zipFile file, unsigned flags);
 
+/*
+  Sets the CRC and the sizes of the next file, which must be opened
+  in the raw mode without a password. Its local header is then written
+  with the final values right away: no data descriptor is written, and
+  the header isn't updated when the file is closed, which also works
+  for non-seekable outputs. zipCloseFileInZipRaw returns ZIP_PARAMERROR
+  if the values turn out to be different.
+*/
+extern int ZEXPORT zipSetKnownSizes(zipFile file, uLong crc32,
+                                    ZPOS64_T compressed_size,
+                                    ZPOS64_T uncompressed_size);
+
+/*
+  Makes the next file, if it is opened with a password, encrypted with
+  WinZip AES instead of the traditional PKWARE encryption. The strength
+  is 1, 2 or 3 for AES-128, AES-192 and AES-256, 0 for the traditional
+  encryption. The version is 1 for AE-1, which stores the CRC like the
+  other methods, or 2 for AE-2, which stores 0 instead and relies on
+  the authentication code alone. The header of such a file has method 99,
+  and the actual method is stored in an extra field.
+*/
+extern int ZEXPORT zipSetAesEncryption(zipFile file, int strength,
+                                       int version);
+
+/*
+  Sets the number of threads used to compress the next files of this zip
+  file with the XZ method. 1, the default, compresses in the calling
+  thread. The data is split into blocks of several megabytes, so small
+  files are compressed by one thread anyway. The LZMA method is always
+  single-threaded, as its data is a single stream.
+*/
+extern int ZEXPORT zipSetThreadCount(zipFile file, int threads);
+/* Returns the number of threads set by zipSetThreadCount(). */
+extern int ZEXPORT zipGetThreadCount(zipFile file);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,12 +26,19 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include "testquazip.h"
 #include "testquazipfile.h"
 #include "testquachecksum32.h"
+#include "testquachecksumiodevice.h"
+#include "testquaparallelchecksum.h"
 #include "testjlcompress.h"
 #include "testquazipdir.h"
 #include "testquagzipfile.h"
 #include "testquaziodevice.h"
 #include "testquazipnewinfo.h"
 #include "testquazipfileinfo.h"
+#include "testquazipstreamreader.h"
+#include "testquazipasyncwriter.h"
+#include "testquazipbatchbuilder.h"
+#include "testquazipmemorydevice.h"
+#include "testquazipcodec.h"
 
 #include <quazip.h>
 #include <quazipfile.h>
@@ -83,6 +90,30 @@ bool createTestFiles(const QStringList &fileNames, int size, const QString &dir)
     return true;
 }
 
+QByteArray compressibleData(int size)
+{
+    // numbers that only repeat after a while, compressing like text
+    QByteArray data;
+    data.reserve(size + 16);
+    for (int i = 0; data.size() < size; ++i) {
+        data.append(QByteArray::number(i % 100003 * 7919 % 100003));
+        data.append(i % 16 == 15 ? '\n' : ' ');
+    }
+    data.truncate(size);
+    return data;
+}
+
+QByteArray randomData(int size, quint32 seed)
+{
+    // a simple LCG is enough to get data that deflate can't shrink
+    QByteArray data(size, '\0');
+    for (int i = 0; i < size; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = static_cast<char>(seed >> 24);
+    }
+    return data;
+}
+
 bool createTestArchive(QuaZip &zip, const QString &zipName,
                        const QStringList &fileNames,
                        QTextCodec *codec,
@@ -205,6 +236,14 @@ int main(int argc, char **argv)
         TestQuaChecksum32 testQuaChecksum32;
         err = qMax(err, QTest::qExec(&testQuaChecksum32, app.arguments()));
     }
+    {
+        TestQuaChecksumIODevice testQuaChecksumIODevice;
+        err = qMax(err, QTest::qExec(&testQuaChecksumIODevice, app.arguments()));
+    }
+    {
+        TestQuaParallelChecksum testQuaParallelChecksum;
+        err = qMax(err, QTest::qExec(&testQuaParallelChecksum, app.arguments()));
+    }
     {
         TestJlCompress testJlCompress;
         err = qMax(err, QTest::qExec(&testJlCompress, app.arguments()));
@@ -229,6 +268,26 @@ int main(int argc, char **argv)
         TestQuaZipFileInfo testQuaZipFileInfo;
         err = qMax(err, QTest::qExec(&testQuaZipFileInfo, app.arguments()));
     }
+    {
+        TestQuaZipStreamReader testQuaZipStreamReader;
+        err = qMax(err, QTest::qExec(&testQuaZipStreamReader, app.arguments()));
+    }
+    {
+        TestQuaZipAsyncWriter testQuaZipAsyncWriter;
+        err = qMax(err, QTest::qExec(&testQuaZipAsyncWriter, app.arguments()));
+    }
+    {
+        TestQuaZipBatchBuilder testQuaZipBatchBuilder;
+        err = qMax(err, QTest::qExec(&testQuaZipBatchBuilder, app.arguments()));
+    }
+    {
+        TestQuaZipMemoryDevice testQuaZipMemoryDevice;
+        err = qMax(err, QTest::qExec(&testQuaZipMemoryDevice, app.arguments()));
+    }
+    {
+        TestQuaZipCodec testQuaZipCodec;
+        err = qMax(err, QTest::qExec(&testQuaZipCodec, app.arguments()));
+    }
     if (err == 0) {
         qDebug("All tests executed successfully");
     } else {
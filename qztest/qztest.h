@@ -25,6 +25,7 @@ Original ZIP package is copyrighted by Gilles Vollant and contributors,
 see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
+#include <QtCore/QByteArray>
 #include <QtCore/QIODevice>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
@@ -36,6 +37,8 @@ extern bool createTestFiles(const QStringList &fileNames,
                             const QString &dir = "tmp");
 extern void removeTestFiles(const QStringList &fileNames, const QString
         &dir = "tmp");
+extern QByteArray compressibleData(int size);
+extern QByteArray randomData(int size, quint32 seed = 1);
 extern bool createTestArchive(const QString &zipName, 
                               const QStringList &fileNames, 
                               const QString &dir = "tmp");
@@ -29,6 +29,9 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
 #include <quazip_qt_compat.h>
 
 #include <QtTest/QtTest>
@@ -453,6 +456,90 @@ void TestJlCompress::zeroPermissions()
     curDir.remove("zero.txt");
 }
 
+void TestJlCompress::async()
+{
+    QStringList fileNames;
+    fileNames << "test0.txt" << "testdir1/test1.txt" << "testdir2/test2.txt";
+    if (!createTestFiles(fileNames, 300000, "async_tmp")) {
+        QFAIL("Couldn't create test files");
+    }
+    QFuture<bool> compressed = JlCompress::compressDirAsync("async.zip",
+                                                            "async_tmp");
+    compressed.waitForFinished();
+    QVERIFY(!compressed.isCanceled());
+    QVERIFY(compressed.result());
+    QCOMPARE(compressed.progressMaximum(), 3 * 300000 + 3);
+    QCOMPARE(compressed.progressValue(), compressed.progressMaximum());
+    QCOMPARE(compressed.progressText(), QString("3/3"));
+    QFuture<QStringList> extracted = JlCompress::extractDirAsync("async.zip",
+                                                                 "async_ext");
+    extracted.waitForFinished();
+    QCOMPARE(extracted.result().size(), fileNames.size());
+    QCOMPARE(extracted.progressValue(), extracted.progressMaximum());
+    QCOMPARE(extracted.progressText(), QString("3/3"));
+    foreach (QString fileName, fileNames) {
+        QCOMPARE(QFileInfo("async_ext/async_tmp/" + fileName).size(),
+                 static_cast<qint64>(300000));
+    }
+    QFuture<QStringList> one = JlCompress::extractFilesAsync("async.zip",
+            QStringList() << "async_tmp/testdir2/test2.txt", "async_ext");
+    one.waitForFinished();
+    QCOMPARE(one.result(), QStringList()
+             << QDir("async_ext").absoluteFilePath("async_tmp/testdir2/test2.txt"));
+    QCOMPARE(one.progressText(), QString("1/1"));
+    // the same methods and levels as the synchronous functions
+    QFuture<bool> stored = JlCompress::compressDirAsync("asyncStored.zip",
+            "async_tmp", true, QDir::Filters(), 0, 0);
+    stored.waitForFinished();
+    QVERIFY(stored.result());
+    QuaZip zip("asyncStored.zip");
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QList<QuaZipFileInfo64> infos = zip.getFileInfoList64();
+    QCOMPARE(infos.size(), fileNames.size());
+    foreach (QuaZipFileInfo64 info, infos)
+        QCOMPARE(info.method, static_cast<quint16>(0));
+    zip.close();
+    removeTestFiles(fileNames, "async_tmp");
+    removeTestFiles(fileNames, "async_ext/async_tmp");
+    QDir curDir;
+    curDir.rmpath("async_ext");
+    curDir.remove("async.zip");
+    curDir.remove("asyncStored.zip");
+}
+
+/// Keeps a thread of the pool busy until released.
+class BlockingRunnable: public QRunnable {
+public:
+    BlockingRunnable(QSemaphore *gate): gate(gate) {}
+    virtual void run() {gate->acquire();}
+private:
+    QSemaphore *gate;
+};
+
+void TestJlCompress::asyncCancel()
+{
+    QStringList fileNames;
+    fileNames << "test0.txt" << "test1.txt";
+    if (!createTestFiles(fileNames, 100000, "asyncCancel_tmp")) {
+        QFAIL("Couldn't create test files");
+    }
+    // make sure the task is canceled before it gets a chance to run
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int maxThreadCount = pool->maxThreadCount();
+    pool->setMaxThreadCount(1);
+    QSemaphore gate;
+    pool->start(new BlockingRunnable(&gate));
+    QFuture<bool> future = JlCompress::compressDirAsync("asyncCancel.zip",
+                                                        "asyncCancel_tmp");
+    future.cancel();
+    gate.release();
+    future.waitForFinished();
+    pool->setMaxThreadCount(maxThreadCount);
+    QVERIFY(future.isCanceled());
+    QVERIFY(!QFileInfo("asyncCancel.zip").exists());
+    removeTestFiles(fileNames, "asyncCancel_tmp");
+}
+
 #ifdef QUAZIP_SYMLINK_TEST
 
 void TestJlCompress::symlinkHandling()
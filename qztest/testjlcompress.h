@@ -52,6 +52,8 @@ private slots:
     void extractDir_data();
     void extractDir();
     void zeroPermissions();
+    void async();
+    void asyncCancel();
 #ifdef QUAZIP_SYMLINK_TEST
     void symlinkHandling();
 #endif
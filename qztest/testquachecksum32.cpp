@@ -24,8 +24,11 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include "testquachecksum32.h"
 
+#include "qztest.h"
+
 #include <quaadler32.h>
 #include <quacrc32.h>
+#include <quazip_zlib.h>
 
 #include <QtTest/QtTest>
 
@@ -48,3 +51,166 @@ void TestQuaChecksum32::update()
     adler32.update("pedia");
     QCOMPARE(adler32.value(), 0x11E60398u);
 }
+
+void TestQuaChecksum32::rawData()
+{
+    const char data[] = "Wikipedia";
+    QuaCrc32 crc32;
+    QCOMPARE(crc32.calculate(data, 9), 0xADAAC02Eu);
+    crc32.update(data, 4);
+    crc32.update(data + 4, 5);
+    QCOMPARE(crc32.value(), 0xADAAC02Eu);
+    QuaAdler32 adler32;
+    QCOMPARE(adler32.calculate(data, 9), 0x11E60398u);
+    adler32.update(data, 4);
+    adler32.update(data + 4, 5);
+    QCOMPARE(adler32.value(), 0x11E60398u);
+    // through the interface, going to the QByteArray versions
+    QuaChecksum32 *checksum = &crc32;
+    QCOMPARE(checksum->calculate(data, 9), 0xADAAC02Eu);
+    checksum->reset();
+    checksum->update(data, 4);
+    checksum->update(data + 4, 5);
+    checksum->update(data, 0);
+    QCOMPARE(checksum->value(), 0xADAAC02Eu);
+}
+
+void TestQuaChecksum32::crc32Random()
+{
+    // the accelerated code has separate paths for short buffers, the
+    // 64-byte blocks, 16-byte blocks and the tail
+    QByteArray data = randomData(1 << 20, 1);
+    quint32 seed = 2;
+    for (int i = 0; i < 3000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int offset = (seed >> 8) % 64;
+        seed = seed * 1103515245u + 12345u;
+        int size = i < 1000 ? i : static_cast<int>((seed >> 4)
+                                                   % (data.size() - 64));
+        QByteArray piece = data.mid(offset, size);
+        uLong expected = crc32(0L,
+            reinterpret_cast<const Bytef*>(piece.constData()),
+            static_cast<uInt>(piece.size()));
+        QuaCrc32 crc;
+        QCOMPARE(crc.calculate(piece), static_cast<quint32>(expected));
+        // split at a random point, going through the same code as
+        // zipWriteInFileInZip() and unzReadCurrentFile() do
+        int split = size == 0 ? 0 : static_cast<int>(seed % size);
+        crc.update(piece.left(split));
+        crc.update(piece.mid(split));
+        QCOMPARE(crc.value(), static_cast<quint32>(expected));
+    }
+}
+
+void TestQuaChecksum32::benchmarkCrc32_data()
+{
+    QTest::addColumn<bool>("zlib");
+    QTest::addColumn<int>("size");
+    const int sizes[] = {16, 64, 256, 4096, 65536, 1 << 20};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        QTest::newRow(QString("zlib/%1").arg(sizes[i]).toUtf8().constData())
+            << true << sizes[i];
+        QTest::newRow(QString("QuaCrc32/%1").arg(sizes[i]).toUtf8()
+                      .constData())
+            << false << sizes[i];
+    }
+}
+
+void TestQuaChecksum32::benchmarkCrc32()
+{
+    QFETCH(bool, zlib);
+    QFETCH(int, size);
+    QByteArray data = randomData(size, 3);
+    quint32 result = 0;
+    QuaCrc32 crc;
+    QBENCHMARK {
+        if (zlib) {
+            result = static_cast<quint32>(crc32(0L,
+                reinterpret_cast<const Bytef*>(data.constData()),
+                static_cast<uInt>(data.size())));
+        } else {
+            result = crc.calculate(data);
+        }
+    }
+    QCOMPARE(result, crc.calculate(data));
+}
+
+void TestQuaChecksum32::adler32Random()
+{
+    // the vector code takes 32-byte blocks, reducing every 5536 bytes
+    QByteArray data = randomData(1 << 20, 4);
+    quint32 seed = 5;
+    for (int i = 0; i < 3000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int offset = (seed >> 8) % 64;
+        seed = seed * 1103515245u + 12345u;
+        int size = i < 1000 ? i : static_cast<int>((seed >> 4)
+                                                   % (data.size() - 64));
+        QByteArray piece = data.mid(offset, size);
+        uLong expected = adler32(1L,
+            reinterpret_cast<const Bytef*>(piece.constData()),
+            static_cast<uInt>(piece.size()));
+        QuaAdler32 adler;
+        QCOMPARE(adler.calculate(piece), static_cast<quint32>(expected));
+        int split = size == 0 ? 0 : static_cast<int>(seed % size);
+        adler.update(piece.left(split));
+        adler.update(piece.mid(split));
+        QCOMPARE(adler.value(), static_cast<quint32>(expected));
+    }
+    // the largest sums possible
+    QByteArray ones(100000, '\xff');
+    QCOMPARE(QuaAdler32().calculate(ones), static_cast<quint32>(
+        adler32(1L, reinterpret_cast<const Bytef*>(ones.constData()),
+                static_cast<uInt>(ones.size()))));
+}
+
+void TestQuaChecksum32::adler32Parallel()
+{
+    qint64 threshold = QuaAdler32::parallelThreshold();
+    QuaAdler32::setParallelThreshold(1000);
+    QByteArray data = randomData(3 * 1000 * 1000 + 7, 6);
+    uLong expected = adler32(1L,
+        reinterpret_cast<const Bytef*>(data.constData()),
+        static_cast<uInt>(data.size()));
+    QuaAdler32 adler;
+    quint32 result = adler.calculate(data);
+    adler.update(data.left(999));
+    adler.update(data.mid(999));
+    quint32 updated = adler.value();
+    QuaAdler32::setParallelThreshold(threshold);
+    QCOMPARE(result, static_cast<quint32>(expected));
+    QCOMPARE(updated, static_cast<quint32>(expected));
+}
+
+void TestQuaChecksum32::benchmarkAdler32_data()
+{
+    QTest::addColumn<bool>("zlib");
+    QTest::addColumn<int>("size");
+    const int sizes[] = {16, 64, 256, 4096, 65536, 1 << 20, 16 << 20};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        QTest::newRow(QString("zlib/%1").arg(sizes[i]).toUtf8().constData())
+            << true << sizes[i];
+        QTest::newRow(QString("QuaAdler32/%1").arg(sizes[i]).toUtf8()
+                      .constData())
+            << false << sizes[i];
+    }
+}
+
+void TestQuaChecksum32::benchmarkAdler32()
+{
+    QFETCH(bool, zlib);
+    QFETCH(int, size);
+    QByteArray data = randomData(size, 7);
+    quint32 result = 0;
+    QuaAdler32 adler;
+    QBENCHMARK {
+        if (zlib) {
+            result = static_cast<quint32>(adler32(1L,
+                reinterpret_cast<const Bytef*>(data.constData()),
+                static_cast<uInt>(data.size())));
+        } else {
+            result = adler.calculate(data);
+        }
+    }
+    QCOMPARE(result, adler.calculate(data));
+}
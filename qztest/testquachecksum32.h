@@ -32,6 +32,14 @@ class TestQuaChecksum32: public QObject {
 private slots:
     void calculate();
     void update();
+    void rawData();
+    void crc32Random();
+    void benchmarkCrc32_data();
+    void benchmarkCrc32();
+    void adler32Random();
+    void adler32Parallel();
+    void benchmarkAdler32_data();
+    void benchmarkAdler32();
 };
 
 #endif // QUAZIP_TEST_QUACHECKSUM32_H
@@ -0,0 +1,144 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip test suite.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+
+#include "testquachecksumiodevice.h"
+
+#include "qztest.h"
+
+#include <quaadler32.h>
+#include <quachecksumiodevice.h>
+#include <quacrc32.h>
+#include <quazip.h>
+#include <quazipfile.h>
+#include <quazipmemorydevice.h>
+#include <quazipnewinfo.h>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QByteArray>
+
+#include <QtTest/QtTest>
+
+void TestQuaChecksumIODevice::read()
+{
+    QByteArray data = compressibleData(80000);
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QuaCrc32 crc;
+    QuaChecksumIODevice device(&buffer, &crc);
+    QCOMPARE(device.getIoDevice(), static_cast<QIODevice*>(&buffer));
+    QCOMPARE(device.getChecksum(), static_cast<QuaChecksum32*>(&crc));
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QVERIFY((device.openMode() & QIODevice::Unbuffered) != 0);
+    // only what was read so far counts
+    QByteArray head = device.read(1000);
+    QCOMPARE(head.size(), 1000);
+    QCOMPARE(device.totalBytes(), static_cast<qint64>(1000));
+    QCOMPARE(crc.value(), QuaCrc32().calculate(head));
+    QByteArray rest = device.readAll();
+    QVERIFY(device.atEnd());
+    QCOMPARE(head + rest, data);
+    QCOMPARE(device.totalBytes(), static_cast<qint64>(data.size()));
+    QCOMPARE(crc.value(), QuaCrc32().calculate(data));
+    device.close();
+    QVERIFY(!device.isOpen());
+    QVERIFY(buffer.isOpen());
+}
+
+void TestQuaChecksumIODevice::write()
+{
+    QByteArray data = compressibleData(80000);
+    QByteArray output;
+    QBuffer buffer(&output);
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QuaAdler32 adler;
+    QuaChecksumIODevice device(&buffer, &adler);
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    for (int pos = 0; pos < data.size(); pos += 777) {
+        QByteArray piece = data.mid(pos, 777);
+        QCOMPARE(device.write(piece), static_cast<qint64>(piece.size()));
+    }
+    device.close();
+    QCOMPARE(output, data);
+    QCOMPARE(adler.value(), QuaAdler32().calculate(data));
+    // opening again starts over
+    buffer.seek(0);
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    QCOMPARE(device.totalBytes(), static_cast<qint64>(0));
+    QCOMPARE(device.write("abc", 3), static_cast<qint64>(3));
+    device.close();
+    QCOMPARE(adler.value(), QuaAdler32().calculate("abc"));
+}
+
+void TestQuaChecksumIODevice::zipEntry()
+{
+    // the checksum of an upload, taken while storing it
+    QByteArray data = compressibleData(80000);
+    QuaZipMemoryDevice archive;
+    QuaZip zip(&archive);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QuaZipFile entry(&zip);
+    QVERIFY(entry.open(QIODevice::WriteOnly, QuaZipNewInfo("upload.txt")));
+    QuaCrc32 crc;
+    QuaChecksumIODevice device(&entry, &crc);
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    QCOMPARE(device.write(data), static_cast<qint64>(data.size()));
+    device.close();
+    entry.close();
+    QCOMPARE(entry.getZipError(), UNZ_OK);
+    zip.close();
+    QuaZip check(&archive);
+    QVERIFY(check.open(QuaZip::mdUnzip));
+    QVERIFY(check.goToFirstFile());
+    QuaZipFileInfo64 info;
+    QVERIFY(check.getCurrentFileInfo(&info));
+    QCOMPARE(info.crc, crc.value());
+    // and of a download, taken while extracting it
+    QuaZipFile stored(&check);
+    QVERIFY(stored.open(QIODevice::ReadOnly));
+    QuaCrc32 readCrc;
+    QuaChecksumIODevice reader(&stored, &readCrc);
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    QCOMPARE(reader.readAll(), data);
+    QCOMPARE(readCrc.value(), info.crc);
+    reader.close();
+    stored.close();
+    check.close();
+}
+
+void TestQuaChecksumIODevice::openModes()
+{
+    QByteArray data("data");
+    QBuffer buffer(&data);
+    QuaCrc32 crc;
+    QuaChecksumIODevice device(&buffer, &crc);
+    // the underlying device must be open in the same mode
+    QVERIFY(!device.open(QIODevice::ReadOnly));
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(!device.open(QIODevice::WriteOnly));
+    QVERIFY(!device.open(QIODevice::ReadWrite));
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.readAll(), data);
+    QCOMPARE(crc.value(), QuaCrc32().calculate(data));
+}
@@ -23,8 +23,15 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
 #include "testquagzipfile.h"
-#include <zlib.h>
+
+#include "qztest.h"
+
+#include <quazip_zlib.h>
+#include <QtCore/QBuffer>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QtEndian>
 #include <quagzipfile.h>
 #include <QtTest/QtTest>
 
@@ -37,6 +44,8 @@ void TestQuaGzipFile::read()
     gzclose(file);
     QuaGzipFile testFile("tmp/test.gz");
     QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QVERIFY(!testFile.isBlocked());
+    QCOMPARE(testFile.virtualOffset(), static_cast<qint64>(-1));
     char buf[5];
     buf[4] = '\0';
     QCOMPARE(testFile.read(buf, 5), static_cast<qint64>(4));
@@ -69,6 +78,333 @@ void TestQuaGzipFile::write()
     curDir.rmdir("tmp");
 }
 
+void TestQuaGzipFile::parallelWrite_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("flushAt");
+    QTest::newRow("empty") << 4 << 0 << -1;
+    QTest::newRow("small") << 4 << 1000 << -1;
+    QTest::newRow("one block") << 2 << 128 * 1024 << -1;
+    QTest::newRow("many blocks") << 4 << 1000 * 1000 << -1;
+    QTest::newRow("flushed") << 4 << 1000 * 1000 << 300 * 1000 + 7;
+    QTest::newRow("one thread") << 1 << 1000 * 1000 << 300 * 1000 + 7;
+}
+
+void TestQuaGzipFile::parallelWrite()
+{
+    QFETCH(int, threads);
+    QFETCH(int, size);
+    QFETCH(int, flushAt);
+    QDir curDir;
+    curDir.mkpath("tmp");
+    QByteArray data = compressibleData(size);
+    QuaGzipFile testFile("tmp/test.gz");
+    testFile.setMaxThreadCount(threads);
+    QCOMPARE(testFile.getMaxThreadCount(), threads);
+    QVERIFY(testFile.open(QIODevice::WriteOnly));
+    for (int pos = 0; pos < size; pos += 10000) {
+        int count = qMin(10000, size - pos);
+        QCOMPARE(testFile.write(data.constData() + pos, count),
+                 static_cast<qint64>(count));
+        if (flushAt >= pos && flushAt < pos + count)
+            QVERIFY(testFile.flush());
+    }
+    testFile.close();
+    QVERIFY(!testFile.isOpen());
+    // a single member that zlib reads to the end
+    gzFile file = gzopen("tmp/test.gz", "rb");
+    QVERIFY(file != nullptr);
+    QByteArray contents(size + 1, '\0');
+    int read = gzread(file, contents.data(), size + 1);
+    gzclose(file);
+    QCOMPARE(read, size);
+    contents.truncate(read);
+    QCOMPARE(contents, data);
+    QFile gz("tmp/test.gz");
+    QVERIFY(gz.open(QIODevice::ReadOnly));
+    QByteArray compressed = gz.readAll();
+    gz.close();
+    QVERIFY(compressed.size() >= 18);
+    QCOMPARE(compressed.left(3), QByteArray("\x1F\x8B\x08"));
+    curDir.remove("tmp/test.gz");
+    curDir.rmdir("tmp");
+}
+
+void TestQuaGzipFile::blocked_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<int>("size");
+    QTest::newRow("empty") << 1 << 0;
+    QTest::newRow("small") << 1 << 1000;
+    QTest::newRow("one thread") << 1 << 1000 * 1000;
+    QTest::newRow("many threads") << 4 << 1000 * 1000;
+}
+
+void TestQuaGzipFile::blocked()
+{
+    QFETCH(int, threads);
+    QFETCH(int, size);
+    QDir curDir;
+    curDir.mkpath("tmp");
+    QByteArray data = compressibleData(size);
+    QuaGzipFile testFile("tmp/test.gz");
+    testFile.setMaxThreadCount(threads);
+    testFile.setBlocked(true);
+    QVERIFY(testFile.isBlocked());
+    QVERIFY(testFile.open(QIODevice::WriteOnly));
+    for (int pos = 0; pos < size; pos += 10000) {
+        int count = qMin(10000, size - pos);
+        QCOMPARE(testFile.write(data.constData() + pos, count),
+                 static_cast<qint64>(count));
+    }
+    testFile.close();
+    // still a plain GZIP file, just with many members
+    gzFile file = gzopen("tmp/test.gz", "rb");
+    QVERIFY(file != nullptr);
+    QByteArray contents(size + 1, '\0');
+    int read = gzread(file, contents.data(), size + 1);
+    gzclose(file);
+    QCOMPARE(read, size);
+    contents.truncate(read);
+    QCOMPARE(contents, data);
+    QFile gz("tmp/test.gz");
+    QVERIFY(gz.open(QIODevice::ReadOnly));
+    QByteArray compressed = gz.readAll();
+    gz.close();
+    static const char eof[] = "\x1F\x8B\x08\x04\0\0\0\0\0\xFF\x06\0BC\x02\0"
+        "\x1B\0\x03\0\0\0\0\0\0\0\0\0";
+    QCOMPARE(compressed.right(28), QByteArray(eof, 28));
+    QuaGzipFile readFile("tmp/test.gz");
+    readFile.setMaxThreadCount(threads);
+    QVERIFY(!readFile.isBlocked());
+    QVERIFY(readFile.open(QIODevice::ReadOnly));
+    QVERIFY(readFile.isBlocked());
+    QCOMPARE(readFile.virtualOffset(), static_cast<qint64>(0));
+    QCOMPARE(readFile.readAll(), data);
+    QCOMPARE(readFile.virtualOffset(),
+             static_cast<qint64>(compressed.size()) << 16);
+    QVERIFY(readFile.atEnd());
+    readFile.close();
+    // unbuffered, so only the reader knows whether there is more
+    QVERIFY(readFile.open(QIODevice::ReadOnly));
+    QCOMPARE(readFile.atEnd(), false);
+    QByteArray pieces;
+    while (!readFile.atEnd())
+        pieces += readFile.read(7777);
+    QCOMPARE(pieces, data);
+    readFile.close();
+    curDir.remove("tmp/test.gz");
+    curDir.rmdir("tmp");
+}
+
+void TestQuaGzipFile::seekVirtual()
+{
+    QDir curDir;
+    curDir.mkpath("tmp");
+    const int size = 1000 * 1000;
+    QByteArray data = compressibleData(size);
+    QuaGzipFile testFile("tmp/test.gz");
+    testFile.setMaxThreadCount(2);
+    testFile.setBlocked(true);
+    QVERIFY(testFile.open(QIODevice::WriteOnly));
+    QTest::ignoreMessage(QtWarningMsg, "QuaGzipFile::seekVirtual(): "
+            "file is not open for reading in the blocked format");
+    QVERIFY(!testFile.seekVirtual(0));
+    QCOMPARE(testFile.write(data), static_cast<qint64>(size));
+    testFile.close();
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QList<qint64> offsets;
+    QList<int> positions;
+    const int chunk = 7001;
+    for (int pos = 0; pos < size; pos += chunk) {
+        offsets.append(testFile.virtualOffset());
+        positions.append(pos);
+        QCOMPARE(testFile.read(chunk), data.mid(pos, chunk));
+    }
+    QVERIFY(testFile.read(1).isEmpty());
+    for (int i = offsets.size() - 1; i >= 0; --i) {
+        QVERIFY(testFile.seekVirtual(offsets.at(i)));
+        QCOMPARE(testFile.virtualOffset(), offsets.at(i));
+        QCOMPARE(testFile.read(100), data.mid(positions.at(i), 100));
+    }
+    // beyond the end of the first member
+    QVERIFY(!testFile.seekVirtual(0xFFFF));
+    QVERIFY(testFile.seekVirtual(0));
+    QCOMPARE(testFile.readAll(), data);
+    testFile.close();
+    curDir.remove("tmp/test.gz");
+    curDir.rmdir("tmp");
+}
+
+void TestQuaGzipFile::index()
+{
+    QDir curDir;
+    curDir.mkpath("tmp");
+    // several members, the second one in stored blocks
+    QByteArray first = compressibleData(1000 * 1000);
+    QByteArray second = randomData(300 * 1000);
+    QByteArray third = compressibleData(500 * 1000 + 1);
+    const char *modes[] = {"wb", "ab", "ab9"};
+    const QByteArray *parts[] = {&first, &second, &third};
+    for (int i = 0; i < 3; ++i) {
+        gzFile file = gzopen("tmp/test.gz", modes[i]);
+        QVERIFY(file != nullptr);
+        QCOMPARE(gzwrite(file, parts[i]->constData(), parts[i]->size()),
+                 parts[i]->size());
+        gzclose(file);
+    }
+    QByteArray data = first + second + third;
+    curDir.remove("tmp/test.gz.idx");
+    QuaGzipFile testFile("tmp/test.gz");
+    QVERIFY(testFile.isSequential());
+    testFile.setIndexSpan(64 * 1024);
+    QCOMPARE(testFile.getIndexSpan(), static_cast<qint64>(64 * 1024));
+    testFile.setIndexFileName("tmp/test.gz.idx");
+    QCOMPARE(testFile.getIndexFileName(),
+             QString::fromLatin1("tmp/test.gz.idx"));
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QVERIFY(!testFile.isSequential());
+    QCOMPARE(testFile.size(), static_cast<qint64>(0));
+    // forward, backward, then far beyond the part indexed so far
+    QVERIFY(testFile.seek(400 * 1000));
+    QCOMPARE(testFile.read(1000), data.mid(400 * 1000, 1000));
+    QVERIFY(testFile.seek(100));
+    QCOMPARE(testFile.read(1000), data.mid(100, 1000));
+    QVERIFY(testFile.seek(1200 * 1000));
+    QCOMPARE(testFile.read(1000), data.mid(1200 * 1000, 1000));
+    QVERIFY(!QFile::exists("tmp/test.gz.idx"));
+    QVERIFY(testFile.buildIndex());
+    QCOMPARE(testFile.pos(), static_cast<qint64>(1201 * 1000));
+    QCOMPARE(testFile.size(), static_cast<qint64>(data.size()));
+    QVERIFY(QFile::exists("tmp/test.gz.idx"));
+    QVERIFY(!testFile.seek(data.size() + 1));
+    testFile.close();
+    // the index is loaded now
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QCOMPARE(testFile.size(), static_cast<qint64>(data.size()));
+    QByteArray positions = randomData(100 * 4, 2);
+    for (int i = 0; i < 100; ++i) {
+        qint64 pos = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(
+                positions.constData()) + i * 4) % data.size();
+        QVERIFY(testFile.seek(pos));
+        QCOMPARE(testFile.read(3000), data.mid(static_cast<int>(pos), 3000));
+    }
+    QVERIFY(testFile.seek(data.size()));
+    QVERIFY(testFile.atEnd());
+    QVERIFY(testFile.seek(0));
+    QCOMPARE(testFile.readAll(), data);
+    QVERIFY(testFile.atEnd());
+    testFile.close();
+    curDir.remove("tmp/test.gz.idx");
+    curDir.remove("tmp/test.gz");
+    curDir.rmdir("tmp");
+}
+
+void TestQuaGzipFile::staleIndex()
+{
+    QDir curDir;
+    curDir.mkpath("tmp");
+    // stored, so that both files are of the same size and have access
+    // points at the same places
+    QByteArray first = randomData(300 * 1000, 3);
+    QByteArray second = randomData(300 * 1000, 4);
+    const QByteArray *parts[] = {&first, &second};
+    qint64 sizes[2];
+    curDir.remove("tmp/test.gz.idx");
+    for (int i = 0; i < 2; ++i) {
+        gzFile file = gzopen("tmp/test.gz", "wb0");
+        QVERIFY(file != nullptr);
+        QCOMPARE(gzwrite(file, parts[i]->constData(), parts[i]->size()),
+                 parts[i]->size());
+        gzclose(file);
+        sizes[i] = QFileInfo("tmp/test.gz").size();
+        QuaGzipFile testFile("tmp/test.gz");
+        testFile.setIndexSpan(64 * 1024);
+        testFile.setIndexFileName("tmp/test.gz.idx");
+        if (i == 1) {
+            QTest::ignoreMessage(QtWarningMsg, "QuaGzipFile: ignoring an"
+                    " invalid or outdated index tmp/test.gz.idx");
+        }
+        QVERIFY(testFile.open(QIODevice::ReadOnly));
+        // the index of the first file isn't used for the second one
+        QCOMPARE(testFile.size(), static_cast<qint64>(0));
+        QVERIFY(testFile.buildIndex());
+        QVERIFY(testFile.seek(200 * 1000));
+        QCOMPARE(testFile.read(1000), parts[i]->mid(200 * 1000, 1000));
+        testFile.close();
+    }
+    QCOMPARE(sizes[1], sizes[0]);
+    // the second index is saved in place of the first one
+    QuaGzipFile testFile("tmp/test.gz");
+    testFile.setIndexSpan(64 * 1024);
+    testFile.setIndexFileName("tmp/test.gz.idx");
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QCOMPARE(testFile.size(), static_cast<qint64>(second.size()));
+    QVERIFY(testFile.seek(100 * 1000));
+    QCOMPARE(testFile.read(1000), second.mid(100 * 1000, 1000));
+    testFile.close();
+    curDir.remove("tmp/test.gz.idx");
+    curDir.remove("tmp/test.gz");
+    curDir.rmdir("tmp");
+}
+
+void TestQuaGzipFile::ioDevice()
+{
+    QDir curDir;
+    curDir.mkpath("tmp");
+    QByteArray data = compressibleData(500 * 1000);
+    QByteArray compressed;
+    QBuffer buffer(&compressed);
+    QuaGzipFile testFile;
+    testFile.setIoDevice(&buffer);
+    QCOMPARE(testFile.getIoDevice(), static_cast<QIODevice*>(&buffer));
+    testFile.setBufferSize(1000);
+    QCOMPARE(testFile.getBufferSize(), 1000);
+    QVERIFY(testFile.open(QIODevice::WriteOnly));
+    QVERIFY(buffer.isOpen());
+    for (int pos = 0; pos < data.size(); pos += 7777) {
+        QByteArray piece = data.mid(pos, 7777);
+        QCOMPARE(testFile.write(piece), static_cast<qint64>(piece.size()));
+    }
+    QVERIFY(testFile.flush());
+    testFile.close();
+    QVERIFY(!buffer.isOpen());
+    // gzread() sees one member, and another one is read after it
+    QFile file("tmp/test.gz");
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(compressed);
+    file.close();
+    gzFile gz = gzopen("tmp/test.gz", "rb");
+    QVERIFY(gz != nullptr);
+    QByteArray check(data.size() + 1, '\0');
+    QCOMPARE(gzread(gz, check.data(), check.size()), data.size());
+    gzclose(gz);
+    gz = gzopen("tmp/test.gz", "ab");
+    gzwrite(gz, "test", 4);
+    gzclose(gz);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    compressed = file.readAll();
+    file.close();
+    // an open device is left open
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(!testFile.open(QIODevice::WriteOnly));
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QCOMPARE(testFile.readAll(), data + "test");
+    QVERIFY(testFile.atEnd());
+    testFile.close();
+    QVERIFY(buffer.isOpen());
+    buffer.close();
+    // a file name replaces the device
+    testFile.setFileName("tmp/test.gz");
+    QVERIFY(testFile.getIoDevice() == nullptr);
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QCOMPARE(testFile.readAll(), data + "test");
+    testFile.close();
+    curDir.remove("tmp/test.gz");
+    curDir.rmdir("tmp");
+}
+
 void TestQuaGzipFile::constructorDestructor()
 {
     QuaGzipFile *f1 = new QuaGzipFile();
@@ -32,6 +32,14 @@ class TestQuaGzipFile: public QObject {
 private slots:
     void read();
     void write();
+    void parallelWrite_data();
+    void parallelWrite();
+    void blocked_data();
+    void blocked();
+    void seekVirtual();
+    void index();
+    void staleIndex();
+    void ioDevice();
     void constructorDestructor();
 };
 
@@ -0,0 +1,175 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip test suite.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+
+#include "testquaparallelchecksum.h"
+
+#include "qztest.h"
+
+#include <quaadler32.h>
+#include <quacrc32.h>
+#include <quaparallelchecksum.h>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+
+#include <QtTest/QtTest>
+
+Q_DECLARE_METATYPE(QuaParallelChecksum::Algorithm)
+
+static quint32 expectedChecksum(QuaParallelChecksum::Algorithm algorithm,
+                                const QByteArray &data)
+{
+    if (algorithm == QuaParallelChecksum::Crc32)
+        return QuaCrc32().calculate(data);
+    else
+        return QuaAdler32().calculate(data);
+}
+
+void TestQuaParallelChecksum::calculate_data()
+{
+    QTest::addColumn<QuaParallelChecksum::Algorithm>("algorithm");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<qint64>("chunkSize");
+    QTest::addColumn<int>("threads");
+    QTest::newRow("crc32 empty") << QuaParallelChecksum::Crc32 << 0
+                                 << static_cast<qint64>(1000) << 4;
+    QTest::newRow("crc32 one chunk") << QuaParallelChecksum::Crc32 << 999
+                                     << static_cast<qint64>(1000) << 4;
+    QTest::newRow("crc32 exact") << QuaParallelChecksum::Crc32 << 100000
+                                 << static_cast<qint64>(1000) << 4;
+    QTest::newRow("crc32 tail") << QuaParallelChecksum::Crc32 << 1234567
+                                << static_cast<qint64>(65536) << 3;
+    QTest::newRow("crc32 one thread") << QuaParallelChecksum::Crc32 << 300001
+                                      << static_cast<qint64>(4096) << 1;
+    QTest::newRow("adler32 empty") << QuaParallelChecksum::Adler32 << 0
+                                   << static_cast<qint64>(1000) << 4;
+    QTest::newRow("adler32 tail") << QuaParallelChecksum::Adler32 << 1234567
+                                  << static_cast<qint64>(65536) << 3;
+    QTest::newRow("adler32 small chunks") << QuaParallelChecksum::Adler32
+                                          << 100001
+                                          << static_cast<qint64>(7) << 8;
+}
+
+void TestQuaParallelChecksum::calculate()
+{
+    QFETCH(QuaParallelChecksum::Algorithm, algorithm);
+    QFETCH(int, size);
+    QFETCH(qint64, chunkSize);
+    QFETCH(int, threads);
+    QByteArray data = randomData(size, 11);
+    QuaParallelChecksum checksum(algorithm);
+    QCOMPARE(checksum.getAlgorithm(), algorithm);
+    checksum.setChunkSize(chunkSize);
+    QCOMPARE(checksum.getChunkSize(), chunkSize);
+    checksum.setMaxThreadCount(threads);
+    QCOMPARE(checksum.getMaxThreadCount(), threads);
+    quint32 result = 0;
+    QVERIFY(checksum.calculate(data.constData(), data.size(), &result));
+    QCOMPARE(result, expectedChecksum(algorithm, data));
+    QVERIFY(checksum.getErrorString().isEmpty());
+    // the same object can be used again
+    QVERIFY(checksum.calculate(data.constData(), data.size() / 2, &result));
+    QCOMPARE(result, expectedChecksum(algorithm, data.left(data.size() / 2)));
+}
+
+void TestQuaParallelChecksum::calculateFile()
+{
+    QByteArray data = randomData(3 * 1000 * 1000 + 17, 11);
+    QStringList fileNames;
+    fileNames << "parallel.bin";
+    QVERIFY(createTestFiles(fileNames, 0));
+    QFile file("tmp/parallel.bin");
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(data), static_cast<qint64>(data.size()));
+    file.close();
+    QuaParallelChecksum crc;
+    crc.setChunkSize(100000);
+    quint32 result = 0;
+    QVERIFY(crc.calculateFile("tmp/parallel.bin", &result));
+    QCOMPARE(result, QuaCrc32().calculate(data));
+    QuaParallelChecksum adler(QuaParallelChecksum::Adler32);
+    QVERIFY(adler.calculateFile("tmp/parallel.bin", &result));
+    QCOMPARE(result, QuaAdler32().calculate(data));
+    removeTestFiles(fileNames);
+}
+
+void TestQuaParallelChecksum::calculateDevice()
+{
+    QByteArray data = randomData(1000 * 1000 + 3, 11);
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    // from the current position
+    QVERIFY(buffer.seek(10));
+    QuaParallelChecksum checksum;
+    checksum.setChunkSize(65536);
+    checksum.setMaxThreadCount(2);
+    quint32 result = 0;
+    QVERIFY(checksum.calculateDevice(&buffer, &result));
+    QCOMPARE(result, QuaCrc32().calculate(data.mid(10)));
+    QVERIFY(buffer.atEnd());
+}
+
+void TestQuaParallelChecksum::errors()
+{
+    QuaParallelChecksum checksum;
+    quint32 result = 12345;
+    QVERIFY(!checksum.calculateFile("tmp/no such file.bin", &result));
+    QVERIFY(!checksum.getErrorString().isEmpty());
+    QCOMPARE(result, 12345u);
+    QBuffer closed;
+    QVERIFY(!checksum.calculateDevice(&closed, &result));
+    QVERIFY(!checksum.getErrorString().isEmpty());
+    // a success clears the error
+    QVERIFY(checksum.calculate("abc", 3, &result));
+    QVERIFY(checksum.getErrorString().isEmpty());
+    QCOMPARE(result, QuaCrc32().calculate("abc"));
+}
+
+void TestQuaParallelChecksum::benchmarkCalculate_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("QuaCrc32") << 0;
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("ideal threads") << QThread::idealThreadCount();
+}
+
+void TestQuaParallelChecksum::benchmarkCalculate()
+{
+    QFETCH(int, threads);
+    QByteArray data = randomData(64 * 1024 * 1024, 11);
+    QuaParallelChecksum checksum;
+    checksum.setMaxThreadCount(threads);
+    quint32 result = 0;
+    QBENCHMARK {
+        if (threads == 0)
+            result = QuaCrc32().calculate(data);
+        else
+            QVERIFY(checksum.calculate(data.constData(), data.size(),
+                                       &result));
+    }
+    QCOMPARE(result, QuaCrc32().calculate(data));
+}
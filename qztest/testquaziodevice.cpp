@@ -23,9 +23,14 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
 #include "testquaziodevice.h"
+
+#include "qztest.h"
+
 #include <quaziodevice.h>
 #include <QtCore/QBuffer>
 #include <QtCore/QByteArray>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
 #include <QtTest/QtTest>
 
 void TestQuaZIODevice::read()
@@ -111,3 +116,326 @@ void TestQuaZIODevice::write()
     QCOMPARE(static_cast<const char*>(outBuf), "test");
     delete testDevice; // Test D0 destructor
 }
+
+/// A device taking only so much data until it's drained.
+class ThrottledDevice: public QIODevice {
+public:
+    ThrottledDevice(qint64 room): room(room), buffered(0) {}
+    virtual bool isSequential() const {return true;}
+    virtual qint64 bytesToWrite() const {return buffered;}
+    /// Writes out the buffered data, like a socket would.
+    void drain()
+    {
+        qint64 count = buffered;
+        buffered = 0;
+        emit bytesWritten(count);
+    }
+    QByteArray sent;
+    qint64 room;
+protected:
+    virtual qint64 readData(char *, qint64) {return -1;}
+    virtual qint64 writeData(const char *data, qint64 maxSize)
+    {
+        qint64 count = qMin(maxSize, room - buffered);
+        if (count <= 0)
+            return 0;
+        sent.append(data, static_cast<int>(count));
+        buffered += count;
+        return count;
+    }
+private:
+    qint64 buffered;
+};
+
+void TestQuaZIODevice::backpressure()
+{
+    ThrottledDevice throttled(5000);
+    QVERIFY(throttled.open(QIODevice::WriteOnly));
+    QuaZIODevice writer(&throttled);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    QSignalSpy writtenSpy(&writer, SIGNAL(bytesWritten(qint64)));
+    // hardly compressible, so that the device fills up quickly
+    QByteArray data = randomData(300000);
+    int pos = 0;
+    int shortWrites = 0;
+    int rounds = 0;
+    while (pos < data.size()) {
+        qint64 count = writer.write(data.constData() + pos,
+                                    qMin(10000, data.size() - pos));
+        QVERIFY(count >= 0);
+        if (count < qMin(10000, data.size() - pos)) {
+            ++shortWrites;
+            throttled.drain();
+        }
+        pos += static_cast<int>(count);
+        QVERIFY(++rounds < 100000);
+    }
+    QVERIFY(shortWrites > 0);
+    // the flush can't be done at once, bytesWritten() finishes it
+    QVERIFY(writer.flush());
+    QVERIFY(writer.bytesToWrite() > 0);
+    while (writer.bytesToWrite() > 0) {
+        throttled.drain();
+        QVERIFY(++rounds < 100000);
+    }
+    QVERIFY(writtenSpy.count() > 0);
+    z_stream zins;
+    zins.zalloc = (alloc_func) NULL;
+    zins.zfree = (free_func) NULL;
+    zins.opaque = NULL;
+    QCOMPARE(inflateInit(&zins), Z_OK);
+    QByteArray result(data.size(), '\0');
+    zins.next_in = reinterpret_cast<Bytef*>(throttled.sent.data());
+    zins.avail_in = throttled.sent.size();
+    zins.next_out = reinterpret_cast<Bytef*>(result.data());
+    zins.avail_out = result.size();
+    QCOMPARE(inflate(&zins, Z_SYNC_FLUSH), Z_OK);
+    inflateEnd(&zins);
+    QCOMPARE(result, data);
+    throttled.room = 1024 * 1024;
+    writer.close();
+}
+
+void TestQuaZIODevice::socket()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress(QHostAddress::LocalHost)));
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress(QHostAddress::LocalHost),
+                         server.serverPort());
+    QVERIFY(socket.waitForConnected());
+    QVERIFY(server.waitForNewConnection(30000));
+    QTcpSocket *client = server.nextPendingConnection();
+    QuaZIODevice writer(client);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    QuaZIODevice reader(&socket);
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    QSignalSpy readySpy(&reader, SIGNAL(readyRead()));
+    QSignalSpy writtenSpy(&writer, SIGNAL(bytesWritten(qint64)));
+    QSignalSpy finishedSpy(&reader, SIGNAL(readChannelFinished()));
+    // nothing to read, and no waiting for it
+    QCOMPARE(reader.bytesAvailable(), static_cast<qint64>(0));
+    QVERIFY(reader.read(100).isEmpty());
+    QVERIFY(!reader.atEnd());
+    QByteArray data = QByteArray("Compressible text. ").repeated(20000);
+    QCOMPARE(writer.write(data), static_cast<qint64>(data.size()));
+    QVERIFY(writer.flush());
+    QVERIFY(writer.bytesToWrite() > 0);
+    while (writer.bytesToWrite() > 0)
+        QVERIFY(writer.waitForBytesWritten(30000));
+    QVERIFY(writtenSpy.count() > 0);
+    QByteArray received;
+    while (received.size() < data.size()) {
+        QVERIFY(reader.waitForReadyRead(30000));
+        QVERIFY(reader.bytesAvailable() > 0);
+        received += reader.readAll();
+    }
+    QCOMPARE(received, data);
+    QVERIFY(readySpy.count() > 0);
+    QCOMPARE(reader.bytesAvailable(), static_cast<qint64>(0));
+    QVERIFY(!reader.atEnd());
+    QVERIFY(!reader.waitForReadyRead(100));
+    // the end of the stream
+    writer.close();
+    QVERIFY(client->waitForBytesWritten(30000) || client->bytesToWrite() == 0);
+    for (int i = 0; i < 100 && !reader.atEnd(); ++i)
+        reader.waitForReadyRead(100);
+    QVERIFY(reader.atEnd());
+    QCOMPARE(finishedSpy.count(), 1);
+    reader.close();
+    client->close();
+}
+
+static void addBufferRows()
+{
+    QTest::addColumn<int>("bufferSize");
+    QTest::addColumn<bool>("direct");
+    QTest::newRow("4 KB") << 4096 << false;
+    QTest::newRow("256 KB") << 256 * 1024 << false;
+    QTest::newRow("direct") << 4096 << true;
+}
+
+static QByteArray compressBulk(const QByteArray &data, int bufferSize,
+                               bool direct)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QuaZIODevice device(&buffer);
+    device.setBufferSize(bufferSize);
+    device.setDirectEnabled(direct);
+    device.open(QIODevice::WriteOnly);
+    const int chunk = 1024 * 1024;
+    for (int pos = 0; pos < data.size(); pos += chunk) {
+        if (device.write(data.constData() + pos,
+                         qMin(chunk, data.size() - pos)) == -1)
+            return QByteArray();
+    }
+    device.close();
+    return buffer.data();
+}
+
+static QByteArray decompressBulk(const QByteArray &compressed,
+                                 int bufferSize, bool direct, int size)
+{
+    QBuffer buffer;
+    buffer.setData(compressed);
+    buffer.open(QIODevice::ReadOnly);
+    QuaZIODevice device(&buffer);
+    device.setBufferSize(bufferSize);
+    device.setDirectEnabled(direct);
+    device.open(QIODevice::ReadOnly);
+    QByteArray result(size, '\0');
+    const int chunk = 1024 * 1024;
+    qint64 pos = 0;
+    while (pos < size) {
+        qint64 read = device.read(result.data() + pos,
+                                  qMin<qint64>(chunk, size - pos));
+        if (read <= 0)
+            break;
+        pos += read;
+    }
+    result.resize(static_cast<int>(pos));
+    return result;
+}
+
+void TestQuaZIODevice::bulk_data()
+{
+    addBufferRows();
+}
+
+void TestQuaZIODevice::bulk()
+{
+    QFETCH(int, bufferSize);
+    QFETCH(bool, direct);
+    QBuffer buffer;
+    QuaZIODevice device(&buffer);
+    QCOMPARE(device.getBufferSize(), 4096);
+    QVERIFY(!device.isDirectEnabled());
+    device.setBufferSize(1);
+    QCOMPARE(device.getBufferSize(), 64);
+    QByteArray data = compressibleData(8 * 1024 * 1024);
+    QByteArray compressed = compressBulk(data, bufferSize, direct);
+    QVERIFY(!compressed.isEmpty());
+    // the stream doesn't depend on the buffers
+    QCOMPARE(compressed, compressBulk(data, 4096, false));
+    QCOMPARE(decompressBulk(compressed, bufferSize, direct, data.size()),
+             data);
+}
+
+void TestQuaZIODevice::bufferSizeWhileOpen()
+{
+    QByteArray data = compressibleData(200000);
+    QByteArray compressed = compressBulk(data, 4096, false);
+    QBuffer buffer;
+    buffer.setData(compressed);
+    buffer.open(QIODevice::ReadOnly);
+    QuaZIODevice device(&buffer);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QByteArray result = device.read(10);
+    // takes effect only after reopening, reading goes on as before
+    device.setBufferSize(1024 * 1024);
+    QCOMPARE(device.getBufferSize(), 1024 * 1024);
+    while (!device.atEnd()) {
+        QByteArray piece = device.read(100);
+        if (piece.isEmpty())
+            break;
+        result += piece;
+    }
+    QCOMPARE(result, data);
+    device.close();
+    buffer.seek(0);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.readAll(), data);
+    device.close();
+}
+
+void TestQuaZIODevice::benchmarkRead_data()
+{
+    addBufferRows();
+}
+
+void TestQuaZIODevice::benchmarkRead()
+{
+    QFETCH(int, bufferSize);
+    QFETCH(bool, direct);
+    QByteArray data = compressibleData(8 * 1024 * 1024);
+    QByteArray compressed = compressBulk(data, 4096, false);
+    QByteArray result;
+    QBENCHMARK {
+        result = decompressBulk(compressed, bufferSize, direct, data.size());
+    }
+    QCOMPARE(result, data);
+}
+
+void TestQuaZIODevice::benchmarkWrite_data()
+{
+    addBufferRows();
+}
+
+void TestQuaZIODevice::benchmarkWrite()
+{
+    QFETCH(int, bufferSize);
+    QFETCH(bool, direct);
+    QByteArray data = compressibleData(8 * 1024 * 1024);
+    QByteArray compressed;
+    QBENCHMARK {
+        compressed = compressBulk(data, bufferSize, direct);
+    }
+    QVERIFY(!compressed.isEmpty());
+}
+
+void TestQuaZIODevice::threads_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1") << 1;
+    QTest::newRow("2") << 2;
+    QTest::newRow("4") << 4;
+}
+
+void TestQuaZIODevice::threads()
+{
+    QFETCH(int, threads);
+    QByteArray data = compressibleData(8 * 1024 * 1024);
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QuaZIODevice device(&buffer);
+    QCOMPARE(device.getMaxThreadCount(), 1);
+    device.setMaxThreadCount(threads);
+    QCOMPARE(device.getMaxThreadCount(), threads);
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    const int half = data.size() / 2 + 12345;
+    QCOMPARE(device.write(data.constData(), half), static_cast<qint64>(half));
+    QVERIFY(device.flush());
+    // everything written so far can be decompressed after a flush
+    QByteArray flushed = buffer.data();
+    z_stream zins;
+    zins.zalloc = (alloc_func) NULL;
+    zins.zfree = (free_func) NULL;
+    zins.opaque = NULL;
+    QCOMPARE(inflateInit(&zins), Z_OK);
+    QByteArray result(half, '\0');
+    zins.next_in = reinterpret_cast<Bytef*>(flushed.data());
+    zins.avail_in = flushed.size();
+    zins.next_out = reinterpret_cast<Bytef*>(result.data());
+    zins.avail_out = result.size();
+    QCOMPARE(inflate(&zins, Z_SYNC_FLUSH), Z_OK);
+    inflateEnd(&zins);
+    QCOMPARE(result, data.left(half));
+    QCOMPARE(device.write(data.constData() + half, data.size() - half),
+             static_cast<qint64>(data.size() - half));
+    device.close();
+    // an ordinary zlib stream
+    QByteArray compressed = buffer.data();
+    QCOMPARE(inflateInit(&zins), Z_OK);
+    result = QByteArray(data.size(), '\0');
+    zins.next_in = reinterpret_cast<Bytef*>(compressed.data());
+    zins.avail_in = compressed.size();
+    zins.next_out = reinterpret_cast<Bytef*>(result.data());
+    zins.avail_out = result.size();
+    QCOMPARE(inflate(&zins, Z_FINISH), Z_STREAM_END);
+    QCOMPARE(static_cast<int>(zins.total_out), data.size());
+    QCOMPARE(static_cast<int>(zins.total_in), compressed.size());
+    inflateEnd(&zins);
+    QCOMPARE(result, data);
+    QCOMPARE(decompressBulk(compressed, 4096, false, data.size()), data);
+}
@@ -33,6 +33,17 @@ private slots:
     void read();
     void readMany();
     void write();
+    void backpressure();
+    void socket();
+    void bulk_data();
+    void bulk();
+    void bufferSizeWhileOpen();
+    void benchmarkRead_data();
+    void benchmarkRead();
+    void benchmarkWrite_data();
+    void benchmarkWrite();
+    void threads_data();
+    void threads();
 };
 
 #endif // QUAZIP_TEST_QUAZIODEVICE_H
@@ -26,10 +26,12 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include "qztest.h"
 
+#include <QtCore/QBuffer>
 #include <QtCore/QDataStream>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
 #include <QtCore/QHash>
+#include <QtCore/QtEndian>
 #ifdef QUAZIP_TEST_QSAVEFILE
 #include <QtCore/QSaveFile>
 #endif
@@ -41,6 +43,8 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include <quazip.h>
 #include <JlCompress.h>
+#include <quagzipfile.h>
+#include <quazipfile.h>
 
 void TestQuaZip::getFileList_data()
 {
@@ -164,6 +168,222 @@ void TestQuaZip::add()
     curDir.remove(zipName);
 }
 
+void TestQuaZip::readEntry()
+{
+    QString zipName = "qzreadentry.zip";
+    QStringList fileNames;
+    fileNames << "test0.txt" << "testdir1/test1.txt" << "testdir2/test2.txt";
+    QDir curDir;
+    if (curDir.exists(zipName)) {
+        if (!curDir.remove(zipName))
+            QFAIL("Can't remove zip file");
+    }
+    if (!createTestFiles(fileNames, 10000)) {
+        QFAIL("Can't create test file");
+    }
+    if (!createTestArchive(zipName, fileNames)) {
+        QFAIL("Can't create test archive");
+    }
+    QList<QByteArray> expected;
+    foreach (QString fileName, fileNames) {
+        QFile file("tmp/" + fileName);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        expected << file.readAll();
+    }
+    QuaZip testZip(zipName);
+    QVERIFY(testZip.open(QuaZip::mdUnzip));
+    for (int i = 0; i < fileNames.size(); ++i) {
+        QCOMPARE(testZip.readEntry(fileNames[i]), expected[i]);
+        QCOMPARE(testZip.getZipError(), UNZ_OK);
+        QCOMPARE(testZip.getCurrentFileName(), fileNames[i]);
+    }
+    QCOMPARE(testZip.readEntries(fileNames), expected);
+    QByteArray buffer(expected[1].size(), '\0');
+    QCOMPARE(testZip.readEntry(fileNames[1], buffer.data(), buffer.size()),
+             static_cast<qint64>(expected[1].size()));
+    QCOMPARE(buffer, expected[1]);
+    QCOMPARE(testZip.readEntry(fileNames[1], buffer.data(),
+                               buffer.size() - 1), static_cast<qint64>(-1));
+    QCOMPARE(testZip.getZipError(), UNZ_PARAMERROR);
+    QVERIFY(testZip.readEntry("nonexistent.txt").isNull());
+    QCOMPARE(testZip.getZipError(), UNZ_OK);
+    QVERIFY(testZip.readEntries(QStringList() << fileNames[0]
+                                << "nonexistent.txt").isEmpty());
+    testZip.close();
+    // an entry with a wrong CRC, written in the raw mode
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZip badZip(&zipBuffer);
+    QVERIFY(badZip.open(QuaZip::mdCreate));
+    QuaZipFile badFile(&badZip);
+    QuaZipNewInfo badInfo("bad.txt");
+    badInfo.uncompressedSize = 4;
+    QVERIFY(badFile.open(QIODevice::WriteOnly, badInfo, nullptr, 0x1234u,
+                         0, 0, true));
+    QCOMPARE(badFile.write("data", 4), static_cast<qint64>(4));
+    badFile.close();
+    QCOMPARE(badFile.getZipError(), ZIP_OK);
+    QuaZipFile emptyFile(&badZip);
+    QVERIFY(emptyFile.open(QIODevice::WriteOnly, QuaZipNewInfo("empty.txt")));
+    emptyFile.close();
+    QuaZipFile secretFile(&badZip);
+    QVERIFY(secretFile.open(QIODevice::WriteOnly, QuaZipNewInfo("secret.txt"),
+                            "password"));
+    QCOMPARE(secretFile.write("data", 4), static_cast<qint64>(4));
+    secretFile.close();
+    badZip.close();
+    QVERIFY(badZip.open(QuaZip::mdUnzip));
+    QVERIFY(badZip.readEntry("bad.txt").isNull());
+    QCOMPARE(badZip.getZipError(), UNZ_CRCERROR);
+    QByteArray empty = badZip.readEntry("empty.txt");
+    QVERIFY(!empty.isNull());
+    QVERIFY(empty.isEmpty());
+    QTest::ignoreMessage(QtWarningMsg,
+                         "QuaZip::readEntry(): secret.txt is encrypted");
+    QVERIFY(badZip.readEntry("secret.txt").isNull());
+    QCOMPARE(badZip.getZipError(), UNZ_PARAMERROR);
+    badZip.close();
+    // clean up
+    removeTestFiles(fileNames);
+    curDir.remove(zipName);
+}
+
+void TestQuaZip::addEntry()
+{
+    QByteArray text = QByteArray("Compressible text. ").repeated(1000);
+    QByteArray noise = randomData(100000, 12345);
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZip zip(&zipBuffer);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("text.txt"), text));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("noise.bin"), noise));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("stored.txt"), text, 0));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("empty.txt"), QByteArray()));
+    zip.close();
+    QCOMPARE(zip.getZipError(), UNZ_OK);
+    // the local header is complete from the start
+    QCOMPARE(zipData.mid(0, 4), QByteArray("PK\3\4"));
+    QCOMPARE(static_cast<int>(zipData.at(6)) & 8, 0);
+    QCOMPARE(qFromLittleEndian<quint32>(
+                 reinterpret_cast<const uchar*>(zipData.constData()) + 14),
+             static_cast<quint32>(crc32(0, reinterpret_cast<const Bytef*>(
+                 text.constData()), text.size())));
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QList<QuaZipFileInfo64> infos = zip.getFileInfoList64();
+    QCOMPARE(infos.size(), 4);
+    QCOMPARE(infos[0].method, static_cast<quint16>(Z_DEFLATED));
+    QVERIFY(infos[0].compressedSize < infos[0].uncompressedSize);
+    QCOMPARE(infos[1].method, static_cast<quint16>(0));
+    QCOMPARE(infos[2].method, static_cast<quint16>(0));
+    QCOMPARE(infos[3].method, static_cast<quint16>(0));
+    foreach (const QuaZipFileInfo64 &info, infos) {
+        QCOMPARE(info.flags & 8, 0);
+    }
+    QCOMPARE(zip.readEntry("text.txt"), text);
+    QCOMPARE(zip.readEntry("noise.bin"), noise);
+    QCOMPARE(zip.readEntry("stored.txt"), text);
+    QCOMPARE(zip.readEntry("empty.txt"), QByteArray(""));
+    QVERIFY(!zip.addEntry(QuaZipNewInfo("wrong mode.txt"), text));
+    QCOMPARE(zip.getZipError(), UNZ_OK);
+    zip.close();
+}
+
+void TestQuaZip::gzipEntry()
+{
+    QByteArray text = QByteArray("Compressible text. ").repeated(10000);
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZip zip(&zipBuffer);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("text.txt"), text, 9));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("stored.txt"), text, 0));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("empty.txt"), QByteArray()));
+    zip.close();
+    // ZIP to GZIP
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QStringList names;
+    names << "text.txt" << "stored.txt" << "empty.txt";
+    QList<QByteArray> gzipped;
+    foreach (const QString &name, names) {
+        QByteArray gzipData;
+        QBuffer gzipBuffer(&gzipData);
+        QVERIFY(gzipBuffer.open(QIODevice::WriteOnly));
+        QVERIFY(zip.readEntryAsGzip(name, &gzipBuffer));
+        gzipBuffer.close();
+        QuaGzipFile gzip;
+        gzip.setIoDevice(&gzipBuffer);
+        QVERIFY(gzip.open(QIODevice::ReadOnly));
+        QCOMPARE(gzip.readAll(), zip.readEntry(name));
+        gzip.close();
+        gzipped.append(gzipData);
+    }
+    // the deflated data is copied as is, with the level
+    QVERIFY(gzipped.at(0).size() < text.size() / 10);
+    QCOMPARE(static_cast<int>(gzipped.at(0).at(8)), 2);
+    QVERIFY(gzipped.at(1).size() > text.size());
+    QByteArray nothing;
+    QBuffer nothingBuffer(&nothing);
+    QVERIFY(nothingBuffer.open(QIODevice::WriteOnly));
+    QVERIFY(!zip.readEntryAsGzip("missing.txt", &nothingBuffer));
+    QCOMPARE(zip.getZipError(), UNZ_OK);
+    QVERIFY(nothing.isEmpty());
+    zip.close();
+    // and back, the GZIP header with a name is skipped
+    QDir curDir;
+    curDir.mkpath("tmp");
+    gzFile gz = gzopen("tmp/text.gz", "wb9");
+    QVERIFY(gz != nullptr);
+    QCOMPARE(gzwrite(gz, text.constData(), text.size()), text.size());
+    gzclose(gz);
+    QByteArray named = gzipped.at(1);
+    named[3] = 8;
+    named.insert(10, QByteArray("stored.txt", 11));
+    QByteArray blockedData;
+    QBuffer blockedBuffer(&blockedData);
+    QuaGzipFile blocked;
+    blocked.setIoDevice(&blockedBuffer);
+    blocked.setBlocked(true);
+    QVERIFY(blocked.open(QIODevice::WriteOnly));
+    blocked.write(text);
+    blocked.close();
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QFile textFile("tmp/text.gz");
+    QVERIFY(textFile.open(QIODevice::ReadOnly));
+    QVERIFY(zip.addGzipEntry(QuaZipNewInfo("text.txt"), &textFile));
+    textFile.close();
+    QBuffer namedBuffer(&named);
+    QVERIFY(namedBuffer.open(QIODevice::ReadOnly));
+    QVERIFY(zip.addGzipEntry(QuaZipNewInfo("stored.txt"), &namedBuffer));
+    QBuffer emptyBuffer(&gzipped[2]);
+    QVERIFY(emptyBuffer.open(QIODevice::ReadOnly));
+    QVERIFY(zip.addGzipEntry(QuaZipNewInfo("empty.txt"), &emptyBuffer));
+    QVERIFY(blockedBuffer.open(QIODevice::ReadOnly));
+    QVERIFY(!zip.addGzipEntry(QuaZipNewInfo("blocked.txt"), &blockedBuffer));
+    QCOMPARE(zip.getZipError(), Z_DATA_ERROR);
+    QByteArray notGzip("not a GZIP file");
+    QBuffer notGzipBuffer(&notGzip);
+    QVERIFY(notGzipBuffer.open(QIODevice::ReadOnly));
+    QVERIFY(!zip.addGzipEntry(QuaZipNewInfo("text.gz"), &notGzipBuffer));
+    QCOMPARE(zip.getZipError(), Z_DATA_ERROR);
+    zip.close();
+    QCOMPARE(zip.getZipError(), UNZ_OK);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QList<QuaZipFileInfo64> infos = zip.getFileInfoList64();
+    QCOMPARE(infos.size(), 3);
+    foreach (const QuaZipFileInfo64 &info, infos) {
+        QCOMPARE(info.method, static_cast<quint16>(Z_DEFLATED));
+        QCOMPARE(info.flags & 8, 0);
+    }
+    QCOMPARE(infos[0].flags & 6, 2);
+    QCOMPARE(zip.readEntry("text.txt"), text);
+    QCOMPARE(zip.readEntry("stored.txt"), text);
+    QCOMPARE(zip.readEntry("empty.txt"), QByteArray(""));
+    zip.close();
+    curDir.remove("tmp/text.gz");
+    curDir.rmdir("tmp");
+}
+
 void TestQuaZip::setFileNameCodec_data()
 {
     QTest::addColumn<QString>("zipName");
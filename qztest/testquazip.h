@@ -38,6 +38,9 @@ private slots:
     void getFileList();
     void add_data();
     void add();
+    void readEntry();
+    void addEntry();
+    void gzipEntry();
     void setFileNameCodec_data();
     void setFileNameCodec();
     void setOsCode_data();
@@ -0,0 +1,202 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip test suite.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "testquazipasyncwriter.h"
+
+#include "qztest.h"
+
+#include <quazip.h>
+#include <quazipasyncwriter.h>
+#include <quazipfile.h>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QSemaphore>
+
+#include <QtTest/QtTest>
+
+/// A device that holds the reader until it's told to go on.
+class BlockingDevice: public QIODevice {
+public:
+    BlockingDevice(): done(false) {}
+    virtual bool isSequential() const {return true;}
+    void waitUntilRead() {started.acquire();}
+    void release() {gate.release();}
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize)
+    {
+        if (done || maxSize < 4)
+            return 0;
+        started.release();
+        gate.acquire();
+        done = true;
+        memcpy(data, "data", 4);
+        return 4;
+    }
+    virtual qint64 writeData(const char *, qint64) {return -1;}
+private:
+    QSemaphore started;
+    QSemaphore gate;
+    bool done;
+};
+
+/// A device that fails to be read.
+class FailingDevice: public QIODevice {
+public:
+    virtual bool isSequential() const {return true;}
+protected:
+    virtual qint64 readData(char *, qint64)
+    {
+        setErrorString("Read failed");
+        return -1;
+    }
+    virtual qint64 writeData(const char *, qint64) {return -1;}
+};
+
+static bool checkArchive(QIODevice *ioDevice, const QStringList &names,
+                         const QList<QByteArray> &contents)
+{
+    QuaZip zip(ioDevice);
+    if (!zip.open(QuaZip::mdUnzip))
+        return false;
+    if (zip.getFileNameList() != names)
+        return false;
+    for (int i = 0; i < names.size(); ++i) {
+        if (!zip.setCurrentFile(names[i]))
+            return false;
+        QuaZipFile file(&zip);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        if (file.readAll() != contents[i])
+            return false;
+        file.close();
+        if (file.getZipError() != UNZ_OK)
+            return false;
+    }
+    zip.close();
+    return true;
+}
+
+void TestQuaZipAsyncWriter::write()
+{
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZipAsyncWriter writer(&zipBuffer);
+    QVERIFY(writer.open());
+    QVERIFY(writer.isOpen());
+    QStringList names;
+    QList<QByteArray> contents;
+    qint64 total = 0;
+    for (int i = 0; i < 10; ++i) {
+        names << QString("entry%1.txt").arg(i);
+        contents << QByteArray("Entry number ").append(QByteArray::number(i))
+            .repeated(100 * (i + 1));
+        total += contents.last().size();
+        QVERIFY(writer.addEntry(QuaZipNewInfo(names.last()),
+                                contents.last(), i % 2 == 0 ? Z_DEFLATED : 0));
+    }
+    QByteArray deviceData("Data read from a device");
+    QBuffer source(&deviceData);
+    names << "device.txt";
+    contents << deviceData;
+    total += deviceData.size();
+    QVERIFY(writer.addEntry(QuaZipNewInfo("device.txt"), &source));
+    QVERIFY(writer.close());
+    QVERIFY(!writer.isOpen());
+    QVERIFY(!source.isOpen());
+    QCOMPARE(writer.getZipError(), UNZ_OK);
+    QCOMPARE(writer.getEntriesWritten(), names.size());
+    QCOMPARE(writer.getUncompressedBytes(), total);
+    QCOMPARE(writer.getCompressedBytes(), static_cast<qint64>(zipData.size()));
+    QCOMPARE(writer.getQueueDepth(), 0);
+    QVERIFY(writer.getPeakQueueDepth() >= 1);
+    QVERIFY(writer.getElapsedTime() >= 0);
+    QVERIFY(!zipBuffer.isOpen());
+    QVERIFY(checkArchive(&zipBuffer, names, contents));
+}
+
+void TestQuaZipAsyncWriter::writeFile()
+{
+    QString zipName = "asyncwriter.zip";
+    QStringList names;
+    QList<QByteArray> contents;
+    {
+        QuaZipAsyncWriter writer(zipName);
+        writer.setComment("async");
+        QVERIFY(writer.open());
+        names << "test.txt";
+        contents << QByteArray("test");
+        QVERIFY(writer.addEntry(QuaZipNewInfo("test.txt"), contents.last()));
+        // the destructor closes it
+    }
+    QFile zipFile(zipName);
+    QVERIFY(checkArchive(&zipFile, names, contents));
+    QuaZip zip(zipName);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QCOMPARE(zip.getComment(), QString("async"));
+    zip.close();
+    QDir().remove(zipName);
+}
+
+void TestQuaZipAsyncWriter::sourceError()
+{
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZipAsyncWriter writer(&zipBuffer);
+    QVERIFY(writer.open());
+    FailingDevice source;
+    QVERIFY(writer.addEntry(QuaZipNewInfo("failing.txt"), &source));
+    QVERIFY(!writer.close());
+    QCOMPARE(writer.getZipError(), UNZ_ERRNO);
+    // opened by the writer, so closed by it even after the failure
+    QVERIFY(!source.isOpen());
+}
+
+void TestQuaZipAsyncWriter::queueFull()
+{
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZipAsyncWriter writer(&zipBuffer);
+    writer.setMaxQueueSize(1);
+    writer.setQueueFullPolicy(QuaZipAsyncWriter::qfReject);
+    QSignalSpy fullSpy(&writer, SIGNAL(queueFull()));
+    QVERIFY(writer.open());
+    BlockingDevice blocker;
+    QVERIFY(writer.addEntry(QuaZipNewInfo("blocked.txt"), &blocker));
+    blocker.waitUntilRead(); // now the worker is busy and the queue is empty
+    QVERIFY(writer.addEntry(QuaZipNewInfo("queued.txt"), QByteArray("queued")));
+    QVERIFY(!writer.addEntry(QuaZipNewInfo("rejected.txt"),
+                             QByteArray("rejected")));
+    QCOMPARE(fullSpy.count(), 1);
+    QCOMPARE(writer.getQueueDepth(), 1);
+    QCOMPARE(writer.getQueuedBytes(), static_cast<qint64>(6));
+    blocker.release();
+    QVERIFY(writer.close());
+    QCOMPARE(writer.getEntriesWritten(), 2);
+    QCOMPARE(writer.getPeakQueueDepth(), 1);
+    QVERIFY(checkArchive(&zipBuffer, QStringList() << "blocked.txt"
+                         << "queued.txt", QList<QByteArray>()
+                         << QByteArray("data") << QByteArray("queued")));
+}
@@ -0,0 +1,188 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip test suite.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+
+#include "testquazipbatchbuilder.h"
+
+#include "qztest.h"
+
+#include <quazip.h>
+#include <quazipbatchbuilder.h>
+#include <quazipfile.h>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QSemaphore>
+
+#include <QtTest/QtTest>
+
+static bool checkArchive(QIODevice *ioDevice, const QStringList &names,
+                         const QList<QByteArray> &contents)
+{
+    QuaZip zip(ioDevice);
+    if (!zip.open(QuaZip::mdUnzip))
+        return false;
+    if (zip.getFileNameList() != names)
+        return false;
+    for (int i = 0; i < names.size(); ++i) {
+        if (!zip.setCurrentFile(names[i]))
+            return false;
+        QuaZipFile file(&zip);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        if (file.readAll() != contents[i])
+            return false;
+        file.close();
+        if (file.getZipError() != UNZ_OK)
+            return false;
+    }
+    zip.close();
+    return true;
+}
+
+void TestQuaZipBatchBuilder::build()
+{
+    QStringList fileNames;
+    fileNames << "batch.txt";
+    QVERIFY(createTestFiles(fileNames, 100000));
+    QFile testFile("tmp/batch.txt");
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QByteArray fileData = testFile.readAll();
+    testFile.close();
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZip zip(&zipBuffer);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QStringList names;
+    QList<QByteArray> contents;
+    {
+        QuaZipBatchBuilder builder(&zip);
+        builder.setMaxThreadCount(3);
+        QCOMPARE(builder.getMaxThreadCount(), 3);
+        QCOMPARE(builder.getMaxPendingEntries(), 6);
+        names << "file.txt";
+        contents << fileData;
+        QVERIFY(builder.addFile("file.txt", "tmp/batch.txt"));
+        for (int i = 0; i < 20; ++i) {
+            names << QString("data%1.txt").arg(i);
+            contents << QByteArray("Entry number ")
+                .append(QByteArray::number(i)).repeated(100 * (i + 1));
+            QVERIFY(builder.addData(QuaZipNewInfo(names.last()),
+                                    contents.last(),
+                                    i % 2 == 0 ? Z_DEFLATED : 0));
+            QVERIFY(builder.getPendingEntries() <= 6);
+        }
+        QByteArray deviceData("Data read from a device");
+        QBuffer source(&deviceData);
+        QVERIFY(source.open(QIODevice::ReadOnly));
+        names << "device.txt";
+        contents << deviceData;
+        QVERIFY(builder.addDevice(QuaZipNewInfo("device.txt"), &source));
+        names << "generated.txt";
+        contents << QByteArray("generated").repeated(1000);
+        QVERIFY(builder.addGenerated(QuaZipNewInfo("generated.txt"), []() {
+            return QByteArray("generated").repeated(1000);
+        }, Z_DEFLATED, 9));
+        names << "empty.txt";
+        contents << QByteArray("");
+        QVERIFY(builder.addGenerated(QuaZipNewInfo("empty.txt"), []() {
+            return QByteArray("");
+        }));
+        QVERIFY(builder.finish());
+        QCOMPARE(builder.getZipError(), UNZ_OK);
+        QCOMPARE(builder.getPendingEntries(), 0);
+        QCOMPARE(builder.getEntriesWritten(), names.size());
+    }
+    zip.close();
+    QCOMPARE(zip.getZipError(), UNZ_OK);
+    QVERIFY(checkArchive(&zipBuffer, names, contents));
+    removeTestFiles(fileNames);
+}
+
+void TestQuaZipBatchBuilder::order()
+{
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZip zip(&zipBuffer);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QuaZipBatchBuilder builder(&zip);
+    builder.setMaxThreadCount(4);
+    builder.setMaxPendingEntries(4);
+    QSemaphore lastGenerated;
+    QStringList names;
+    QList<QByteArray> contents;
+    names << "first.txt" << "second.txt" << "third.txt" << "last.txt";
+    contents << "first" << "second" << "third" << "last";
+    // the first entry is only produced after the last one
+    QVERIFY(builder.addGenerated(QuaZipNewInfo("first.txt"),
+                                 [&lastGenerated]() {
+        lastGenerated.acquire();
+        return QByteArray("first");
+    }));
+    QVERIFY(builder.addData(QuaZipNewInfo("second.txt"), "second"));
+    QVERIFY(builder.addData(QuaZipNewInfo("third.txt"), "third"));
+    QVERIFY(builder.addGenerated(QuaZipNewInfo("last.txt"),
+                                 [&lastGenerated]() {
+        lastGenerated.release();
+        return QByteArray("last");
+    }));
+    QVERIFY(builder.finish());
+    QCOMPARE(builder.getEntriesWritten(), 4);
+    zip.close();
+    QVERIFY(checkArchive(&zipBuffer, names, contents));
+}
+
+void TestQuaZipBatchBuilder::error()
+{
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZip zip(&zipBuffer);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QuaZipBatchBuilder builder(&zip);
+    builder.setMaxThreadCount(1);
+    builder.setMaxPendingEntries(1);
+    QVERIFY(builder.addData(QuaZipNewInfo("good.txt"), "good"));
+    // this may fail already if the generator is fast enough
+    builder.addGenerated(QuaZipNewInfo("bad.txt"), []() {
+        return QByteArray();
+    });
+    // writing the bad entry fails here at the latest
+    QVERIFY(!builder.addData(QuaZipNewInfo("rejected.txt"), "rejected"));
+    QVERIFY(!builder.finish());
+    QCOMPARE(builder.getZipError(), UNZ_INTERNALERROR);
+    QCOMPARE(builder.getEntriesWritten(), 1);
+    QCOMPARE(builder.getPendingEntries(), 0);
+    // ready for more after finish()
+    QVERIFY(builder.addFile("missing.txt", "tmp/no such file.txt"));
+    QVERIFY(!builder.finish());
+    QCOMPARE(builder.getZipError(), UNZ_ERRNO);
+    QVERIFY(builder.addData(QuaZipNewInfo("more.txt"), "more"));
+    QCOMPARE(builder.getZipError(), UNZ_OK);
+    QVERIFY(builder.finish());
+    QCOMPARE(builder.getEntriesWritten(), 2);
+    zip.close();
+    QVERIFY(checkArchive(&zipBuffer, QStringList() << "good.txt" << "more.txt",
+                         QList<QByteArray>() << "good" << "more"));
+}
@@ -0,0 +1,279 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip test suite.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "testquazipcodec.h"
+
+#include "qztest.h"
+
+#include <quazip.h>
+#include <quazipcodec.h>
+#include <quazipfile.h>
+#include <quazipmemorydevice.h>
+#include <quazipnewinfo.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QPair>
+
+#include <QtTest/QtTest>
+
+static QString backendName(QuaZipCodec::Backend backend)
+{
+    return backend == QuaZipCodec::LibDeflate ? "libdeflate" : "zlib";
+}
+
+// The kinds of files the other tests create, the test archive, and some
+// incompressible data.
+static QList<QPair<QString, QByteArray> > corpus()
+{
+    QList<QPair<QString, QByteArray> > files;
+    QByteArray text;
+    for (int i = 0; i < 20000; ++i) {
+        text.append("This is a test file named dir/file")
+            .append(QByteArray::number(i)).append(".txt\n");
+    }
+    files << qMakePair(QString("text"), text);
+    QByteArray digits(1024 * 1024, '\0');
+    for (int i = 0; i < digits.size(); ++i) {
+        digits[i] = static_cast<char>('0' + i % 10);
+    }
+    files << qMakePair(QString("digits"), digits);
+    QByteArray random = randomData(256 * 1024);
+    files << qMakePair(QString("random"), random);
+    QFile zip(":/test_files/issue43_cant_get_dates.zip");
+    if (zip.open(QIODevice::ReadOnly))
+        files << qMakePair(QString("zip"), zip.readAll());
+    return files;
+}
+
+static void addCorpusRows()
+{
+    QTest::addColumn<int>("backend");
+    QTest::addColumn<QByteArray>("data");
+    QList<QPair<QString, QByteArray> > files = corpus();
+    foreach (QuaZipCodec::Backend backend,
+             QuaZipCodec::getAvailableBackends()) {
+        for (int i = 0; i < files.size(); ++i) {
+            QTest::newRow(QString("%1/%2").arg(backendName(backend),
+                                               files.at(i).first)
+                          .toUtf8().constData())
+                << static_cast<int>(backend) << files.at(i).second;
+        }
+    }
+}
+
+// plain zlib streaming, as any other reader would do
+static QByteArray zlibInflate(const QByteArray &compressed, int size)
+{
+    QByteArray result(size, '\0');
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return QByteArray();
+    stream.next_in = reinterpret_cast<Bytef*>(
+                const_cast<char*>(compressed.constData()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+    int ret = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    if (ret != Z_STREAM_END || stream.avail_out != 0)
+        return QByteArray();
+    return result;
+}
+
+static QByteArray deflateData(const QByteArray &data)
+{
+    QByteArray compressed(static_cast<int>(
+                QuaZipCodec::deflateRawBound(data.size())), '\0');
+    qint64 size = QuaZipCodec::deflateRaw(data.constData(), data.size(),
+                                          compressed.data(),
+                                          compressed.size());
+    if (size <= 0)
+        return QByteArray();
+    compressed.resize(static_cast<int>(size));
+    return compressed;
+}
+
+void TestQuaZipCodec::cleanup()
+{
+    QuaZipCodec::setBackend(QuaZipCodec::Zlib);
+}
+
+void TestQuaZipCodec::deflateRaw_data()
+{
+    addCorpusRows();
+}
+
+void TestQuaZipCodec::deflateRaw()
+{
+    QFETCH(int, backend);
+    QFETCH(QByteArray, data);
+    QVERIFY(QuaZipCodec::setBackend(
+                static_cast<QuaZipCodec::Backend>(backend)));
+    QVERIFY(QuaZipCodec::deflateRawBound(data.size()) >= data.size());
+    QByteArray compressed = deflateData(data);
+    QVERIFY(!compressed.isEmpty());
+    QCOMPARE(zlibInflate(compressed, data.size()), data);
+    // a buffer too small is not an error
+    QByteArray small(compressed.size() - 1, '\0');
+    qint64 size = QuaZipCodec::deflateRaw(data.constData(), data.size(),
+                                          small.data(), small.size());
+    QVERIFY(size >= 0);
+    QVERIFY(size < compressed.size());
+    QVERIFY(QuaZipCodec::deflateRaw(data.constData(), data.size(),
+                                    compressed.data(), compressed.size(),
+                                    10) < 0);
+}
+
+void TestQuaZipCodec::inflateRaw_data()
+{
+    addCorpusRows();
+}
+
+void TestQuaZipCodec::inflateRaw()
+{
+    QFETCH(int, backend);
+    QFETCH(QByteArray, data);
+    // compressed by zlib, to be read by the backend
+    QByteArray compressed = deflateData(data);
+    QVERIFY(!compressed.isEmpty());
+    QVERIFY(QuaZipCodec::setBackend(
+                static_cast<QuaZipCodec::Backend>(backend)));
+    QByteArray result(data.size(), '\0');
+    QCOMPARE(QuaZipCodec::inflateRaw(compressed.constData(),
+                                     compressed.size(),
+                                     result.data(), result.size()),
+             static_cast<int>(Z_OK));
+    QCOMPARE(result, data);
+    // the size must be exact
+    QVERIFY(QuaZipCodec::inflateRaw(compressed.constData(),
+                                    compressed.size(),
+                                    result.data(), result.size() - 1)
+            != Z_OK);
+    QByteArray larger(data.size() + 1, '\0');
+    QVERIFY(QuaZipCodec::inflateRaw(compressed.constData(),
+                                    compressed.size(),
+                                    larger.data(), larger.size())
+            != Z_OK);
+    QVERIFY(QuaZipCodec::inflateRaw(compressed.constData(),
+                                    compressed.size() / 2,
+                                    result.data(), result.size())
+            != Z_OK);
+}
+
+void TestQuaZipCodec::zip_data()
+{
+    QTest::addColumn<int>("backend");
+    foreach (QuaZipCodec::Backend backend,
+             QuaZipCodec::getAvailableBackends()) {
+        QTest::newRow(backendName(backend).toUtf8().constData())
+            << static_cast<int>(backend);
+    }
+}
+
+void TestQuaZipCodec::zip()
+{
+    QFETCH(int, backend);
+    QCOMPARE(QuaZipCodec::setBackend(QuaZipCodec::LibDeflate),
+             QuaZipCodec::isBackendAvailable(QuaZipCodec::LibDeflate));
+    QVERIFY(QuaZipCodec::setBackend(
+                static_cast<QuaZipCodec::Backend>(backend)));
+    QCOMPARE(QuaZipCodec::getBackend(),
+             static_cast<QuaZipCodec::Backend>(backend));
+    QList<QPair<QString, QByteArray> > files = corpus();
+    QuaZipMemoryDevice device;
+    QuaZip zip(&device);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QStringList names;
+    for (int i = 0; i < files.size(); ++i) {
+        names << files.at(i).first;
+        QVERIFY(zip.addEntry(QuaZipNewInfo(files.at(i).first),
+                             files.at(i).second));
+    }
+    zip.close();
+    QCOMPARE(zip.getZipError(), UNZ_OK);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QList<QByteArray> entries = zip.readEntries(names);
+    QCOMPARE(entries.size(), files.size());
+    for (int i = 0; i < files.size(); ++i) {
+        QCOMPARE(entries.at(i), files.at(i).second);
+        // streamed by zlib
+        QVERIFY(zip.setCurrentFile(names.at(i)));
+        QuaZipFile file(&zip);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), files.at(i).second);
+        file.close();
+        QCOMPARE(file.getZipError(), UNZ_OK);
+    }
+    zip.close();
+}
+
+void TestQuaZipCodec::benchmarkDeflate_data()
+{
+    addCorpusRows();
+}
+
+void TestQuaZipCodec::benchmarkDeflate()
+{
+    QFETCH(int, backend);
+    QFETCH(QByteArray, data);
+    QVERIFY(QuaZipCodec::setBackend(
+                static_cast<QuaZipCodec::Backend>(backend)));
+    QByteArray compressed(static_cast<int>(
+                QuaZipCodec::deflateRawBound(data.size())), '\0');
+    qint64 size = 0;
+    QBENCHMARK {
+        size = QuaZipCodec::deflateRaw(data.constData(), data.size(),
+                                       compressed.data(), compressed.size());
+    }
+    QVERIFY(size > 0);
+}
+
+void TestQuaZipCodec::benchmarkInflate_data()
+{
+    addCorpusRows();
+}
+
+void TestQuaZipCodec::benchmarkInflate()
+{
+    QFETCH(int, backend);
+    QFETCH(QByteArray, data);
+    QByteArray compressed = deflateData(data);
+    QVERIFY(QuaZipCodec::setBackend(
+                static_cast<QuaZipCodec::Backend>(backend)));
+    QByteArray result(data.size(), '\0');
+    int ret = Z_OK;
+    QBENCHMARK {
+        ret = QuaZipCodec::inflateRaw(compressed.constData(),
+                                      compressed.size(),
+                                      result.data(), result.size());
+    }
+    QCOMPARE(ret, static_cast<int>(Z_OK));
+    QCOMPARE(result, data);
+}
@@ -27,6 +27,7 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include "qztest.h"
 
 #include <JlCompress.h>
+#include <quazipcodec.h>
 #include <quazipfile.h>
 #include <quazip.h>
 #include <quazip_qt_compat.h>
@@ -583,3 +584,537 @@ void TestQuaZipFile::largeFile()
     fakeLargeZip.close();
     curDir.remove("tmp/large.zip");
 }
+
+void TestQuaZipFile::zstd()
+{
+    if (!QuaZipCodec::isMethodSupported(Z_ZSTD))
+        QSKIP("QuaZip is built without zstd");
+    QByteArray contents;
+    for (int i = 0; i < 10000; ++i)
+        contents += QByteArray::number(i) + ' ';
+    QString zipName = "zstd.zip";
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("test.txt"),
+                             nullptr, 0, Z_ZSTD, 19));
+        QCOMPARE(zipFile.write(contents), static_cast<qint64>(contents.size()));
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    QByteArray raw;
+    quint32 crc;
+    {
+        QuaZipFile zipFile(zipName, "test.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly));
+        QuaZipFileInfo64 info;
+        QVERIFY(zipFile.getFileInfo(&info));
+        QCOMPARE(info.method, static_cast<quint16>(Z_ZSTD));
+        QVERIFY(info.compressedSize < info.uncompressedSize);
+        crc = info.crc;
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+        // the raw data, to copy it to another archive
+        int method, level;
+        QVERIFY(zipFile.open(QIODevice::ReadOnly, &method, &level, true));
+        QCOMPARE(method, static_cast<int>(Z_ZSTD));
+        raw = zipFile.readAll();
+        zipFile.close();
+    }
+    QString copyName = "zstdCopy.zip";
+    {
+        QuaZip zip(copyName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QuaZipNewInfo info("good.txt");
+        info.uncompressedSize = contents.size();
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, info, nullptr, crc,
+                             Z_ZSTD, 19, true));
+        zipFile.write(raw);
+        zipFile.close();
+        info.name = "bad.txt";
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, info, nullptr, crc ^ 1,
+                             Z_ZSTD, 19, true));
+        zipFile.write(raw);
+        zipFile.close();
+        zip.close();
+    }
+    {
+        QuaZipFile zipFile(copyName, "good.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly));
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    }
+    {
+        QuaZipFile zipFile(copyName, "bad.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly));
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_CRCERROR);
+    }
+    // JlCompress
+    QStringList fileNames;
+    fileNames << "zstd1.txt" << "zstd2.txt";
+    QVERIFY(createTestFiles(fileNames));
+    QString dirName = "jlZstd.zip";
+    QVERIFY(JlCompress::compressDir(dirName, "tmp", true, QDir::Filters(),
+                                    Z_ZSTD, 3));
+    {
+        QuaZip zip(dirName);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        QList<QuaZipFileInfo64> infos = zip.getFileInfoList64();
+        QCOMPARE(infos.size(), fileNames.size());
+        for (const QuaZipFileInfo64 &info : infos)
+            QCOMPARE(info.method, static_cast<quint16>(Z_ZSTD));
+        zip.close();
+    }
+    // the entries are named after the compressed directory
+    QStringList extractedNames;
+    for (const QString &fileName : fileNames)
+        extractedNames << "tmp/" + fileName;
+    QDir extracted("jlZstd");
+    QCOMPARE(JlCompress::extractDir(dirName, "jlZstd").size(),
+             fileNames.size());
+    for (const QString &fileName : fileNames) {
+        QFile source("tmp/" + fileName);
+        QFile result(extracted.filePath("tmp/" + fileName));
+        QVERIFY(source.open(QIODevice::ReadOnly));
+        QVERIFY(result.open(QIODevice::ReadOnly));
+        QCOMPARE(result.readAll(), source.readAll());
+    }
+    removeTestFiles(fileNames);
+    // removes jlZstd/tmp and jlZstd too
+    removeTestFiles(extractedNames, "jlZstd");
+    QDir().remove(zipName);
+    QDir().remove(copyName);
+    QDir().remove(dirName);
+}
+
+void TestQuaZipFile::lzma_data()
+{
+    QTest::addColumn<int>("method");
+    QTest::addColumn<int>("level");
+    QTest::addColumn<int>("threads");
+    QTest::newRow("lzma") << static_cast<int>(Z_LZMA) << 6 << 1;
+    QTest::newRow("lzma fast") << static_cast<int>(Z_LZMA) << 0 << 1;
+    QTest::newRow("xz") << static_cast<int>(Z_XZ)
+                        << static_cast<int>(Z_DEFAULT_COMPRESSION) << 1;
+    QTest::newRow("xz threads") << static_cast<int>(Z_XZ) << 1 << 4;
+}
+
+void TestQuaZipFile::lzma()
+{
+    QFETCH(int, method);
+    QFETCH(int, level);
+    QFETCH(int, threads);
+    if (!QuaZipCodec::isMethodSupported(method))
+        QSKIP("QuaZip is built without liblzma");
+    // large enough for several XZ blocks at level 1
+    QByteArray contents = compressibleData(8 * 1024 * 1024);
+    QString zipName = "lzma.zip";
+    {
+        QuaZip zip(zipName);
+        QCOMPARE(zip.getThreadCount(), 1);
+        zip.setThreadCount(threads);
+        QCOMPARE(zip.getThreadCount(), threads);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("empty.txt"),
+                             nullptr, 0, method, level));
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("test.txt"),
+                             "password", 0, method, level));
+        QCOMPARE(zipFile.write(contents), static_cast<qint64>(contents.size()));
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    {
+        QuaZipFile zipFile(zipName, "empty.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly));
+        QCOMPARE(zipFile.readAll(), QByteArray());
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    }
+    {
+        QuaZipFile zipFile(zipName, "test.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly, "password"));
+        QuaZipFileInfo64 info;
+        QVERIFY(zipFile.getFileInfo(&info));
+        QCOMPARE(info.method, static_cast<quint16>(method));
+        QVERIFY(info.compressedSize < info.uncompressedSize / 2);
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    }
+    QDir().remove(zipName);
+}
+
+void TestQuaZipFile::bzip2_data()
+{
+    QTest::addColumn<int>("level");
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<QByteArray>("password");
+    QTest::newRow("default") << static_cast<int>(Z_DEFAULT_COMPRESSION) << 1
+                             << 1000000 << QByteArray();
+    QTest::newRow("threads") << 1 << 4 << 1000000 << QByteArray();
+    QTest::newRow("threads max") << 9 << 4 << 3000000 << QByteArray();
+    QTest::newRow("threads small") << 9 << 4 << 1000 << QByteArray();
+    QTest::newRow("threads empty") << 9 << 4 << 0 << QByteArray();
+    QTest::newRow("threads password") << 1 << 2 << 300000
+                                      << QByteArray("secret");
+}
+
+void TestQuaZipFile::bzip2()
+{
+    QFETCH(int, level);
+    QFETCH(int, threads);
+    QFETCH(int, size);
+    QFETCH(QByteArray, password);
+    if (!QuaZipCodec::isMethodSupported(Z_BZIP2ED))
+        QSKIP("QuaZip is built without bzip2");
+    // runs of 4 grow with bzip2's run-length encoding, testing the
+    // chunk size
+    QByteArray contents = compressibleData(size);
+    for (int pos = 0; pos + 4 <= contents.size(); pos += 16)
+        contents.replace(pos, 4, QByteArray(4, static_cast<char>(
+                'a' + pos / 16 % 26)));
+    const char *pwd = password.isEmpty() ? nullptr : password.constData();
+    QString zipName = "bzip2.zip";
+    {
+        QuaZip zip(zipName);
+        zip.setThreadCount(threads);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("test.txt"),
+                             pwd, 0, Z_BZIP2ED, level));
+        // odd pieces, so chunks don't match writes
+        for (int pos = 0; pos < contents.size(); pos += 77777)
+            QVERIFY(zipFile.write(contents.mid(pos, 77777)) >= 0);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    {
+        QuaZipFile zipFile(zipName, "test.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly, pwd));
+        QuaZipFileInfo64 info;
+        QVERIFY(zipFile.getFileInfo(&info));
+        QCOMPARE(info.method, static_cast<quint16>(Z_BZIP2ED));
+        QCOMPARE(info.uncompressedSize, static_cast<quint64>(size));
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    }
+    QDir().remove(zipName);
+}
+
+void TestQuaZipFile::deflate64()
+{
+    // made by a Deflate64 encoder with fixed, dynamic and stored blocks,
+    // matches longer than 258 bytes and distances over 32 KB
+    QuaZipFile zipFile(":/test_files/deflate64.zip", "deflate64.txt");
+    QVERIFY(zipFile.open(QIODevice::ReadOnly));
+    QuaZipFileInfo64 info;
+    QVERIFY(zipFile.getFileInfo(&info));
+    QCOMPARE(info.method, static_cast<quint16>(Z_DEFLATE64));
+    // small reads, to stop in the middle of matches
+    QByteArray contents;
+    char buf[1000];
+    qint64 count;
+    while ((count = zipFile.read(buf, sizeof(buf))) > 0)
+        contents.append(buf, static_cast<int>(count));
+    QCOMPARE(count, static_cast<qint64>(0));
+    QCOMPARE(contents.size(), 157268);
+    QVERIFY(contents.startsWith("0: the quick brown fox jumps over the lazy dog"));
+    QCOMPARE(contents.mid(36220, 70000), QByteArray(70000, 'x'));
+    zipFile.close();
+    QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    // can't be compressed, but can be copied in the raw mode
+    int method = 0;
+    QVERIFY(zipFile.open(QIODevice::ReadOnly, &method, nullptr, true));
+    QCOMPARE(method, static_cast<int>(Z_DEFLATE64));
+    QByteArray raw = zipFile.readAll();
+    zipFile.close();
+    QString copyName = "deflate64Copy.zip";
+    {
+        QuaZip zip(copyName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile copy(&zip);
+        QVERIFY(!copy.open(QIODevice::WriteOnly, QuaZipNewInfo("bad.txt"),
+                           nullptr, 0, Z_DEFLATE64));
+        QuaZipNewInfo newInfo("copy.txt");
+        newInfo.uncompressedSize = static_cast<ulong>(info.uncompressedSize);
+        QVERIFY(copy.open(QIODevice::WriteOnly, newInfo, nullptr, info.crc,
+                          Z_DEFLATE64, Z_DEFAULT_COMPRESSION, true));
+        QCOMPARE(copy.write(raw), static_cast<qint64>(raw.size()));
+        copy.close();
+        QCOMPARE(copy.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    {
+        QuaZipFile copy(copyName, "copy.txt");
+        QVERIFY(copy.open(QIODevice::ReadOnly));
+        QCOMPARE(copy.readAll(), contents);
+        copy.close();
+        QCOMPARE(copy.getZipError(), UNZ_OK);
+    }
+    QDir().remove(copyName);
+}
+
+void TestQuaZipFile::deflate64Stored()
+{
+    // two stored blocks followed by a fixed one, the bits after each
+    // stored block header must be dropped completely
+    static const char raw[] = "\x00\x03\x00\xFC\xFF" "abc"
+        "\x00\x02\x00\xFD\xFF" "gh" "\x4B\x49\x4D\x03\x00";
+    QByteArray contents("abcghdef");
+    QString zipName = "deflate64Stored.zip";
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QuaZipNewInfo newInfo("stored.txt");
+        newInfo.uncompressedSize = static_cast<ulong>(contents.size());
+        uLong crc = crc32(0, reinterpret_cast<const Bytef*>(
+                contents.constData()), static_cast<uInt>(contents.size()));
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, newInfo, nullptr, crc,
+                             Z_DEFLATE64, Z_DEFAULT_COMPRESSION, true));
+        QCOMPARE(zipFile.write(raw, sizeof(raw) - 1),
+                 static_cast<qint64>(sizeof(raw) - 1));
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    {
+        QuaZipFile zipFile(zipName, "stored.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly));
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    }
+    QDir().remove(zipName);
+}
+
+void TestQuaZipFile::aes_data()
+{
+    QTest::addColumn<int>("encryption");
+    QTest::addColumn<int>("method");
+    QTest::addColumn<int>("size");
+    QTest::newRow("aes128") << static_cast<int>(QuaZipFile::etAes128)
+                            << static_cast<int>(Z_DEFLATED) << 100000;
+    QTest::newRow("aes192") << static_cast<int>(QuaZipFile::etAes192)
+                            << static_cast<int>(Z_DEFLATED) << 100000;
+    QTest::newRow("aes256") << static_cast<int>(QuaZipFile::etAes256)
+                            << static_cast<int>(Z_DEFLATED) << 100000;
+    QTest::newRow("aes256 stored") << static_cast<int>(QuaZipFile::etAes256)
+                                   << 0 << 100000;
+    QTest::newRow("aes256 small") << static_cast<int>(QuaZipFile::etAes256)
+                                  << static_cast<int>(Z_DEFLATED) << 5;
+    QTest::newRow("aes256 empty") << static_cast<int>(QuaZipFile::etAes256)
+                                  << static_cast<int>(Z_DEFLATED) << 0;
+}
+
+void TestQuaZipFile::aes()
+{
+    QFETCH(int, encryption);
+    QFETCH(int, method);
+    QFETCH(int, size);
+    QByteArray contents = compressibleData(size);
+    QString zipName = "aes.zip";
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QCOMPARE(zipFile.getEncryption(), QuaZipFile::etTraditional);
+        zipFile.setEncryption(static_cast<QuaZipFile::Encryption>(encryption));
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("test.txt"),
+                             "secret", 0, method));
+        // odd pieces, not matching the AES blocks
+        for (int pos = 0; pos < contents.size(); pos += 7777)
+            QVERIFY(zipFile.write(contents.mid(pos, 7777)) >= 0);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    QuaZipFileInfo64 info;
+    QByteArray localExtra, raw;
+    {
+        QuaZipFile zipFile(zipName, "test.txt");
+        int actualMethod = -1;
+        QVERIFY(zipFile.open(QIODevice::ReadOnly, &actualMethod, nullptr,
+                             false, "secret"));
+        QCOMPARE(actualMethod, method);
+        QVERIFY(zipFile.getFileInfo(&info));
+        QCOMPARE(info.method, static_cast<quint16>(99));
+        QVERIFY(info.isEncrypted());
+        QCOMPARE(info.uncompressedSize, static_cast<quint64>(size));
+        // the vendor version, "AE", the strength and the actual method
+        QByteArray aesExtra("\x01\x99\x07\x00\x01\x00" "AE", 8);
+        aesExtra += static_cast<char>(encryption);
+        aesExtra += static_cast<char>(method);
+        aesExtra += '\0';
+        QVERIFY(info.extra.contains(aesExtra));
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+        // without the password, it can only be copied as is
+        QVERIFY(!zipFile.open(QIODevice::ReadOnly));
+        int rawMethod = -1;
+        QVERIFY(zipFile.open(QIODevice::ReadOnly, &rawMethod, nullptr, true));
+        QCOMPARE(rawMethod, 99);
+        localExtra = zipFile.getLocalExtraField();
+        raw = zipFile.readAll();
+        zipFile.close();
+        QCOMPARE(static_cast<quint64>(raw.size()), info.compressedSize);
+    }
+    QString copyName = "aesCopy.zip";
+    {
+        QuaZip zip(copyName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile copy(&zip);
+        QuaZipNewInfo newInfo("copy.txt");
+        newInfo.uncompressedSize = static_cast<ulong>(info.uncompressedSize);
+        newInfo.extraLocal = localExtra;
+        newInfo.extraGlobal = info.extra;
+        QVERIFY(copy.open(QIODevice::WriteOnly, newInfo, nullptr, info.crc,
+                          99, Z_DEFAULT_COMPRESSION, true));
+        QCOMPARE(copy.write(raw), static_cast<qint64>(raw.size()));
+        copy.close();
+        QCOMPARE(copy.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    {
+        QuaZipFile copy(copyName, "copy.txt");
+        QVERIFY(copy.open(QIODevice::ReadOnly, "secret"));
+        QCOMPARE(copy.readAll(), contents);
+        copy.close();
+        QCOMPARE(copy.getZipError(), UNZ_OK);
+    }
+    QDir().remove(zipName);
+    QDir().remove(copyName);
+}
+
+void TestQuaZipFile::aesAuthentication()
+{
+    QByteArray contents = compressibleData(100000);
+    QString zipName = "aesAuth.zip";
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        zipFile.setEncryption(QuaZipFile::etAes256);
+        // stored, so that the wrong data is read to the end
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("test.txt"),
+                             "secret", 0, 0));
+        QCOMPARE(zipFile.write(contents), static_cast<qint64>(contents.size()));
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    {
+        // the 2-byte verifier catches a wrong password, except once in
+        // 65536 salts, and then the authentication code does
+        QuaZipFile zipFile(zipName, "test.txt");
+        if (zipFile.open(QIODevice::ReadOnly, "wrong")) {
+            zipFile.readAll();
+            zipFile.close();
+            QCOMPARE(zipFile.getZipError(), UNZ_CRCERROR);
+        } else {
+            QCOMPARE(zipFile.getZipError(), UNZ_BADPASSWORD);
+        }
+    }
+    // the data of the entry, after the local header, the salt and the
+    // verifier, followed by the authentication code
+    QFile file(zipName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray header = file.read(30);
+    qint64 dataPos = 30 + 16 + 2
+        + (static_cast<uchar>(header[26]) | static_cast<uchar>(header[27]) << 8)
+        + (static_cast<uchar>(header[28]) | static_cast<uchar>(header[29]) << 8);
+    qint64 macPos = dataPos + contents.size();
+    // a changed code, with the data and the CRC intact
+    QVERIFY(file.seek(macPos));
+    char byte;
+    QVERIFY(file.getChar(&byte));
+    QVERIFY(file.seek(macPos));
+    QVERIFY(file.putChar(static_cast<char>(byte ^ 1)));
+    file.flush();
+    {
+        QuaZipFile zipFile(zipName, "test.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly, "secret"));
+        QCOMPARE(zipFile.readAll(), contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_CRCERROR);
+    }
+    // changed data, with the code restored
+    QVERIFY(file.seek(macPos));
+    QVERIFY(file.putChar(byte));
+    QVERIFY(file.seek(dataPos + 1000));
+    QVERIFY(file.getChar(&byte));
+    QVERIFY(file.seek(dataPos + 1000));
+    QVERIFY(file.putChar(static_cast<char>(byte ^ 1)));
+    file.close();
+    {
+        QuaZipFile zipFile(zipName, "test.txt");
+        QVERIFY(zipFile.open(QIODevice::ReadOnly, "secret"));
+        QByteArray read = zipFile.readAll();
+        QCOMPARE(read.size(), contents.size());
+        QVERIFY(read != contents);
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_CRCERROR);
+    }
+    QDir().remove(zipName);
+}
+
+void TestQuaZipFile::aesExternal_data()
+{
+    QTest::addColumn<QString>("zipName");
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<int>("version");
+    QTest::addColumn<QByteArray>("contents");
+    // made by libarchive, which writes AE-2 for entries under 20 bytes
+    QTest::newRow("AE-1") << QString(":/test_files/aes_ae1.zip")
+        << QString("aes.txt") << 1
+        << QByteArray("This file was encrypted by libarchive.\n");
+    QTest::newRow("AE-2") << QString(":/test_files/aes_ae2.zip")
+        << QString("ae2.txt") << 2 << QByteArray("short\n");
+}
+
+void TestQuaZipFile::aesExternal()
+{
+    QFETCH(QString, zipName);
+    QFETCH(QString, fileName);
+    QFETCH(int, version);
+    QFETCH(QByteArray, contents);
+    QuaZipFile zipFile(zipName, fileName);
+    QVERIFY(zipFile.open(QIODevice::ReadOnly, "secret"));
+    QuaZipFileInfo64 info;
+    QVERIFY(zipFile.getFileInfo(&info));
+    QCOMPARE(info.method, static_cast<quint16>(99));
+    QVERIFY(info.isEncrypted());
+    QByteArray aesExtra("\x01\x99\x07\x00", 4);
+    aesExtra += static_cast<char>(version);
+    aesExtra += '\0';
+    aesExtra += "AE";
+    QVERIFY(info.extra.contains(aesExtra));
+    // AE-2 leaves the CRC out, relying on the authentication code
+    if (version == 2)
+        QCOMPARE(info.crc, static_cast<quint32>(0));
+    QCOMPARE(zipFile.readAll(), contents);
+    zipFile.close();
+    QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    if (zipFile.open(QIODevice::ReadOnly, "wrong")) {
+        zipFile.readAll();
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_CRCERROR);
+    } else {
+        QCOMPARE(zipFile.getZipError(), UNZ_BADPASSWORD);
+    }
+}
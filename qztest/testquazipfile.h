@@ -48,6 +48,18 @@ private slots:
     void constructorDestructor();
     void setFileAttrs();
     void largeFile();
+    void zstd();
+    void lzma_data();
+    void lzma();
+    void bzip2_data();
+    void bzip2();
+    void deflate64();
+    void deflate64Stored();
+    void aes_data();
+    void aes();
+    void aesAuthentication();
+    void aesExternal_data();
+    void aesExternal();
 };
 
 #endif // QUAZIP_TEST_QUAZIPFILE_H
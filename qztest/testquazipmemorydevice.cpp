@@ -0,0 +1,126 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip test suite.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+
+#include "testquazipmemorydevice.h"
+
+#include "qztest.h"
+
+#include <quazip.h>
+#include <quazipmemorydevice.h>
+#include <quazipnewinfo.h>
+
+#include <QtCore/QByteArray>
+
+#include <QtTest/QtTest>
+
+void TestQuaZipMemoryDevice::write()
+{
+    QuaZipMemoryDevice device;
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    QVERIFY((device.openMode() & QIODevice::Unbuffered) != 0);
+    QByteArray expected;
+    // enough to span several chunks
+    for (int i = 0; i < 20000; ++i) {
+        QByteArray line = QByteArray::number(i).append('\n');
+        QCOMPARE(device.write(line), static_cast<qint64>(line.size()));
+        expected.append(line);
+    }
+    QCOMPARE(device.size(), static_cast<qint64>(expected.size()));
+    QVERIFY(device.chunks().size() > 1);
+    // overwrite across a chunk boundary
+    qint64 boundary = device.chunks().first().size();
+    QVERIFY(device.seek(boundary - 2));
+    QCOMPARE(device.write("abcd", 4), static_cast<qint64>(4));
+    expected.replace(static_cast<int>(boundary - 2), 4, "abcd");
+    // past the end, leaving a gap
+    QVERIFY(device.seek(expected.size() + 3));
+    QCOMPARE(device.write("end", 3), static_cast<qint64>(3));
+    expected.append(QByteArray(3, '\0')).append("end");
+    device.close();
+    QCOMPARE(device.size(), static_cast<qint64>(expected.size()));
+    QByteArray joined;
+    foreach (const QByteArray &chunk, device.chunks()) {
+        joined.append(chunk);
+    }
+    QCOMPARE(joined, expected);
+    QCOMPARE(device.data(), expected);
+    QCOMPARE(device.chunks().size(), 1);
+    // WriteOnly truncates, like QFile
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    QCOMPARE(device.size(), static_cast<qint64>(0));
+    QCOMPARE(device.write("new", 3), static_cast<qint64>(3));
+    device.close();
+    QCOMPARE(device.data(), QByteArray("new"));
+    QVERIFY(device.open(QIODevice::Append));
+    QCOMPARE(device.write("er", 2), static_cast<qint64>(2));
+    device.close();
+    QCOMPARE(device.data(), QByteArray("newer"));
+    // reserved memory makes the result a single chunk
+    QuaZipMemoryDevice reserved;
+    reserved.reserve(expected.size());
+    QVERIFY(reserved.open(QIODevice::WriteOnly));
+    QCOMPARE(reserved.write(expected), static_cast<qint64>(expected.size()));
+    reserved.close();
+    QCOMPARE(reserved.chunks().size(), 1);
+    QCOMPARE(reserved.data(), expected);
+}
+
+void TestQuaZipMemoryDevice::read()
+{
+    QByteArray source("Some data to read from memory");
+    QuaZipMemoryDevice device(source);
+    QCOMPARE(device.size(), static_cast<qint64>(source.size()));
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.read(4), QByteArray("Some"));
+    QVERIFY(device.seek(5));
+    QCOMPARE(device.readAll(), source.mid(5));
+    QVERIFY(device.atEnd());
+    QCOMPARE(device.read(1), QByteArray());
+    device.close();
+    // shared, not copied
+    QVERIFY(device.data().constData() == source.constData());
+}
+
+void TestQuaZipMemoryDevice::zip()
+{
+    QuaZipMemoryDevice output;
+    QuaZip zip(&output);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QByteArray text = QByteArray("Text to compress. ").repeated(10000);
+    QVERIFY(zip.addEntry(QuaZipNewInfo("text.txt"), text));
+    QVERIFY(zip.addEntry(QuaZipNewInfo("stored.txt"), text, 0));
+    zip.close();
+    QCOMPARE(zip.getZipError(), UNZ_OK);
+    QByteArray archive = output.data();
+    QuaZipMemoryDevice input(archive);
+    QuaZip unzip(&input);
+    QVERIFY(unzip.open(QuaZip::mdUnzip));
+    QCOMPARE(unzip.getFileNameList(), QStringList() << "text.txt"
+             << "stored.txt");
+    QCOMPARE(unzip.readEntry("text.txt"), text);
+    QCOMPARE(unzip.readEntry("stored.txt"), text);
+    unzip.close();
+    QCOMPARE(unzip.getZipError(), UNZ_OK);
+}
@@ -0,0 +1,221 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZip test suite.
+
+QuaZip is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZip is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZip.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "testquazipstreamreader.h"
+
+#include "qztest.h"
+
+#include <quazip.h>
+#include <quazipfile.h>
+#include <quazipstreamreader.h>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QByteArray>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+
+#include <QtTest/QtTest>
+
+/// A sequential device that hands out its data in small pieces.
+class SequentialByteArrayDevice: public QIODevice {
+public:
+    SequentialByteArrayDevice(QByteArray *data, int chunkSize):
+        data(data), readPos(0), chunkSize(chunkSize) {}
+    virtual bool isSequential() const {return true;}
+    virtual qint64 bytesAvailable() const
+    {
+        return data->size() - readPos + QIODevice::bytesAvailable();
+    }
+protected:
+    virtual qint64 readData(char *dest, qint64 maxSize)
+    {
+        qint64 size = qMin<qint64>(qMin<qint64>(maxSize, chunkSize),
+                                   data->size() - readPos);
+        memcpy(dest, data->constData() + readPos, size);
+        readPos += size;
+        return size;
+    }
+    virtual qint64 writeData(const char *src, qint64 maxSize)
+    {
+        data->append(src, maxSize);
+        return maxSize;
+    }
+private:
+    QByteArray *data;
+    int readPos;
+    int chunkSize;
+};
+
+void TestQuaZipStreamReader::read_data()
+{
+    QTest::addColumn<QStringList>("fileNames");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("chunkSize");
+    QTest::newRow("simple") << (
+            QStringList() << "test0.txt" << "testdir1/test1.txt"
+            << "testdir2/test2.txt" << "testdir2/subdir/test2sub.txt")
+        << -1 << 4096;
+    QTest::newRow("tiny chunks") << (
+            QStringList() << "test0.txt" << "testdir1/test1.txt")
+        << -1 << 1;
+    QTest::newRow("large") << (QStringList() << "large.txt")
+        << 65536 * 4 << 1000;
+}
+
+void TestQuaZipStreamReader::read()
+{
+    QFETCH(QStringList, fileNames);
+    QFETCH(int, size);
+    QFETCH(int, chunkSize);
+    QVERIFY(createTestFiles(fileNames, size));
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QVERIFY(createTestArchive(&zipBuffer, fileNames, NULL));
+    removeTestFiles(fileNames);
+    QVERIFY(createTestFiles(fileNames, size));
+    SequentialByteArrayDevice stream(&zipData, chunkSize);
+    QVERIFY(stream.open(QIODevice::ReadOnly));
+    QuaZipStreamReader reader(&stream);
+    QDir curDir;
+    int count = 0;
+    while (reader.nextEntry()) {
+        QuaZipFileInfo64 info;
+        QVERIFY(reader.getCurrentFileInfo(&info));
+        QCOMPARE(info.name, fileNames[count]);
+        QCOMPARE(reader.getCurrentFileName(), fileNames[count]);
+        QFile original(curDir.filePath("tmp/" + fileNames[count]));
+        QVERIFY(original.open(QIODevice::ReadOnly));
+        QIODevice *entry = reader.currentEntry();
+        QVERIFY(entry != nullptr);
+        QCOMPARE(entry->readAll(), original.readAll());
+        QVERIFY(entry->atEnd());
+        QCOMPARE(reader.getZipError(), UNZ_OK);
+        QVERIFY(reader.getCurrentFileInfo(&info));
+        QCOMPARE(info.uncompressedSize,
+                 static_cast<quint64>(original.size()));
+        ++count;
+    }
+    QCOMPARE(reader.getZipError(), UNZ_OK);
+    QCOMPARE(count, fileNames.size());
+    QVERIFY(reader.atEnd());
+    QVERIFY(!reader.hasCurrentEntry());
+    removeTestFiles(fileNames);
+    curDir.rmpath("tmp");
+}
+
+void TestQuaZipStreamReader::readSequential()
+{
+    QByteArray zipData;
+    SequentialByteArrayDevice output(&zipData, 0);
+    QuaZip zip(&output);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    // Something that looks like a data descriptor inside stored data.
+    QByteArray tricky = QByteArray("PK\x07\x08", 4)
+        + QByteArray(" this is not a data descriptor");
+    QByteArray text(QByteArray("deflated text ").repeated(1000));
+    QuaZipFile zipFile(&zip);
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("stored.bin"),
+                         NULL, 0, 0));
+    QCOMPARE(zipFile.write(tricky), static_cast<qint64>(tricky.size()));
+    zipFile.close();
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("text.txt")));
+    QCOMPARE(zipFile.write(text), static_cast<qint64>(text.size()));
+    zipFile.close();
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("empty.txt"),
+                         NULL, 0, 0));
+    zipFile.close();
+    zip.close();
+    SequentialByteArrayDevice stream(&zipData, 7);
+    QVERIFY(stream.open(QIODevice::ReadOnly));
+    QuaZipStreamReader reader(&stream);
+    QuaZipFileInfo64 info;
+    QVERIFY(reader.nextEntry());
+    QVERIFY(reader.getCurrentFileInfo(&info));
+    QVERIFY((info.flags & 8) != 0);
+    QCOMPARE(info.compressedSize, static_cast<quint64>(0));
+    QCOMPARE(reader.currentEntry()->readAll(), tricky);
+    QVERIFY(reader.getCurrentFileInfo(&info));
+    QCOMPARE(info.uncompressedSize, static_cast<quint64>(tricky.size()));
+    QVERIFY(reader.nextEntry());
+    QCOMPARE(reader.getCurrentFileName(), QString("text.txt"));
+    QCOMPARE(reader.currentEntry()->readAll(), text);
+    QVERIFY(reader.getCurrentFileInfo(&info));
+    QCOMPARE(info.method, static_cast<quint16>(Z_DEFLATED));
+    QCOMPARE(info.uncompressedSize, static_cast<quint64>(text.size()));
+    QVERIFY(info.compressedSize < info.uncompressedSize);
+    QVERIFY(reader.nextEntry());
+    QCOMPARE(reader.getCurrentFileName(), QString("empty.txt"));
+    QCOMPARE(reader.currentEntry()->readAll(), QByteArray());
+    QVERIFY(!reader.nextEntry());
+    QCOMPARE(reader.getZipError(), UNZ_OK);
+    QVERIFY(reader.atEnd());
+}
+
+void TestQuaZipStreamReader::skip()
+{
+    QStringList fileNames;
+    fileNames << "test0.txt" << "test1.txt" << "test2.txt";
+    QVERIFY(createTestFiles(fileNames, 10000));
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QVERIFY(createTestArchive(&zipBuffer, fileNames, NULL));
+    removeTestFiles(fileNames);
+    QBuffer stream(&zipData);
+    QVERIFY(stream.open(QIODevice::ReadOnly));
+    QuaZipStreamReader reader(&stream);
+    QVERIFY(reader.nextEntry());
+    QCOMPARE(reader.currentEntry()->read(10), QByteArray("0123456789"));
+    QVERIFY(reader.nextEntry());
+    QCOMPARE(reader.getCurrentFileName(), QString("test1.txt"));
+    QVERIFY(reader.nextEntry());
+    QCOMPARE(reader.getCurrentFileName(), QString("test2.txt"));
+    QCOMPARE(reader.currentEntry()->readAll().size(), 10000);
+    QVERIFY(!reader.nextEntry());
+    QCOMPARE(reader.getZipError(), UNZ_OK);
+}
+
+void TestQuaZipStreamReader::crcError()
+{
+    QByteArray zipData;
+    QBuffer zipBuffer(&zipData);
+    QuaZip zip(&zipBuffer);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QuaZipFile zipFile(&zip);
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("test.txt"),
+                         NULL, 0, 0));
+    QCOMPARE(zipFile.write("test"), static_cast<qint64>(4));
+    zipFile.close();
+    zip.close();
+    int dataPos = zipData.indexOf("test", 30 + 8);
+    QVERIFY(dataPos > 0);
+    zipData[dataPos] = 'b';
+    QBuffer stream(&zipData);
+    QVERIFY(stream.open(QIODevice::ReadOnly));
+    QuaZipStreamReader reader(&stream);
+    QVERIFY(reader.nextEntry());
+    char buf[16];
+    QCOMPARE(reader.currentEntry()->read(buf, sizeof(buf)),
+             static_cast<qint64>(-1));
+    QCOMPARE(reader.getZipError(), UNZ_CRCERROR);
+}